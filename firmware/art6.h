@@ -247,9 +247,6 @@ extern uint8_t SlaveMode;
 //#define EVT_ENTRY_UP            (0xfe - _MSK_KEY_REPT)
 //#define EVT_KEY_MASK             0x0f
 //
-#define HEART_TIMER_PULSES 1;
-#define HEART_TIMER_10ms 2;
-//
 //#define TMRMODE_NONE     0
 //#define TMRMODE_ABS      1
 //#define TMRMODE_THR      2
@@ -312,6 +309,8 @@ extern uint8_t SlaveMode;
 //
 #define NO_TRAINER 0x01
 #define NO_INPUT   0x02
+#define NO_STATE   0x04	// leave the slow/delay/switch state and timers alone
+#define THR_IDLE   0x08	// throttle stick at idle, whatever it reads
 //#define FADE_FIRST	0x20
 //#define FADE_LAST		0x40
 ////#define NO_TRIMS   0x04
@@ -0,0 +1,83 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Packed GUI bitmaps, see bitmap.h.
+ * Made by tools/bmpconv, do not edit.
+ *
+ */
+
+#include "assets.h"
+
+// logo.bmp, 128x64, 1024 bytes unpacked
+const uint8_t asset_logo[584] = {
+	0x80, 0x40, 0xEC, 0x00, 0x05, 0x80, 0xC0, 0x60, 0x60, 0xC0, 0x80, 0x8E, 0x00, 0x12, 0xE0, 0xE0,
+	0xF0, 0xF8, 0xEC, 0xE6, 0xE3, 0xE1, 0xE0, 0xE0, 0x20, 0xF8, 0x69, 0xBF, 0x68, 0xB8, 0x68, 0xF8,
+	0x20, 0xF9, 0xE0, 0xF0, 0x00, 0x01, 0xFC, 0x02, 0xFE, 0x01, 0x01, 0x42, 0xFC, 0xFB, 0x00, 0x08,
+	0xC0, 0x20, 0x10, 0x0E, 0x00, 0xC0, 0x20, 0x10, 0x0E, 0xFC, 0x00, 0x04, 0xC0, 0x40, 0x7E, 0x40,
+	0xC0, 0xFE, 0x00, 0x00, 0xFE, 0xFC, 0x00, 0x00, 0xFE, 0xDC, 0x00, 0x04, 0xF8, 0x20, 0x20, 0xF8,
+	0x00, 0xFC, 0xFF, 0xFC, 0x03, 0x08, 0x02, 0x0F, 0x1B, 0x3E, 0x1B, 0x0E, 0x0B, 0x0F, 0x02, 0xFE,
+	0x03, 0xFC, 0xFF, 0xF0, 0x00, 0x00, 0xFF, 0xFE, 0x00, 0x02, 0x82, 0x92, 0xFF, 0xFA, 0x00, 0x07,
+	0x21, 0x12, 0x0C, 0x00, 0x00, 0x21, 0x12, 0x0C, 0xFC, 0x00, 0x10, 0x03, 0x02, 0xFE, 0x02, 0x03,
+	0x00, 0xF0, 0x90, 0x9F, 0x90, 0xF0, 0x00, 0x3C, 0x24, 0xE7, 0x24, 0x3C, 0xDE, 0x00, 0x04, 0xFF,
+	0x00, 0x00, 0xFF, 0x3C, 0xFC, 0xFF, 0x00, 0xE0, 0xFD, 0xE8, 0xFC, 0xF8, 0x01, 0x18, 0x18, 0xFD,
+	0x08, 0x00, 0x00, 0xFC, 0xFF, 0xF0, 0x00, 0x00, 0xFF, 0xFE, 0x00, 0x02, 0x20, 0x24, 0xFF, 0xEB,
+	0x00, 0x00, 0x7F, 0xFC, 0x00, 0x00, 0x7F, 0xFC, 0x00, 0x00, 0x7F, 0xDC, 0x00, 0x04, 0x1F, 0x04,
+	0x04, 0x9F, 0x80, 0xFC, 0xFF, 0xF0, 0x80, 0xFC, 0xFF, 0x01, 0x80, 0x80, 0xF6, 0x00, 0x0E, 0xC0,
+	0x70, 0xA8, 0x54, 0xAB, 0x56, 0xAA, 0x56, 0xAA, 0x57, 0xAB, 0x54, 0xA8, 0x70, 0xC0, 0xFB, 0x00,
+	0x01, 0x20, 0xE0, 0xFE, 0x00, 0x08, 0xE0, 0xA0, 0xA0, 0xE0, 0x00, 0xC0, 0x20, 0x20, 0xC0, 0xF7,
+	0x00, 0xFE, 0x20, 0x11, 0xC0, 0x00, 0xC0, 0x20, 0x20, 0xC0, 0x00, 0xC0, 0x20, 0x20, 0xC0, 0x00,
+	0x00, 0x60, 0x90, 0x60, 0x00, 0xE0, 0xFE, 0x10, 0x00, 0x20, 0xF1, 0x00, 0xE2, 0x7F, 0xF6, 0x00,
+	0x0E, 0x01, 0x07, 0x0A, 0x15, 0x2A, 0x35, 0x6A, 0x55, 0x6A, 0x35, 0x2A, 0x15, 0x0A, 0x07, 0x01,
+	0xFB, 0x00, 0x0D, 0x04, 0x07, 0x04, 0x00, 0x00, 0x04, 0x04, 0x06, 0x03, 0x00, 0x03, 0x04, 0x04,
+	0x03, 0xFD, 0x00, 0x01, 0x01, 0x01, 0xFD, 0x00, 0x0D, 0x04, 0x05, 0x05, 0x06, 0x00, 0x03, 0x04,
+	0x04, 0x03, 0x00, 0x03, 0x04, 0x04, 0x03, 0xFB, 0x00, 0x00, 0x03, 0xFE, 0x04, 0x00, 0x02, 0xFC,
+	0x00, 0x03, 0xC0, 0x00, 0x00, 0xC0, 0xFE, 0x00, 0x00, 0xC0, 0xFE, 0x00, 0x03, 0xC0, 0x00, 0x00,
+	0xC0, 0xFE, 0x00, 0x06, 0xC0, 0x00, 0x00, 0xC0, 0x00, 0x00, 0xC0, 0xFE, 0x00, 0x00, 0xC0, 0xFB,
+	0x00, 0x03, 0xC0, 0x70, 0x30, 0xC0, 0xFD, 0x00, 0x00, 0xF0, 0xFD, 0x10, 0x01, 0xE0, 0x00, 0xFE,
+	0x10, 0x00, 0xF0, 0xFE, 0x10, 0x00, 0xC0, 0xFE, 0x40, 0x04, 0xC0, 0x80, 0x00, 0x00, 0xC0, 0xFE,
+	0x00, 0x0C, 0xC0, 0x40, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x80, 0xC0, 0x40, 0x40, 0xC0, 0x80, 0xFE,
+	0x00, 0x03, 0xC0, 0x80, 0x40, 0x40, 0xFD, 0x00, 0x01, 0x80, 0xC0, 0xFE, 0x40, 0x07, 0x00, 0x00,
+	0x80, 0xC0, 0x40, 0x40, 0xC0, 0x80, 0xFB, 0x00, 0x00, 0xC0, 0xFE, 0x00, 0x00, 0xC0, 0xFE, 0x00,
+	0x04, 0xF8, 0x00, 0x00, 0x80, 0x40, 0xFE, 0x00, 0x07, 0x03, 0x1C, 0x1E, 0x01, 0x03, 0x1C, 0x1E,
+	0x01, 0xFE, 0x00, 0x20, 0x03, 0x1C, 0x1E, 0x01, 0x03, 0x1C, 0x1E, 0x01, 0x00, 0x00, 0x03, 0x1C,
+	0x1E, 0x01, 0x03, 0x1C, 0x1E, 0x01, 0x00, 0x00, 0x10, 0x00, 0x10, 0x1E, 0x07, 0x04, 0x04, 0x05,
+	0x0E, 0x18, 0x00, 0x00, 0x1F, 0xFE, 0x01, 0x02, 0x03, 0x0E, 0x18, 0xFE, 0x00, 0x00, 0x1F, 0xFE,
+	0x00, 0x00, 0x0C, 0xFE, 0x12, 0x08, 0x0A, 0x1F, 0x00, 0x00, 0x81, 0xCE, 0x70, 0x0E, 0x01, 0xFE,
+	0x00, 0x08, 0x1F, 0x00, 0x00, 0x0F, 0x18, 0x10, 0x10, 0x18, 0x0F, 0xFE, 0x00, 0x00, 0x1F, 0xFE,
+	0x00, 0x00, 0x10, 0xFE, 0x00, 0x01, 0x0F, 0x18, 0xFE, 0x10, 0x07, 0x00, 0x00, 0x0F, 0x18, 0x10,
+	0x10, 0x18, 0x0F, 0xFE, 0x00, 0x07, 0x10, 0x00, 0x00, 0x0F, 0x10, 0x10, 0x08, 0x1F, 0xFE, 0x00,
+	0x06, 0x1F, 0x02, 0x05, 0x08, 0x10, 0x00, 0x00
+};
+
+// radio_settings.bmp, 32x32, 128 bytes unpacked
+const uint8_t asset_radio_settings[121] = {
+	0x20, 0x20, 0x01, 0x00, 0x80, 0xFD, 0x00, 0x04, 0xF0, 0x88, 0x88, 0xC8, 0xC8, 0xFE, 0x88, 0x03,
+	0xEA, 0xFF, 0xFF, 0xEA, 0xFE, 0x88, 0x04, 0xC8, 0xC8, 0x88, 0x88, 0xF0, 0xFD, 0x00, 0x48, 0x80,
+	0x00, 0x00, 0xF0, 0xF9, 0x0E, 0x26, 0x83, 0x41, 0x41, 0x21, 0x21, 0x43, 0x47, 0x8D, 0x28, 0x08,
+	0x0C, 0x0A, 0x09, 0x28, 0x8D, 0x47, 0x43, 0x21, 0x21, 0x41, 0x41, 0x83, 0x26, 0x0E, 0xF9, 0xF0,
+	0x00, 0x00, 0xFF, 0xFF, 0x80, 0x46, 0x19, 0x20, 0x20, 0x46, 0x46, 0x20, 0x20, 0x19, 0x46, 0x00,
+	0xE3, 0x23, 0xE0, 0x06, 0x19, 0x20, 0x20, 0x46, 0x46, 0x20, 0x20, 0x19, 0x46, 0x80, 0xFF, 0xFF,
+	0x00, 0x00, 0x9F, 0xBF, 0xB3, 0xA1, 0xA5, 0xE5, 0xFD, 0xE1, 0xF8, 0xA1, 0x0B, 0xAD, 0xE1, 0xED,
+	0xE1, 0xED, 0xE1, 0xAD, 0xA1, 0xB3, 0xBF, 0x9F, 0x00
+};
+
+// model_settings.bmp, 32x32, 128 bytes unpacked
+const uint8_t asset_model_settings[63] = {
+	0x20, 0x20, 0xFC, 0x00, 0x05, 0x78, 0xFC, 0xFE, 0xFF, 0xF0, 0xE0, 0xFB, 0xC0, 0x05, 0xE0, 0xF0,
+	0xFF, 0xFE, 0xFC, 0x78, 0xF7, 0x00, 0xFC, 0xC0, 0x04, 0x80, 0x81, 0x83, 0x87, 0x8F, 0xFB, 0x7F,
+	0x03, 0x8F, 0xC7, 0x23, 0xA1, 0xF9, 0xA0, 0x03, 0x20, 0xC0, 0x00, 0x00, 0xFC, 0x01, 0xFC, 0x00,
+	0xFB, 0xFF, 0x01, 0x00, 0x01, 0xF6, 0x02, 0x00, 0x01, 0xF5, 0x00, 0xFB, 0x7F, 0xF2, 0x00
+};
@@ -0,0 +1,25 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _ASSETS_H
+#define _ASSETS_H
+
+#include <stdint.h>
+
+// Packed bitmaps (see bitmap.h), made from the .bmp files by tools/bmpconv.
+extern const uint8_t asset_logo[];
+extern const uint8_t asset_radio_settings[];
+extern const uint8_t asset_model_settings[];
+
+#endif // _ASSETS_H
@@ -0,0 +1,150 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Packed bitmaps (logo, icons) drawn straight into the lcd_buffer.
+ * The image is decoded a byte at a time as it is drawn, so no buffer is
+ * needed, and can go at any x/y with the bitmap clipped to the screen.
+ * Runs of blank bytes are skipped without touching the lcd_buffer.
+ * The format is in bitmap.h, tools/bmpconv makes assets.c from the .bmp
+ * sources and benchmarks the decoder.
+ *
+ */
+
+#include <stdbool.h>
+
+#include "bitmap.h"
+#include "lcd.h"
+
+#define LCD_PAGES		(LCD_HEIGHT / 8)
+
+/**
+  * @brief  Draw one bitmap byte.
+  * @note	The byte covers 8 pixels down from the top of page row, less
+  *			shift, so it can straddle two lcd_buffer pages.
+  * @param  bits: Pixels, bit 0 at the top.
+  * @param  x: Screen column.
+  * @param  row: lcd_buffer page.
+  * @param  shift: Pixels down from the top of the page.
+  * @param  op: LCD_OP
+  * @retval None
+  */
+static void bitmap_put(uint8_t bits, uint16_t x, uint8_t row, uint8_t shift, LCD_OP op)
+{
+	uint8_t *dst;
+	uint8_t lo = bits << shift;
+	uint8_t hi = shift ? bits >> (8 - shift) : 0;
+
+	if (x >= LCD_WIDTH || row >= LCD_PAGES)
+		return;
+	dst = &lcd_buffer[x + row * LCD_WIDTH];
+
+	switch (op)
+	{
+	case LCD_OP_SET:
+		dst[0] |= lo;
+		if (hi && row + 1 < LCD_PAGES)
+			dst[LCD_WIDTH] |= hi;
+		break;
+	case LCD_OP_CLR:
+		dst[0] &= ~lo;
+		if (hi && row + 1 < LCD_PAGES)
+			dst[LCD_WIDTH] &= ~hi;
+		break;
+	case LCD_OP_XOR:
+		dst[0] ^= lo;
+		if (hi && row + 1 < LCD_PAGES)
+			dst[LCD_WIDTH] ^= hi;
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+  * @brief  Draw a packed bitmap.
+  * @note	SET draws the set pixels, CLR clears them and XOR inverts
+  *			them. Clear pixels are never touched.
+  * @param  bmp: Packed bitmap, see bitmap.h.
+  * @param  x: Left column.
+  * @param  y: Top row, need not be on a page boundary.
+  * @param  op: LCD_OP
+  * @retval None
+  */
+void bitmap_draw(const uint8_t *bmp, uint8_t x, uint8_t y, LCD_OP op)
+{
+	const uint8_t *p = bmp + BITMAP_HDR_LEN;
+	uint8_t width = BITMAP_WIDTH(bmp);
+	uint8_t height = BITMAP_HEIGHT(bmp);
+	uint8_t pages = (height + 7) / 8;
+	uint8_t shift = y % 8;
+	uint8_t mask = 0xFF;
+	uint8_t col = 0;
+	uint8_t page = 0;
+
+	if (op == LCD_OP_NONE || width == 0 || pages == 0)
+		return;
+
+	// The last page may be part used.
+	if (pages == 1 && (height % 8) != 0)
+		mask = 0xFF >> (8 - height % 8);
+
+	while (page < pages)
+	{
+		uint8_t t = *p++;
+		uint8_t n;
+		uint8_t b = 0;
+		bool run;
+
+		if (t == 0x80)
+			continue;
+
+		run = (t & 0x80) != 0;
+		n = run ? 257 - t : t + 1;
+		if (run)
+			b = *p++;
+
+		// Blank runs only need the position moving on.
+		if (run && b == 0)
+		{
+			col += n;
+			while (col >= width && page < pages)
+			{
+				col -= width;
+				page++;
+			}
+			if (page == pages - 1 && (height % 8) != 0)
+				mask = 0xFF >> (8 - height % 8);
+			continue;
+		}
+
+		while (n--)
+		{
+			if (!run)
+				b = *p++;
+			if (b & mask)
+				bitmap_put(b & mask, (uint16_t)x + col, y / 8 + page, shift, op);
+
+			if (++col == width)
+			{
+				col = 0;
+				if (++page == pages)
+					break;
+				if (page == pages - 1 && (height % 8) != 0)
+					mask = 0xFF >> (8 - height % 8);
+			}
+		}
+	}
+}
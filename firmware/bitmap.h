@@ -0,0 +1,42 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _BITMAP_H
+#define _BITMAP_H
+
+#include <stdint.h>
+
+#include "lcd.h"
+
+/*
+ * Packed bitmap, as made by tools/bmpconv from the .bmp sources.
+ *
+ * Header: width, height (pixels, 1 byte each).
+ * Then the image in lcd_buffer order, one byte per column of each 8 pixel
+ * high page, top page first and bit 0 at the top, packed as PackBits:
+ *   0x00..0x7F   literal, (T + 1) bytes follow
+ *   0x80         no-op
+ *   0x81..0xFF   the next byte, (257 - T) times
+ * Bits below the height in the last page are ignored.
+ */
+
+#define BITMAP_HDR_LEN		2
+#define BITMAP_RUN_MAX		128
+
+#define BITMAP_WIDTH(b)		((b)[0])
+#define BITMAP_HEIGHT(b)	((b)[1])
+
+void bitmap_draw(const uint8_t *bmp, uint8_t x, uint8_t y, LCD_OP op);
+
+#endif // _BITMAP_H
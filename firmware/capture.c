@@ -0,0 +1,285 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Input capture for replay on the host (tools/replay).
+ * While a capture is running, every stick scan, key and trainer frame is
+ * time stamped to the microsecond and queued in a ring, which the serial
+ * task drains to the host. Nothing is queued otherwise.
+ * Records come from ISRs at different priorities and the main loop, so
+ * the ring is only touched with BASEPRI masking priority 1 and below,
+ * for a few dozen cycles at a time. The PPM output ISR is never held
+ * off. The trainer input ISR shares its priority 0 and can still get in,
+ * so a frame it finishes while the ring is held is parked and queued
+ * after. If the host falls behind, records are counted and a
+ * CAPTURE_LOST record marks the gap.
+ *
+ */
+
+#include <string.h>
+
+#include "stm32f10x.h"
+
+#include "capture.h"
+#include "tasks.h"
+#include "keypad.h"
+#include "sticks.h"
+#include "art6.h"
+
+static uint8_t ring[CAPTURE_BUFFER_SIZE];
+static volatile uint16_t head;
+static uint16_t tail;
+static uint16_t lost;
+static volatile bool active;
+static uint32_t start_ms;
+static volatile bool held;				// A put is updating the ring
+static CapturePpmIn parked_ppm_in;		// Trainer frame that came in meanwhile
+static volatile bool parked;
+
+// Masks priority 1 and below, the PPM output (TIM2) still runs.
+#define CAPTURE_BASEPRI		(1 << (8 - __NVIC_PRIO_BITS))
+
+/**
+  * @brief  Time since the capture started.
+  * @note	Can be called from ISR or main loop.
+  * @param  None
+  * @retval us
+  */
+static uint32_t capture_time(void)
+{
+	uint32_t ms;
+	uint32_t val;
+
+	do {
+		ms = system_ticks;
+		val = SysTick->VAL;
+	} while (ms != system_ticks);
+
+	// Wrapped, but we're preempting the SysTick handler.
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET)
+	{
+		val = SysTick->VAL;
+		ms++;
+	}
+
+	return (ms - start_ms) * 1000 +
+			(SysTick->LOAD - val) / (SystemCoreClock / 1000000);
+}
+
+static void capture_copy(const void *rec, uint8_t length)
+{
+	const uint8_t *p = rec;
+
+	while (length--)
+		ring[head++ % CAPTURE_BUFFER_SIZE] = *p++;
+}
+
+/**
+  * @brief  Copy a record into the ring.
+  * @note	Marks any gap first. Only with BASEPRI set and the ring held.
+  * @param  rec: Record, header filled in
+  * @param  length: Bytes
+  * @retval None
+  */
+static void capture_queue(const void *rec, uint8_t length)
+{
+	const CaptureHdr *hdr = rec;
+
+	if (lost != 0 && (uint16_t) (head - tail) + sizeof(CaptureLost) <= CAPTURE_BUFFER_SIZE)
+	{
+		CaptureLost gap;
+
+		gap.hdr.type = CAPTURE_LOST;
+		gap.hdr.time = hdr->time;
+		gap.count = lost;
+		capture_copy(&gap, sizeof(gap));
+		lost = 0;
+	}
+
+	if (lost == 0 && (uint16_t) (head - tail) + length <= CAPTURE_BUFFER_SIZE)
+		capture_copy(rec, length);
+	else
+		lost++;
+}
+
+/**
+  * @brief  Queue a record.
+  * @note	Fills in the header.
+  * 		A trainer frame from TIM3 at priority 0 that comes in while
+  * 		the ring is held is parked and queued by the put it interrupted.
+  * @param  rec: Record, starting with a CaptureHdr
+  * @param  type: CAPTURE_TYPE
+  * @retval None
+  */
+static void capture_put(void *rec, uint8_t type)
+{
+	CaptureHdr *hdr = rec;
+	uint8_t length = capture_length(type);
+	uint32_t basepri;
+
+	if (!active)
+		return;
+
+	hdr->type = type;
+
+	if (held)
+	{
+		// Only TIM3 can get in here. A second frame in one put can't happen.
+		if (type == CAPTURE_PPM_IN && !parked)
+		{
+			hdr->time = capture_time();
+			memcpy(&parked_ppm_in, rec, sizeof(parked_ppm_in));
+			parked = true;
+		}
+		return;
+	}
+
+	basepri = __get_BASEPRI();
+	__set_BASEPRI(CAPTURE_BASEPRI);
+	held = true;
+	hdr->time = capture_time();
+
+	// A frame parked before the time was taken goes first.
+	if (parked && parked_ppm_in.hdr.time <= hdr->time)
+	{
+		capture_queue(&parked_ppm_in, sizeof(parked_ppm_in));
+		parked = false;
+	}
+	capture_queue(rec, length);
+	if (parked)
+	{
+		capture_queue(&parked_ppm_in, sizeof(parked_ppm_in));
+		parked = false;
+	}
+
+	held = false;
+	__set_BASEPRI(basepri);
+}
+
+/**
+  * @brief  Start a capture.
+  * @note	Record times start from here.
+  * @param  None
+  * @retval None
+  */
+void capture_start(void)
+{
+	__disable_irq();
+	head = tail = 0;
+	lost = 0;
+	start_ms = system_ticks;
+	active = true;
+	__enable_irq();
+}
+
+/**
+  * @brief  Stop capturing.
+  * @note	Records already queued can still be read.
+  * @param  None
+  * @retval None
+  */
+void capture_stop(void)
+{
+	active = false;
+}
+
+/**
+  * @brief  Is a capture running?
+  * @note
+  * @param  None
+  * @retval true if running.
+  */
+bool capture_active(void)
+{
+	return active;
+}
+
+/**
+  * @brief  Take queued records.
+  * @note	Main loop only.
+  * @param  buf: Destination
+  * @param  length: Space in buf
+  * @retval Bytes copied, whole records only.
+  */
+uint8_t capture_read(uint8_t *buf, uint8_t length)
+{
+	uint8_t n = 0;
+
+	// Only the reader moves tail, and head only grows.
+	while (tail != head)
+	{
+		uint8_t size = capture_length(ring[tail % CAPTURE_BUFFER_SIZE]);
+
+		if (size == 0 || n + size > length)
+			break;
+		while (size--)
+			buf[n++] = ring[tail++ % CAPTURE_BUFFER_SIZE];
+	}
+
+	return n;
+}
+
+/**
+  * @brief  Record a stick scan.
+  * @note	Called from the ADC DMA ISR.
+  * @param  None
+  * @retval None
+  */
+void capture_adc(void)
+{
+	CaptureAdc rec;
+	uint8_t i;
+
+	if (!active)
+		return;
+	for (i = 0; i < STICK_ADC_CHANNELS; i++)
+		rec.adc[i] = adc_data[i];
+	rec.switches = keypad_get_switches();
+	capture_put(&rec, CAPTURE_ADC);
+}
+
+/**
+  * @brief  Record a key.
+  * @note	Called when the key is passed to the GUI.
+  * @param  key: KEYPAD_KEY
+  * @retval None
+  */
+void capture_key(uint16_t key)
+{
+	CaptureKey rec;
+
+	if (!active)
+		return;
+	rec.key = key;
+	capture_put(&rec, CAPTURE_KEY);
+}
+
+/**
+  * @brief  Record a trainer frame.
+  * @note	Called from the capture ISR once all channels are in.
+  * @param  None
+  * @retval None
+  */
+void capture_ppm_in(void)
+{
+	CapturePpmIn rec;
+	uint8_t i;
+
+	if (!active)
+		return;
+	for (i = 0; i < CAPTURE_PPM_CHANNELS; i++)
+		rec.ppm[i] = g_ppmIns[i];
+	capture_put(&rec, CAPTURE_PPM_IN);
+}
@@ -0,0 +1,113 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _CAPTURE_H
+#define _CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sticks.h"
+
+/*
+ * Input capture format (shared with tools/artlink.c and tools/replay).
+ *
+ * Records are packed and little endian. Each starts with its type and
+ * the time in us since the capture was started. They are streamed in
+ * MSG_CAPTURE_DATA frames, whole records only.
+ *
+ * A trace file, as written by "artlink capture", is a CaptureFileHdr,
+ * the EEGeneral and ModelData in use when the capture started, then the
+ * records in the order they were taken.
+ */
+#define CAPTURE_MAGIC		0x43545241	// "ARTC"
+#define CAPTURE_VERSION		1
+#define CAPTURE_BUFFER_SIZE	256
+#define CAPTURE_PPM_CHANNELS	8
+
+typedef enum
+{
+	CAPTURE_ADC = 1,	// One stick scan, before the mixer sees it
+	CAPTURE_KEY,		// Key passed to the GUI
+	CAPTURE_PPM_IN,		// Complete trainer frame
+	CAPTURE_LOST,		// Records dropped here, the host was too slow
+} CAPTURE_TYPE;
+
+typedef struct __attribute__((packed))
+{
+	uint8_t type;
+	uint32_t time;
+} CaptureHdr;
+
+typedef struct __attribute__((packed))
+{
+	CaptureHdr hdr;
+	uint16_t adc[STICK_ADC_CHANNELS];	// adc_data
+	uint8_t switches;					// keypad_get_switches()
+} CaptureAdc;
+
+typedef struct __attribute__((packed))
+{
+	CaptureHdr hdr;
+	uint16_t key;						// KEYPAD_KEY
+} CaptureKey;
+
+typedef struct __attribute__((packed))
+{
+	CaptureHdr hdr;
+	int16_t ppm[CAPTURE_PPM_CHANNELS];	// g_ppmIns
+} CapturePpmIn;
+
+typedef struct __attribute__((packed))
+{
+	CaptureHdr hdr;
+	uint16_t count;
+} CaptureLost;
+
+typedef struct __attribute__((packed))
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t general_size;
+	uint16_t model_size;
+} CaptureFileHdr;
+
+/**
+  * @brief  Get the size of a record.
+  * @note
+  * @param  type: CAPTURE_TYPE
+  * @retval Bytes, 0 for an unknown type.
+  */
+static inline uint8_t capture_length(uint8_t type)
+{
+	switch (type)
+	{
+	case CAPTURE_ADC:		return sizeof(CaptureAdc);
+	case CAPTURE_KEY:		return sizeof(CaptureKey);
+	case CAPTURE_PPM_IN:	return sizeof(CapturePpmIn);
+	case CAPTURE_LOST:		return sizeof(CaptureLost);
+	}
+	return 0;
+}
+
+void capture_start(void);
+void capture_stop(void);
+bool capture_active(void);
+uint8_t capture_read(uint8_t *buf, uint8_t length);
+
+void capture_adc(void);
+void capture_key(uint16_t key);
+void capture_ppm_in(void);
+
+#endif // _CAPTURE_H
@@ -0,0 +1,206 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Fault capture.
+ * The fault handlers save the stacked registers, the fault status
+ * registers and a short heuristic stack walk into a RAM record that is
+ * not cleared at startup, then reset. On the next boot crash_init()
+ * finds the record, saves it to EEPROM and tells the user. The last
+ * saved record is shown on the FAULT page of the system menu and can be
+ * decoded against the ELF with tools/crashdecode.c.
+ *
+ * The watchdog supervisor uses the same path, from PendSV, to record a
+ * lockup with the context that stopped responding.
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "stm32f10x.h"
+
+#include "tasks.h"
+#include "crash.h"
+#include "eeprom.h"
+#include "gui.h"
+#include "watchdog.h"
+
+#define CRASH_RAM_END		(SRAM_BASE + 8 * 1024)
+#define CRASH_FLASH_END		(FLASH_BASE + 64 * 1024)
+
+void crash_capture(uint32_t *frame, uint32_t exc_return) __attribute__((used, noreturn));
+
+static CrashRecord crash CRASH_NOINIT;
+static bool crash_valid;
+static uint8_t crash_stalled;
+
+/**
+  * @brief  Checksum a record.
+  * @note
+  * @param  rec: Record
+  * @retval Sum of every word before the checksum, inverted.
+  */
+uint32_t crash_checksum(const CrashRecord *rec)
+{
+	const uint32_t *p = (const uint32_t*) rec;
+	uint32_t sum = 0;
+	uint8_t i;
+
+	for (i = 0; i < offsetof(CrashRecord, check) / 4; i++)
+		sum += p[i];
+	return ~sum;
+}
+
+static bool crash_is_valid(const CrashRecord *rec)
+{
+	return rec->magic == CRASH_MAGIC && rec->version == CRASH_VERSION &&
+			rec->check == crash_checksum(rec);
+}
+
+/**
+  * @brief  Save a record left by the fault handler.
+  * @note	Call after eeprom_init().
+  * @param  None
+  * @retval None
+  */
+void crash_init(void)
+{
+	// Give the configurable faults their own vectors, for a clearer record.
+	SCB->SHCSR |= SCB_SHCSR_USGFAULTENA | SCB_SHCSR_BUSFAULTENA | SCB_SHCSR_MEMFAULTENA;
+
+	// The supervisor stopped too, all we know is that it happened.
+	if (!crash_is_valid(&crash) && watchdog_caused_reset())
+	{
+		memset(&crash, 0, sizeof(crash));
+		crash.magic = CRASH_MAGIC;
+		crash.version = CRASH_VERSION;
+		crash.task = TASK_END;
+		crash.check = crash_checksum(&crash);
+	}
+
+	if (crash_is_valid(&crash))
+	{
+		uint32_t hdr[2];
+
+		eeprom_read(CRASH_EEPROM_BASE, sizeof(hdr), hdr);
+		crash.count = (hdr[0] == CRASH_MAGIC) ? (hdr[1] >> 16) + 1 : 1;
+		crash.check = crash_checksum(&crash);
+		eeprom_write(CRASH_EEPROM_BASE, sizeof(crash), &crash);
+		gui_popup(GUI_MSG_FAULT_RESET, 0);
+	}
+	else
+	{
+		eeprom_read(CRASH_EEPROM_BASE, sizeof(crash), &crash);
+	}
+
+	crash_valid = crash_is_valid(&crash);
+
+	// Only save it once.
+	crash.magic = 0;
+}
+
+/**
+  * @brief  Get the last saved fault.
+  * @note
+  * @param  None
+  * @retval The record, or 0 if there is none.
+  */
+const CrashRecord *crash_get(void)
+{
+	return crash_valid ? &crash : 0;
+}
+
+/**
+  * @brief  Fill in the record and reset.
+  * @note	Called from the fault handlers with the exception frame.
+  * @param  frame: Stacked r0-r3, r12, lr, pc, xPSR
+  * @param  exc_return: lr on entry to the handler
+  * @retval None
+  */
+void crash_capture(uint32_t *frame, uint32_t exc_return)
+{
+	uint32_t *sp;
+	uint8_t i;
+
+	memset(&crash, 0, sizeof(crash));
+	crash.magic = CRASH_MAGIC;
+	crash.version = CRASH_VERSION;
+	crash.exception = __get_IPSR() & 0x1FF;
+	crash.exc_return = exc_return;
+	crash.cfsr = SCB->CFSR;
+	crash.hfsr = SCB->HFSR;
+	crash.mmfar = SCB->MMFAR;
+	crash.bfar = SCB->BFAR;
+	crash.ticks = system_ticks;
+	crash.stalled = crash_stalled;
+	crash.task = task_current();
+
+	// A bad stack pointer would fault again (and lock up) here.
+	if ((uint32_t) frame >= SRAM_BASE && (uint32_t) frame <= CRASH_RAM_END - 8 * 4 &&
+			((uint32_t) frame & 3) == 0)
+	{
+		memcpy(&crash.r0, frame, 8 * 4);
+
+		// The core adds a padding word if it had to align the stack.
+		sp = frame + 8 + ((frame[7] >> 9) & 1);
+		crash.sp = (uint32_t) sp;
+
+		for (i = 0; i < CRASH_STACK_WORDS && (uint32_t) sp < CRASH_RAM_END; sp++)
+		{
+			// Thumb return addresses are odd.
+			if ((*sp & 1) && *sp >= FLASH_BASE && *sp < CRASH_FLASH_END)
+				crash.stack[i++] = *sp;
+		}
+	}
+
+	crash.check = crash_checksum(&crash);
+
+	NVIC_SystemReset();
+	while (1) {}
+}
+
+/**
+  * @brief  Record a lockup and reset.
+  * @note	Called by the watchdog supervisor. PendSV preempts the stuck
+  *         context, so the record shows where it was.
+  * @param  stalled: WATCHDOG_* sources that stopped beating
+  * @retval None
+  */
+void crash_watchdog(uint8_t stalled)
+{
+	crash_stalled = stalled;
+	SCB->ICSR = SCB_ICSR_PENDSVSET;
+}
+
+/* Pass the active stack pointer and EXC_RETURN on to crash_capture(). */
+void HardFault_Handler(void) __attribute__((naked));
+void HardFault_Handler(void)
+{
+	__asm volatile
+	(
+		" tst lr, #4            \n"
+		" ite eq                \n"
+		" mrseq r0, msp         \n"
+		" mrsne r0, psp         \n"
+		" mov r1, lr            \n"
+		" b crash_capture       \n"
+	);
+}
+
+void MemManage_Handler(void) __attribute__((alias("HardFault_Handler")));
+void BusFault_Handler(void) __attribute__((alias("HardFault_Handler")));
+void UsageFault_Handler(void) __attribute__((alias("HardFault_Handler")));
+void PendSV_Handler(void) __attribute__((alias("HardFault_Handler")));
@@ -0,0 +1,69 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _CRASH_H
+#define _CRASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "recorder.h"
+
+/*
+ * Post-mortem record (shared with tools/crashdecode.c).
+ * Filled in by the fault handlers in RAM that survives the reset, then
+ * saved to EEPROM on the next boot. Little endian, as on the target.
+ *
+ * stack[] holds the words found above the exception frame that look like
+ * return addresses into flash, innermost first. There are no frame
+ * pointers, so it can contain stale entries.
+ *
+ * Lockups found by the watchdog supervisor are recorded from PendSV
+ * (exception 14) with the WATCHDOG_* bits of the silent sources in
+ * stalled. Exception 0 means the IWDG itself reset the radio, with no
+ * context saved.
+ */
+#define CRASH_MAGIC			0x48535243	// "CRSH"
+#define CRASH_VERSION		2
+#define CRASH_STACK_WORDS	8
+
+#define CRASH_EEPROM_SIZE	128
+#define CRASH_EEPROM_BASE	(RECORDER_EEPROM_BASE - CRASH_EEPROM_SIZE)
+
+// RAM not cleared at startup, the .noinit section from noinit.ld.
+#define CRASH_NOINIT		__attribute__((section(".noinit")))
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t count;			// Faults saved since the EEPROM was formatted
+	uint32_t exception;		// Exception number (3 = HardFault ... 6 = UsageFault)
+	uint32_t r0, r1, r2, r3, r12, lr, pc, psr;	// Stacked by the core
+	uint32_t exc_return;
+	uint32_t sp;			// Stack pointer before the exception
+	uint32_t cfsr, hfsr, mmfar, bfar;
+	uint32_t ticks;			// system_ticks at the fault
+	uint16_t stalled;		// WATCHDOG_* sources that stopped
+	uint16_t task;			// Task running (TASK_END if none)
+	uint32_t stack[CRASH_STACK_WORDS];
+	uint32_t check;
+} CrashRecord;
+
+void crash_init(void);
+const CrashRecord *crash_get(void);
+uint32_t crash_checksum(const CrashRecord *rec);
+void crash_watchdog(uint8_t stalled);
+
+#endif // _CRASH_H
@@ -15,90 +15,681 @@
 
 /* Description:
  *
- * This is an IRQ driven EEPROM driver (including I2C).
+ * Settings and model storage on top of the storage backend (storage.h).
  *
- * The 8KB is split into 4 blocks of 2KB.
- * The 2KB blocks are cycled between when writing new data.
- * Each block has a checksum. If the checksum fails, the previous block is used.
+ * Layout: general settings, two copies of the model index, then a pool of
+ * pages holding the compressed models, then the flight recorder dump.
  *
  */
 
-#include <stm32f10x.h>
-#include <stm32f10x_i2c.h>
-#include <stm32f10x_dma.h>
-#include <stm32f10x_exti.h>
-#include <stm32f10x_gpio.h>
-#include <stm32f10x_rcc.h>
-#include <stm32f10x_misc.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "eeprom.h"
+#include "storage.h"
 #include "myeeprom.h"
 #include "gui.h"
 #include "lcd.h"
 #include "tasks.h"
+#include "recorder.h"
+#include "crash.h"
+#include "modelimg.h"
+#include "mixer.h"
+#include "watchdog.h"
 
 // forwards
-void eeprom_wait_complete(void);
 uint16_t eeprom_calc_chksum(void *buffer, uint16_t length);
 void eeprom_process(uint32_t data);
-void eeprom_read(uint16_t offset, uint16_t length, void *buffer);
-void eeprom_write(uint16_t offset, uint16_t length, void *buffer);
+static bool legacy_find(void);
 
 #define EEPROM_PAGE_SIZE 32
 #define EEPROM_PAGE_MASK 0xFFE0
 
-#define I2C_PINS	(1 << 6 | 1 << 7)
+// locals
 
-#define EEPROM_ADDR 0xA0
+static volatile uint8_t currModel = 0xFF;
 
-typedef enum _state {
-	STATE_IDLE,
-	STATE_START,
-	STATE_ADDRESSED1,
-	STATE_ADDRESSED2,
-	STATE_RESTART,
-	STATE_TRANSFER_START,
-	STATE_TRANSFERRING,
-	STATE_COMPLETING,
-	STATE_COMPLETE,
-	STATE_ERROR
-} STATE;
+/*
+ * Models are stored as compressed images (see modelimg.h) in a pool of
+ * EEPROM pages. An index after the general settings gives the first page
+ * and length of each model. A saved model is written to free pages before
+ * the index is updated, so an interrupted save leaves the old copy intact.
+ * A save that does not fit beside the old copy is refused.
+ *
+ * The index is written to its two copies in turn, each with a sequence
+ * number, so a torn index write still leaves the previous one. The
+ * addresses are fixed, EEGeneral can grow up to MODEL_INDEX_ADDR.
+ *
+ * Trims are saved as part of the model image, once they have been left
+ * alone for a while (mixer_trim_pending()). There is deliberately no
+ * separate trim record: every reader of a stored model (model select,
+ * model reads, serial backup and copy) would have to merge it in, and the
+ * index written with each save is as hot a page as the record would be.
+ */
+#define MODEL_INDEX_MAGIC	0x4958	// "XI"
+#define MODEL_INDEX_ADDR	256
+#define MODEL_INDEX_SIZE	128		// Per copy
+#define MODEL_POOL_ADDR		(MODEL_INDEX_ADDR + 2 * MODEL_INDEX_SIZE)
+// The fault record and flight recorder dump live in the space after the model pool.
+#define MODEL_POOL_PAGES	((CRASH_EEPROM_BASE - MODEL_POOL_ADDR) / EEPROM_PAGE_SIZE)
+#define PAGES(length)		(((length) + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE)
+
+PACK(typedef struct t_ModelSlot {
+	uint8_t page;		// First page in the pool
+	uint16_t length;	// Image length, 0 = empty
+}) ModelSlot;
+
+PACK(typedef struct t_ModelIndex {
+	uint16_t magic;
+	uint16_t seq;		// Newest valid copy wins
+	uint16_t legacy;	// Old layout models still to convert, LEGACY_GENERAL
+	uint8_t staged;		// Old model in slot B, LEGACY_NONE
+	ModelSlot slot[MAX_MODELS];
+	uint16_t seqEnd;	// seq again, a torn write leaves the old one
+	uint16_t chkSum;
+}) ModelIndex;
 
+/*
+ * Before the pool, general settings were followed by MAX_MODELS (15 then)
+ * fixed slots of a page rounded ModelData. Found by checksum when there is
+ * no index and converted into the pool, see legacy_find(). Model 0 and the
+ * settings are in the way of the index, they are first copied to slots A
+ * and B at the end of the EEPROM. Once the settings are converted each
+ * other model is copied to slot B before its old pages are reused. The
+ * crash record and flight recorder dump there are not in use yet.
+ */
+#define LEGACY_LAYOUT		(EEPROM_SIZE >= 8192)
+#define LEGACY_MODELS		15
+#define LEGACY_GENERAL_SIZE	83		// No calLin, recorderRate, stickDeadband
+#define LEGACY_MODEL_SIZE	450		// int8_t trim, no failsafe
+#define LEGACY_MODEL_ADDR(i)	(96 + (i) * 480)
+#define LEGACY_STAGE_A		(EEPROM_SIZE - 2 * LEGACY_MODEL_SIZE)
+#define LEGACY_STAGE_B		(EEPROM_SIZE - LEGACY_MODEL_SIZE)
+#define LEGACY_GENERAL		0x8000	// ModelIndex.legacy: settings in slot B
+#define LEGACY_NONE		0xFF
+
+typedef char eeprom_general_fits[(sizeof(EEGeneral) <= MODEL_INDEX_ADDR) ? 1 : -1];
+typedef char eeprom_index_fits[(sizeof(ModelIndex) <= MODEL_INDEX_SIZE) ? 1 : -1];
+typedef char eeprom_pool_pages_fit[(MODEL_POOL_PAGES <= 255) ? 1 : -1];
+
+static ModelIndex model_index;
+static uint8_t model_index_copy;	// Copy model_index was last read from or written to
+
+// Image being written to the pool.
+static struct {
+	uint8_t model;
+	uint8_t page;
+	uint16_t length;
+	uint16_t pos;
+	uint8_t len;
+	bool overrun;		// More than length bytes were added
+	uint8_t buf[EEPROM_PAGE_SIZE];
+} writer;
 
-// locals
+/**
+ * @brief  Write the model index back to EEPROM
+ * @note   Goes to the copy not holding the current index.
+ * @retval None
+ */
+static void model_index_save(void) {
+	model_index.seq++;
+	model_index.seqEnd = model_index.seq;
+	model_index.chkSum = eeprom_calc_chksum(&model_index, sizeof(model_index) - 2);
+	model_index_copy ^= 1;
+	eeprom_write(MODEL_INDEX_ADDR + model_index_copy * MODEL_INDEX_SIZE,
+			sizeof(model_index), &model_index);
+}
 
-static volatile STATE state = STATE_ERROR;
-static volatile uint8_t read_write = 1;
-static volatile uint16_t addr = 0;
-static volatile DMA_InitTypeDef g_dmaInit;
-static volatile uint8_t currModel = 0xFF;
+/**
+ * @brief  Read one copy of the model index
+ * @param  copy - 0 or 1
+ * @retval true if it is valid
+ */
+static bool model_index_read(uint8_t copy) {
+	eeprom_read(MODEL_INDEX_ADDR + copy * MODEL_INDEX_SIZE, sizeof(model_index), &model_index);
+	return model_index.magic == MODEL_INDEX_MAGIC && model_index.seqEnd == model_index.seq &&
+			model_index.chkSum == eeprom_calc_chksum(&model_index, sizeof(model_index) - 2);
+}
+
+/**
+ * @brief  Read the newest valid model index, formatting the pool if neither copy is
+ * @retval None
+ */
+static void model_index_load(void) {
+	bool valid1 = model_index_read(1);
+	uint16_t seq1 = model_index.seq;
+	bool valid0 = model_index_read(0);
+
+	model_index_copy = 0;
+	// Sequence numbers wrap.
+	if (valid1 && (!valid0 || (int16_t)(seq1 - model_index.seq) > 0)) {
+		model_index_read(1);
+		model_index_copy = 1;
+	} else if (!valid0 && !legacy_find()) {
+		memset(&model_index, 0, sizeof(model_index));
+		model_index.magic = MODEL_INDEX_MAGIC;
+		model_index_save();
+	}
+
+	if (valid0 || valid1) {
+		// Drop models that run past the end of the pool.
+		uint8_t i;
+		for (i = 0; i < MAX_MODELS; i++) {
+			ModelSlot *s = &model_index.slot[i];
+			if (s->length && s->page + PAGES(s->length) > MODEL_POOL_PAGES)
+				s->length = 0;
+		}
+	}
+}
+
+/**
+ * @brief  Find a free run of pages
+ * @note   Pages of every stored model are in use, including the old copy
+ *         of the model being saved.
+ * @param  pages - number of pages needed
+ * @retval first page or -1 if there is no gap big enough
+ */
+static int16_t model_find_space(uint8_t pages) {
+	uint16_t candidate = 0;
+	uint16_t end;
+	uint8_t m;
+
+	while (candidate + pages <= MODEL_POOL_PAGES) {
+		end = 0;
+		for (m = 0; m < MAX_MODELS; m++) {
+			ModelSlot *s = &model_index.slot[m];
+			if (s->length == 0)
+				continue;
+			if (s->page < candidate + pages && candidate < s->page + PAGES(s->length)) {
+				end = s->page + PAGES(s->length);
+				break;
+			}
+		}
+#if LEGACY_LAYOUT
+		// Old models not converted yet, model 0 is in slot A.
+		for (m = 1; end == 0 && m < LEGACY_MODELS; m++) {
+			uint16_t first = (LEGACY_MODEL_ADDR(m) - MODEL_POOL_ADDR) / EEPROM_PAGE_SIZE;
+			uint16_t last = PAGES(LEGACY_MODEL_ADDR(m) + LEGACY_MODEL_SIZE - MODEL_POOL_ADDR);
+			if ((model_index.legacy & (1 << m)) && first < candidate + pages && candidate < last)
+				end = last;
+		}
+#endif
+		if (end == 0)
+			return candidate;
+		// Overlaps a model, try again just after it.
+		candidate = end;
+	}
+	return -1;
+}
+
+/**
+ * @brief  Move the models towards the start of the pool
+ * @note   Slow, only needed when the free space is fragmented. A model is
+ *         only moved to pages clear of its old ones, so the index always
+ *         points at a whole image. One that would overlap stays put.
+ * @retval None
+ */
+static void model_compact(void) {
+	uint8_t buf[EEPROM_PAGE_SIZE];
+	uint8_t cursor = 0;
+
+	for (;;) {
+		ModelSlot *next = 0;
+		uint8_t m, p, pages;
+
+		// Lowest model not yet packed.
+		for (m = 0; m < MAX_MODELS; m++) {
+			ModelSlot *s = &model_index.slot[m];
+			if (s->length != 0 && s->page >= cursor &&
+					(next == 0 || s->page < next->page))
+				next = s;
+		}
+		if (next == 0)
+			break;
+
+		pages = PAGES(next->length);
+		if (cursor + pages <= next->page) {
+			for (p = 0; p < pages; p++) {
+				eeprom_read(MODEL_POOL_ADDR + (next->page + p) * EEPROM_PAGE_SIZE,
+						EEPROM_PAGE_SIZE, buf);
+				eeprom_write(MODEL_POOL_ADDR + (cursor + p) * EEPROM_PAGE_SIZE,
+						EEPROM_PAGE_SIZE, buf);
+			}
+			next->page = cursor;
+			model_index_save();
+		}
+		cursor = next->page + pages;
+	}
+}
+
+/**
+ * @brief  Choose where to write a model image
+ * @note   The old copy of the model is kept until the new one is committed.
+ * @param  length - image length
+ * @retval first page or -1 if the pool is full
+ */
+static int16_t model_allocate(uint16_t length) {
+	uint8_t pages = PAGES(length);
+	int16_t page;
+
+	page = model_find_space(pages);
+	// Compacting could move a model over an old one still to convert.
+	if (page >= 0 || model_index.legacy)
+		return page;
+
+	model_compact();
+	return model_find_space(pages);
+}
+
+/**
+ * @brief  Decode a stored model
+ * @param  model - model number
+ * @param  put - called with each byte of ModelData in order
+ * @param  ctx - passed to put
+ * @param  limit - stop once this many bytes of ModelData have been produced
+ * @retval MODELIMG_DONE if the whole model was decoded
+ */
+static MODELIMG_STATUS model_decode(uint8_t model, void (*put)(uint8_t, void*), void *ctx,
+		uint16_t limit) {
+	ModelSlot *s = &model_index.slot[model];
+	ModelImgDecoder dec;
+	MODELIMG_STATUS status = MODELIMG_ERROR;
+	uint8_t buf[EEPROM_PAGE_SIZE];
+	uint16_t done;
+
+	modelimg_decode_start(&dec, put, ctx);
+	for (done = 0; done < s->length && dec.pos < limit; done += EEPROM_PAGE_SIZE) {
+		uint16_t size = s->length - done;
+		if (size > EEPROM_PAGE_SIZE)
+			size = EEPROM_PAGE_SIZE;
+		eeprom_read(MODEL_POOL_ADDR + s->page * EEPROM_PAGE_SIZE + done, size, buf);
+		status = modelimg_decode(&dec, buf, size);
+		if (status != MODELIMG_MORE)
+			break;
+	}
+	return status;
+}
+
+/**
+ * @brief  Encoder callback that only counts the image length
+ */
+static void model_put_count(uint8_t b, void *ctx) {
+	(*(uint16_t*)ctx)++;
+}
+
+/**
+ * @brief  Encoder callback that writes the image to the pool a page at a time
+ */
+static void model_put_writer(uint8_t b, void *ctx) {
+	// Never past the pages allocated for the image.
+	if (writer.pos + writer.len >= writer.length) {
+		writer.overrun = true;
+		return;
+	}
+	writer.buf[writer.len++] = b;
+	if (writer.len == EEPROM_PAGE_SIZE) {
+		eeprom_write(MODEL_POOL_ADDR + writer.page * EEPROM_PAGE_SIZE + writer.pos,
+				EEPROM_PAGE_SIZE, writer.buf);
+		writer.pos += EEPROM_PAGE_SIZE;
+		writer.len = 0;
+	}
+}
+
+/**
+ * @brief  Decoder callback that sums ModelData the way eeprom_calc_chksum() does
+ */
+static void model_put_sum(uint8_t b, void *ctx) {
+	ModelImgWindow *w = ctx;
+	if (w->pos < sizeof(ModelData) - 2)
+		w->start += b;
+	w->pos++;
+}
+
+/**
+ * @brief  Start writing a model image to the pool
+ * @param  model - model number
+ * @param  length - image length
+ * @retval false if the pool is full
+ */
+bool eeprom_model_image_begin(uint8_t model, uint16_t length) {
+	int16_t page = model_allocate(length);
+	if (page < 0)
+		return false;
+	writer.model = model;
+	writer.page = page;
+	writer.length = length;
+	writer.pos = 0;
+	writer.len = 0;
+	writer.overrun = false;
+	return true;
+}
+
+/**
+ * @brief  Add image bytes started by eeprom_model_image_begin()
+ * @retval None
+ */
+void eeprom_model_image_append(const uint8_t *data, uint16_t length) {
+	while (length--)
+		model_put_writer(*data++, 0);
+}
+
+/**
+ * @brief  Finish the image and point the index at it
+ * @note   If this is the current model it is reloaded by the next eeprom_process()
+ * @retval false if the image was not the length given to begin, the old
+ *         copy is then kept
+ */
+bool eeprom_model_image_commit(void) {
+	if (writer.overrun || writer.pos + writer.len != writer.length) {
+		eeprom_model_image_abort();
+		return false;
+	}
+	if (writer.len)
+		eeprom_write(MODEL_POOL_ADDR + writer.page * EEPROM_PAGE_SIZE + writer.pos,
+				writer.len, writer.buf);
+	writer.len = 0;
+	model_index.slot[writer.model].page = writer.page;
+	model_index.slot[writer.model].length = writer.length;
+	model_index_save();
+	if (writer.model == currModel)
+		currModel = 0xFF;
+	return true;
+}
+
+/**
+ * @brief  Give up on an image
+ * @note   The index still points at the old copy.
+ * @retval None
+ */
+void eeprom_model_image_abort(void) {
+	writer.len = 0;
+}
+
+/**
+ * @brief  Remove a stored model
+ * @param  model - model number
+ * @retval true
+ */
+bool eeprom_model_image_clear(uint8_t model) {
+	model_index.slot[model].length = 0;
+	model_index_save();
+	if (model == currModel)
+		currModel = 0xFF;
+	return true;
+}
+
+/**
+ * @brief  Read part of a stored model's image
+ * @param  model - model number, 0..MAX_MODELS-1
+ * @param  offset - byte offset within the image
+ * @param  length - number of bytes wanted
+ * @param  buffer - destination buffer
+ * @retval full image length, 0 for an empty slot
+ */
+uint16_t eeprom_read_model_image(uint8_t model, uint16_t offset, uint16_t length, void *buffer) {
+	ModelSlot *s = &model_index.slot[model];
+	if (offset < s->length) {
+		if (length > s->length - offset)
+			length = s->length - offset;
+		eeprom_read(MODEL_POOL_ADDR + s->page * EEPROM_PAGE_SIZE + offset, length, buffer);
+	}
+	return s->length;
+}
+
+/**
+ * @brief  Save g_model
+ * @note   The mixer IRQ changes the trims and offsets, so the caller holds
+ *         it off g_model (mixer_hold_model()) while it is measured and
+ *         encoded.
+ * @param  model - model number to save it as
+ * @retval false if the pool is full or the image came out a different
+ *         length than measured, the old copy is then kept
+ */
+static bool eeprom_save_model(uint8_t model) {
+	ModelImgEncoder enc;
+	uint16_t length = 0;
+	uint8_t loaded = currModel;
+
+	// Measure first so the image can be placed in one go.
+	modelimg_encode_start(&enc, model_put_count, &length);
+	modelimg_encode(&enc, (const uint8_t*) &g_model, sizeof(g_model));
+	modelimg_encode_end(&enc);
+
+	if (!eeprom_model_image_begin(model, length)) {
+		gui_popup(GUI_MSG_EEPROM_FULL, 0);
+		return false;
+	}
+	modelimg_encode_start(&enc, model_put_writer, 0);
+	modelimg_encode(&enc, (const uint8_t*) &g_model, sizeof(g_model));
+	modelimg_encode_end(&enc);
+
+	if (!eeprom_model_image_commit()) {
+		gui_popup(GUI_MSG_EEPROM_WRITE, 0);
+		return false;
+	}
+	// g_model is what was just written, no need to reload it.
+	currModel = loaded;
+	return true;
+}
+
+#if LEGACY_LAYOUT
+typedef char eeprom_legacy_fits[(LEGACY_MODEL_ADDR(LEGACY_MODELS - 1) + LEGACY_MODEL_SIZE <= LEGACY_STAGE_A &&
+		LEGACY_MODEL_ADDR(1) >= MODEL_POOL_ADDR) ? 1 : -1];
+typedef char eeprom_legacy_general[(offsetof(EEGeneral, recorderRate) ==
+		LEGACY_GENERAL_SIZE - 2 + sizeof(g_eeGeneral.calLin)) ? 1 : -1];
+typedef char eeprom_legacy_model[(offsetof(ModelData, failsafe) - offsetof(ModelData, curves5) +
+		sizeof(ModelData) - offsetof(ModelData, failsafe) - sizeof(g_model.failsafe) +
+		offsetof(ModelData, trim) + 4 == LEGACY_MODEL_SIZE) ? 1 : -1];
+
+/**
+ * @brief  Copy a block of EEPROM a page at a time
+ * @retval None
+ */
+static void legacy_copy(uint16_t from, uint16_t to, uint16_t length) {
+	uint8_t buf[EEPROM_PAGE_SIZE];
+	uint16_t size;
+
+	for (; length; length -= size, from += size, to += size) {
+		size = (length > EEPROM_PAGE_SIZE) ? EEPROM_PAGE_SIZE : length;
+		eeprom_read(from, size, buf);
+		eeprom_write(to, size, buf);
+	}
+}
+
+/**
+ * @brief  Read old layout settings into g_eeGeneral
+ * @note   calLin is left linear, recorderRate and stickDeadband at their defaults.
+ * @param  addr - EEPROM address
+ * @retval true if the checksum matched
+ */
+static bool legacy_read_general(uint16_t addr) {
+	uint8_t *g = (uint8_t*) &g_eeGeneral;
+	uint16_t chksum;
 
-#define PAGE_ALIGN 1
+	eeprom_read(addr, offsetof(EEGeneral, calLin), g);
+	eeprom_read(addr + offsetof(EEGeneral, calLin), LEGACY_GENERAL_SIZE - offsetof(EEGeneral, calLin),
+			g + offsetof(EEGeneral, calLin) + sizeof(g_eeGeneral.calLin));
+	memcpy(&chksum, g + offsetof(EEGeneral, recorderRate), sizeof(chksum));
+	memset((void*)g_eeGeneral.calLin, 0, sizeof(g_eeGeneral.calLin));
+	if (chksum != eeprom_calc_chksum(g, offsetof(EEGeneral, recorderRate)))
+		return false;
+	g_eeGeneral.recorderRate = RECORDER_DEFAULT_RATE;
+	g_eeGeneral.stickDeadband = 0;
+	g_eeGeneral.chkSum = eeprom_calc_chksum((void*)&g_eeGeneral, sizeof(EEGeneral) - 2);
+	return true;
+}
+
+/**
+ * @brief  Read an old layout model into g_model
+ * @note   Trims are widened to the new scale, keeping their effect.
+ *         Failsafe comes from g_modelDefaults. The checksum is the sum of
+ *         the old bytes, so it is taken over the pieces where they land.
+ * @param  addr - EEPROM address
+ * @retval true if the checksum matched
+ */
+static bool legacy_read_model(uint16_t addr) {
+	uint8_t *m = (uint8_t*) &g_model;
+	const uint16_t trim = offsetof(ModelData, trim);
+	const uint16_t middle = offsetof(ModelData, failsafe) - offsetof(ModelData, curves5);
+	const uint16_t tail = offsetof(ModelData, failsafe) + sizeof(g_model.failsafe);
+	int8_t trims[4];
+	uint16_t chksum;
+	uint8_t i;
+
+	eeprom_read(addr, trim, m);
+	eeprom_read(addr + trim, sizeof(trims), trims);
+	eeprom_read(addr + trim + sizeof(trims), middle, m + offsetof(ModelData, curves5));
+	eeprom_read(addr + trim + sizeof(trims) + middle, sizeof(ModelData) - tail, m + tail);
+
+	chksum = eeprom_calc_chksum(m, trim) + eeprom_calc_chksum(trims, sizeof(trims)) +
+			eeprom_calc_chksum(m + trim + sizeof(g_model.trim), sizeof(ModelData) - 2 - trim - sizeof(g_model.trim)) -
+			eeprom_calc_chksum(m + offsetof(ModelData, failsafe), sizeof(g_model.failsafe));
+	// An all zero slot sums up too.
+	if (chksum != g_model.chkSum || g_model.name[0] == 0)
+		return false;
+
+	// Ordinary trims were applied doubled, now as they are. The throttle
+	// idle trim had twice the effect of an ordinary one and now has half,
+	// so it takes four times the old value to keep the idle point.
+	for (i = 0; i < 4; i++)
+		g_model.trim[i] = trims[i] * ((IS_THROTTLE(i) && g_model.thrTrim) ? 4 : 2);
+	if (g_model.trimInc >= TRIM_INC_MAX)
+		g_model.trimInc = g_modelDefaults.trimInc;
+	memcpy((void*)g_model.failsafe, g_modelDefaults.failsafe, sizeof(g_model.failsafe));
+	g_model.chkSum = eeprom_calc_chksum(m, sizeof(ModelData) - 2);
+	return true;
+}
 
 /**
- * @brief  compute given model's address in eeprom
- * @note rounds up to the nearest eeprom page
- * @param  modelNumber
- * @retval eeprom address for model
+ * @brief  Look for old layout models, called when neither index copy is valid
+ * @note   Nothing the old layout uses is overwritten until model 0 and the
+ *         settings are in slots A and B. A copy of model 0 left in slot A
+ *         by an interrupted try is used once the original is gone.
+ * @retval true if any were found, the index then lists them
  */
-static uint16_t model_address(uint8_t modelNumber) {
-	if( modelNumber > MAX_MODELS - 1 )
-		modelNumber = MAX_MODELS - 1;
-#if PAGE_ALIGN
-	const uint16_t modelAddressBase =
-			(sizeof(EEGeneral) + EEPROM_PAGE_SIZE - 1) & EEPROM_PAGE_MASK;
-	const uint16_t modelSizePageRoundup =
-			(sizeof(ModelData) + EEPROM_PAGE_SIZE - 1) & EEPROM_PAGE_MASK;
-	uint16_t modelAddress =
-			modelAddressBase + modelNumber * modelSizePageRoundup;
+static bool legacy_find(void) {
+	uint16_t legacy = 0;
+	uint8_t i;
+
+	if (legacy_read_model(LEGACY_MODEL_ADDR(0)))
+		legacy_copy(LEGACY_MODEL_ADDR(0), LEGACY_STAGE_A, LEGACY_MODEL_SIZE);
+	if (legacy_read_model(LEGACY_STAGE_A))
+		legacy |= 1;
+	for (i = 1; i < LEGACY_MODELS; i++)
+		if (legacy_read_model(LEGACY_MODEL_ADDR(i)))
+			legacy |= 1 << i;
+	if (legacy_read_general(0)) {
+		legacy_copy(0, LEGACY_STAGE_B, LEGACY_GENERAL_SIZE);
+		legacy |= LEGACY_GENERAL;
+	}
+	if (legacy == 0)
+		return false;
+
+	memset(&model_index, 0, sizeof(model_index));
+	model_index.magic = MODEL_INDEX_MAGIC;
+	model_index.legacy = legacy;
+	model_index.staged = LEGACY_NONE;
+	model_index_save();
+	return true;
+}
+
+/**
+ * @brief  Move the models found by legacy_find() into the pool
+ * @note   Each step is saved in the index, so a power cut resumes where it
+ *         stopped. Model 0 goes last, it needs space freed by the others.
+ *         A model that does not fit is dropped.
+ * @retval None
+ */
+static void legacy_convert(void) {
+	// Which trim is the throttle depends on the stick mode. Resumed after
+	// the settings were converted, they are only in their new place.
+	if (model_index.legacy && !(model_index.legacy & LEGACY_GENERAL))
+		eeprom_read(0, sizeof(EEGeneral), (void*)&g_eeGeneral);
+
+	while (model_index.legacy) {
+		uint8_t i;
+		uint16_t addr;
+
+		watchdog_heartbeat(WATCHDOG_MAIN);
+		if (model_index.legacy & LEGACY_GENERAL) {
+			if (legacy_read_general(LEGACY_STAGE_B))
+				eeprom_write(0, sizeof(EEGeneral), (void*)&g_eeGeneral);
+			model_index.legacy &= ~LEGACY_GENERAL;
+			model_index_save();
+			continue;
+		}
+
+		for (i = 1; i < LEGACY_MODELS && !(model_index.legacy & (1 << i)); i++)
+			;
+		if (i == LEGACY_MODELS) {
+			i = 0;
+			addr = LEGACY_STAGE_A;
+		} else {
+			addr = LEGACY_STAGE_B;
+			if (model_index.staged != i) {
+				legacy_copy(LEGACY_MODEL_ADDR(i), LEGACY_STAGE_B, LEGACY_MODEL_SIZE);
+				model_index.staged = i;
+				model_index_save();
+			}
+		}
+
+		// Its old pages are free now, the index saved with the image says it is done.
+		model_index.legacy &= ~(1 << i);
+		model_index.staged = LEGACY_NONE;
+		if (!legacy_read_model(addr)) {
+			gui_popup(GUI_MSG_EEPROM_WRITE, 0);
+			model_index_save();
+		} else if (!eeprom_save_model(i)) {
+			model_index_save();
+		}
+	}
+}
 #else
-	uint16_t modelAddress =
-			sizeof(EEGeneral) + modelNumber * sizeof(ModelData);
+static bool legacy_find(void) {
+	return false;
+}
 #endif
-	return modelAddress;
+
+/**
+ * @brief  Checksum a stored model by decoding it
+ * @param  model - model number
+ * @retval checksum of everything but chkSum, as eeprom_calc_chksum()
+ */
+static uint16_t model_checksum(uint8_t model) {
+	ModelImgWindow sum;
+	// No buffer, start is reused as the running sum.
+	modelimg_window_init(&sum, 0, 0, 0);
+	model_decode(model, model_put_sum, &sum, sizeof(ModelData));
+	return sum.start;
 }
 
+#define DEFAULT_MIX(ch)	{ .srcRaw = ch, .weight = 100, .destCh = ch, .mltpx = MLTPX_REP }
+// in mixer.c there was +/- 100 on limits which I have removed
+// so now the min/max are true values (no offsets)
+#define DEFAULT_LIMIT	{ .min = -100, .max = 100 }
+
+typedef char eeprom_defaults_cover_all_channels[(NUM_CHNOUT == 8) ? 1 : -1];
+
+/**
+ * Defaults for a new model, kept in flash.
+ * Everything not listed is zero. Also used as the reference for model images.
+ */
+const ModelData g_modelDefaults = {
+	.name = "MODEL    ",
+	.protocol = PROTO_PPM,
+	.extendedLimits = true,
+	.ppmFrameLength = 8,
+	.ppmDelay = 6,
+	.ppmNCH = 8,
+	.mixData = {
+		DEFAULT_MIX(1), DEFAULT_MIX(2), DEFAULT_MIX(3), DEFAULT_MIX(4),
+		DEFAULT_MIX(5), DEFAULT_MIX(6), DEFAULT_MIX(7), DEFAULT_MIX(8),
+	},
+	.limitData = {
+		DEFAULT_LIMIT, DEFAULT_LIMIT, DEFAULT_LIMIT, DEFAULT_LIMIT,
+		DEFAULT_LIMIT, DEFAULT_LIMIT, DEFAULT_LIMIT, DEFAULT_LIMIT,
+	},
+};
 
 /**
  * @brief  Initialize model data in global g_model
@@ -106,44 +697,17 @@ static uint16_t model_address(uint8_t modelNumber) {
  * @retval None
  */
 void eeprom_init_current_model() {
-	memset((void*)&g_model, 0, sizeof(g_model));
+	memcpy((void*)&g_model, &g_modelDefaults, sizeof(g_model));
 #if FRUGAL
 	g_model.name[0] = 'M';
 	g_model.name[1] = '0' + (g_eeGeneral.currModel / 10);
 	g_model.name[2] = '0' + (g_eeGeneral.currModel % 10);
+	g_model.name[3] = 0;
 #else
-	memcpy(&g_model.name, "MODEL    ", sizeof(g_model.name));
 	g_model.name[MODEL_NAME_LEN-3] = '0' + (g_eeGeneral.currModel / 10);
 	g_model.name[MODEL_NAME_LEN-2] = '0' + (g_eeGeneral.currModel % 10);
 #endif
 	g_model.name[MODEL_NAME_LEN-1] =  0;
-	g_model.protocol = PROTO_PPM;
-	g_model.extendedLimits = true;
-	g_model.ppmFrameLength = 8;
-	g_model.ppmDelay = 6;
-	g_model.ppmNCH = 8;
-	for(int mx=0; mx < NUM_CHNOUT; mx++)
-	{
-		MixData* md = &g_model.mixData[mx];
-		md->destCh = mx+1;
-		md->srcRaw = mx+1;
-		md->mltpx = MLTPX_REP;
-		md->weight = 100;
-	}
-	for(int l=0; l < sizeof(g_model.limitData)/sizeof(g_model.limitData[0]); l++)
-	{
-		LimitData *p = &g_model.limitData[l];
-		// in mixer.c there was +/- 100 on limits which I have removed
-		// so now the min/max are true values (no offsets)
-		p->min = -100;
-		p->max =  100;
-		//p->offset = 0;
-		//p->reverse = 0;
-	}
-
-	// already initialized to zero
-	//g_model.ppmStart = 0;
-	//g_model.pulsePol = 0;
 }
 
 /**
@@ -156,9 +720,12 @@ void eeprom_load_current_model() {
 		g_eeGeneral.currModel = MAX_MODELS-1;
 	// prevent others to use model data as it may be invalid for a moment
 	g_modelInvalid = 1;
-	eeprom_read( model_address(g_eeGeneral.currModel), sizeof(g_model), (void*)&g_model);
+	ModelImgWindow w;
+	modelimg_window_init(&w, 0, (void*)&g_model, sizeof(g_model));
+	MODELIMG_STATUS status = model_decode(g_eeGeneral.currModel, modelimg_put_window, &w,
+			sizeof(g_model));
 	uint16_t chksum = eeprom_calc_chksum((void*) &g_model, sizeof(g_model) - 2);
-	if (chksum != g_model.chkSum) {
+	if (status != MODELIMG_DONE || chksum != g_model.chkSum) {
 		eeprom_init_current_model();
 		// set the checksum so the empty model does not get saved
 		g_model.chkSum = eeprom_calc_chksum((void*) &g_model, sizeof(g_model) - 2);
@@ -173,14 +740,35 @@ void eeprom_load_current_model() {
 
 /**
  * @brief  Read given model's name into supplied buffer
+ * @note   Only the start of the image is decoded.
  * @param model - model number, 0..MAX_MODELS-1
  * @param buf - buffer to read model into
  * @retval None
  */
 void eeprom_read_model_name(char model, char buf[MODEL_NAME_LEN]) {
-	 model = model < MAX_MODELS ? model : MAX_MODELS-1;
-	 eeprom_read( model_address(model)+offsetof(ModelData, name), MODEL_NAME_LEN, buf );
-	 buf[MODEL_NAME_LEN-1]=0;
+	model = model < MAX_MODELS ? model : MAX_MODELS-1;
+	eeprom_read_model_data(model, offsetof(ModelData, name), MODEL_NAME_LEN, buf);
+	if (model_index.slot[(uint8_t)model].length == 0) {
+		buf[MODEL_NAME_LEN-3] = '0' + (model / 10);
+		buf[MODEL_NAME_LEN-2] = '0' + (model % 10);
+	}
+	buf[MODEL_NAME_LEN-1]=0;
+}
+
+/**
+ * @brief  Read part of a stored model
+ * @note   An empty slot reads as g_modelDefaults.
+ * @param model - model number, 0..MAX_MODELS-1
+ * @param offset - byte offset within ModelData
+ * @param length - number of bytes
+ * @param buffer - destination buffer
+ * @retval None
+ */
+void eeprom_read_model_data(uint8_t model, uint16_t offset, uint16_t length, void *buffer) {
+	ModelImgWindow w;
+	memcpy(buffer, (const uint8_t*) &g_modelDefaults + offset, length);
+	modelimg_window_init(&w, offset, buffer, length);
+	model_decode(model, modelimg_put_window, &w, offset + length);
 }
 
 /**
@@ -215,83 +803,21 @@ unsigned eeprom_checksum_memory(uint16_t offset, uint16_t length) {
 }
 
 /**
- * @brief  Initialise the I2C bus and EEPROM.
+ * @brief  Initialise the storage and load the settings.
  * @note
  * @param  None
  * @retval None
  */
 void eeprom_init(void) {
-	I2C_InitTypeDef i2cInit;
-	GPIO_InitTypeDef gpioInit;
-	NVIC_InitTypeDef nvicInit;
-	DMA_InitTypeDef dmaInit;
-
-	// Enable the I2C block clocks and setup the pins.
-	RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
-	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
-
-	GPIO_StructInit(&gpioInit);
-	gpioInit.GPIO_Speed = GPIO_Speed_2MHz;
-
-	// Configure the Column pins
-	gpioInit.GPIO_Pin = I2C_PINS;
-	gpioInit.GPIO_Mode = GPIO_Mode_AF_OD;
-	GPIO_SetBits(GPIOB, I2C_PINS);
-	GPIO_Init(GPIOB, &gpioInit);
-
-	I2C_DeInit(I2C1);
-
-	I2C_StructInit(&i2cInit);
-	i2cInit.I2C_ClockSpeed = 200000;
-	I2C_Init(I2C1, &i2cInit);
-	I2C_Cmd(I2C1, ENABLE);
-	I2C_DMACmd(I2C1, DISABLE);
-
-	// Configure the Interrupt to the lowest priority
-	nvicInit.NVIC_IRQChannelPreemptionPriority = 0x05;
-	nvicInit.NVIC_IRQChannelSubPriority = 0x00;
-	nvicInit.NVIC_IRQChannelCmd = ENABLE;
-	nvicInit.NVIC_IRQChannel = I2C1_EV_IRQn;
-	NVIC_Init(&nvicInit);
-	nvicInit.NVIC_IRQChannel = I2C1_ER_IRQn;
-	NVIC_Init(&nvicInit);
-
-	// Enable the TX and RX DMA channel IRQs
-	nvicInit.NVIC_IRQChannel = DMA1_Channel6_IRQn;
-	NVIC_Init(&nvicInit);
-	nvicInit.NVIC_IRQChannel = DMA1_Channel7_IRQn;
-	NVIC_Init(&nvicInit);
-
-	// Enable the event interrupt
-	I2C_ITConfig(I2C1, I2C_IT_EVT | I2C_IT_ERR | I2C_IT_BUF, ENABLE);
-
-	// DMA Configuration
-	DMA_DeInit(DMA1_Channel6);	// TX
-	DMA_DeInit(DMA1_Channel7);	// RX
-	DMA_ITConfig(DMA1_Channel6, DMA_IT_TC, ENABLE);
-	DMA_ITConfig(DMA1_Channel7, DMA_IT_TC, ENABLE);
-
-	DMA_StructInit(&dmaInit);
-	dmaInit.DMA_PeripheralBaseAddr = (uint32_t) &I2C1->DR;
-	dmaInit.DMA_DIR = DMA_DIR_PeripheralSRC;
-	dmaInit.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-	dmaInit.DMA_MemoryInc = DMA_MemoryInc_Enable;
-	dmaInit.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
-	dmaInit.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
-	dmaInit.DMA_Mode = DMA_Mode_Normal;
-	dmaInit.DMA_Priority = DMA_Priority_Medium;
-	dmaInit.DMA_M2M = DMA_M2M_Disable;
-	g_dmaInit = dmaInit;
-
-	I2C_DMACmd(I2C1, ENABLE);
-
-	I2C_AcknowledgeConfig(I2C1, ENABLE);
-
-	state = STATE_COMPLETE;
+	storage_init();
 
 	task_register(TASK_PROCESS_EEPROM, eeprom_process);
 
+	model_index_load();
+#if LEGACY_LAYOUT
+	legacy_convert();
+#endif
+
 	// Read the configuration data out of EEPROM.
 	eeprom_read(0, sizeof(EEGeneral), (void*)&g_eeGeneral);
 	uint16_t chksum = eeprom_calc_chksum((void*)&g_eeGeneral, sizeof(EEGeneral) - 2);
@@ -302,6 +828,9 @@ void eeprom_init(void) {
 		g_eeGeneral.contrast = (LCD_CONTRAST_MIN+LCD_CONTRAST_MAX)/2;
 		g_eeGeneral.enablePpmsim = false;
 		g_eeGeneral.vBatCalib = 100;
+		g_eeGeneral.recorderRate = RECORDER_DEFAULT_RATE;
+		g_eeGeneral.stickDeadband = 0;
+		memset((void*)g_eeGeneral.calLin, 0, sizeof(g_eeGeneral.calLin));
 		// memset(&g_eeGeneral, 0, sizeof(EEGeneral));
 		// rechecksum - otherwise it will overwrite
 		g_eeGeneral.chkSum = eeprom_calc_chksum((void*)&g_eeGeneral, sizeof(EEGeneral) - 2);
@@ -312,106 +841,40 @@ void eeprom_init(void) {
 }
 
 /**
- * @brief  Read a block of data from EEPROM.
+ * @brief  Read a block of data from storage.
  * @note
- * @param  offset: EEPROM start byte address
+ * @param  offset: byte address
  * @param  length: number of bytes
  * @param  buffer: Destination buffer pointer
  * @retval None
  */
 void eeprom_read(uint16_t offset, uint16_t length, void *buffer) {
-	//do we care here that prev transaction erred?
-	//if (state == STATE_ERROR)
-	//return;
-
-	eeprom_wait_complete();
-
-	addr = offset;
-	read_write = 1;
-
-	// Configure the DMA controller, but don't enable it yet.
-	g_dmaInit.DMA_MemoryBaseAddr = (uint32_t) buffer;
-	g_dmaInit.DMA_BufferSize = length;
-	g_dmaInit.DMA_DIR = DMA_DIR_PeripheralSRC;
-
-	state = STATE_IDLE;
-
-	// Start the I2C transactions.
-	I2C_GenerateSTART(I2C1, ENABLE);
-
-	// wait for the read to complete
-	eeprom_wait_complete();
+	storage_read(offset, length, buffer);
 }
 
 /**
- * @brief  Write a block of data to EEPROM.
- * @note
- * @param  offset: EEPROM start byte address
+ * @brief  Write a block of data to storage.
+ * @note   Shows a write indicator in the top left corner, 'E' and a popup
+ *         if it failed.
+ * @param  offset: byte address
  * @param  length: number of bytes
  * @param  buffer: Source buffer pointer
  * @retval None
  */
 void eeprom_write(uint16_t offset, uint16_t length, void *buffer) {
-	uint16_t written = 0;
-
-	//do we care here that prev transaction erred?
-	//if (state == STATE_ERROR)
-	//return;
+	bool ok;
 
 	lcd_set_cursor(0, 0);
 	lcd_write_char(0x05, LCD_OP_SET, FLAGS_NONE);
 	lcd_update();
 
-	// Make sure nothing else is pending
-	eeprom_wait_complete();
-
-	// We have to split the transfer into page writes.
-	while (written < length) {
-		addr = offset + written;
-		read_write = 0;
-
-		// Compute this write size but check to see if we need to round up to a page.
-		// Check only on first write when written==0
-		uint16_t towrite = EEPROM_PAGE_SIZE;
-		if (written == 0 && offset % EEPROM_PAGE_SIZE != 0) {
-			towrite = offset % EEPROM_PAGE_SIZE;
-		} else if (length - written < EEPROM_PAGE_SIZE) {
-			towrite = length - written;
-		}
-
-		// Start the I2C transactions.
-		state = STATE_IDLE;
-		// Configure the DMA controller, but don't enable it yet.
-		g_dmaInit.DMA_MemoryBaseAddr = (uint32_t) buffer + written;
-		g_dmaInit.DMA_BufferSize = towrite;
-		g_dmaInit.DMA_DIR = DMA_DIR_PeripheralDST;
-
-		I2C_GenerateSTART(I2C1, ENABLE);
-
-		// The rest happens in IRQ&DMA so just wait for it to COMPLETE or ERR
-		eeprom_wait_complete();
-		if (state == STATE_ERROR)
-			break;
-
-		written += towrite;
-	}
-
-	// no need to wait for completion here as it was done in the loop above
+	ok = storage_write(offset, length, buffer);
 
 	lcd_set_cursor(0, 0);
-	lcd_write_char(state == STATE_ERROR ? 'E' : ' ', LCD_OP_SET, FLAGS_NONE);
+	lcd_write_char(ok ? ' ' : 'E', LCD_OP_SET, FLAGS_NONE);
 	lcd_update();
-}
-
-/**
- * @brief  Wait for any pending actions to complete.
- * @note
- * @param  None
- * @retval None
- */
-void eeprom_wait_complete(void) {
-	while (state != STATE_COMPLETE && state != STATE_ERROR)
-		;
+	if (!ok)
+		gui_popup(GUI_MSG_EEPROM_WRITE, 0);
 }
 
 /**
@@ -457,16 +920,25 @@ void eeprom_process(uint32_t data) {
 				gui_popup(GUI_MSG_EEPROM_INVALID, 0);
 		}
 		// see if current model's settings need to be saved
+		// The checksum and the image must both be of the same g_model, so
+		// the mixer leaves the trims alone until the save is done.
+		mixer_hold_model(true);
 		chksum = eeprom_calc_chksum((void*)&g_model, sizeof(g_model) - 2);
-		if (chksum != g_model.chkSum) {
-			uint16_t modelAddress = model_address(g_eeGeneral.currModel);
+		// g_model still belongs to currModel if g_eeGeneral.currModel just changed.
+		// Trim changes wait until the trims are quiet, unless the model is changing.
+		bool save = chksum != g_model.chkSum && currModel < MAX_MODELS &&
+				(g_eeGeneral.currModel != currModel || !mixer_trim_pending());
+		bool saved = false;
+		if (save) {
+			// set even if the save fails so it is only retried on the next change
 			g_model.chkSum = chksum;
-			eeprom_write( modelAddress, sizeof(g_model), (void*)&g_model);
-			// check after write
-			unsigned cs = eeprom_checksum_memory(modelAddress, sizeof(g_model) - 2);
-			if (chksum != cs)
-				gui_popup(GUI_MSG_EEPROM_INVALID, 0);
+			saved = eeprom_save_model(currModel);
 		}
+		mixer_hold_model(false);
+
+		// check after write
+		if (saved && chksum != model_checksum(currModel))
+			gui_popup(GUI_MSG_EEPROM_INVALID, 0);
 	}
 
 	eeprom_load_current_model_if_changed();
@@ -474,157 +946,3 @@ void eeprom_process(uint32_t data) {
 	task_schedule(TASK_PROCESS_EEPROM, 0, 1000);
 }
 
-/**
- * @brief  I2C Error Handler
- * @note
- * @param  None
- * @retval None
- */
-void I2C1_ER_IRQHandler(void) {
-	uint32_t event = I2C_GetLastEvent(I2C1);
-
-	if (event & (I2C_FLAG_AF | I2C_FLAG_TIMEOUT)) {
-		I2C_ClearFlag(I2C1, I2C_FLAG_AF);
-		I2C_ClearFlag(I2C1, I2C_FLAG_TIMEOUT);
-		// I2C_AcknowledgeConfig(I2C1, DISABLE);
-		I2C_GenerateSTOP(I2C1, ENABLE);
-
-		// timeout on addressing - this is ok as we are waiting for EEPROM to complete
-		// hence restart the polling
-		if (state == STATE_COMPLETING) {
-			// wait for STOP
-			while (I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY))
-				;
-			I2C_GenerateSTART(I2C1, ENABLE);
-		} else // really an error
-		{
-			state = STATE_ERROR;
-		}
-	}
-}
-
-/**
- * @brief  I2C Event Handler
- * @note	This drives the EEPROM access logic and starts the DMA.
- * @param  None
- * @retval None
- */
-void I2C1_EV_IRQHandler(void) {
-	uint32_t event = I2C_GetLastEvent(I2C1);
-#define ISEV(EV) ((event & EV)==EV)
-
-	switch (state) {
-	case STATE_IDLE:
-		if (ISEV(I2C_EVENT_MASTER_MODE_SELECT)) {
-			state = STATE_START;
-			I2C_Send7bitAddress(I2C1, EEPROM_ADDR, I2C_Direction_Transmitter);
-		}
-		break;
-
-	case STATE_START:
-		if (ISEV(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED)) {
-			state = STATE_ADDRESSED1;
-			I2C_SendData(I2C1, (addr >> 8) & 0xFF);
-		}
-		break;
-
-	case STATE_ADDRESSED1:
-		if (ISEV(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {
-			state = STATE_ADDRESSED2;
-			I2C_SendData(I2C1, addr & 0xFF);
-		}
-		break;
-
-	case STATE_ADDRESSED2:
-		if (ISEV(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {
-			if (read_write) {
-				state = STATE_RESTART;
-				I2C_GenerateSTART(I2C1, ENABLE);
-			} else {
-				state = STATE_TRANSFER_START;
-			}
-		}
-		break;
-
-	case STATE_RESTART:
-		if (ISEV(I2C_EVENT_MASTER_MODE_SELECT)) {
-			state = STATE_TRANSFER_START;
-			I2C_Send7bitAddress(I2C1, EEPROM_ADDR, I2C_Direction_Receiver);
-		}
-		break;
-
-	case STATE_TRANSFER_START: {
-		if ((event & I2C_FLAG_ADDR) || // already master, only ADDR now hence this does not work: ISEV(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED) ||
-			ISEV(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {
-			state = STATE_TRANSFERRING;
-			DMA_Channel_TypeDef *channel = (read_write) ? DMA1_Channel7 :
-														  DMA1_Channel6;
-			DMA_Cmd(channel, DISABLE);
-			DMA_ClearFlag(DMA1_FLAG_TC7);
-			DMA_ClearFlag(DMA1_FLAG_TC6);
-			DMA_Init(channel, (DMA_InitTypeDef*)&g_dmaInit);
-			I2C_DMALastTransferCmd(I2C1, ENABLE);
-			DMA_Cmd(channel, ENABLE);
-		}
-	}
-		break;
-	case STATE_TRANSFERRING: {
-		// transfer finished hence complete write
-		if (event & I2C_FLAG_TXE) {
-			state = STATE_COMPLETING;
-			I2C_GenerateSTOP(I2C1, ENABLE);
-			// wait for I2C to STOP (could do with IRQ?)
-			while (I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY))
-				;
-			I2C_GenerateSTART(I2C1, ENABLE);
-		}
-	}
-		break;
-
-	case STATE_COMPLETING: {
-		// addressing the eeprom successfully marks the end of write
-		if (ISEV(I2C_EVENT_MASTER_MODE_SELECT)) {
-			I2C_Send7bitAddress(I2C1, EEPROM_ADDR, I2C_Direction_Transmitter);
-		} else if (ISEV(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED)) {
-			I2C_GenerateSTOP(I2C1, ENABLE);
-			state = STATE_COMPLETE;
-		} else {// if( ISEV(I2C_EVENT_SLAVE_ACK_FAILURE ) )
-			I2C_ClearFlag(I2C1, I2C_FLAG_AF);
-			I2C_GenerateSTART(I2C1, ENABLE);
-		}
-
-	}
-		break;
-
-	case STATE_ERROR:
-	case STATE_COMPLETE:
-		break;
-	}
-}
-
-/**
- * @brief  I2C DMA TX Complete Handler
- * @note
- * @param  None
- * @retval None
- */
-void DMA1_Channel6_IRQHandler(void) {
-	DMA_Cmd(DMA1_Channel6, DISABLE);
-	DMA_ClearFlag(DMA1_FLAG_TC6);
-	DMA_ClearITPendingBit(DMA_IT_TC);
-	// dma finished transferring to the I2C but the I2C did not finished yet
-}
-
-/**
- * @brief  I2C DMA RX Complete Handler
- * @note
- * @param  None
- * @retval None
- */
-void DMA1_Channel7_IRQHandler(void) {
-	DMA_Cmd(DMA1_Channel7, DISABLE);
-	DMA_ClearFlag(DMA1_FLAG_TC7);
-	DMA_ClearITPendingBit(DMA_IT_TC);
-	state = STATE_COMPLETE;
-	I2C_GenerateSTOP(I2C1, ENABLE);
-}
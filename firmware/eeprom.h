@@ -17,10 +17,24 @@
 #define _EEPROM_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "storage.h"
+
+#define EEPROM_SIZE STORAGE_SIZE
 
 void eeprom_init(void);
 void eeprom_load_current_model_if_changed();
 void eeprom_init_current_model();
 void eeprom_read_model_name(char model, char buf[]);
+void eeprom_read_model_data(uint8_t model, uint16_t offset, uint16_t length, void *buffer);
+uint16_t eeprom_read_model_image(uint8_t model, uint16_t offset, uint16_t length, void *buffer);
+bool eeprom_model_image_begin(uint8_t model, uint16_t length);
+void eeprom_model_image_append(const uint8_t *data, uint16_t length);
+bool eeprom_model_image_commit(void);
+void eeprom_model_image_abort(void);
+bool eeprom_model_image_clear(uint8_t model);
+void eeprom_read(uint16_t offset, uint16_t length, void *buffer);
+void eeprom_write(uint16_t offset, uint16_t length, void *buffer);
 
 #endif // _EEPROM_H
@@ -0,0 +1,137 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Output failsafe.
+ * The PPM encoder calls failsafe_frame() before building each frame and
+ * takes the channels from failsafe_get() rather than g_chans. Normally
+ * they are g_chans. The failsafe takes over while:
+ *   - the mixer has not run for FAILSAFE_LATE_FRAMES frames,
+ *   - a model is being loaded (g_modelInvalid), or
+ *   - the mixer uses PPM-IN (trainer) and no trainer frame has arrived
+ *     for FAILSAFE_TRAINER_FRAMES frames.
+ * Each output then holds its last good value, jumps to its preset or
+ * ramps to it, as set in g_model.failsafe. The settings are copied
+ * while the model is valid, so a model load doesn't change them halfway.
+ *
+ */
+
+#include "failsafe.h"
+#include "art6.h"
+#include "myeeprom.h"
+#include "mixer.h"
+#include "sticks.h"
+
+volatile uint8_t g_failsafe;
+
+static FailsafeData policy[NUM_CHNOUT];
+static int16_t out[NUM_CHNOUT];
+static int16_t hold[NUM_CHNOUT];	// Last good output.
+static uint8_t ramp;				// Frames since the failsafe took over.
+static uint32_t last_passes;
+static uint8_t late;
+static volatile bool ppm_in_used;
+
+/**
+  * @brief  Work out the outputs for the next PPM frame.
+  * @note	Called from the PPM interrupt, once per frame.
+  * @param  None
+  * @retval None
+  */
+void failsafe_frame(void)
+{
+	uint32_t passes = g_mixer_passes;
+	uint8_t reason = 0;
+	uint8_t i;
+
+	if (g_modelInvalid)
+		reason |= FAILSAFE_MODEL;
+	else
+	{
+		for (i = 0; i < NUM_CHNOUT; i++)
+			policy[i] = g_model.failsafe[i];
+	}
+
+	if (passes != last_passes)
+		late = 0;
+	else if (late < FAILSAFE_LATE_FRAMES)
+		late++;
+	last_passes = passes;
+	if (late >= FAILSAFE_LATE_FRAMES)
+		reason |= FAILSAFE_MIXER;
+
+	// Set by each complete frame on PPM-IN.
+	if (ppmInValid)
+		ppmInValid--;
+	if (ppm_in_used && !ppmInValid)
+		reason |= FAILSAFE_TRAINER;
+
+	g_failsafe = reason;
+
+	if (!reason)
+	{
+		for (i = 0; i < NUM_CHNOUT; i++)
+			out[i] = hold[i] = g_chans[i];
+		ramp = 0;
+		return;
+	}
+
+	if (ramp < 0xFF)
+		ramp++;
+
+	for (i = 0; i < NUM_CHNOUT; i++)
+	{
+		const FailsafeData *fs = &policy[i];
+		int16_t preset = (int16_t)fs->value * RESX / 100;
+
+		switch (fs->mode)
+		{
+		case FAILSAFE_PRESET:
+			out[i] = preset;
+			break;
+		case FAILSAFE_RAMP:
+			if (ramp >= fs->frames)
+				out[i] = preset;
+			else
+				out[i] = hold[i] + (int32_t)(preset - hold[i]) * ramp / fs->frames;
+			break;
+		default:
+			out[i] = hold[i];
+			break;
+		}
+	}
+}
+
+/**
+  * @brief  Get an output for the PPM frame.
+  * @note	Valid after failsafe_frame().
+  * @param  chan: Output channel.
+  * @retval Output -RESX..RESX, or past with limits over 100%.
+  */
+int16_t failsafe_get(uint8_t chan)
+{
+	return out[chan];
+}
+
+/**
+  * @brief  Tell the failsafe whether the mixer output depends on PPM-IN.
+  * @note	Called by the mixer after every pass.
+  * @param  used: A trainer mix is on, or a mix takes a PPM-IN channel.
+  * @retval None
+  */
+void failsafe_ppm_in_used(bool used)
+{
+	ppm_in_used = used;
+}
@@ -0,0 +1,41 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _FAILSAFE_H
+#define _FAILSAFE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// FailsafeData.mode
+#define FAILSAFE_HOLD		0	// Keep the last good output.
+#define FAILSAFE_PRESET		1	// Jump to the preset.
+#define FAILSAFE_RAMP		2	// Move to the preset over FailsafeData.frames.
+#define FAILSAFE_MODE_MAX	3
+
+#define FAILSAFE_LATE_FRAMES	2	// PPM frames without a mixer pass.
+#define FAILSAFE_TRAINER_FRAMES	4	// PPM frames without a trainer frame.
+
+// g_failsafe reasons
+#define FAILSAFE_MIXER		0x01
+#define FAILSAFE_MODEL		0x02
+#define FAILSAFE_TRAINER	0x04
+
+extern volatile uint8_t g_failsafe;
+
+void failsafe_frame(void);
+int16_t failsafe_get(uint8_t chan);
+void failsafe_ppm_in_used(bool used);
+
+#endif // _FAILSAFE_H
@@ -0,0 +1,86 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Font tables, see fonts.h.
+ * Made by tools/fontconv from lcd_font_medium.h, do not edit.
+ *
+ */
+
+#include "fonts.h"
+
+const uint8_t font_prop[FONT_GLYPHS] = {
+	0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x02, 0x02, 0x05, 0x05, 0x05, 0x05,
+	0x14, 0x23, 0x32, 0x14, 0x04, 0x02, 0x03, 0x04, 0x05, 0x05, 0x02, 0x02,
+	0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x05, 0x02, 0x21, 0x05, 0x05,
+	0x05, 0x05, 0x02, 0x22, 0x13, 0x13, 0x05, 0x05, 0x12, 0x05, 0x12, 0x05,
+	0x05, 0x13, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x21, 0x12,
+	0x04, 0x05, 0x14, 0x14, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+	0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+	0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x03, 0x05, 0x23, 0x05, 0x05,
+	0x12, 0x05, 0x05, 0x05, 0x05, 0x05, 0x14, 0x05, 0x05, 0x13, 0x04, 0x04,
+	0x14, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x04, 0x05, 0x05, 0x05,
+	0x05, 0x05, 0x04, 0x13, 0x13, 0x05, 0x02, 0x02,
+};
+
+const uint8_t font_large_metrics[FONT_LARGE_COUNT] = {
+	0x0A, 0x16, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x34,
+};
+
+const uint8_t font_large[FONT_LARGE_COUNT * FONT_LARGE_STRIDE] = {
+	// '-'
+	0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	// '.'
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x18, 0x3C, 0x3C, 0x18, 0x00, 0x00, 0x00, 0x00,
+	// '/'
+	0x00, 0x00, 0x00, 0x80, 0xC0, 0xE0, 0x70, 0x38, 0x1C, 0x0C,
+	0x0C, 0x0E, 0x07, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	// '0'
+	0xFC, 0xFE, 0x07, 0x03, 0xC3, 0xE3, 0x33, 0x33, 0xFE, 0xFC,
+	0x0F, 0x1F, 0x33, 0x33, 0x31, 0x30, 0x30, 0x38, 0x1F, 0x0F,
+	// '1'
+	0x00, 0x00, 0x0C, 0x1E, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x30, 0x38, 0x3F, 0x3F, 0x38, 0x30, 0x00, 0x00,
+	// '2'
+	0x0C, 0x0E, 0x07, 0x03, 0x03, 0x03, 0x03, 0x87, 0xFE, 0xFC,
+	0x30, 0x38, 0x3C, 0x3E, 0x33, 0x33, 0x33, 0x33, 0x31, 0x30,
+	// '3'
+	0x03, 0x03, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x3E, 0x3C,
+	0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x39, 0x1F, 0x0F,
+	// '4'
+	0xC0, 0xE0, 0x30, 0x38, 0x0C, 0x8E, 0xFF, 0xFF, 0x80, 0x00,
+	0x01, 0x03, 0x03, 0x03, 0x03, 0x07, 0x3F, 0x3F, 0x07, 0x03,
+	// '5'
+	0x7E, 0xFF, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0x83, 0x03,
+	0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x39, 0x1F, 0x0F,
+	// '6'
+	0xFC, 0xFE, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0x83, 0x03,
+	0x0F, 0x1F, 0x39, 0x30, 0x30, 0x30, 0x30, 0x39, 0x1F, 0x0F,
+	// '7'
+	0x03, 0x03, 0x03, 0x03, 0x03, 0x83, 0xC3, 0xE7, 0x7F, 0x3E,
+	0x30, 0x38, 0x1C, 0x0E, 0x07, 0x03, 0x01, 0x00, 0x00, 0x00,
+	// '8'
+	0x3C, 0x3E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x3E, 0x3C,
+	0x0F, 0x1F, 0x39, 0x30, 0x30, 0x30, 0x30, 0x39, 0x1F, 0x0F,
+	// '9'
+	0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0xFE, 0xFC,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x3F, 0x3F,
+	// ':'
+	0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x00, 0x00,
+};
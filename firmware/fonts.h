@@ -0,0 +1,49 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _FONTS_H
+#define _FONTS_H
+
+#include <stdint.h>
+
+/*
+ * Font tables made from the 5x7 glyphs (lcd_font_medium.h) by
+ * tools/fontconv, drawn by lcd_write_char().
+ *
+ * Metrics are one byte per glyph, (lead << 4) | width: the first column
+ * drawn and how many columns follow.
+ *
+ * font_prop: metrics of the 5x7 glyphs for CHAR_PROP.
+ * font_large: pre-scaled glyphs for CHAR_4X, FONT_LARGE_STRIDE bytes
+ *   each, page by page in lcd_buffer order, with font_large_metrics.
+ */
+
+#define FONT_GLYPHS			128
+
+#define FONT_LARGE_FIRST	'-'
+#define FONT_LARGE_LAST		':'
+#define FONT_LARGE_COUNT	(FONT_LARGE_LAST - FONT_LARGE_FIRST + 1)
+#define FONT_LARGE_WIDTH	10
+#define FONT_LARGE_HEIGHT	14
+#define FONT_LARGE_PAGES	2
+#define FONT_LARGE_STRIDE	(FONT_LARGE_WIDTH * FONT_LARGE_PAGES)
+
+#define FONT_LEAD(m)		((m) >> 4)
+#define FONT_WIDTH(m)		((m) & 0x0F)
+
+extern const uint8_t font_prop[FONT_GLYPHS];
+extern const uint8_t font_large_metrics[FONT_LARGE_COUNT];
+extern const uint8_t font_large[FONT_LARGE_COUNT * FONT_LARGE_STRIDE];
+
+#endif // _FONTS_H
@@ -0,0 +1,141 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Packet framing for the serial link.
+ * Payloads are protected by a CRC16 and COBS encoded so that 0x00 only
+ * ever appears as the frame delimiter. A receiver that loses sync simply
+ * discards bytes up to the next 0x00.
+ * This file has no hardware dependencies and is shared with the host tools.
+ *
+ */
+
+#include "frame.h"
+
+/**
+  * @brief  Calculate the CRC-16/CCITT of a buffer.
+  * @note	Bitwise to save flash, the frames are short.
+  * @param  data: Data to check
+  * @param  length: Data length
+  * @retval CRC
+  */
+uint16_t frame_crc16(const uint8_t *data, uint16_t length)
+{
+	uint16_t crc = 0xFFFF;
+	uint8_t i;
+
+	while (length--)
+	{
+		crc ^= (uint16_t)*data++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+
+	return crc;
+}
+
+/**
+  * @brief  Encode a payload into a frame ready to transmit.
+  * @note	out must hold at least length + FRAME_CRC_LEN + 2 bytes.
+  * @param  payload: Data to send
+  * @param  length: Payload length (max. FRAME_MAX_PAYLOAD)
+  * @param  out: Destination buffer
+  * @retval Number of bytes to transmit, including the delimiter.
+  */
+uint16_t frame_encode(const uint8_t *payload, uint16_t length, uint8_t *out)
+{
+	uint16_t crc = frame_crc16(payload, length);
+	uint16_t code_idx = 0;
+	uint16_t pos = 1;
+	uint8_t code = 1;
+	uint16_t i;
+
+	for (i = 0; i < length + FRAME_CRC_LEN; i++)
+	{
+		uint8_t b;
+
+		if (i < length)
+			b = payload[i];
+		else if (i == length)
+			b = crc & 0xFF;
+		else
+			b = crc >> 8;
+
+		if (b == 0)
+		{
+			out[code_idx] = code;
+			code_idx = pos++;
+			code = 1;
+		}
+		else
+		{
+			out[pos++] = b;
+			if (++code == 0xFF)
+			{
+				out[code_idx] = code;
+				code_idx = pos++;
+				code = 1;
+			}
+		}
+	}
+
+	out[code_idx] = code;
+	out[pos++] = 0;
+
+	return pos;
+}
+
+/**
+  * @brief  Decode a received frame in place.
+  * @note	The delimiter must not be included.
+  * @param  buf: Encoded frame, replaced by the payload
+  * @param  length: Encoded length
+  * @retval Payload length or -1 if the frame is corrupt.
+  */
+int16_t frame_decode(uint8_t *buf, uint16_t length)
+{
+	uint16_t in = 0;
+	uint16_t out = 0;
+	uint16_t crc;
+
+	while (in < length)
+	{
+		uint8_t code = buf[in++];
+		uint8_t i;
+
+		if (code == 0)
+			return -1;
+
+		for (i = 1; i < code; i++)
+		{
+			if (in >= length)
+				return -1;
+			buf[out++] = buf[in++];
+		}
+
+		if (code != 0xFF && in < length)
+			buf[out++] = 0;
+	}
+
+	if (out < FRAME_CRC_LEN)
+		return -1;
+
+	out -= FRAME_CRC_LEN;
+	crc = buf[out] | (buf[out + 1] << 8);
+	if (crc != frame_crc16(buf, out))
+		return -1;
+
+	return out;
+}
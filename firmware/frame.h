@@ -0,0 +1,34 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include <stdint.h>
+
+/*
+ * On the wire a frame is COBS(payload + CRC16) followed by a 0x00 delimiter.
+ * The CRC is CRC-16/CCITT (poly 0x1021, init 0xFFFF), little endian.
+ */
+
+#define FRAME_MAX_PAYLOAD	64
+#define FRAME_CRC_LEN		2
+// COBS adds one byte per 254 plus the leading code byte, then the delimiter.
+#define FRAME_MAX_ENCODED	(FRAME_MAX_PAYLOAD + FRAME_CRC_LEN + 2)
+
+uint16_t frame_crc16(const uint8_t *data, uint16_t length);
+uint16_t frame_encode(const uint8_t *payload, uint16_t length, uint8_t *out);
+int16_t frame_decode(uint8_t *buf, uint16_t length);
+
+#endif // _FRAME_H
@@ -20,6 +20,7 @@
  */
 
 #include <stdbool.h>
+#include <string.h>
 
 #include "stm32f10x.h"
 #include "tasks.h"
@@ -34,6 +35,15 @@
 #include "icons.h"
 #include "sound.h"
 #include "strings.h"
+#include "recorder.h"
+#include "startup.h"
+#include "crash.h"
+#include "watchdog.h"
+#include "stack.h"
+#include "monitor.h"
+#include "failsafe.h"
+#include "bitmap.h"
+#include "assets.h"
 
 // Battery values.
 #define BATT_MIN	99	//NiMh: 88
@@ -61,8 +71,12 @@
 #define SW_R_X	(BOX_R_X + BOX_W + 4)
 
 #define LIST_ROWS	7
+#define MONITOR_ROWS	6	// Below the column headings.
 
-#define PAGE_LIMIT	((g_current_layout == GUI_LAYOUT_SYSTEM_MENU)?5:9)
+// How long the splash screen stays up (ms) unless a key is pressed.
+#define SPLASH_TIME	2000
+
+#define PAGE_LIMIT	((g_current_layout == GUI_LAYOUT_SYSTEM_MENU)?8:10)
 
 static volatile GUI_LAYOUT g_new_layout = GUI_LAYOUT_NONE;
 static GUI_LAYOUT g_current_layout = GUI_LAYOUT_SPLASH;
@@ -112,6 +126,7 @@ static void gui_draw_slider(int x, int y, int w, int h, int range, int value);
 static void gui_draw_stick_icon(STICK stick, uint8_t inverse);
 
 static void gui_string_edit(char *string, int8_t delta, uint32_t keys);
+static void gui_write_hex32(uint32_t val);
 static uint32_t gui_bitfield_edit(char *string, uint32_t field, int8_t delta,
 		uint32_t keys, uint8_t edit);
 static int32_t gui_int_edit(int32_t data, int32_t delta, int32_t min,
@@ -145,7 +160,7 @@ for(int col = 0; col < context.col_limit; ++col ) {\
 
 #define GUI_EDIT_ENUM( VAR, MIN, MAX, LABELS ) \
 		if (context.edit) VAR = gui_int_edit(VAR, context.inc, MIN, MAX); \
-		lcd_write_string((char*)LABELS[VAR], context.op_item, FLAGS_NONE);
+		lcd_write_string((char*)str_get(LABELS, VAR), context.op_item, FLAGS_NONE);
 
 #define GUI_EDIT_STR( VAR ) \
 			prefill_string((char*)VAR, sizeof(VAR));\
@@ -269,13 +284,18 @@ void gui_process(uint32_t data) {
 		{
 			if( g_popup_selected_line && (g_key_press & (KEY_LEFT|KEY_RIGHT)) )
 			{
+				char old = g_popup_selected_line;
 				if( g_key_press & KEY_LEFT ) g_popup_selected_line--;
 				if( g_key_press & KEY_RIGHT ) g_popup_selected_line++;
 				if( g_popup_selected_line < 1 ) g_popup_selected_line = 1;
 				if( g_popup_selected_line > g_popup_lines ) g_popup_selected_line = g_popup_lines;
-				g_new_msg = g_current_msg;
-				g_current_msg = 0;
-				update = 1;
+				// Only the highlight moves, the message is left as drawn.
+				if( g_popup_selected_line != old )
+				{
+					lcd_invert_message_line(str_get(STR_MSG, g_current_msg), old);
+					lcd_invert_message_line(str_get(STR_MSG, g_current_msg), g_popup_selected_line);
+					lcd_update();
+				}
 				g_key_press = KEY_NONE;
 			}
 			if ( (g_key_press & (KEY_OK | KEY_CANCEL | KEY_SEL)) )
@@ -321,7 +341,7 @@ void gui_process(uint32_t data) {
 
 			// Model Name
 			lcd_set_cursor(8, 0);
-			lcd_write_string((char*) g_model.name, LCD_OP_SET, CHAR_2X);
+			lcd_write_string((char*) g_model.name, LCD_OP_SET, CHAR_2X | CHAR_PROP);
 		}
 
 		full = true;
@@ -341,7 +361,7 @@ void gui_process(uint32_t data) {
 				MSG_Y + MSG_H - 2, LCD_OP_SET, FLAGS_NONE);
 		// Draw the message
 		lcd_set_cursor(MSG_X + 4, MSG_Y + 4);
-		g_popup_lines = lcd_draw_message(msg[g_new_msg], LCD_OP_SET, LCD_OP_CLR,
+		g_popup_lines = lcd_draw_message(str_get(STR_MSG, g_new_msg), LCD_OP_SET, LCD_OP_CLR,
 				                         g_popup_selected_line);
 
 		g_new_msg = GUI_MSG_NONE;
@@ -364,11 +384,18 @@ void gui_process(uint32_t data) {
 			// Long press menu key handling.
 			g_main_layout = g_current_layout;
 			gui_navigate(GUI_LAYOUT_MENU);
+		} else if (g_key_press & KEY_OK_LONG) {
+			mixer_instant_trim();
+		} else if (g_key_press & KEY_CANCEL_LONG) {
+			mixer_instant_trim_undo();
 		}
 
 		// Update the battery level
 		if ((g_update_type & UPDATE_STICKS) != 0) {
 			gui_show_battery(83, 0);
+			// Instant trim finishes in the mixer.
+			if (mixer_instant_trim_done())
+				gui_update_trim();
 		}
 
 		// Update the timer
@@ -382,9 +409,69 @@ void gui_process(uint32_t data) {
 		// Something went badly wrong.
 		break; // GUI_LAYOUT_NONE
 
-	case GUI_LAYOUT_SPLASH:
+	case GUI_LAYOUT_SPLASH: {
+		static uint32_t splash_end;
+
+		if (full) {
+			if (g_eeGeneral.disableSplashScreen || watchdog_recovered()) {
+				gui_navigate(GUI_LAYOUT_MAIN1);
+				break;
+			}
+			bitmap_draw(asset_logo, 0, 0, LCD_OP_SET);
+			splash_end = system_ticks + SPLASH_TIME;
+		}
+
+		// The radio is already running, this is just for show.
+		if (g_key_press != KEY_NONE || system_ticks >= splash_end)
+			gui_navigate(GUI_LAYOUT_MAIN1);
+		else
+			task_schedule(TASK_PROCESS_GUI, UPDATE_TIMER, splash_end - system_ticks);
+	}
 		break; // GUI_LAYOUT_SPLASH
 
+		/**********************************************************************
+		 * Startup check
+		 *
+		 * Shown while the throttle is held by the startup checks.
+		 * The required switch positions are shown inverted when on,
+		 * with the ones still wrong marked underneath.
+		 *
+		 */
+	case GUI_LAYOUT_STARTUP_CHECK: {
+		uint8_t problems = startup_get_problems();
+		uint8_t i;
+
+		if (startup_get_state() == STARTUP_READY) {
+			gui_navigate(GUI_LAYOUT_MAIN1);
+			break;
+		}
+
+		lcd_draw_rect(0, 0, LCD_WIDTH - 1, LCD_HEIGHT - 1, LCD_OP_CLR,
+				RECT_FILL);
+		if (problems & STARTUP_THROTTLE) {
+			lcd_set_cursor(5, 0);
+			lcd_draw_message(str_get(STR_MSG, GUI_MSG_ZERO_THROTTLE), LCD_OP_SET, 0, 0);
+		}
+		if (problems & ~STARTUP_THROTTLE) {
+			lcd_set_cursor(5, 24);
+			lcd_draw_message(str_get(STR_MSG, GUI_MSG_SET_SWITCHES), LCD_OP_SET, 0, 0);
+			for (i = 0; i < NUM_SWITCHES; ++i) {
+				lcd_set_cursor(10 + i * 30, 6 * 8);
+				lcd_write_string((char*) str_get(STR_SWITCHES, i + 1),
+						(g_eeGeneral.switchWarningStates & (1 << i)) ?
+								LCD_OP_CLR : LCD_OP_SET, FLAGS_NONE);
+				if (problems & (1 << i)) {
+					lcd_set_cursor(10 + i * 30, 7 * 8);
+					lcd_write_string("^^^", LCD_OP_SET, FLAGS_NONE);
+				}
+			}
+		}
+
+		// Keep checking until released.
+		task_schedule(TASK_PROCESS_GUI, UPDATE_TIMER, 100);
+	}
+		break; // GUI_LAYOUT_STARTUP_CHECK
+
 		/**********************************************************************
 		 * Main 1
 		 *
@@ -520,7 +607,7 @@ void gui_process(uint32_t data) {
 			}
 		}
 
-		lcd_set_cursor(37, 40);
+		lcd_set_cursor(39, 40);
 		lcd_write_int(timer / 60, LCD_OP_SET, INT_PAD10 | CHAR_4X);
 		lcd_write_char(':', LCD_OP_SET, CHAR_4X);
 		lcd_write_int(timer % 60, LCD_OP_SET, INT_PAD10 | CHAR_4X);
@@ -694,17 +781,17 @@ void gui_process(uint32_t data) {
 			/**********************************************************************
 			 * System Menu
 			 *
-			 * This is the main system menu with 6 pages.
+			 * This is the main system menu with 9 pages.
 			 *
 			 */
 
-			lcd_write_string((char*) msg[GUI_HDG_RADIO_SETUP + context.page],
+			lcd_write_string((char*) str_get(STR_MSG, GUI_HDG_RADIO_SETUP + context.page),
 					LCD_OP_CLR, FLAGS_NONE);
 			lcd_set_cursor(110, 0);
 			lcd_write_int(context.page + 1,
 					(g_menu_mode == MENU_MODE_PAGE) ? LCD_OP_CLR : LCD_OP_SET,
 					FLAGS_NONE);
-			lcd_write_string("/6",
+			lcd_write_string("/9",
 					(g_menu_mode == MENU_MODE_PAGE) ? LCD_OP_CLR : LCD_OP_SET,
 					FLAGS_NONE);
 
@@ -720,13 +807,13 @@ void gui_process(uint32_t data) {
 
 					prepare_context_for_list_row(&context, row);
 
-					lcd_write_string((char*) system_menu_list1[row], context.op_list,
+					lcd_write_string((char*) str_get(STR_SYS_MENU_LIST1, row), context.op_list,
 							FLAGS_NONE);
 					lcd_write_string(" ", LCD_OP_SET, FLAGS_NONE);
 					switch (row) {
 					GUI_CASE_OFS(0, 74, GUI_EDIT_STR(g_eeGeneral.ownerName))
 					GUI_CASE_OFS(1, 92,
-							GUI_EDIT_ENUM(g_eeGeneral.beeperVal, BEEPER_SILENT, BEEPER_NORMAL, system_menu_beeper ))
+							GUI_EDIT_ENUM(g_eeGeneral.beeperVal, BEEPER_SILENT, BEEPER_NORMAL, STR_BEEPER ))
 					GUI_CASE_OFS(2, 110,
 							GUI_EDIT_INT_EX( g_eeGeneral.volume, 0, 15, NULL, sound_set_volume(g_eeGeneral.volume) ))
 					GUI_CASE_OFS(3, 110,
@@ -748,7 +835,7 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.throttleReversed = gui_int_edit(
 									g_eeGeneral.throttleReversed, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[g_eeGeneral.throttleReversed],
+								(char*) str_get(STR_ON_OFF, g_eeGeneral.throttleReversed),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 7:	// Minute Beep
@@ -757,7 +844,7 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.minuteBeep = gui_int_edit(
 									g_eeGeneral.minuteBeep, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[g_eeGeneral.minuteBeep],
+								(char*) str_get(STR_ON_OFF, g_eeGeneral.minuteBeep),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 8:	// Beep Countdown
@@ -766,7 +853,7 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.preBeep = gui_int_edit(
 									g_eeGeneral.preBeep, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[g_eeGeneral.preBeep],
+								(char*) str_get(STR_ON_OFF, g_eeGeneral.preBeep),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 9:	// Flash on beep
@@ -775,7 +862,7 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.flashBeep = gui_int_edit(
 									g_eeGeneral.flashBeep, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[g_eeGeneral.flashBeep],
+								(char*) str_get(STR_ON_OFF, g_eeGeneral.flashBeep),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 10: // Light Switch
@@ -791,7 +878,7 @@ void gui_process(uint32_t data) {
 							sw = -sw;
 							lcd_write_string("!", context.op_item, FLAGS_NONE);
 						}
-						lcd_write_string((char*) switches[sw], context.op_item,
+						lcd_write_string((char*) str_get(STR_SWITCHES, sw), context.op_item,
 								FLAGS_NONE);
 					}
 						break;
@@ -801,7 +888,7 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.blightinv = gui_int_edit(
 									g_eeGeneral.blightinv, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[g_eeGeneral.blightinv],
+								(char*) str_get(STR_ON_OFF, g_eeGeneral.blightinv),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 12: // Light timeout
@@ -819,7 +906,7 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.lightOnStickMove = gui_int_edit(
 									g_eeGeneral.lightOnStickMove, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[g_eeGeneral.lightOnStickMove],
+								(char*) str_get(STR_ON_OFF, g_eeGeneral.lightOnStickMove),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 14: // Splash screen
@@ -828,8 +915,8 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.disableSplashScreen = gui_int_edit(
 									g_eeGeneral.disableSplashScreen, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[1
-										- g_eeGeneral.disableSplashScreen],
+								(char*) str_get(STR_ON_OFF, 1
+										- g_eeGeneral.disableSplashScreen),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 15: // Throttle Warning
@@ -839,8 +926,8 @@ void gui_process(uint32_t data) {
 									g_eeGeneral.disableThrottleWarning, context.inc, 0,
 									1);
 						lcd_write_string(
-								(char*) menu_on_off[1
-										- g_eeGeneral.disableThrottleWarning],
+								(char*) str_get(STR_ON_OFF, 1
+										- g_eeGeneral.disableThrottleWarning),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 16: // Switch Warning
@@ -850,8 +937,8 @@ void gui_process(uint32_t data) {
 									g_eeGeneral.disableSwitchWarning, context.inc, 0,
 									1);
 						lcd_write_string(
-								(char*) menu_on_off[1
-										- g_eeGeneral.disableSwitchWarning],
+								(char*) str_get(STR_ON_OFF, 1
+										- g_eeGeneral.disableSwitchWarning),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 17: // Default Sw
@@ -867,8 +954,8 @@ void gui_process(uint32_t data) {
 									g_eeGeneral.disableMemoryWarning, context.inc, 0,
 									1);
 						lcd_write_string(
-								(char*) menu_on_off[1
-										- g_eeGeneral.disableMemoryWarning],
+								(char*) str_get(STR_ON_OFF, 1
+										- g_eeGeneral.disableMemoryWarning),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 19: // Alarm Warning
@@ -877,8 +964,8 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.disableAlarmWarning = gui_int_edit(
 									g_eeGeneral.disableAlarmWarning, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[1
-										- g_eeGeneral.disableAlarmWarning],
+								(char*) str_get(STR_ON_OFF, 1
+										- g_eeGeneral.disableAlarmWarning),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 20: // PPSIM
@@ -887,7 +974,7 @@ void gui_process(uint32_t data) {
 							g_eeGeneral.enablePpmsim = gui_int_edit(
 									g_eeGeneral.enablePpmsim, context.inc, 0, 1);
 						lcd_write_string(
-								(char*) menu_on_off[g_eeGeneral.enablePpmsim],
+								(char*) str_get(STR_ON_OFF, g_eeGeneral.enablePpmsim),
 								context.op_item, FLAGS_NONE);
 						break;
 					case 21: // Channel Order & Mode
@@ -911,6 +998,30 @@ void gui_process(uint32_t data) {
 						 lcd_write_string("   ", LCD_OP_SET, FLAGS_NONE);
 						 break;
 						 */
+					case 22: // Flight recorder rate
+						lcd_set_cursor(110, context.line);
+						if (context.edit)
+							g_eeGeneral.recorderRate = gui_int_edit(
+									g_eeGeneral.recorderRate, context.inc, 0, 50);
+						if (g_eeGeneral.recorderRate == 0)
+							lcd_write_string((char*) str_get(STR_ON_OFF, 0),
+									context.op_item, FLAGS_NONE);
+						else
+							lcd_write_int(g_eeGeneral.recorderRate, context.op_item,
+									FLAGS_NONE);
+						break;
+					case 23: // Save recording
+						lcd_set_cursor(98, context.line);
+						lcd_write_int(recorder_get_used(), context.op_item,
+								FLAGS_NONE);
+						lcd_write_char('b', context.op_item, FLAGS_NONE);
+						if (context.edit && (g_key_press & (KEY_OK | KEY_SEL))) {
+							recorder_flush();
+							g_menu_mode = MENU_MODE_LIST;
+						}
+						break;
+					GUI_CASE_OFS(24, 98,
+							GUI_EDIT_INT_EX2( g_eeGeneral.stickDeadband, 0, STICK_DEADBAND_MAX, "%", INT_DIV10, sticks_apply_calibration() ))
 					}
 				}
 				break; // SYS_PAGE_SETUP
@@ -930,7 +1041,7 @@ void gui_process(uint32_t data) {
 					switch (row) {
 					case 0:
 						lcd_set_cursor(24, context.line);
-						lcd_write_string((char*) mix_mode_hdr, LCD_OP_SET,
+						lcd_write_string((char*) str_get(STR_MIX_MODE_HDR, 0), LCD_OP_SET,
 								FLAGS_NONE);
 						lcd_set_cursor(66, context.line);
 						lcd_write_string("% src sw", LCD_OP_SET, FLAGS_NONE);
@@ -965,10 +1076,10 @@ void gui_process(uint32_t data) {
 							}
 
 
-						lcd_write_string((char*) sticks[row - 1], context.op_list, FLAGS_NONE);
+						lcd_write_string((char*) str_get(STR_STICKS, row - 1), context.op_list, FLAGS_NONE);
 						lcd_write_string(" ", LCD_OP_SET, FLAGS_NONE);
 						lcd_write_string(
-								(char*) mix_mode[g_eeGeneral.trainer.mix[row - 1].mode],
+								(char*) str_get(STR_MIX_MODE, g_eeGeneral.trainer.mix[row - 1].mode),
 								(context.col == 0) ? context.op_item : LCD_OP_SET,
 								FLAGS_NONE);
 
@@ -992,7 +1103,7 @@ void gui_process(uint32_t data) {
 								lcd_write_char('!', LCD_OP_SET, FLAGS_NONE);
 								sw = -sw;
 							}
-							lcd_write_string((char*) switches[sw],
+							lcd_write_string((char*) str_get(STR_SWITCHES, sw),
 									(context.col == 3) ?
 											context.op_item : LCD_OP_SET ,
 									FLAGS_NONE);
@@ -1059,10 +1170,11 @@ void gui_process(uint32_t data) {
 
 			case SYS_PAGE_DIAG: {
 				uint8_t sw = keypad_get_switches();
+				uint16_t keys = keypad_get_state();
 				uint8_t i;
 				for (i = 0; i < NUM_SWITCHES; ++i) {
 					lcd_set_cursor(6 * 6, (2 + i) * 8);
-					lcd_write_string((char*) switches[i + 1], LCD_OP_SET,
+					lcd_write_string((char*) str_get(STR_SWITCHES, i + 1), LCD_OP_SET,
 							FLAGS_NONE);
 					lcd_write_char(' ', LCD_OP_SET, FLAGS_NONE);
 					lcd_write_int((sw & (1 << i)) ? 1 : 0, LCD_OP_SET,
@@ -1073,19 +1185,19 @@ void gui_process(uint32_t data) {
 				lcd_set_cursor(3 * 6, (2 + i) * 8);
 				lcd_write_string("Sel", LCD_OP_SET, ALIGN_RIGHT);
 				lcd_set_cursor(4 * 6, (2 + i) * 8);
-				lcd_write_int((keypad_scan_keys() == KEY_SEL) ? 1 : 0,
+				lcd_write_int((keys & KEY_SEL) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				i++;
 				lcd_set_cursor(3 * 6, (2 + i) * 8);
 				lcd_write_string("OK", LCD_OP_SET, ALIGN_RIGHT);
 				lcd_set_cursor(4 * 6, (2 + i) * 8);
-				lcd_write_int((keypad_scan_keys() == KEY_OK) ? 1 : 0,
+				lcd_write_int((keys & KEY_OK) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				i++;
 				lcd_set_cursor(3 * 6, (2 + i) * 8);
 				lcd_write_string("Can", LCD_OP_SET, ALIGN_RIGHT);
 				lcd_set_cursor(4 * 6, (2 + i) * 8);
-				lcd_write_int((keypad_scan_keys() == KEY_CANCEL) ? 1 : 0,
+				lcd_write_int((keys & KEY_CANCEL) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				i++;
 
@@ -1096,42 +1208,138 @@ void gui_process(uint32_t data) {
 				lcd_set_cursor(12 * 6, (2 + i) * 8);
 				lcd_write_string("\x0A\x0B\x0C ", LCD_OP_SET, CHAR_NOSPACE);
 				lcd_set_cursor(17 * 6, (2 + i) * 8);
-				lcd_write_int((keypad_scan_keys() == KEY_CH1_DN) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH1_DN) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				lcd_write_char(' ', LCD_OP_SET, FLAGS_NONE);
-				lcd_write_int((keypad_scan_keys() == KEY_CH1_UP) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH1_UP) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				i++;
 				lcd_set_cursor(12 * 6, (2 + i) * 8);
 				lcd_write_string("\x0D\x0E\x0F ", LCD_OP_SET, CHAR_NOSPACE);
 				lcd_set_cursor(17 * 6, (2 + i) * 8);
-				lcd_write_int((keypad_scan_keys() == KEY_CH2_DN) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH2_DN) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				lcd_write_char(' ', LCD_OP_SET, FLAGS_NONE);
-				lcd_write_int((keypad_scan_keys() == KEY_CH2_UP) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH2_UP) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				i++;
 				lcd_set_cursor(12 * 6, (2 + i) * 8);
 				lcd_write_string("\x10\x11\x12 ", LCD_OP_SET, CHAR_NOSPACE);
 				lcd_set_cursor(17 * 6, (2 + i) * 8);
-				lcd_write_int((keypad_scan_keys() == KEY_CH3_DN) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH3_DN) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				lcd_write_char(' ', LCD_OP_SET, FLAGS_NONE);
-				lcd_write_int((keypad_scan_keys() == KEY_CH3_UP) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH3_UP) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				i++;
 				lcd_set_cursor(12 * 6, (2 + i) * 8);
 				lcd_write_string("\x13\x14\x15 ", LCD_OP_SET, CHAR_NOSPACE);
 				lcd_set_cursor(17 * 6, (2 + i) * 8);
-				lcd_write_int((keypad_scan_keys() == KEY_CH4_DN) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH4_DN) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				lcd_write_char(' ', LCD_OP_SET, FLAGS_NONE);
-				lcd_write_int((keypad_scan_keys() == KEY_CH4_UP) ? 1 : 0,
+				lcd_write_int((keys & KEY_CH4_UP) ? 1 : 0,
 						LCD_OP_SET, FLAGS_NONE);
 				i++;
+
+				lcd_set_cursor(30, 7 * 8);
+				lcd_write_string("Boot:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(36, 7 * 8);
+				lcd_write_int(g_pulses_first_ms, LCD_OP_SET, FLAGS_NONE);
+				lcd_write_string("ms", LCD_OP_SET, FLAGS_NONE);
 			}
 				break; // SYS_PAGE_DIAG
 
+			case SYS_PAGE_FAULT: {
+				const CrashRecord *c = crash_get();
+
+				if (!c) {
+					lcd_set_cursor(5, 3 * 8);
+					lcd_draw_message(str_get(STR_MSG, GUI_MSG_NO_FAULT), LCD_OP_SET, 0, 0);
+					break;
+				}
+
+				lcd_set_cursor(30, 2 * 8);
+				lcd_write_string("PC:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(36, 2 * 8);
+				gui_write_hex32(c->pc);
+				lcd_set_cursor(90, 2 * 8);
+				lcd_write_string("#", LCD_OP_SET, FLAGS_NONE);
+				lcd_write_int(c->count, LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(30, 3 * 8);
+				lcd_write_string("LR:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(36, 3 * 8);
+				gui_write_hex32(c->lr);
+				lcd_set_cursor(90, 3 * 8);
+				lcd_write_string("E", LCD_OP_SET, FLAGS_NONE);
+				lcd_write_int(c->exception, LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(30, 4 * 8);
+				lcd_write_string("CFSR:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(36, 4 * 8);
+				gui_write_hex32(c->cfsr);
+				// Watchdog sources that stopped
+				lcd_set_cursor(90, 4 * 8);
+				lcd_write_string("S", LCD_OP_SET, FLAGS_NONE);
+				lcd_write_int(c->stalled, LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(30, 5 * 8);
+				lcd_write_string("HFSR:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(36, 5 * 8);
+				gui_write_hex32(c->hfsr);
+				lcd_set_cursor(90, 5 * 8);
+				lcd_write_string("T", LCD_OP_SET, FLAGS_NONE);
+				lcd_write_int(c->task, LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(30, 6 * 8);
+				lcd_write_string("Addr:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(36, 6 * 8);
+				gui_write_hex32((c->cfsr & SCB_CFSR_MMARVALID) ? c->mmfar : c->bfar);
+
+				lcd_set_cursor(30, 7 * 8);
+				lcd_write_string("Up:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(36, 7 * 8);
+				lcd_write_int(c->ticks / 1000, LCD_OP_SET, FLAGS_NONE);
+				lcd_write_string("s", LCD_OP_SET, FLAGS_NONE);
+			}
+				break; // SYS_PAGE_FAULT
+
+			case SYS_PAGE_MEMORY:
+				lcd_set_cursor(42, 2 * 8);
+				lcd_write_string("Stack:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(48, 2 * 8);
+				lcd_write_int(stack_get_used(), LCD_OP_SET, FLAGS_NONE);
+				lcd_write_string(" used", LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(42, 3 * 8);
+				lcd_write_string("Free:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(48, 3 * 8);
+				lcd_write_int(stack_get_free(), LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(42, 4 * 8);
+				lcd_write_string("Mixer:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(48, 4 * 8);
+				lcd_write_int(stack_get_isr(STACK_ISR_MIXER), LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(42, 5 * 8);
+				lcd_write_string("PPM:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(48, 5 * 8);
+				lcd_write_int(stack_get_isr(STACK_ISR_PULSES), LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(42, 6 * 8);
+				lcd_write_string("Tick:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(48, 6 * 8);
+				lcd_write_int(stack_get_isr(STACK_ISR_TICK), LCD_OP_SET, FLAGS_NONE);
+
+				lcd_set_cursor(42, 7 * 8);
+				lcd_write_string("Static:", LCD_OP_SET, ALIGN_RIGHT);
+				lcd_set_cursor(48, 7 * 8);
+				lcd_write_int(stack_get_static(), LCD_OP_SET, FLAGS_NONE);
+				lcd_write_char('/', LCD_OP_SET, FLAGS_NONE);
+				lcd_write_int(STACK_RAM_SIZE, LCD_OP_SET, FLAGS_NONE);
+				break; // SYS_PAGE_MEMORY
+
 			case SYS_PAGE_ANA: {
 				context.op_list = LCD_OP_SET;
 				context.list_limit = 1;
@@ -1165,7 +1373,7 @@ void gui_process(uint32_t data) {
 
 			case SYS_PAGE_CAL:
 				lcd_set_cursor(5, 16);
-				lcd_draw_message(msg[GUI_MSG_CAL_OK_START], LCD_OP_SET, 0, 0);
+				lcd_draw_message(str_get(STR_MSG, GUI_MSG_CAL_OK_START), LCD_OP_SET, 0, 0);
 
 				if (g_update_type & UPDATE_STICKS) {
 					gui_show_sticks();
@@ -1178,6 +1386,51 @@ void gui_process(uint32_t data) {
 					gui_navigate(GUI_LAYOUT_STICK_CALIBRATION);
 				}
 				break; // SYS_PAGE_CAL
+
+			case SYS_PAGE_MONITOR: {
+				// Output statistics since the last reset, [OK] resets.
+				static const char *const hdr[] = { "Min", "Max", "Avg", "Step" };
+				static const uint8_t right[] = { 38, 68, 98, 127 };
+				uint8_t i;
+
+				context.list_limit = MONITOR_CHANNELS - 1;
+				if (context.list >= context.list_top + MONITOR_ROWS)
+					context.list_top = context.list - MONITOR_ROWS + 1;
+
+				if (g_menu_mode == MENU_MODE_EDIT) {
+					monitor_reset();
+					g_menu_mode = MENU_MODE_LIST;
+				}
+
+				for (i = 0; i < 4; ++i) {
+					lcd_set_cursor(right[i], 8);
+					lcd_write_string((char*) hdr[i], LCD_OP_SET, ALIGN_RIGHT);
+				}
+
+				for (uint8_t row = context.list_top;
+					 row < context.list_top + MONITOR_ROWS && row <= context.list_limit; ++row) {
+					MonitorStats st;
+					int16_t v[4];
+					uint8_t y = (row - context.list_top + 2) * 8;
+
+					monitor_get(row, &st);
+					v[0] = st.min;
+					v[1] = st.max;
+					v[2] = st.mean;
+					v[3] = st.delta;
+
+					lcd_set_cursor(0, y);
+					lcd_write_int(row + 1,
+							(g_menu_mode == MENU_MODE_LIST && row == context.list) ?
+									LCD_OP_CLR : LCD_OP_SET, FLAGS_NONE);
+					for (i = 0; i < 4; ++i) {
+						lcd_set_cursor(right[i], y);
+						lcd_write_int(1000 * (int32_t) v[i] / RESX, LCD_OP_SET,
+								INT_DIV10 | CHAR_CONDENSED | ALIGN_RIGHT);
+					}
+				}
+			}
+				break; // SYS_PAGE_MONITOR
 			}
 		}
 
@@ -1186,11 +1439,11 @@ void gui_process(uint32_t data) {
 			/**********************************************************************
 			 * Model Menu
 			 *
-			 * This is the model editing menu with 10 pages.
+			 * This is the model editing menu with 11 pages.
 			 *
 			 */
 
-			lcd_write_string((char*) msg[GUI_HDG_MODELSEL + context.page], LCD_OP_CLR,
+			lcd_write_string((char*) str_get(STR_MSG, GUI_HDG_MODELSEL + context.page), LCD_OP_CLR,
 					FLAGS_NONE);
 			if (context.page == MOD_PAGE_SETUP)
 				lcd_write_int(g_eeGeneral.currModel, LCD_OP_CLR, FLAGS_NONE);
@@ -1199,7 +1452,7 @@ void gui_process(uint32_t data) {
 					(g_menu_mode == MENU_MODE_PAGE) ? LCD_OP_CLR : LCD_OP_SET,
 					ALIGN_RIGHT);
 			lcd_set_cursor(110, 0);
-			lcd_write_string("/10",
+			lcd_write_string("/11",
 					(g_menu_mode == MENU_MODE_PAGE) ? LCD_OP_CLR : LCD_OP_SET,
 					FLAGS_NONE);
 
@@ -1267,25 +1520,32 @@ void gui_process(uint32_t data) {
 
 					prepare_context_for_list_row(&context, row);
 
-					lcd_write_string((char*) model_menu_list1[row], context.op_list,
+					lcd_write_string((char*) str_get(STR_MOD_MENU_LIST1, row), context.op_list,
 							FLAGS_NONE);
 					lcd_write_string(" ", LCD_OP_SET, FLAGS_NONE);
 					switch (row) {
 					GUI_CASE_OFS(0, 74, GUI_EDIT_STR(g_model.name))
 					GUI_CASE_OFS(1, 96,
-							GUI_EDIT_ENUM( g_model.tmrMode, 0, 5, timer_modes ))
+							GUI_EDIT_ENUM( g_model.tmrMode, 0, 5, STR_TIMER_MODES ))
 					GUI_CASE_OFS(2, 96,
-							GUI_EDIT_ENUM( g_model.tmrDir, 0, 1, dir_labels ))
+							GUI_EDIT_ENUM( g_model.tmrDir, 0, 1, STR_DIR ))
 					GUI_CASE_OFS(3, 96, GUI_EDIT_INT( g_model.tmrVal, 0, 3600 ))
 					GUI_CASE_OFS(4, 96,
-							GUI_EDIT_ENUM( g_model.traineron, 0, 1, menu_on_off ))
+							GUI_EDIT_ENUM( g_model.traineron, 0, 1, STR_ON_OFF ))
 					GUI_CASE_OFS(5, 96,
-							GUI_EDIT_ENUM( g_model.thrTrim, 0, 1, menu_on_off ))
+							GUI_EDIT_ENUM( g_model.thrTrim, 0, 1, STR_ON_OFF ))
 					GUI_CASE_OFS(6, 96,
-							GUI_EDIT_ENUM( g_model.thrExpo, 0, 1, menu_on_off ))
-					GUI_CASE_OFS(7, 96, GUI_EDIT_INT( g_model.trimInc, 0, 7 ))
+							GUI_EDIT_ENUM( g_model.thrExpo, 0, 1, STR_ON_OFF ))
+					GUI_CASE_OFS(7, 96,
+							GUI_EDIT_ENUM( g_model.trimInc, 0, TRIM_INC_MAX - 1, STR_TRIM_INC ))
 					GUI_CASE_OFS(8, 96,
-							GUI_EDIT_ENUM( g_model.extendedLimits, 0, 1, menu_on_off ))
+							GUI_EDIT_ENUM( g_model.extendedLimits, 0, 1, STR_ON_OFF ))
+					case 9: // Move the trims into the output offsets
+						if (context.edit && (g_key_press & (KEY_OK | KEY_SEL))) {
+							mixer_trims_to_offsets();
+							g_menu_mode = MENU_MODE_LIST;
+						}
+						break;
 					}
 				}
 				break;
@@ -1302,10 +1562,10 @@ void gui_process(uint32_t data) {
 						(row < context.list_top + LIST_ROWS) && (row <= context.list_limit); ++row)
 				{
 					prepare_context_for_list_row(&context, row);
-					lcd_write_string(sticks[row], context.op_list, TRAILING_SPACE);
+					lcd_write_string(str_get(STR_STICKS, row), context.op_list, TRAILING_SPACE);
 					ExpoData* ed = &g_model.expoData[row];
-					lcd_write_string(switches[ed->drSw1], context.op_list, TRAILING_SPACE);
-					lcd_write_string(switches[ed->drSw2], context.op_list, TRAILING_SPACE);
+					lcd_write_string(str_get(STR_SWITCHES, ed->drSw1), context.op_list, TRAILING_SPACE);
+					lcd_write_string(str_get(STR_SWITCHES, ed->drSw2), context.op_list, TRAILING_SPACE);
 				}
 				break;
 
@@ -1327,16 +1587,16 @@ void gui_process(uint32_t data) {
 					}
 					else
 					{
-						lcd_write_string(mix_mode[mx->destCh ? mx->mltpx : 0], context.op_list, FLAGS_NONE);
+						lcd_write_string(str_get(STR_MIX_MODE, mx->destCh ? mx->mltpx : 0), context.op_list, FLAGS_NONE);
 					}
 					lcd_set_cursor(4*6, context.line);
 
 					// TODO: mix_src must be changed accrding to stick modes!
-					lcd_write_string(mix_src[mx->srcRaw], context.op_list, FLAGS_NONE);
+					lcd_write_string(str_get(STR_MIX_SRC, mx->srcRaw), context.op_list, FLAGS_NONE);
 					lcd_write_string(" ", context.op_list, FLAGS_NONE);
 					lcd_write_int(mx->weight,context.op_list,FLAGS_NONE);
 					lcd_write_string(" ", context.op_list, FLAGS_NONE);
-					lcd_write_string(switches[mx->swtch], context.op_list, FLAGS_NONE);
+					lcd_write_string(str_get(STR_SWITCHES, mx->swtch), context.op_list, FLAGS_NONE);
 				}
 				// if we were in the popup then the result would show up, once
 				char popupRes = gui_popup_get_result();
@@ -1425,10 +1685,10 @@ void gui_process(uint32_t data) {
 
 							switch(col)
 							{
-								GUI_CASE_OFS( 0, (3+6-1)*6+2, GUI_EDIT_INT_EX2(p->offset,-100, 100, 0 , INT_DIV10|ALIGN_RIGHT, {}))
+								GUI_CASE_OFS( 0, (3+6-1)*6+2, GUI_EDIT_INT_EX2(p->offset,-MIXER_OFFSET_LIMIT, MIXER_OFFSET_LIMIT, 0 , INT_DIV10|ALIGN_RIGHT, {}))
 								GUI_CASE_OFS( 1, (3+6+4-1)*6+2, GUI_EDIT_INT_EX2(p->min, -100, 100,0, ALIGN_RIGHT, {}))
 								GUI_CASE_OFS( 2, (3+6+4+4-1)*6+2, GUI_EDIT_INT_EX2(p->max, -100, 100,0, ALIGN_RIGHT,{}))
-								GUI_CASE_OFS( 3, (3+6+4+4+2-1)*6+2, GUI_EDIT_ENUM(p->reverse, 0, 1, inverse_labels))
+								GUI_CASE_OFS( 3, (3+6+4+4+2-1)*6+2, GUI_EDIT_ENUM(p->reverse, 0, 1, STR_INVERSE))
 							}
 					)
 
@@ -1472,25 +1732,49 @@ void gui_process(uint32_t data) {
 				// ToDo: Implement!
 				break;
 
+			case MOD_PAGE_FAILSAFE:
+				context.list_limit = NUM_CHNOUT - 1;
+				context.col_limit = 3;
+				FOREACH_ROW(
+
+					char s[4] = "CH1";
+					s[2] += row;
+					lcd_write_string(s, context.op_list, CHAR_NOSPACE);
+
+					FailsafeData* const p = &g_model.failsafe[row];
+
+					FOREACH_COL(
+
+							switch(col)
+							{
+								GUI_CASE_OFS( 0, 4*6, GUI_EDIT_ENUM(p->mode, FAILSAFE_HOLD, FAILSAFE_MODE_MAX - 1, STR_FAILSAFE_MODES))
+								GUI_CASE_OFS( 1, 15*6, GUI_EDIT_INT_EX2(p->value, -100, 100, 0, ALIGN_RIGHT, {}))
+								GUI_CASE_OFS( 2, 20*6, GUI_EDIT_INT_EX2(p->frames, 0, 63, 0, ALIGN_RIGHT, {}))
+							}
+					)
+
+				)
+				break;
+
 				// Not navigable through left / right scrolling.
 
 			case MOD_PAGE_MIX_EDIT:
 				// ToDo: Implement!
 				context.list_limit = MIXER_EDIT_LIST1_LEN - 1;
 				FOREACH_ROW(
-					lcd_write_string((char*) mixer_edit_list1[row], context.op_list, FLAGS_NONE);
+					lcd_write_string((char*) str_get(STR_MIXER_EDIT_LIST1, row), context.op_list, FLAGS_NONE);
 					lcd_write_string(" ", LCD_OP_SET, FLAGS_NONE);
 					MixData* const mx = &g_model.mixData[g_edit_item];
 					switch (row) {
-						GUI_CASE_OFS(0, 96, GUI_EDIT_ENUM( mx->srcRaw, 0, MIX_SRC_MAX-1, mix_src ));
+						GUI_CASE_OFS(0, 96, GUI_EDIT_ENUM( mx->srcRaw, 0, MIX_SRC_MAX-1, STR_MIX_SRC ));
 						GUI_CASE_OFS(1, 96, GUI_EDIT_INT( mx->weight, -125, 125 ));
 						GUI_CASE_OFS(2, 96, GUI_EDIT_INT( mx->sOffset, -125, 125 ));
-						GUI_CASE_OFS(3, 96, GUI_EDIT_ENUM( mx->carryTrim, 0, 1, menu_on_off ));
+						GUI_CASE_OFS(3, 96, GUI_EDIT_ENUM( mx->carryTrim, 0, 1, STR_ON_OFF ));
 						// #4 curve
-						GUI_CASE_OFS(5, 96, GUI_EDIT_ENUM( mx->swtch, 0, 4, switches ));
+						GUI_CASE_OFS(5, 96, GUI_EDIT_ENUM( mx->swtch, 0, 4, STR_SWITCHES ));
 						// #6 phase
-						GUI_CASE_OFS(7, 96, GUI_EDIT_ENUM( mx->mixWarn, 0, 1, menu_on_off ));
-						GUI_CASE_OFS(8, 96, GUI_EDIT_ENUM( mx->mltpx, 0, 3, mix_mode ));
+						GUI_CASE_OFS(7, 96, GUI_EDIT_ENUM( mx->mixWarn, 0, 1, STR_ON_OFF ));
+						GUI_CASE_OFS(8, 96, GUI_EDIT_ENUM( mx->mltpx, 0, 3, STR_MIX_MODE ));
 						GUI_CASE_OFS(9, 96, GUI_EDIT_INT( mx->delayUp, 0, 255 ));
 						GUI_CASE_OFS(10, 96, GUI_EDIT_INT( mx->delayDown, 0, 255 ));
 						GUI_CASE_OFS(11, 96, GUI_EDIT_INT( mx->speedUp, 0, 255 ));
@@ -1521,7 +1805,7 @@ void gui_process(uint32_t data) {
 			state = CAL_LIMITS;
 			sticks_calibrate(state);
 			lcd_set_cursor(5, 0);
-			lcd_draw_message(msg[GUI_MSG_CAL_MOVE_EXTENTS], LCD_OP_SET, 0, 0);
+			lcd_draw_message(str_get(STR_MSG, GUI_MSG_CAL_MOVE_EXTENTS), LCD_OP_SET, 0, 0);
 		}
 
 		if ((g_update_type & UPDATE_STICKS) != 0) {
@@ -1529,26 +1813,44 @@ void gui_process(uint32_t data) {
 		}
 
 		if ((g_update_type & UPDATE_KEYPRESS) != 0) {
+			GUI_MSG m = GUI_MSG_NONE;
 			lcd_set_cursor(5, 8);
-			if ((g_key_press & KEY_SEL) || (g_key_press & KEY_OK)) {
-				lcd_draw_rect(5, 0, 123, BOX_Y - 1, LCD_OP_CLR, RECT_FILL);
+			if (state == CAL_LINEAR && (g_key_press & KEY_OK)) {
+				// Take another half travel point.
+				m = sticks_calibrate(CAL_LINEAR) ?
+						GUI_MSG_CAL_LINEAR : GUI_MSG_CAL_STEADY;
+			} else if (state == CAL_LINEAR && (g_key_press & KEY_SEL)) {
+				state = CAL_OFF;
+				m = GUI_MSG_OK_CANCEL;
+			} else if ((g_key_press & KEY_SEL) || (g_key_press & KEY_OK)) {
 				if (state == CAL_LIMITS) {
-					state = CAL_CENTER;
-					sticks_calibrate(CAL_CENTER);
-					lcd_draw_message(msg[GUI_MSG_CAL_CENTRE], LCD_OP_SET,0,0);
+					if (sticks_calibrate(CAL_CENTER)) {
+						state = CAL_CENTER;
+						m = GUI_MSG_CAL_CENTRE;
+					} else {
+						m = GUI_MSG_CAL_MOVE_EXTENTS;
+					}
 				} else if (state == CAL_CENTER) {
-					state = CAL_OFF;
-					sticks_calibrate(CAL_OFF);
-					lcd_draw_message(msg[GUI_MSG_OK_CANCEL], LCD_OP_SET,0,0);
+					if (sticks_calibrate(CAL_LINEAR)) {
+						state = CAL_LINEAR;
+						m = GUI_MSG_CAL_LINEAR;
+					} else {
+						m = GUI_MSG_CAL_STEADY;
+					}
 				} else {
-					// ToDo: Write the calibration data into EEPROM.
-					// eeprom_set_data(EEPROM_ADC_CAL, cal_data);
+					// Saved to EEPROM with the rest of g_eeGeneral.
+					sticks_calibrate(CAL_OFF);
 					gui_navigate(GUI_LAYOUT_MAIN1);
 				}
 			} else if (g_key_press & KEY_CANCEL) {
-				// ToDo: eeprom_get_data(EEPROM_ADC_CAL, cal_data);
+				sticks_calibrate_abort();
 				gui_navigate(GUI_LAYOUT_MAIN1);
 			}
+
+			if (m != GUI_MSG_NONE) {
+				lcd_draw_rect(5, 0, 123, BOX_Y - 1, LCD_OP_CLR, RECT_FILL);
+				lcd_draw_message(str_get(STR_MSG, m), LCD_OP_SET, 0, 0);
+			}
 		}
 	}
 		break;
@@ -1793,7 +2095,7 @@ static void gui_update_trim(void) {
  * @note
  * @param  x, y: The TL position of the bar on screen.
  * @param  h_v: Whether the trim is horizontal (true) or vertical (false)
- * @param  value: The value of the trim (location of the rectangle) from -100 to +100.
+ * @param  value: The value of the trim (location of the rectangle), +/- MIXER_TRIM_LIMIT.
  * @retval None
  */
 static void gui_draw_trim(int x, int y, bool h_v, int value) {
@@ -1952,6 +2254,17 @@ static void gui_string_edit(char *string, int8_t delta, uint32_t keys) {
 	}
 }
 
+/**
+ * @brief  Write all 8 hex digits of a value.
+ * @note
+ * @param  val: The value.
+ * @retval None
+ */
+static void gui_write_hex32(uint32_t val) {
+	lcd_write_hex(val >> 16, LCD_OP_SET, FLAGS_NONE);
+	lcd_write_hex(val & 0xFFFF, LCD_OP_SET, FLAGS_NONE);
+}
+
 /**
  * @brief  Draw a box around the string and allow each 'bit' (character) to be enabled / disabled.
  * @note
@@ -31,6 +31,7 @@ typedef enum
 	GUI_LAYOUT_SYSTEM_MENU,
 	GUI_LAYOUT_MODEL_MENU,
 	GUI_LAYOUT_STICK_CALIBRATION,
+	GUI_LAYOUT_STARTUP_CHECK,
 
 } GUI_LAYOUT;
 
@@ -1,93 +1,54 @@
-/*
- *                  Copyright 2014 ARTaylor.co.uk
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License version 3 as
- * published by the Free Software Foundation.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * Author: Richard Taylor (richard@artaylor.co.uk)
- */
-
-/* Description:
- *
- * This is a simple icon module.
- * 32x32 icons are indexed and written directly to the lcd_buffer.
- *
- */
-
-
-//------------------------------------------------------------------------------
-// File generated by LCD Assistant
-// http://en.radzio.dxp.pl/bitmap_converter/
-//------------------------------------------------------------------------------
-
-#include <string.h>
-
-#include "stm32f10x.h"
-#include "lcd.h"
-
-/*
-const unsigned char radio_settings [] = {
-0x00, 0xC0, 0xC0, 0x80, 0x00, 0xC0, 0xC0, 0x00, 0x80, 0xC0, 0xC0, 0x08, 0x04, 0x02, 0x04, 0x02,
-0x81, 0x80, 0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x01, 0x03, 0x07, 0xFF, 0xFF, 0x07, 0x03, 0x01, 0x00, 0x00, 0x78, 0xDC, 0x8E, 0x07,
-0x33, 0x7F, 0xE3, 0xC1, 0x80, 0x80, 0x80, 0xC0, 0xE0, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xC3, 0xE0, 0x70, 0xB8, 0x1C, 0xAE, 0xC7, 0xEB, 0x71, 0x3A,
-0x1C, 0x0C, 0x18, 0x11, 0x19, 0x1C, 0x0E, 0x06, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x03, 0x07, 0x06, 0x07, 0x03, 0x01, 0x00, 0x00, 0x00,
-0x00, 0x6C, 0x92, 0x92, 0x6C, 0x00, 0x70, 0x88, 0x88, 0x00, 0xFE, 0x10, 0xE0, 0x00, 0x00, 0x00
-};
-*/
-
-const unsigned char radio_settings [] = {
-0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x88, 0x88, 0xC8, 0xC8, 0x88, 0x88, 0x88, 0xEA, 0xFF,
-0xFF, 0xEA, 0x88, 0x88, 0x88, 0xC8, 0xC8, 0x88, 0x88, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00,
-0x00, 0xF0, 0xF9, 0x0E, 0x26, 0x83, 0x41, 0x41, 0x21, 0x21, 0x43, 0x47, 0x8D, 0x28, 0x08, 0x0C,
-0x0A, 0x09, 0x28, 0x8D, 0x47, 0x43, 0x21, 0x21, 0x41, 0x41, 0x83, 0x26, 0x0E, 0xF9, 0xF0, 0x00,
-0x00, 0xFF, 0xFF, 0x80, 0x46, 0x19, 0x20, 0x20, 0x46, 0x46, 0x20, 0x20, 0x19, 0x46, 0x00, 0xE3,
-0x23, 0xE0, 0x06, 0x19, 0x20, 0x20, 0x46, 0x46, 0x20, 0x20, 0x19, 0x46, 0x80, 0xFF, 0xFF, 0x00,
-0x00, 0x9F, 0xBF, 0xB3, 0xA1, 0xA5, 0xE5, 0xE1, 0xE1, 0xE1, 0xE1, 0xA1, 0xA1, 0xA1, 0xA1, 0xA1,
-0xA1, 0xA1, 0xA1, 0xA1, 0xAD, 0xE1, 0xED, 0xE1, 0xED, 0xE1, 0xAD, 0xA1, 0xB3, 0xBF, 0x9F, 0x00
-};
-
-const unsigned char model_settings [] = {
-0x00, 0x00, 0x00, 0x00, 0x00, 0x78, 0xFC, 0xFE, 0xFF, 0xF0, 0xE0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0,
-0xC0, 0xE0, 0xF0, 0xFF, 0xFE, 0xFC, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0x80, 0x81, 0x83, 0x87, 0x8F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
-0x7F, 0x8F, 0xC7, 0x23, 0xA1, 0xA0, 0xA0, 0xA0, 0xA0, 0xA0, 0xA0, 0xA0, 0xA0, 0x20, 0xC0, 0x00,
-0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-0xFF, 0x00, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x01, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
-0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-};
-
-
-void icon_draw(uint8_t index, uint8_t x, uint8_t y)
-{
-	const unsigned char *ptr;
-	int y1;
-
-	switch (index)
-	{
-		case 0:
-			ptr = radio_settings;
-		break;
-
-		default:
-		case 1:
-			ptr = model_settings;
-		break;
-	}
-
-	// This only works if we're on an 8-pixel boundary.
-	for (y1 = y/8; y1 < (y + 32)/8; ++y1)
-	{
-		memcpy(&lcd_buffer[x + y1*LCD_WIDTH], ptr, 32);
-		ptr += 32;
-	}
-}
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Author: Richard Taylor (richard@artaylor.co.uk)
+ */
+
+/* Description:
+ *
+ * This is a simple icon module.
+ * 32x32 icons are indexed and drawn into the lcd_buffer from the packed
+ * bitmaps in assets.c.
+ *
+ */
+
+#include "stm32f10x.h"
+#include "lcd.h"
+#include "bitmap.h"
+#include "assets.h"
+
+/**
+  * @brief  Draw a 32x32 icon.
+  * @note
+  * @param  index: 0 radio settings, 1 model settings.
+  * @param  x: Left column.
+  * @param  y: Top row, any row.
+  * @retval None
+  */
+void icon_draw(uint8_t index, uint8_t x, uint8_t y)
+{
+	const uint8_t *bmp;
+
+	switch (index)
+	{
+		case 0:
+			bmp = asset_radio_settings;
+		break;
+
+		default:
+		case 1:
+			bmp = asset_model_settings;
+		break;
+	}
+
+	bitmap_draw(bmp, x, y, LCD_OP_SET);
+}
@@ -20,6 +20,13 @@
  * This will then call into the mixer (for trim) and GUI.
  * GUI events are asynchronous, and will be processed on the next main loop cycle.
  *
+ * While idle all the columns are driven low, so any key pulls its row low
+ * and fires the EXTI. The row IRQs are then masked and keypad_tick() walks
+ * the columns from the SysTick, one per ms so each has settled by the time
+ * its rows are read. A full scan takes 4ms and a key must be the same for
+ * KEY_DEBOUNCE_SCANS scans to change the debounced state. Once all keys
+ * have been released the columns go back to low and the IRQs are unmasked.
+ *
  */
 
 #include <stdbool.h>
@@ -35,12 +42,17 @@
 #include "gui.h"
 #include "sound.h"
 #include "myeeprom.h"
+#include "capture.h"
 
 #define ROW_MASK       (0x07 << 12)
 #define COL_MASK       (0x0F << 8)
 #define ROW(n)         (1 << (12 + n))
 #define COL(n)         (1 << (8 + n))
 
+#define KEY_COLS			4
+#define KEY_ROWS			3
+#define KEY_DEBOUNCE_SCANS	2
+
 #define KEY_HOLDOFF			10
 #define KEY_REPEAT_DELAY	500
 #define KEY_REPEAT_TIME		100
@@ -50,7 +62,26 @@ static uint32_t keys_pressed = 0;
 static uint32_t key_repeat = 0;
 static uint32_t key_time = 0;
 
+// Key on each column (down) and row (across), there is none on col 0, row 2.
+static const uint16_t key_matrix[KEY_COLS][KEY_ROWS] = {
+	{ KEY_CH1_UP, KEY_CH3_UP, KEY_NONE },
+	{ KEY_CH1_DN, KEY_CH3_DN, KEY_SEL },
+	{ KEY_CH2_UP, KEY_CH4_UP, KEY_OK },
+	{ KEY_CH2_DN, KEY_CH4_DN, KEY_CANCEL },
+};
+
+// Background scan, from the SysTick and EXTI handlers.
+static bool scanning;
+static uint8_t scan_col;
+static uint16_t scan_keys;		// Keys seen so far in this scan.
+static uint16_t scan_last;		// Keys seen by the last full scan.
+static uint8_t scan_same;		// Full scans in a row that saw scan_last.
+
+// Debounced state of every matrix key.
+static volatile uint16_t key_state;
+
 static void keypad_process(uint32_t data);
+static KEYPAD_KEY keypad_first_key(uint16_t keys);
 
 /**
  * @brief  Initialise the keypad scanning pins.
@@ -120,6 +151,18 @@ void keypad_init(void) {
 	task_register(TASK_PROCESS_KEYPAD, keypad_process);
 }
 
+/**
+ * @brief  Get the debounced state of all the matrix keys.
+ * @note   Does not touch the hardware, so is safe to call at any time.
+ *         Three keys on the corners of a rectangle in the matrix also show
+ *         the fourth as down.
+ * @param  None
+ * @retval uint16_t: Bitmask of the KEY_xxx that are down.
+ */
+uint16_t keypad_get_state(void) {
+	return key_state;
+}
+
 /**
  * @brief  Poll to see if a specific key has been pressed
  * @note
@@ -194,10 +237,8 @@ static void keypad_process(uint32_t data) {
 		return;
 	}
 
-	// Scan the keys.
-	key = keypad_scan_keys();
-	// Scanning the keys causes the IRQ to fire, so de-schedule for now.
-	task_deschedule(TASK_PROCESS_KEYPAD);
+	// Take the first key down.
+	key = keypad_first_key(key_state);
 
 	// Cancel the repeat if we see a different key.
 	if (key == KEY_NONE) {
@@ -238,6 +279,12 @@ static void keypad_process(uint32_t data) {
 						key = KEY_MENU;
 					else
 						return;
+				} else if (key & (KEY_OK | KEY_CANCEL)) {
+					// Likewise one long press from KEY_OK and KEY_CANCEL.
+					if (key_repeat == 0)
+						key = (key & KEY_OK) ? KEY_OK_LONG : KEY_CANCEL_LONG;
+					else
+						return;
 				} else if (!(key & TRIM_KEYS)) {
 					// For non-trim keys, don't repeat.
 					return;
@@ -259,90 +306,87 @@ static void keypad_process(uint32_t data) {
 			sound_play_tone(500, 10);
 
 		// Send the key to the UI.
+		capture_key(key);
 		gui_input_key(key);
 	}
 }
 
 /**
- * @brief  Scan the keypad and return the active key.
- * @note   Will only return the first key found if multiple keys pressed.
- * @param  None
+ * @brief  Find the first key down in a key state.
+ * @note   In scan order, only one key is handled at a time.
+ * @param  keys: Bitmask of the keys down.
  * @retval KEYPAD_KEY
  *   Returns the active key
  *     @arg KEY_xxx: The key that was pressed
  *     @arg KEY_NONE: No key was pressed
  */
-KEYPAD_KEY keypad_scan_keys(void) {
-	KEYPAD_KEY key = KEY_NONE;
-	bool found = false;
-	uint16_t rows;
-	uint8_t col;
-
-	for (col = 0; col < 4; ++col) {
-		// Walk a '0' down the cols.
-		GPIO_SetBits(GPIOB, COL_MASK);
-		GPIO_ResetBits(GPIOB, COL(col));
+static KEYPAD_KEY keypad_first_key(uint16_t keys) {
+	uint8_t col, row;
 
-		// Allow some time for the GPIO to settle.
-		delay_us(100);
-
-		// The rows are pulled high externally.
-		// Any '0' seen here is due to a switch connecting to our active '0' on a column.
-		rows = GPIO_ReadInputData(GPIOB);
-		if ((rows & ROW_MASK) != ROW_MASK) {
-			// Only support one key pressed at a time.
-			found = true;
-			break;
+	for (col = 0; col < KEY_COLS; ++col) {
+		for (row = 0; row < KEY_ROWS; ++row) {
+			if (keys & key_matrix[col][row])
+				return key_matrix[col][row];
 		}
 	}
+	return KEY_NONE;
+}
 
-	// Set the cols to all '0'.
-	GPIO_ResetBits(GPIOB, COL_MASK);
+/**
+ * @brief  Step the background key scan.
+ * @note   Called from the SysTick handler every ms. The row IRQs stay
+ *         masked from the start of a scan until it stops.
+ * @param  None
+ * @retval None
+ */
+void keypad_tick(void) {
+	uint16_t rows;
+	uint8_t row;
 
-	if (found) {
-		rows = ~rows & ROW_MASK;
+	if (!scanning)
+		return;
 
-		switch (col) {
-		case 0:
-			if ((rows & ROW(0)) != 0)
-				key = KEY_CH1_UP;
-			else if ((rows & ROW(1)) != 0)
-				key = KEY_CH3_UP;
-			break;
+	// The rows are pulled high externally.
+	// Any '0' seen here is due to a switch connecting to our active '0' on a column.
+	rows = ~GPIO_ReadInputData(GPIOB);
+	for (row = 0; row < KEY_ROWS; ++row) {
+		if (rows & ROW(row))
+			scan_keys |= key_matrix[scan_col][row];
+	}
 
-		case 1:
-			if ((rows & ROW(0)) != 0)
-				key = KEY_CH1_DN;
-			else if ((rows & ROW(1)) != 0)
-				key = KEY_CH3_DN;
-			else if ((rows & ROW(2)) != 0)
-				key = KEY_SEL;
-			break;
+	if (++scan_col < KEY_COLS) {
+		// Walk a '0' down the cols, read on the next tick.
+		GPIO_SetBits(GPIOB, COL_MASK);
+		GPIO_ResetBits(GPIOB, COL(scan_col));
+		return;
+	}
 
-		case 2:
-			if ((rows & ROW(0)) != 0)
-				key = KEY_CH2_UP;
-			else if ((rows & ROW(1)) != 0)
-				key = KEY_CH4_UP;
-			else if ((rows & ROW(2)) != 0)
-				key = KEY_OK;
-			break;
+	// End of a full scan.
+	if (scan_keys != scan_last) {
+		scan_last = scan_keys;
+		scan_same = 1;
+	} else if (scan_same < KEY_DEBOUNCE_SCANS) {
+		scan_same++;
+	}
 
-		case 3:
-			if ((rows & ROW(0)) != 0)
-				key = KEY_CH2_DN;
-			else if ((rows & ROW(1)) != 0)
-				key = KEY_CH4_DN;
-			else if ((rows & ROW(2)) != 0)
-				key = KEY_CANCEL;
-			break;
+	if (scan_same >= KEY_DEBOUNCE_SCANS && scan_last != key_state) {
+		key_state = scan_last;
+		task_schedule(TASK_PROCESS_KEYPAD, 0, 0);
+	}
 
-		default:
-			break;
-		}
+	if (key_state == 0 && scan_last == 0) {
+		// All released, wait for the next key.
+		scanning = false;
+		GPIO_ResetBits(GPIOB, COL_MASK);
+		EXTI->PR = KEYPAD_EXTI_LINES;
+		EXTI->IMR |= KEYPAD_EXTI_LINES;
+		return;
 	}
 
-	return key;
+	scan_col = 0;
+	scan_keys = 0;
+	GPIO_SetBits(GPIOB, COL_MASK);
+	GPIO_ResetBits(GPIOB, COL(0));
 }
 
 /**
@@ -358,8 +402,15 @@ void EXTI15_10_IRQHandler(void) {
 		// Clear the IRQ
 		EXTI->PR = KEYPAD_EXTI_LINES;
 
-		// Schedule the keys to be scanned.
-		task_schedule(TASK_PROCESS_KEYPAD, 0, 0);
+		// Start the background scan, the rows toggle as it walks the cols.
+		EXTI->IMR &= ~KEYPAD_EXTI_LINES;
+		scan_col = 0;
+		scan_keys = 0;
+		scan_last = 0;
+		scan_same = 1;
+		GPIO_SetBits(GPIOB, COL_MASK);
+		GPIO_ResetBits(GPIOB, COL(0));
+		scanning = true;
 	}
 
 	if ((flags & ROTARY_EXTI_LINES) != 0) {
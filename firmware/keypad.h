@@ -41,7 +41,9 @@ typedef enum
     KEY_RIGHT = 0x1000,	// Rotary encoder
 
     /* Long press Keys */
-    KEY_MENU = 0x2000,
+    KEY_MENU = 0x2000,		// KEY_SEL
+    KEY_OK_LONG = 0x4000,
+    KEY_CANCEL_LONG = 0x8000,
 } KEYPAD_KEY;
 
 typedef enum
@@ -53,7 +55,8 @@ typedef enum
 } KEYPAD_SWITCH;
 
 void keypad_init(void);
-KEYPAD_KEY keypad_scan_keys(void);
+uint16_t keypad_get_state(void);
+void keypad_tick(void);
 bool keypad_get_pressed(KEYPAD_KEY key);
 uint8_t keypad_get_switches(void);
 bool keypad_get_switch(KEYPAD_SWITCH sw);
@@ -34,6 +34,7 @@
 
 #include "tasks.h"
 #include "lcd.h"
+#include "fonts.h"
 
 #include "lcd_font_medium.h"
 
@@ -71,13 +72,34 @@ static uint8_t contrast = 0x28;
 
 uint8_t lcd_buffer[LCD_WIDTH * LCD_HEIGHT / 8];
 
-#define FONT_STRIDE				(16 * 5)
-
 static uint8_t cursor_x = 0;
 static uint8_t cursor_y = 0;
 
 static const unsigned char *font = font_medium;
 
+// Each nibble with its bits doubled, to draw the 5x7 font double height.
+static const uint8_t nibble_double[16] = {
+	0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+	0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF,
+};
+
+#define MSG_CACHE		2		// A popup and a page message.
+#define MSG_LINES		(LCD_HEIGHT / (CHAR_HEIGHT + 1))
+
+// Where a message wraps, for a width in chars, and where it was drawn.
+typedef struct
+{
+	const char *msg;
+	uint8_t width;
+	uint8_t lines;				// All of them, only MSG_LINES fit.
+	uint8_t x, y;
+	uint16_t start[MSG_LINES];
+	uint8_t len[MSG_LINES];
+} MsgLayout;
+
+static MsgLayout msg_cache[MSG_CACHE];
+static uint8_t msg_cache_next;
+
 /**
   * @brief  Send a command to the LCD.
   * @note	Switch the MPU interface to command mode and send
@@ -278,9 +300,119 @@ void lcd_set_cursor(uint8_t x, uint8_t y)
 	cursor_y = y;
 }
 
+/**
+  * @brief  Draw bits into a byte of the lcd_buffer.
+  * @param  dst: lcd_buffer byte
+  * @param  bits: Pixels to draw
+  * @param  op: LCD_OP
+  * @retval None
+  */
+static void lcd_write_bits(uint8_t *dst, uint8_t bits, LCD_OP op)
+{
+	switch (op)
+	{
+	case LCD_OP_CLR:
+		*dst &= ~bits;
+		break;
+	case LCD_OP_SET:
+		*dst |= bits;
+		break;
+	case LCD_OP_XOR:
+		*dst ^= bits;
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+  * @brief  Draw one column of a character.
+  * @note	The column goes down from cursor_y, so it is written a page at a
+  *			time rather than a pixel at a time.
+  * @param  x: Screen column
+  * @param  bits: Pixels, bit 0 at the top.
+  * @param  rows: Height of the column.
+  * @param  op_set: LCD_OP for the set pixels.
+  * @param  op_clr: LCD_OP for the clear pixels.
+  * @retval None
+  */
+static void lcd_write_column(uint8_t x, uint32_t bits, uint8_t rows, LCD_OP op_set, LCD_OP op_clr)
+{
+	uint8_t shift = cursor_y % 8;
+	uint32_t mask = ((1UL << rows) - 1) << shift;
+	uint8_t *dst = &lcd_buffer[x + (cursor_y / 8) * LCD_WIDTH];
+
+	bits = (bits << shift) & mask;
+	while (mask != 0)
+	{
+		lcd_write_bits(dst, bits, op_set);
+		lcd_write_bits(dst, mask & ~bits, op_clr);
+		mask >>= 8;
+		bits >>= 8;
+		dst += LCD_WIDTH;
+	}
+}
+
+/**
+  * @brief  Find the glyph for a character.
+  * @note	CHAR_4X uses the pre-scaled large font where it has the
+  *			character, otherwise the 5x7 font is doubled as it is drawn.
+  * @param  c: ASCII character
+  * @param  flags: LCD_FLAGS (CHAR_*)
+  * @param  glyph: Set to the first column to draw.
+  * @param  large: Set if the glyph is from the large font.
+  * @retval Number of columns in the glyph.
+  */
+static uint8_t lcd_find_glyph(uint8_t c, uint16_t flags, const uint8_t **glyph, bool *large)
+{
+	uint8_t m;
+
+	if ((flags & CHAR_4X) != 0 && c >= FONT_LARGE_FIRST && c <= FONT_LARGE_LAST)
+	{
+		c -= FONT_LARGE_FIRST;
+		m = font_large_metrics[c];
+		*glyph = &font_large[c * FONT_LARGE_STRIDE + FONT_LEAD(m)];
+		*large = true;
+		return FONT_WIDTH(m);
+	}
+
+	if (c >= FONT_GLYPHS)
+		c = '?';
+	*glyph = &font[c * CHAR_WIDTH];
+	*large = false;
+	if ((flags & CHAR_PROP) == 0)
+		return CHAR_WIDTH;
+
+	m = font_prop[c];
+	*glyph += FONT_LEAD(m);
+	return FONT_WIDTH(m);
+}
+
+/**
+  * @brief  Width of a character.
+  * @note	This is what ALIGN_RIGHT allows for, a condensed character
+  *			is allowed a column more than it takes.
+  * @param  c: ASCII character
+  * @param  flags: LCD_FLAGS (CHAR_*)
+  * @retval Width in pixels, including the space after.
+  */
+uint8_t lcd_char_width(uint8_t c, uint16_t flags)
+{
+	const uint8_t *glyph;
+	bool large;
+	uint8_t width = lcd_find_glyph(c, flags, &glyph, &large);
+
+	if ((flags & CHAR_4X) != 0 && !large)
+		width *= 2;
+
+	return (flags & CHAR_CONDENSED) ? width : width + 1;
+}
+
 /**
   * @brief  Write a character.
-  * @note
+  * @note	Drawn a column at a time. CHAR_2X and CHAR_4X double the rows
+  *			of the 5x7 font with a lookup, CHAR_4X also doubles the columns
+  *			unless the large font has the character.
   * @param  c: ASCII character to write
   * @param  op: LCD_OP
   * @param  flags: LCD_FLAGS (CHAR_*)
@@ -288,27 +420,22 @@ void lcd_set_cursor(uint8_t x, uint8_t y)
   */
 void lcd_write_char(uint8_t c, LCD_OP op, uint16_t flags)
 {
-	uint8_t x, y;
-	uint8_t x1, y1, divX = 1, divY = 1;
-	uint8_t height = CHAR_HEIGHT;
-	uint8_t width = CHAR_WIDTH;
-	uint8_t row = 0;
+	const uint8_t *glyph;
+	bool large;
+	uint8_t x, i;
+	uint8_t columns = lcd_find_glyph(c, flags, &glyph, &large);
+	uint8_t rows = CHAR_HEIGHT + 1;
+	uint8_t repeat = 1;
 	LCD_OP op_set = (op==LCD_OP_SET)?LCD_OP_SET:LCD_OP_CLR;
 	LCD_OP op_clr = (op==LCD_OP_SET)?LCD_OP_CLR:LCD_OP_SET;
 
-	if ((flags & CHAR_2X) != 0)
-	{
-		height *= 2;
-		width *= 1;
-		divY = 2;
-	}
-	else if ((flags & CHAR_4X) != 0)
-	{
-		height *=2;
-		width *=2;
-		divX = 2;
-		divY = 2;
-	}
+	if (large)
+		rows = FONT_LARGE_HEIGHT + 1;
+	else if ((flags & (CHAR_2X | CHAR_4X)) != 0)
+		rows = CHAR_HEIGHT * 2 + 1;
+
+	if ((flags & CHAR_4X) != 0 && !large)
+		repeat = 2;
 
 	if (op == LCD_OP_XOR)
 	{
@@ -320,41 +447,37 @@ void lcd_write_char(uint8_t c, LCD_OP op, uint16_t flags)
 	if (flags & CHAR_CONDENSED)
 		op_clr = LCD_OP_NONE;
 
-	if ((cursor_y+height) >= LCD_HEIGHT) return;
-	else if ((cursor_x+width) >= LCD_WIDTH) return;
+	if ((cursor_y + rows - 1) >= LCD_HEIGHT) return;
+	else if ((cursor_x + columns * repeat) >= LCD_WIDTH) return;
 
-	for (x=0; x<width; x++ )
+	for (x = 0; x < columns; x++)
 	{
-		row = 0;
-		for (y=0; y<height + 1; y++)
-		{
-			uint8_t d;
-			x1 = x / divX;
-			y1 = y / divY;
-			d = font[ (c*CHAR_WIDTH) + x1 + row*FONT_STRIDE ];
-			if (flags & CHAR_UNDERLINE)
-				d |= 0x80;
-
-			if (d & (1 << y1%8))
-				lcd_set_pixel(cursor_x+x, cursor_y+y, op_set);
-			else
-				lcd_set_pixel(cursor_x+x, cursor_y+y, op_clr);
-
-			if (y1%8 == 7)
-				row++;
-		}
+		uint32_t bits;
+
+		if (large)
+			bits = glyph[x] | (glyph[x + FONT_LARGE_WIDTH] << 8);
+		else if (rows > 8)
+			bits = nibble_double[glyph[x] & 0x0F] | (nibble_double[glyph[x] >> 4] << 8);
+		else
+			bits = glyph[x];
+
+		if (flags & CHAR_UNDERLINE)
+			bits |= 1UL << (rows - 1);
 
-		if ((flags & CHAR_CONDENSED) != 0 && x%CHAR_WIDTH==4)
-			cursor_x--;
+		for (i = 0; i < repeat; ++i)
+			lcd_write_column(cursor_x++, bits, rows, op_set, op_clr);
 	}
-	for (y=0; y<height+1; y++) lcd_set_pixel(cursor_x+width, cursor_y+y, op_clr);
+	lcd_write_column(cursor_x, 0, rows, op_set, op_clr);
 
-	cursor_x += width + 1;
+	cursor_x++;
 	if ((flags & (CHAR_CONDENSED | CHAR_NOSPACE)) != 0)
 		cursor_x--;
+	// Condensed chars overlap by a column.
+	if ((flags & CHAR_CONDENSED) != 0)
+		cursor_x--;
 
 	if (cursor_x >= LCD_WIDTH)
-	cursor_y += height + 1;
+	cursor_y += rows;
 }
 
 /**
@@ -372,7 +495,8 @@ void lcd_write_string(const char *s, LCD_OP op, uint16_t flags)
 
 	if (flags & ALIGN_RIGHT)
 	{
-		cursor_x -= n * ((flags & CHAR_CONDENSED) ? CHAR_WIDTH : (CHAR_WIDTH + 1));
+		for (ptr = s; *ptr; ptr++)
+			cursor_x -= lcd_char_width(*ptr, flags);
 	}
 
 	for (ptr = s; n > 0; ptr++, n--)
@@ -400,7 +524,7 @@ static int16_t u;
   */
 void lcd_write_int(int32_t val, LCD_OP op, uint16_t flags)
 {
-	int count = 0;
+	uint8_t width = 0;
 
 	if (val < 0) u = -val;
 	else u = val;
@@ -415,19 +539,16 @@ void lcd_write_int(int32_t val, LCD_OP op, uint16_t flags)
 
 	if (flags & ALIGN_RIGHT)
 	{
-		if (val < 0) count++;
+		if (val < 0) width += lcd_char_width('-', flags);
 		//if (val >= 0) lcd_write_char('+', op);
 
-		if (tth > 0) count++;
-		if (tth > 0 || th > 0) count++;
-		if (tth > 0 || th > 0 || h > 0) count++;
-		if (tth > 0 || th > 0 || h > 0 || t > 0 || (flags & INT_DIV10) || (flags & INT_PAD10)) count++;
-		if (flags & INT_DIV10) count++;
+		if (tth > 0) width += lcd_char_width(tth + '0', flags);
+		if (tth > 0 || th > 0) width += lcd_char_width(th + '0', flags);
+		if (tth > 0 || th > 0 || h > 0) width += lcd_char_width(h + '0', flags);
+		if (tth > 0 || th > 0 || h > 0 || t > 0 || (flags & INT_DIV10) || (flags & INT_PAD10)) width += lcd_char_width(t + '0', flags);
+		if (flags & INT_DIV10) width += lcd_char_width('.', flags);
 
-		if (flags & CHAR_CONDENSED)
-			cursor_x -= count * CHAR_WIDTH;
-		else
-			cursor_x -= count * (CHAR_WIDTH + 1);
+		cursor_x -= width;
 	}
 
 	if (val < 0) lcd_write_char('-', op, flags);
@@ -560,24 +681,30 @@ void lcd_draw_rect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, LCD_OP op, ui
 }
 
 /**
-  * @brief  Draw a message with line wrapping
-  * @note	Starts at the cursor and uses the x offset as a margin.
-  * @param  msg: ASCII message to write
-  * @param  op: LCD_OP
-  * @param: op2: LCD_OP for selected line if any
-  * @param: selected line or 0 for none
-  * @retval lines drawed
+  * @brief  Find where a message wraps.
+  * @note	Cached by address and width, so msg must not change.
+  * @param  msg: ASCII message
+  * @param  width: Line width in chars.
+  * @retval The layout
   */
-char lcd_draw_message(const char *msg, LCD_OP op, LCD_OP op2, char selectedLine)
+static MsgLayout *lcd_layout_message(const char *msg, uint8_t width)
 {
-	char line = 1;
-	const int width = (LCD_WIDTH - 2*cursor_x) / (CHAR_WIDTH + 1);
-	char line_buffer[LCD_WIDTH / (CHAR_WIDTH + 1)];
-	int nchars;
+	MsgLayout *l;
 	const char *ptr = msg;
-	int x = cursor_x;
+	uint8_t i;
+
+	for (i = 0; i < MSG_CACHE; ++i)
+	{
+		if (msg_cache[i].msg == msg && msg_cache[i].width == width)
+			return &msg_cache[i];
+	}
+
+	l = &msg_cache[msg_cache_next];
+	msg_cache_next = (msg_cache_next + 1) % MSG_CACHE;
+	l->msg = msg;
+	l->width = width;
+	l->lines = 0;
 
-	// Iterate through the string to print it
 	while (*ptr)
 	{
 		const char *p;
@@ -599,14 +726,84 @@ char lcd_draw_message(const char *msg, LCD_OP op, LCD_OP op2, char selectedLine)
 				break;
 			}
 		}
-		nchars = p - ptr;
-		memcpy(line_buffer, ptr, nchars);
-		line_buffer[nchars] = 0;
-		cursor_x = x + (width - nchars) * (CHAR_WIDTH + 1) / 2;
-		lcd_write_string(line_buffer, line == selectedLine ? op2 : op, FLAGS_NONE);
+		if (l->lines < MSG_LINES)
+		{
+			l->start[l->lines] = ptr - msg;
+			l->len[l->lines] = p - ptr;
+		}
+		l->lines++;
+		// Skip the space or new line, a word split at the width is kept.
+		ptr = (*p == ' ' || *p == '\n') ? p+1 : p;
+	}
+	return l;
+}
+
+/**
+  * @brief  Draw a message with line wrapping
+  * @note	Starts at the cursor and uses the x offset as a margin.
+  *			The wrap points are cached, see lcd_layout_message().
+  * @param  msg: ASCII message to write
+  * @param  op: LCD_OP
+  * @param: op2: LCD_OP for selected line if any
+  * @param: selected line or 0 for none
+  * @retval lines drawed
+  */
+char lcd_draw_message(const char *msg, LCD_OP op, LCD_OP op2, char selectedLine)
+{
+	const uint8_t width = (LCD_WIDTH - 2*cursor_x) / (CHAR_WIDTH + 1);
+	MsgLayout *l = lcd_layout_message(msg, width);
+	uint8_t line;
+
+	// Keep only where it was last drawn, for lcd_invert_message_line().
+	for (line = 0; line < MSG_CACHE; ++line)
+	{
+		if (msg_cache[line].msg == msg && &msg_cache[line] != l)
+			msg_cache[line].msg = 0;
+	}
+
+	l->x = cursor_x;
+	l->y = cursor_y;
+	for (line = 0; line < l->lines && line < MSG_LINES; ++line)
+	{
+		const char *p = msg + l->start[line];
+		uint8_t n;
+
+		cursor_x = l->x + (width - l->len[line]) * (CHAR_WIDTH + 1) / 2;
+		for (n = l->len[line]; n > 0; --n)
+			lcd_write_char(*p++, line + 1 == selectedLine ? op2 : op, FLAGS_NONE);
 		cursor_y += (CHAR_HEIGHT + 1);
-		line++;
-		ptr = *p ? p+1 : p;
 	}
-	return line-1;
+	return l->lines;
+}
+
+/**
+  * @brief  Invert a line of a message.
+  * @note	After lcd_draw_message(), to move the selection without
+  *			drawing the message again.
+  * @param  msg: ASCII message, as drawn.
+  * @param  line: Line to invert, from 1.
+  * @retval None
+  */
+void lcd_invert_message_line(const char *msg, char line)
+{
+	uint8_t i, x, y;
+
+	for (i = 0; i < MSG_CACHE; ++i)
+	{
+		const MsgLayout *l = &msg_cache[i];
+
+		if (l->msg != msg)
+			continue;
+		if (line < 1 || line > l->lines || line > MSG_LINES || l->len[line - 1] == 0)
+			return;
+
+		// The cells lcd_write_char() would have drawn.
+		x = l->x + (l->width - l->len[line - 1]) * (CHAR_WIDTH + 1) / 2;
+		y = l->y + (line - 1) * (CHAR_HEIGHT + 1);
+		if (y + CHAR_HEIGHT >= LCD_HEIGHT)
+			return;
+		lcd_draw_rect(x, y, x + l->len[line - 1] * (CHAR_WIDTH + 1) - 1,
+				y + CHAR_HEIGHT, LCD_OP_XOR, RECT_FILL);
+		return;
+	}
 }
@@ -45,13 +45,14 @@ typedef enum {
 	INT_PAD10 = 0x10,	// Put a decimal point 1 digit from the end
 
 	CHAR_2X = 0x100,	// Draw double size
-	CHAR_4X = 0x200,	// Draw quadrouple size
+	CHAR_4X = 0x200,	// Draw quadrouple size, large font for numbers
 	CHAR_CONDENSED = 0x400,	// Draw with 4th column missing
 	CHAR_UNDERLINE = 0x800,	// Underline each char
 	CHAR_NOSPACE = 0x1000,
 
 	ALIGN_RIGHT = 0x2000,
 	TRAILING_SPACE = 0x4000,
+	CHAR_PROP = 0x8000,	// Proportional, each char only as wide as it needs
 } LCD_FLAGS;
 
 void lcd_init(void);
@@ -60,6 +61,7 @@ void lcd_set_contrast(uint8_t val);
 void lcd_update(void);
 void lcd_set_pixel(uint8_t x, uint8_t y, LCD_OP op);
 void lcd_set_cursor(uint8_t x, uint8_t y);
+uint8_t lcd_char_width(uint8_t c, uint16_t flags);
 void lcd_write_char(uint8_t c, LCD_OP op, uint16_t flags);
 void lcd_write_string(const char *s, LCD_OP op, uint16_t flags);
 void lcd_write_int(int32_t val, LCD_OP op, uint16_t flags);
@@ -67,6 +69,7 @@ void lcd_write_hex(uint32_t val, LCD_OP op, uint16_t flags);
 void lcd_draw_line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, LCD_OP op);
 void lcd_draw_rect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, LCD_OP op, uint16_t flags);
 char lcd_draw_message(const char *msg, LCD_OP op, LCD_OP op2, char selectedLine);
+void lcd_invert_message_line(const char *msg, char line);
 
 extern uint8_t lcd_buffer[LCD_WIDTH * LCD_HEIGHT / 8];
 
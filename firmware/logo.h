@@ -1,71 +0,0 @@
-//------------------------------------------------------------------------------
-// File generated by LCD Assistant
-// http://en.radzio.dxp.pl/bitmap_converter/
-//------------------------------------------------------------------------------
-
-const unsigned char logo [] = {
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xC0, 0x60, 0x60, 0xC0, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE0, 0xE0,
-0xF0, 0xF8, 0xEC, 0xE6, 0xE3, 0xE1, 0xE0, 0xE0, 0x20, 0xF8, 0x69, 0xBF, 0x68, 0xB8, 0x68, 0xF8,
-0x20, 0xE0, 0xE0, 0xE0, 0xE0, 0xE0, 0xE0, 0xE0, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFC, 0x02, 0x01, 0x01, 0x01, 0x42,
-0xFC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x20, 0x10, 0x0E, 0x00, 0xC0, 0x20, 0x10, 0x0E,
-0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x40, 0x7E, 0x40, 0xC0, 0x00, 0x00, 0x00, 0xFE, 0x00, 0x00,
-0x00, 0x00, 0x00, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x20, 0x20, 0xF8, 0x00, 0xFF, 0xFF,
-0xFF, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, 0x03, 0x02, 0x0F, 0x1B, 0x3E, 0x1B, 0x0E, 0x0B, 0x0F,
-0x02, 0x03, 0x03, 0x03, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x82, 0x92,
-0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x12, 0x0C, 0x00, 0x00, 0x21, 0x12, 0x0C,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x02, 0xFE, 0x02, 0x03, 0x00, 0xF0, 0x90, 0x9F, 0x90, 0xF0,
-0x00, 0x3C, 0x24, 0xE7, 0x24, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x3C, 0xFF, 0xFF,
-0xFF, 0xFF, 0xFF, 0xE0, 0xE8, 0xE8, 0xE8, 0xE8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0x18, 0x18, 0x08,
-0x08, 0x08, 0x08, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x20, 0x24,
-0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x04, 0x04, 0x9F, 0x80, 0xFF, 0xFF,
-0xFF, 0xFF, 0xFF, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
-0x80, 0x80, 0x80, 0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x70, 0xA8, 0x54, 0xAB, 0x56, 0xAA, 0x56, 0xAA, 0x57,
-0xAB, 0x54, 0xA8, 0x70, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0xE0, 0x00, 0x00, 0x00,
-0xE0, 0xA0, 0xA0, 0xE0, 0x00, 0xC0, 0x20, 0x20, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x20, 0x20, 0x20, 0xC0, 0x00, 0xC0, 0x20, 0x20, 0xC0, 0x00, 0xC0, 0x20, 0x20,
-0xC0, 0x00, 0x00, 0x60, 0x90, 0x60, 0x00, 0xE0, 0x10, 0x10, 0x10, 0x20, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F, 0x7F, 0x7F,
-0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
-0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x07, 0x0A, 0x15, 0x2A, 0x35, 0x6A, 0x55, 0x6A, 0x35,
-0x2A, 0x15, 0x0A, 0x07, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x07, 0x04, 0x00, 0x00,
-0x04, 0x04, 0x06, 0x03, 0x00, 0x03, 0x04, 0x04, 0x03, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00,
-0x00, 0x00, 0x00, 0x04, 0x05, 0x05, 0x06, 0x00, 0x03, 0x04, 0x04, 0x03, 0x00, 0x03, 0x04, 0x04,
-0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x04, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00,
-0x00, 0xC0, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0xC0,
-0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0xC0, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00,
-0x00, 0x00, 0x00, 0x00, 0xC0, 0x70, 0x30, 0xC0, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x10, 0x10, 0x10,
-0x10, 0xE0, 0x00, 0x10, 0x10, 0x10, 0xF0, 0x10, 0x10, 0x10, 0xC0, 0x40, 0x40, 0x40, 0xC0, 0x80,
-0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0xC0, 0x40, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x80, 0xC0, 0x40,
-0x40, 0xC0, 0x80, 0x00, 0x00, 0x00, 0xC0, 0x80, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x80, 0xC0,
-0x40, 0x40, 0x40, 0x00, 0x00, 0x80, 0xC0, 0x40, 0x40, 0xC0, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
-0x00, 0xC0, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x80, 0x40, 0x00, 0x00,
-0x00, 0x03, 0x1C, 0x1E, 0x01, 0x03, 0x1C, 0x1E, 0x01, 0x00, 0x00, 0x00, 0x03, 0x1C, 0x1E, 0x01,
-0x03, 0x1C, 0x1E, 0x01, 0x00, 0x00, 0x03, 0x1C, 0x1E, 0x01, 0x03, 0x1C, 0x1E, 0x01, 0x00, 0x00,
-0x10, 0x00, 0x10, 0x1E, 0x07, 0x04, 0x04, 0x05, 0x0E, 0x18, 0x00, 0x00, 0x1F, 0x01, 0x01, 0x01,
-0x03, 0x0E, 0x18, 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x0C, 0x12, 0x12, 0x12, 0x0A, 0x1F,
-0x00, 0x00, 0x81, 0xCE, 0x70, 0x0E, 0x01, 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x0F, 0x18, 0x10,
-0x10, 0x18, 0x0F, 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x0F, 0x18,
-0x10, 0x10, 0x10, 0x00, 0x00, 0x0F, 0x18, 0x10, 0x10, 0x18, 0x0F, 0x00, 0x00, 0x00, 0x10, 0x00,
-0x00, 0x0F, 0x10, 0x10, 0x08, 0x1F, 0x00, 0x00, 0x00, 0x1F, 0x02, 0x05, 0x08, 0x10, 0x00, 0x00
-};
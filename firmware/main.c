@@ -32,7 +32,12 @@
 #include "mixer.h"
 #include "sound.h"
 #include "eeprom.h"
-#include "logo.h"
+#include "recorder.h"
+#include "serial.h"
+#include "startup.h"
+#include "crash.h"
+#include "watchdog.h"
+#include "stack.h"
 
 volatile EEGeneral  g_eeGeneral;
 volatile ModelData  g_model;
@@ -46,7 +51,13 @@ uint8_t SlaveMode;		// Trainer Slave
   */
 void SysTick_Handler(void)
 {
+	uint32_t mark = stack_isr_enter(STACK_ISR_TICK);
+
 	system_ticks++;
+	watchdog_tick();
+	keypad_tick();
+
+	stack_isr_exit(STACK_ISR_TICK, mark);
 }
 
 /**
@@ -60,6 +71,9 @@ int main(void)
 	// PLL and stack setup has aready been done.
 	SystemCoreClockUpdate();
 
+	// Fill the free stack so the high water mark can be measured.
+	stack_init();
+
 	// 1ms System tick
 	SysTick_Config(SystemCoreClock / 1000);
 	RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
@@ -67,36 +81,26 @@ int main(void)
 	// Initialize the task loop.
 	task_init();
 
+	// Check for a lockup or fault before the last reset.
+	watchdog_init();
+
 	// Initialize the keypad scanner (with IRQ wakeup).
 	keypad_init();
 
-	// Initialize the LCD and display logo.
+	// Initialize the LCD. The GUI starts on the splash screen,
+	// which is shown from the task loop once everything is running.
 	lcd_init();
 	gui_init();
 
-	// Initialize the EEPROM
+	// Load the settings and current model, everything below depends on them.
 	eeprom_init();
 
-	// set contrast but to a reasonable value
-	uint16_t contrast = g_eeGeneral.contrast;
-	if( contrast < LCD_CONTRAST_MIN ) contrast = LCD_CONTRAST_MIN;
-	if( contrast > LCD_CONTRAST_MAX ) contrast = LCD_CONTRAST_MAX;
-	lcd_set_contrast(contrast);
-
-	if( !g_eeGeneral.disableSplashScreen )
-	{
-		// Put the logo into out frame buffer
-		memcpy(lcd_buffer, logo, LCD_WIDTH * LCD_HEIGHT / 8);
-		lcd_update();
-		delay_ms(2000);
-	}
-
-	// ToDo: Block here until all switches are set correctly.
-	//check_switches();
-
-	// Initialize the buzzer
+	// The mixer feeds both of these.
 	sound_init();
+	recorder_init();
 
+	// Start the radio output as soon as possible. Until the first
+	// mixer pass the outputs hold the values preset by mixer_init().
 	mixer_init();
 
 	// Initialize the ADC / DMA
@@ -105,7 +109,24 @@ int main(void)
 	// Start the radio output.
 	pulses_init();
 
-	gui_navigate(GUI_LAYOUT_MAIN1);
+	// set contrast but to a reasonable value
+	uint16_t contrast = g_eeGeneral.contrast;
+	if( contrast < LCD_CONTRAST_MIN ) contrast = LCD_CONTRAST_MIN;
+	if( contrast > LCD_CONTRAST_MAX ) contrast = LCD_CONTRAST_MAX;
+	lcd_set_contrast(contrast);
+
+	// Throttle and switch warnings. The throttle is held at idle until
+	// they pass, without holding up the rest of the boot.
+	startup_init();
+
+	// Start the debug / configuration link.
+	serial_init();
+
+	// Save and report a fault from before the last reset.
+	crash_init();
+
+	// Supervise the mixer, PPM and main loop from here on.
+	watchdog_start();
 
 	/*
 	 * The main loop will sit in low power mode waiting for an interrupt.
@@ -133,6 +154,7 @@ int main(void)
 
 		// Process any tasks.
 		task_process_all();
+		watchdog_heartbeat(WATCHDOG_MAIN);
 
 
 		// Wait for an interrupt
@@ -148,75 +170,3 @@ int main(void)
 void NMI_Handler(void)
 {
 }
-
-#define ENABLE_HARD_FAILURE_HELPER 0
-#if ENABLE_HARD_FAILURE_HELPER
-
-static
-void prvGetRegistersFromStack( uint32_t *pulFaultStackAddress )
-{
-	/* These are volatile to try and prevent the compiler/linker optimising them
-	away as the variables never actually get used.  If the debugger won't show the
-	values of the variables, make them global my moving their declaration outside
-	of this function. */
-	volatile uint32_t r0;
-	volatile uint32_t r1;
-	volatile uint32_t r2;
-	volatile uint32_t r3;
-	volatile uint32_t r12;
-	volatile uint32_t lr; /* Link register. */
-	volatile uint32_t pc; /* Program counter. */
-	volatile uint32_t psr;/* Program status register. */
-
-    r0 = pulFaultStackAddress[ 0 ];
-    r1 = pulFaultStackAddress[ 1 ];
-    r2 = pulFaultStackAddress[ 2 ];
-    r3 = pulFaultStackAddress[ 3 ];
-
-    r12 = pulFaultStackAddress[ 4 ];
-    lr = pulFaultStackAddress[ 5 ];
-    pc = pulFaultStackAddress[ 6 ];
-    psr = pulFaultStackAddress[ 7 ];
-
-    /* When the following line is hit, the variables contain the register values. */
-    for( ;; );
-}
-
-
-/* The prototype shows it is a naked function - in effect this is just an
-assembly function. */
-void HardFault_Handler( void ) __attribute__( ( naked ) );
-
-
-/**
-  * @brief  This function handles Hard Fault exception.
-  * @param  None
-  * @retval None
-  */
-void HardFault_Handler(void)
-{
-    __asm volatile
-    (
-        " tst lr, #4                                                \n"
-        " ite eq                                                    \n"
-        " mrseq r0, msp                                             \n"
-        " mrsne r0, psp                                             \n"
-        " ldr r1, [r0, #24]                                         \n"
-        " ldr r2, handler2_address_const                            \n"
-        " bx r2                                                     \n"
-        " handler2_address_const: .word prvGetRegistersFromStack    \n"
-    );
-}
-
-#else
-
-/**
-  * @brief  This function handles Hard Fault exception.
-  * @param  None
-  * @retval None
-  */
-void HardFault_Handler(void)
-{
-	while(1) {}
-}
-#endif
@@ -35,20 +35,66 @@
 #include "mixer.h"
 #include "sound.h"
 #include "keypad.h"
+#include "recorder.h"
+#include "monitor.h"
+#include "failsafe.h"
+#include "startup.h"
+#include "watchdog.h"
+#include "strings.h"
+
+volatile uint32_t g_mixer_passes;
+volatile uint16_t g_mixer_us;
+volatile uint16_t g_mixer_max_us;
+
+// Trim steps for each TRIM_INC_xxx, exponential grows by 1 every 32.
+#define TRIM_STEP_EXP_DIV	32
+#define TRIM_STEP_FINE		1
+#define TRIM_STEP_MEDIUM	4
+#define TRIM_STEP_COARSE	16
+// A held trim key repeats every 100ms. The step doubles after this many
+// repeats, and doubles again after twice as many.
+#define TRIM_HOLD_FAST		10
+#define TRIM_HOLD_GAP		250		// ms between presses that still count as held
+
+static KEYPAD_KEY trim_key;			// Last trim key and when it was seen
+static uint32_t trim_time;
+static uint8_t trim_held;			// Repeats of trim_key
+static bool trim_pending;			// Trims changed since they were last saved
+static volatile bool trim_transfer;	// Move trims to offsets on the next pass
+static volatile bool model_held;	// g_model is being saved, don't change it
+static bool ppm_in_used;			// The last pass took PPM-IN, for the failsafe
+
+// Instant trim: the sticks are averaged over this many passes (320ms).
+#define INSTANT_TRIM_PASSES	16
+
+static volatile uint8_t instant_passes;	// Passes left to average, 0 = idle
+static int32_t instant_sum[4];
+static int16_t instant_comp[4];		// Taken off the sticks until they centre
+static int16_t undo_trim[4];
+static volatile bool undo_valid;
+static volatile bool undo_request;
+static volatile bool instant_done;		// Trims changed, for the GUI
 
-static int16_t trim_increment;
 static void perOut(volatile int16_t *chanOut, uint8_t att);
+static void trims_to_offsets(void);
+static void instant_trim_pass(void);
 
 /**
   * @brief  Initialise the mixer.
-  * @note
+  * @note	Call once the model is loaded. Presets the outputs so that
+  *         pulses can be sent before the first mixer pass: one settled
+  *         pass with the sticks centred and the throttle at idle, so
+  *         trims, offsets, limits and reverse all apply.
   * @param  None
   * @retval None
   */
 void mixer_init(void)
 {
-	// Coarse trim
-	trim_increment = 10;
+	// Carry on from the last good outputs after a lockup.
+	if (watchdog_restore_chans())
+		return;
+
+	perOut(g_chans, NO_TRAINER | NO_INPUT | NO_STATE | THR_IDLE);
 }
 
 /**
@@ -60,18 +106,72 @@ void mixer_init(void)
   */
 void mixer_update(void)
 {
+	uint32_t start = SysTick->VAL;
+	uint32_t end;
+	uint32_t cycles;
+
 	// Input data is in stick_data[].
 	// Values are scaled to +/- RESX
 
 	// =================================
 	// Output Channel Data
 	// =================================
+	ppm_in_used = false;
 	perOut(g_chans, 0);
+	failsafe_ppm_in_used(ppm_in_used);
+
+	// Trim changes wait while g_model is being saved.
+	if (!model_held)
+	{
+		if (trim_transfer)
+		{
+			trims_to_offsets();
+			trim_transfer = false;
+		}
+		instant_trim_pass();
+	}
+
+	recorder_sample();
+	monitor_sample();
+
+	// SysTick counts down and reloads every 1ms.
+	end = SysTick->VAL;
+	cycles = (start >= end) ? start - end : start + SysTick->LOAD + 1 - end;
+	g_mixer_us = cycles / (SystemCoreClock / 1000000);
+	if (g_mixer_us > g_mixer_max_us)
+		g_mixer_max_us = g_mixer_us;
+	g_mixer_passes++;
+}
+
+/**
+  * @brief  Get the size of the next trim step.
+  * @note	Exponential steps grow with the distance from centre, so the
+  *         trim is fine near centre and still reaches the ends quickly.
+  * @param  trim: The current trim.
+  * @retval Step size in 1/RESX.
+  */
+static int16_t trim_step(int16_t trim)
+{
+	switch (g_model.trimInc)
+	{
+	case TRIM_INC_FINE:
+		return TRIM_STEP_FINE;
+	case TRIM_INC_MEDIUM:
+		return TRIM_STEP_MEDIUM;
+	case TRIM_INC_COARSE:
+		return TRIM_STEP_COARSE;
+	default:
+		return 1 + abs(trim) / TRIM_STEP_EXP_DIV;
+	}
 }
 
 /**
   * @brief  Receive key presses and update the trim data
-  * @note
+  * @note	Holding a trim key speeds it up. A trim stops at centre and at
+  *         the ends, with a longer beep. The change is kept in g_model but
+  *         not saved until the trims have been quiet for MIXER_TRIM_QUIET.
+  *         The mixer pass is held off while the trim is changed, it can
+  *         set the trims itself (instant trim, undo, trims to offsets).
   * @param  key: Which trim key was pressed.
   * @retval None
   */
@@ -80,6 +180,8 @@ void mixer_input_trim(KEYPAD_KEY key)
 	uint8_t channel = 0;
 	int8_t increment = 0;
 	uint8_t endstop = 0;
+	int16_t step;
+	int16_t trim;
 
 	switch (key)
 	{
@@ -102,38 +204,145 @@ void mixer_input_trim(KEYPAD_KEY key)
 		channel = 3; increment = -1; break;
 
 	default:
-		break;
+		return;
 	}
 
-	if (increment > 0)
+	// Hold to accelerate.
+	if (key == trim_key && system_ticks - trim_time < TRIM_HOLD_GAP)
 	{
-		if (g_model.trim[channel] < MIXER_TRIM_LIMIT)
-			g_model.trim[channel] += trim_increment;
-		else
-			endstop = 1;
+		if (trim_held < 2 * TRIM_HOLD_FAST)
+			trim_held++;
 	}
 	else
+		trim_held = 0;
+	trim_key = key;
+	trim_time = system_ticks;
+
+	NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+	trim = g_model.trim[channel];
+	step = trim_step(trim);
+	if (trim_held >= 2 * TRIM_HOLD_FAST)
+		step *= 4;
+	else if (trim_held >= TRIM_HOLD_FAST)
+		step *= 2;
+	trim += increment * step;
+
+	// Stop at centre on the way through.
+	if ((g_model.trim[channel] < 0 && trim >= 0) || (g_model.trim[channel] > 0 && trim <= 0))
 	{
-		if (g_model.trim[channel] > -MIXER_TRIM_LIMIT)
-			g_model.trim[channel] -= trim_increment;
-		else
-			endstop = 1;
+		trim = 0;
+		endstop = 1;
 	}
-
-	if (g_model.trim[channel] == 0)
+	if (trim >= MIXER_TRIM_LIMIT)
+	{
+		trim = MIXER_TRIM_LIMIT;
+		endstop = 1;
+	}
+	if (trim <= -MIXER_TRIM_LIMIT)
+	{
+		trim = -MIXER_TRIM_LIMIT;
 		endstop = 1;
+	}
+
+	if (trim != g_model.trim[channel])
+	{
+		g_model.trim[channel] = trim;
+		trim_pending = true;
+	}
+	NVIC_EnableIRQ(DMA1_Channel1_IRQn);
 
 	if (endstop != 0)
 	{
+		trim_held = 0;
 		keypad_cancel_repeat();
-		sound_play_tone(500 + 250*g_model.trim[channel]/MIXER_TRIM_LIMIT, 200);
+		sound_play_tone(500 + 250*trim/MIXER_TRIM_LIMIT, 200);
 	}
 	else
 	{
-		sound_play_tone(500 + 250*g_model.trim[channel]/MIXER_TRIM_LIMIT, 100);
+		sound_play_tone(500 + 250*trim/MIXER_TRIM_LIMIT, 100);
 	}
 }
 
+/**
+  * @brief  Check whether trim changes are waiting to be saved.
+  * @note	True until the trims have been left alone for MIXER_TRIM_QUIET,
+  *         so a trimming session is saved once, not at every step.
+  * @param  None
+  * @retval bool: true while the model should not be saved for the trims.
+  */
+bool mixer_trim_pending(void)
+{
+	if (trim_pending && system_ticks - trim_time >= MIXER_TRIM_QUIET)
+		trim_pending = false;
+	return trim_pending;
+}
+
+/**
+  * @brief  Keep the mixer pass from changing g_model.
+  * @note	While held, instant trims, undo and moving the trims to the
+  *         offsets wait for the next pass after the hold is released.
+  * @param  hold: true while g_model is being saved.
+  * @retval None
+  */
+void mixer_hold_model(bool hold)
+{
+	model_held = hold;
+}
+
+/**
+  * @brief  Move the trims into the output offsets (sub trims).
+  * @note	Done by the next mixer pass. The throttle trim is left alone
+  *         when it is a throttle idle trim.
+  * @param  None
+  * @retval None
+  */
+void mixer_trims_to_offsets(void)
+{
+	trim_transfer = true;
+}
+
+/**
+  * @brief  Trim the model to the current stick positions.
+  * @note	The sticks (not throttle) are averaged over the next
+  *         INSTANT_TRIM_PASSES mixer passes and added to the trims in one
+  *         pass. The old trims can be put back with mixer_instant_trim_undo().
+  * @param  None
+  * @retval None
+  */
+void mixer_instant_trim(void)
+{
+	if (instant_passes == 0)
+	{
+		instant_sum[0] = instant_sum[1] = instant_sum[2] = instant_sum[3] = 0;
+		instant_passes = INSTANT_TRIM_PASSES;
+	}
+}
+
+/**
+  * @brief  Put back the trims from before the last instant trim.
+  * @note	Only one level. Done by the next mixer pass.
+  * @param  None
+  * @retval None
+  */
+void mixer_instant_trim_undo(void)
+{
+	if (undo_valid)
+		undo_request = true;
+}
+
+/**
+  * @brief  Check whether an instant trim or undo has changed the trims.
+  * @note	Clears the indication.
+  * @param  None
+  * @retval bool: true if the trims changed since the last call.
+  */
+bool mixer_instant_trim_done(void)
+{
+	bool done = instant_done;
+	instant_done = false;
+	return done;
+}
+
 /**
   * @brief  Return the current value for the specified input.
   * @note
@@ -165,14 +374,6 @@ static uint8_t  bpanaCenter = 0;
 
 static uint8_t stickMoved = 0;
 
-static int8_t *TrimPtr[4] =
-{
-    &g_model.trim[0],
-    &g_model.trim[1],
-    &g_model.trim[2],
-    &g_model.trim[3]
-};
-
 // DR - double rate sticks
 // dwSw1 dwSw2
 //   1     x	HIGH
@@ -272,6 +473,111 @@ int16_t intpol(int16_t x, uint8_t idx) // -100, -75, -50, -25, 0 ,25 ,50, 75, 10
 }
 
 
+/**
+  * @brief  Move the trims into the output offsets.
+  * @note	Runs the mixer with the sticks centred, with and without the
+  *         trims, and adds the difference to each channel's offset.
+  *         The live pass's inputs and outputs are put back afterwards.
+  * @param  None
+  * @retval None
+  */
+static void trims_to_offsets(void)
+{
+    int16_t before[NUM_CHNOUT];
+    int16_t after[NUM_CHNOUT];
+    int16_t live_anas[NUM_XCHNRAW];
+    int32_t live_chans[NUM_CHNOUT];
+    uint8_t i;
+
+    memcpy(live_anas, anas, sizeof(anas));
+    memcpy(live_chans, chans, sizeof(chans));
+    perOut(before, NO_TRAINER | NO_INPUT | NO_STATE);
+    for(i=0; i<4; i++)
+        if(!(IS_THROTTLE(i) && g_model.thrTrim)) g_model.trim[i] = 0;
+    perOut(after, NO_TRAINER | NO_INPUT | NO_STATE);
+    memcpy(anas, live_anas, sizeof(anas));
+    memcpy(chans, live_chans, sizeof(chans));
+
+    for(i=0; i<NUM_CHNOUT; i++)
+    {
+        int32_t diff = before[i] - after[i];
+        int32_t v = g_model.limitData[i].offset;
+
+        if(g_model.limitData[i].reverse) diff = -diff;
+        v += diff * 1000 / RESX;
+        if(v > MIXER_OFFSET_LIMIT) v = MIXER_OFFSET_LIMIT;
+        if(v < -MIXER_OFFSET_LIMIT) v = -MIXER_OFFSET_LIMIT;
+        g_model.limitData[i].offset = v;
+    }
+}
+
+/**
+  * @brief  Note a trim change made by the mixer pass.
+  * @param  None
+  * @retval None
+  */
+static void instant_trim_changed(void)
+{
+	trim_pending = true;
+	trim_time = system_ticks;
+	instant_done = true;
+}
+
+/**
+  * @brief  Run the instant trim from the mixer pass.
+  * @note	The new trims take effect from the next pass. While the pilot
+  *         still holds the sticks where they were, instant_comp takes the
+  *         same amount off the sticks, so the outputs don't jump. It
+  *         follows each stick back to centre and is then gone.
+  * @param  None
+  * @retval None
+  */
+static void instant_trim_pass(void)
+{
+	uint8_t i;
+
+	if (undo_request)
+	{
+		for (i = 0; i < 4; i++)
+		{
+			g_model.trim[i] = undo_trim[i];
+			instant_comp[i] = 0;
+		}
+		instant_passes = 0;
+		undo_valid = false;
+		undo_request = false;
+		instant_trim_changed();
+		return;
+	}
+
+	if (instant_passes == 0)
+		return;
+
+	for (i = 0; i < 4; i++)
+		instant_sum[i] += anas[i];
+	if (--instant_passes != 0)
+		return;
+
+	for (i = 0; i < 4; i++)
+	{
+		int16_t delta = instant_sum[i] / INSTANT_TRIM_PASSES;
+		int16_t trim = g_model.trim[i];
+
+		undo_trim[i] = trim;
+		if (IS_THROTTLE(i))
+			continue;
+		if (delta > MIXER_TRIM_LIMIT - trim)
+			delta = MIXER_TRIM_LIMIT - trim;
+		if (delta < -MIXER_TRIM_LIMIT - trim)
+			delta = -MIXER_TRIM_LIMIT - trim;
+		g_model.trim[i] = trim + delta;
+		instant_comp[i] += delta;
+	}
+	undo_valid = true;
+	sound_play_tone(1000, 200);
+	instant_trim_changed();
+}
+
 static void perOut(volatile int16_t *chanOut, uint8_t att)
 {
     int16_t trimA[4];
@@ -282,7 +588,7 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
     static uint32_t last10ms = 0;
     uint8_t tick10ms;
 
-    if (last10ms < system_ticks && (system_ticks % 10) == 0)
+    if (!(att&NO_STATE) && last10ms < system_ticks && (system_ticks % 10) == 0)
     {
     	tick10ms = 1;
     	last10ms = system_ticks;
@@ -361,6 +667,7 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
                     if (td->mode && keypad_get_switch(td->swtch))
                     {
                         uint8_t chStud = td->srcChn;
+                        ppm_in_used = true;
                         int16_t vStud  = (g_ppmIns[chStud]- g_eeGeneral.trainer.calib[chStud]) /* *2 */ ;
                         vStud /= 2 ;		// Only 2, because no *2 above
                         vStud *= td->studWeight ;
@@ -373,6 +680,13 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
                     }
                 }
 
+                // Throttle held at idle until the startup checks pass,
+                // whatever the trainer adds or substitutes.
+                if ( i == THR_STICK && ((att&THR_IDLE) || startup_hold()) )
+                {
+                    v = -RESX ;
+                }
+
                 //===========Swash Ring================
                 if(d && (i==ELE_STICK || i==AIL_STICK))
                     v = (int32_t)(v)*g_model.swashRingValue*RESX/((int32_t)(d)*100);
@@ -396,20 +710,28 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
                 int32_t vv = 2*RESX;
 				if(IS_THROTTLE(i) && g_model.thrTrim)
 				{
-					int8_t ttrim ;
-					ttrim = *TrimPtr[i] ;
+					int16_t ttrim ;
+					ttrim = g_model.trim[i] ;
 					if(g_eeGeneral.throttleReversed)
 					{
 						ttrim = -ttrim ;
 					}
-					vv = ((int32_t)ttrim+125)*(RESX-v)/(2*RESX);
+					vv = ((int32_t)ttrim+MIXER_TRIM_LIMIT)*(RESX-v)/(4*RESX);
 				}
-//                if(IS_THROTTLE(i) && g_model.thrTrim) vv = ((int32_t)*TrimPtr[i]+125)*(RESX-v)/(2*RESX);
 
                 //trim
-                trimA[i] = (vv==2*RESX) ? *TrimPtr[i]*2 : (int16_t)vv*2; //    if throttle trim -> trim low end
+                trimA[i] = (vv==2*RESX) ? g_model.trim[i] : (int16_t)vv; //    if throttle trim -> trim low end
             }
             anas[i] = v; //set values for mixer
+
+            //===========Instant trim================
+            if(i<4 && instant_comp[i])
+            {
+                // Follow the stick back to centre, then let go.
+                if((instant_comp[i] > 0) ? (v < instant_comp[i]) : (v > instant_comp[i]))
+                    instant_comp[i] = ((v > 0) == (instant_comp[i] > 0)) ? v : 0;
+                anas[i] = v - instant_comp[i];
+            }
         }
 
         //===========BEEP CENTER================
@@ -446,9 +768,10 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
             int16_t vp = anas[ELE_STICK]+trimA[ELE_STICK];
             int16_t vr = anas[AIL_STICK]+trimA[AIL_STICK];
 
-            if(att&NO_INPUT)  //zero input for setStickCenter()
+            if(att&NO_INPUT)  //zero input, trims only
             {
-                vp = vr = 0;
+                vp = trimA[ELE_STICK];
+                vr = trimA[AIL_STICK];
             }
 
             int16_t vc = 0;
@@ -497,11 +820,10 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
 
     memset(chans,0,sizeof(chans));        // All outputs to 0
 
-    if(att&NO_INPUT) { //zero input for setStickCenter()
+    if(att&NO_INPUT) { //zero input, trims only
         for(i=0;i<4;i++) {
             if(!IS_THROTTLE(i)) {
                 anas[i]  = 0;
-                trimA[i] = 0;
             }
         }
         for(i=0;i<4;i++) anas[i+PPM_BASE] = 0;
@@ -509,18 +831,15 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
 
     //========== MIXER LOOP ===============
 
-    // Set the trim pointers back to the master set
-    TrimPtr[0] = &g_model.trim[0] ;
-    TrimPtr[1] = &g_model.trim[1] ;
-    TrimPtr[2] = &g_model.trim[2] ;
-    TrimPtr[3] = &g_model.trim[3] ;
-
     for(i=0; i<MAX_MIXERS; i++){
         MixData *md = &g_model.mixData[i];
 
         // first unused entry (channel==0) marks an end
         if((md->destCh==0) || (md->destCh>NUM_CHNOUT)) break;
 
+        // Source "off": there is no input to mix.
+        if(md->srcRaw==0) continue;
+
         /* srcRaw
         STK1..STK4
         VRA, VRB
@@ -540,7 +859,7 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
         //swOn[i]=false;
         if(!keypad_get_switch(md->swtch)) { // switch on?  if no switch selected => on
             swTog = swOn[i];
-            swOn[i] = 0;
+            if(!(att&NO_STATE)) swOn[i] = 0;
             //            if(md->srcRaw==MIX_MAX) act[i] = 0;// MAX back to 0 for slow up
             //            if(md->srcRaw!=MIX_FULL) continue;// if not FULL - next loop
             //            v = -RESX; // switch is off  => FULL=-RESX
@@ -551,32 +870,20 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
         }
         else {
             swTog = !swOn[i];
-            swOn[i] = 1;
+            if(!(att&NO_STATE)) swOn[i] = 1;
             uint8_t k = md->srcRaw-1;
             v = anas[k]; //Switch is on. MAX=FULL=512 or value.
             if(k>=CHOUT_BASE && (k<i)) v = chans[k-CHOUT_BASE]; // if we've already calculated the value - take it instead // anas[i+CHOUT_BASE] = chans[i]
-            if(md->mixWarn) mixWarning |= 1<<(md->mixWarn-1); // Mix warning
-#ifdef FMODE_TRIM
-            if ( md->enableFmTrim )
-            {
-                if ( md->srcRaw <= 4 )
-                {
-                    TrimPtr[md->srcRaw-1] = &md->sOffset ;		// Use the value stored here for the trim
-                }
-            }
-#endif
+            if(k>=PPM_BASE && k<CHOUT_BASE) ppm_in_used = true;
+            if(md->mixWarn && !(att&NO_STATE)) mixWarning |= 1<<(md->mixWarn-1); // Mix warning
         }
 
         //========== INPUT OFFSET ===============
-#ifdef FMODE_TRIM
-        if ( md->enableFmTrim == 0 )
-#endif
-        {
-            if(md->sOffset) v += calc100toRESX(md->sOffset);
-        }
+        if(md->sOffset) v += calc100toRESX(md->sOffset);
 
         //========== DELAY and PAUSE ===============
-        if (md->speedUp || md->speedDown || md->delayUp || md->delayDown)  // there are delay values
+        // NO_STATE takes the settled value.
+        if (!(att&NO_STATE) && (md->speedUp || md->speedDown || md->delayUp || md->delayDown))  // there are delay values
         {
 #define DEL_MULT 256
 
@@ -738,7 +1045,7 @@ static void perOut(volatile int16_t *chanOut, uint8_t att)
         int32_t q = chans[i];// + (int32_t)g_model.limitData[i].offset*100; // offset before limit
 
         chans[i] /= 100; // chans back to -1024..1024
-        ex_chans[i] = chans[i]; //for getswitch
+        if(!(att&NO_STATE)) ex_chans[i] = chans[i]; //for getswitch
 
         int16_t ofs = g_model.limitData[i].offset;
         int16_t lim_p = 10*(g_model.limitData[i].max);//+100);
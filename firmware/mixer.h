@@ -21,12 +21,27 @@
 #include "sticks.h"
 #include "keypad.h"
 
-#define MIXER_TRIM_LIMIT	100
+// Trims are in 1/RESX steps.
+#define MIXER_TRIM_LIMIT	500
+// Output offsets are in 0.1% steps. This is as wide as the limits page shows.
+#define MIXER_OFFSET_LIMIT	500
+// Trim changes are saved once the trims have been left alone this long (ms).
+#define MIXER_TRIM_QUIET	3000
+
+extern volatile uint32_t g_mixer_passes;
+extern volatile uint16_t g_mixer_us;
+extern volatile uint16_t g_mixer_max_us;
 
 void mixer_init(void);
 void mixer_update(void);
 
 void mixer_input_trim(KEYPAD_KEY key);
 int16_t mixer_get_trim(STICK stick);
+bool mixer_trim_pending(void);
+void mixer_hold_model(bool hold);
+void mixer_trims_to_offsets(void);
+void mixer_instant_trim(void);
+void mixer_instant_trim_undo(void);
+bool mixer_instant_trim_done(void);
 
 #endif // _MIXER_H
@@ -0,0 +1,349 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Compressed model images for backup, restore and copy.
+ * Most of a ModelData is either untouched defaults or zero (unused mixes,
+ * curves, safety switches), so the image is a run length encoding against
+ * g_modelDefaults. Encoder and decoder are streaming and only hold a
+ * handful of bytes of state.
+ * This is also the format models are stored in (see eeprom.c).
+ *
+ */
+
+#include <string.h>
+
+#include "modelimg.h"
+#include "myeeprom.h"
+#include "eeprom.h"
+
+#define RUN_NONE		0
+#define RUN_LITERAL		1
+#define RUN_ZERO		2
+#define RUN_DEFAULT		3
+
+static const uint8_t *defaults = (const uint8_t*) &g_modelDefaults;
+
+/**
+  * @brief  Emit the pending run.
+  * @note
+  * @param  enc: Encoder
+  * @retval None
+  */
+static void modelimg_flush(ModelImgEncoder *enc)
+{
+	uint8_t i;
+
+	switch (enc->run_type)
+	{
+	case RUN_LITERAL:
+		enc->put(enc->run_len - 1, enc->ctx);
+		for (i = 0; i < enc->run_len; i++)
+			enc->put(enc->lit[i], enc->ctx);
+		break;
+	case RUN_ZERO:
+		enc->put(0x0F + enc->run_len, enc->ctx);
+		break;
+	case RUN_DEFAULT:
+		enc->put(0x7F + enc->run_len, enc->ctx);
+		break;
+	}
+
+	enc->run_type = RUN_NONE;
+	enc->run_len = 0;
+}
+
+/**
+  * @brief  Start encoding a model.
+  * @note	Writes the image header.
+  * @param  enc: Encoder state
+  * @param  put: Called for each output byte
+  * @param  ctx: Passed to put
+  * @retval None
+  */
+void modelimg_encode_start(ModelImgEncoder *enc, void (*put)(uint8_t, void*), void *ctx)
+{
+	enc->pos = 0;
+	enc->run_type = RUN_NONE;
+	enc->run_len = 0;
+	enc->put = put;
+	enc->ctx = ctx;
+
+	put(MODELIMG_VERSION, ctx);
+	put(sizeof(ModelData) & 0xFF, ctx);
+	put(sizeof(ModelData) >> 8, ctx);
+}
+
+/**
+  * @brief  Encode the next part of a model.
+  * @note	Data must be supplied in order, in any sized pieces.
+  * @param  enc: Encoder state
+  * @param  data: Model bytes
+  * @param  length: Number of bytes
+  * @retval None
+  */
+void modelimg_encode(ModelImgEncoder *enc, const uint8_t *data, uint16_t length)
+{
+	while (length-- && enc->pos < sizeof(ModelData))
+	{
+		uint8_t b = *data++;
+		uint8_t type;
+		uint8_t max;
+
+		if (b == defaults[enc->pos]) {
+			type = RUN_DEFAULT;
+			max = MODELIMG_DEFAULT_MAX;
+		} else if (b == 0) {
+			type = RUN_ZERO;
+			max = MODELIMG_ZERO_MAX;
+		} else {
+			type = RUN_LITERAL;
+			max = MODELIMG_LITERAL_MAX;
+		}
+
+		if (type != enc->run_type || enc->run_len == max)
+		{
+			modelimg_flush(enc);
+			enc->run_type = type;
+		}
+
+		if (type == RUN_LITERAL)
+			enc->lit[enc->run_len] = b;
+		enc->run_len++;
+		enc->pos++;
+	}
+}
+
+/**
+  * @brief  Finish the image.
+  * @note
+  * @param  enc: Encoder state
+  * @retval None
+  */
+void modelimg_encode_end(ModelImgEncoder *enc)
+{
+	modelimg_flush(enc);
+}
+
+/**
+  * @brief  Start decoding an image.
+  * @note
+  * @param  dec: Decoder state
+  * @param  put: Called for each model byte, in order
+  * @param  ctx: Passed to put
+  * @retval None
+  */
+void modelimg_decode_start(ModelImgDecoder *dec, void (*put)(uint8_t, void*), void *ctx)
+{
+	dec->pos = 0;
+	dec->size = 0;
+	dec->hdr = 0;
+	dec->run_type = RUN_NONE;
+	dec->run_len = 0;
+	dec->put = put;
+	dec->ctx = ctx;
+}
+
+/**
+  * @brief  Decode the next part of an image.
+  * @note
+  * @param  dec: Decoder state
+  * @param  data: Image bytes
+  * @param  length: Number of bytes
+  * @retval MODELIMG_DONE once the whole model has been produced,
+  *         MODELIMG_ERROR if the image is corrupt or for a different layout.
+  */
+MODELIMG_STATUS modelimg_decode(ModelImgDecoder *dec, const uint8_t *data, uint16_t length)
+{
+	while (length--)
+	{
+		uint8_t b = *data++;
+
+		if (dec->hdr < MODELIMG_HDR_LEN)
+		{
+			if (dec->hdr == 0 && b != MODELIMG_VERSION)
+				return MODELIMG_ERROR;
+			if (dec->hdr == 1)
+				dec->size = b;
+			if (dec->hdr == 2)
+			{
+				dec->size |= b << 8;
+				if (dec->size != sizeof(ModelData))
+					return MODELIMG_ERROR;
+			}
+			dec->hdr++;
+			continue;
+		}
+
+		if (dec->pos >= sizeof(ModelData))
+			return MODELIMG_ERROR;
+
+		if (dec->run_len == 0)
+		{
+			// New token
+			if (b < 0x10) {
+				dec->run_type = RUN_LITERAL;
+				dec->run_len = b + 1;
+				continue;
+			} else if (b < 0x80) {
+				dec->run_type = RUN_ZERO;
+				dec->run_len = b - 0x0F;
+			} else {
+				dec->run_type = RUN_DEFAULT;
+				dec->run_len = b - 0x7F;
+			}
+
+			if (dec->pos + dec->run_len > sizeof(ModelData))
+				return MODELIMG_ERROR;
+			while (dec->run_len)
+			{
+				dec->put(dec->run_type == RUN_ZERO ? 0 : defaults[dec->pos], dec->ctx);
+				dec->pos++;
+				dec->run_len--;
+			}
+		}
+		else
+		{
+			// Literal byte
+			dec->put(b, dec->ctx);
+			dec->pos++;
+			dec->run_len--;
+		}
+	}
+
+	if (dec->hdr == MODELIMG_HDR_LEN && dec->pos == sizeof(ModelData) && dec->run_len == 0)
+		return MODELIMG_DONE;
+	return MODELIMG_MORE;
+}
+
+/**
+  * @brief  Set up a window to collect part of a decoded model.
+  * @note	Pass modelimg_put_window and the window to the decoder.
+  * @param  w: Window
+  * @param  start: First model byte wanted
+  * @param  buf: Destination
+  * @param  length: Number of bytes wanted
+  * @retval None
+  */
+void modelimg_window_init(ModelImgWindow *w, uint16_t start, void *buf, uint16_t length)
+{
+	w->pos = 0;
+	w->start = start;
+	w->buf = buf;
+	w->length = length;
+}
+
+/**
+  * @brief  Decoder output callback for a ModelImgWindow.
+  * @note
+  * @param  b: Model byte
+  * @param  ctx: ModelImgWindow
+  * @retval None
+  */
+void modelimg_put_window(uint8_t b, void *ctx)
+{
+	ModelImgWindow *w = ctx;
+
+	if (w->pos >= w->start && w->pos - w->start < w->length)
+		w->buf[w->pos - w->start] = b;
+	w->pos++;
+}
+
+/******************************************************************************
+ * Restore
+ */
+
+// Restore in progress. The image is checked as it arrives and only
+// committed to the model index once it decodes to a valid model.
+static ModelImgDecoder restore;
+static uint8_t restore_model = 0xFF;
+static uint16_t restore_offset;
+static uint16_t restore_total;
+static uint16_t restore_sum;
+static uint8_t restore_last;			// Length of the last part taken
+static MODELIMG_STATUS restore_status;	// and what it returned
+
+static void modelimg_put_sum(uint8_t b, void *ctx)
+{
+	if (restore.pos < sizeof(ModelData) - 2)
+		restore_sum += b;
+	else if (restore.pos == sizeof(ModelData) - 2)
+		restore_sum -= b;
+	else
+		restore_sum -= b << 8;
+}
+
+/**
+  * @brief  Write the next part of a compressed image into a stored model.
+  * @note	Start with offset 0 and continue in order. An empty image
+  *         (total 0) clears the slot. The part just taken may come again
+  *         if its reply was lost, it gets the same answer.
+  * @param  model: Model number
+  * @param  offset: Offset into the image
+  * @param  total: Full image length
+  * @param  data: Image bytes
+  * @param  length: Number of bytes
+  * @retval MODELIMG_DONE once the model is stored.
+  */
+MODELIMG_STATUS modelimg_write(uint8_t model, uint16_t offset, uint16_t total,
+		const uint8_t *data, uint8_t length)
+{
+	MODELIMG_STATUS status;
+
+	if (offset == 0)
+	{
+		if (total == 0)
+			return eeprom_model_image_clear(model) ? MODELIMG_DONE : MODELIMG_ERROR;
+		if (!eeprom_model_image_begin(model, total))
+			return MODELIMG_ERROR;
+		modelimg_decode_start(&restore, modelimg_put_sum, 0);
+		restore_model = model;
+		restore_offset = 0;
+		restore_total = total;
+		restore_sum = 0;
+	}
+	else if (model == restore_model && offset + length == restore_offset &&
+			length == restore_last)
+		return restore_status;
+	else if (model != restore_model || offset != restore_offset ||
+			restore_status != MODELIMG_MORE)
+		return MODELIMG_ERROR;
+
+	status = MODELIMG_ERROR;
+	if (restore_offset + length <= restore_total)
+		status = modelimg_decode(&restore, data, length);
+	if (status == MODELIMG_DONE &&
+			(restore_offset + length != restore_total || restore_sum != 0))
+		status = MODELIMG_ERROR;
+	if (status == MODELIMG_ERROR)
+	{
+		eeprom_model_image_abort();
+		restore_model = 0xFF;
+		return status;
+	}
+
+	eeprom_model_image_append(data, length);
+	restore_offset += length;
+
+	if (status == MODELIMG_DONE && !eeprom_model_image_commit())
+	{
+		restore_model = 0xFF;
+		return MODELIMG_ERROR;
+	}
+
+	restore_last = length;
+	restore_status = status;
+	return status;
+}
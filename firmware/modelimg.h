@@ -0,0 +1,90 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _MODELIMG_H
+#define _MODELIMG_H
+
+#include <stdint.h>
+
+/*
+ * Compressed model image, used to store models in EEPROM and to move
+ * them over the serial link.
+ *
+ * Header: version (1 byte), sizeof(ModelData) (LE16).
+ * Then tokens until sizeof(ModelData) bytes have been produced:
+ *   0x00..0x0F   literal, (T + 1) bytes follow
+ *   0x10..0x7F   (T - 0x0F) zero bytes
+ *   0x80..0xFF   (T - 0x7F) bytes equal to g_modelDefaults
+ *
+ * Models are stored in EEPROM in this form, so changing g_modelDefaults
+ * or the ModelData layout requires a new MODELIMG_VERSION.
+ */
+
+#define MODELIMG_VERSION		1
+#define MODELIMG_HDR_LEN		3
+#define MODELIMG_LITERAL_MAX	16
+#define MODELIMG_ZERO_MAX		112
+#define MODELIMG_DEFAULT_MAX	128
+
+typedef enum
+{
+	MODELIMG_MORE = 0,
+	MODELIMG_DONE,
+	MODELIMG_ERROR,
+} MODELIMG_STATUS;
+
+typedef struct
+{
+	uint16_t pos;
+	uint8_t run_type;
+	uint8_t run_len;
+	uint8_t lit[MODELIMG_LITERAL_MAX];
+	void (*put)(uint8_t b, void *ctx);
+	void *ctx;
+} ModelImgEncoder;
+
+typedef struct
+{
+	uint16_t pos;			// Model bytes produced
+	uint16_t size;			// Model size from the header
+	uint8_t hdr;			// Header bytes consumed
+	uint8_t run_type;
+	uint8_t run_len;		// Bytes left in the current token
+	void (*put)(uint8_t b, void *ctx);
+	void *ctx;
+} ModelImgDecoder;
+
+// Collects the decoded bytes that fall within [start, start + length).
+typedef struct
+{
+	uint16_t pos;
+	uint16_t start;
+	uint8_t *buf;
+	uint16_t length;
+} ModelImgWindow;
+
+void modelimg_encode_start(ModelImgEncoder *enc, void (*put)(uint8_t, void*), void *ctx);
+void modelimg_encode(ModelImgEncoder *enc, const uint8_t *data, uint16_t length);
+void modelimg_encode_end(ModelImgEncoder *enc);
+
+void modelimg_decode_start(ModelImgDecoder *dec, void (*put)(uint8_t, void*), void *ctx);
+MODELIMG_STATUS modelimg_decode(ModelImgDecoder *dec, const uint8_t *data, uint16_t length);
+
+void modelimg_window_init(ModelImgWindow *w, uint16_t start, void *buf, uint16_t length);
+void modelimg_put_window(uint8_t b, void *ctx);
+
+MODELIMG_STATUS modelimg_write(uint8_t model, uint16_t offset, uint16_t total,
+		const uint8_t *data, uint8_t length);
+
+#endif // _MODELIMG_H
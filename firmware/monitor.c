@@ -0,0 +1,132 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Output channel monitor.
+ * The mixer calls monitor_sample() after every pass, so spikes that
+ * last a single 20ms frame are caught even though the GUI only shows
+ * g_chans every so often. Keeps the min, max, mean and largest change
+ * between passes of the first MONITOR_CHANNELS outputs, until reset.
+ * The mean is over the last MONITOR_MEAN_PASSES or so (about 11 min).
+ *
+ */
+
+#include <stdbool.h>
+
+#include "monitor.h"
+#include "art6.h"
+
+typedef struct
+{
+	int16_t min;
+	int16_t max;
+	int16_t last;
+	uint16_t delta;
+	int32_t sum;
+} MonitorChannel;
+
+static MonitorChannel chan[MONITOR_CHANNELS];
+static volatile uint16_t passes;
+static volatile bool reset_request = true;
+
+/**
+  * @brief  Add the outputs of a mixer pass to the statistics.
+  * @note	Called from the mixer interrupt.
+  * @param  None
+  * @retval None
+  */
+void monitor_sample(void)
+{
+	uint8_t i;
+
+	if (reset_request)
+	{
+		for (i = 0; i < MONITOR_CHANNELS; i++)
+		{
+			chan[i].min = chan[i].max = chan[i].last = g_chans[i];
+			chan[i].delta = 0;
+			chan[i].sum = 0;
+		}
+		passes = 0;
+		reset_request = false;
+	}
+
+	if (passes == MONITOR_MEAN_PASSES)
+	{
+		for (i = 0; i < MONITOR_CHANNELS; i++)
+			chan[i].sum /= 2;
+		passes /= 2;
+	}
+	passes++;
+
+	for (i = 0; i < MONITOR_CHANNELS; i++)
+	{
+		MonitorChannel *c = &chan[i];
+		int16_t v = g_chans[i];
+		uint16_t d = (v > c->last) ? v - c->last : c->last - v;
+
+		if (v < c->min)
+			c->min = v;
+		if (v > c->max)
+			c->max = v;
+		if (d > c->delta)
+			c->delta = d;
+		c->sum += v;
+		c->last = v;
+	}
+}
+
+/**
+  * @brief  Clear the statistics.
+  * @note	Takes effect on the next mixer pass.
+  * @param  None
+  * @retval None
+  */
+void monitor_reset(void)
+{
+	reset_request = true;
+}
+
+/**
+  * @brief  Get the statistics of one output channel.
+  * @note	Before the first pass after a reset all values are 0.
+  * @param  channel: Output channel 0..MONITOR_CHANNELS-1.
+  * @param  stats: Filled in with the statistics.
+  * @retval None
+  */
+void monitor_get(uint8_t channel, MonitorStats *stats)
+{
+	const MonitorChannel *c = &chan[channel];
+	uint16_t n;
+	int32_t sum;
+
+	// Retry if a mixer pass got in between.
+	do {
+		n = passes;
+		sum = c->sum;
+	} while (n != passes);
+
+	if (reset_request || n == 0)
+	{
+		stats->min = stats->max = stats->mean = 0;
+		stats->delta = 0;
+		return;
+	}
+
+	stats->min = c->min;
+	stats->max = c->max;
+	stats->mean = sum / n;
+	stats->delta = c->delta;
+}
@@ -0,0 +1,35 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _MONITOR_H
+#define _MONITOR_H
+
+#include <stdint.h>
+
+#define MONITOR_CHANNELS	8
+#define MONITOR_MEAN_PASSES	0x8000	// Sums are halved after this many passes.
+
+typedef struct
+{
+	int16_t min;
+	int16_t max;
+	int16_t mean;
+	uint16_t delta;		// Largest change between two mixer passes.
+} MonitorStats;
+
+void monitor_sample(void);
+void monitor_reset(void);
+void monitor_get(uint8_t channel, MonitorStats *stats);
+
+#endif // _MONITOR_H
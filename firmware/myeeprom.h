@@ -30,7 +30,7 @@
 
 //eeprom data
 //#define EE_VERSION 2
-#define MAX_MODELS  15
+#define MAX_MODELS  32
 #define MAX_MIXERS  24
 #define MAX_CURVE5  4
 #define MAX_CURVE9  4
@@ -90,6 +90,7 @@ PACK(typedef struct t_TrainerData {
 PACK(typedef struct t_EEGeneral {
 //    uint8_t   myVers;
 	ADC_CAL	calData[7];
+	int16_t   calLin[4][2];	// ADC reading at half travel of each stick [neg|pos], 0 = linear
 //    int16_t   calibMid[7];
 //    int16_t   calibSpanNeg[7];
 //    int16_t   calibSpanPos[7];
@@ -143,6 +144,9 @@ PACK(typedef struct t_EEGeneral {
 //		uint8_t		stickReverse ;
     //=== END === bit fields keep together for better packing
 
+    uint8_t   recorderRate;	// Flight recorder: mixer passes per sample, 0 = off
+    uint8_t   stickDeadband;	// Stick centre deadband in 0.1% of half travel
+
     uint16_t  chkSum;
 }) EEGeneral;
 
@@ -230,6 +234,12 @@ PACK(typedef struct t_SafetySwData { // Custom Switches data
 	} opt ;
 }) SafetySwData;
 
+PACK(typedef struct t_FailsafeData {
+    uint8_t mode:2;     // FAILSAFE_HOLD, FAILSAFE_PRESET, FAILSAFE_RAMP
+    uint8_t frames:6;   // Ramp length in PPM frames
+    int8_t  value;      // Preset, -100..100%
+}) FailsafeData;
+
 PACK(typedef struct t_gvar {
 	int8_t gvar ;
 	uint8_t gvsource ;
@@ -296,7 +306,7 @@ PACK(typedef struct t_ModelData {
 	uint8_t   mixTime:1 ;	// Scaling for slow/delay
     uint8_t   thrExpo:1;    // Enable Throttle Expo
 	uint8_t   ppmStart:3 ;	// Start channel for PPM
-    int8_t    trimInc:3;    // Trim Increments (0-4)
+    uint8_t   trimInc:3;    // Trim step size, TRIM_INC_xxx
     uint8_t   pulsePol:1;
     uint8_t   extendedLimits:1;
     uint8_t   swashInvertELE:1;
@@ -311,7 +321,7 @@ PACK(typedef struct t_ModelData {
     MixData   mixData[MAX_MIXERS];
     LimitData limitData[NUM_CHNOUT];
     ExpoData  expoData[4];
-    int8_t    trim[4];
+    int16_t   trim[4];              // +/- MIXER_TRIM_LIMIT in 1/RESX steps
     int8_t    curves5[MAX_CURVE5][5];
     int8_t    curves9[MAX_CURVE9][9];
 //    CSwData   customSw[NUM_CSW];
@@ -319,6 +329,7 @@ PACK(typedef struct t_ModelData {
 //    uint8_t   numVoice:5;		// 0-16, rest are Safety switches
 //		uint8_t		anaVolume:3 ;	// analog volume control
     SafetySwData  safetySw[NUM_CHNOUT];
+    FailsafeData  failsafe[NUM_CHNOUT];
 //    FrSkyData frsky;
 //		uint8_t numBlades ;
 //		uint8_t frskyoffset[2] ;		// Offsets for A1 and A2 (pending)
@@ -340,11 +351,11 @@ PACK(typedef struct t_ModelData {
     uint16_t  chkSum;
 }) ModelData;
 
-#define TOTAL_EEPROM_USAGE (sizeof(ModelData)*MAX_MODELS + sizeof(EEGeneral))
 
 
 extern volatile EEGeneral g_eeGeneral;
 extern volatile ModelData g_model;
+extern const ModelData g_modelDefaults;
 extern volatile uint8_t g_modelInvalid;
 
 #endif
@@ -23,6 +23,15 @@
  *
  * g_ppmIns[] receives up to 8 Channels on the PPM-IN pin.
  *
+ * The channels actually sent come through the failsafe, which replaces
+ * them when the mixer stalls, a model is loading or PPM-IN is lost.
+ * While a model is loading the frame is built from the settings of the
+ * last valid one.
+ *
+ * pulses_hold() stops the output at the end of a frame, so the CPU can
+ * stall on a flash erase or program without moving a channel edge. The
+ * sync gap of that frame just grows by the length of the stall.
+ *
  * ToDo: Implement a second set of 8 PPM outputs on the PPM-IN pin.
  * Currently this will just mirror the PPM-OUT pin when set to output mode.
  */
@@ -38,6 +47,11 @@
 #include "art6.h"
 #include "myeeprom.h"
 #include "pulses.h"
+#include "mixer.h"
+#include "watchdog.h"
+#include "stack.h"
+#include "capture.h"
+#include "failsafe.h"
 
 
 #define PULSES_WORD_SIZE	72
@@ -48,13 +62,17 @@
 
 // All timings in us
 #define PPM_CENTER 			1500
-#define PPM_STOP_LEN		(300 + g_model.ppmDelay * 50)
+#define PPM_STOP_LEN		(300 + ppm_cfg.delay * 50)
 #define PPM_MAX_FRAME_LEN	60000
 #define PPM_MIN_GAP_LEN		9000
+// The first compare of a frame makes no edge, it only has to come before
+// the first channel's, which can be as short as 700us.
+#define PPM_RESTART_LEN		100
 
 // Exported globals
 volatile struct t_latency g_latency;
 volatile int16_t g_chans[NUM_CHNOUT];
+volatile uint16_t g_pulses_first_ms;
 
 // Private globals
 static union p1mhz_t
@@ -63,7 +81,6 @@ static union p1mhz_t
     uint8_t pbyte[PULSES_BYTE_SIZE] ;   //144
 } pulses_1us;
 
-static volatile uint8_t heartbeat;
 static volatile uint8_t Current_protocol;
 
 volatile int16_t g_ppmIns[8];
@@ -72,7 +89,24 @@ static volatile uint8_t ppmInState = 0; //0=unsync 1..8= wait for value i-1
 
 static bool trainer_out = false;
 
+#define HOLD_WAIT_MS	60	// Longer than any frame
+
+static bool started = false;
+static volatile bool hold = false;	// Stop at the end of this frame
+static volatile bool held = false;	// Stopped, waiting for pulses_release()
+
+// Frame settings from g_model, kept while a model is loading.
+static struct
+{
+	uint8_t start;
+	int8_t nch;
+	int8_t delay;
+	int8_t frame_len;
+	bool ext;
+} ppm_cfg;
+
 void pulses_setup(void);
+void pulses_restart(void);
 void pulses_setup_ppm(uint8_t proto);
 void pulses_set_trainer_port_ppm(void);
 void pulses_set_trainer_port_capture(void);
@@ -145,6 +179,7 @@ void pulses_init(void)
 	SlaveMode = false;
 
 	pulses_setup();
+	started = true;
 }
 
 /**
@@ -157,6 +192,9 @@ void pulses_setup(void)
 {
 	uint8_t required_protocol ;
 	required_protocol = g_model.protocol ;
+
+	failsafe_frame();
+
 	// Sort required_protocol depending on student mode and PPMSIM allowed
 
 	if ( g_eeGeneral.enablePpmsim )
@@ -172,6 +210,9 @@ void pulses_setup(void)
         Current_protocol = required_protocol ;
         // switch mode here
 
+        // The timer stays stopped when we're the trainer slave.
+        watchdog_expect(WATCHDOG_PULSES, required_protocol != PROTO_PPMSIM);
+
         // Pause the timer and reset the count.
         TIM_Cmd(TIM2, DISABLE);
 
@@ -185,7 +226,7 @@ void pulses_setup(void)
 			// 8-Ch PPM: Next frame starts in 20 mS
 			TIM_SetAutoreload(TIM2, PPM_MAX_FRAME_LEN);
 	        TIM_SetCounter(TIM2, 0);
-	        TIM_SetCompare1(TIM2, PPM_STOP_LEN);
+	        TIM_SetCompare1(TIM2, PPM_RESTART_LEN);
 			TIM_Cmd(TIM2, ENABLE);
             break;
 
@@ -201,7 +242,7 @@ void pulses_setup(void)
 			{
 				TIM_SetAutoreload(TIM2, PPM_MAX_FRAME_LEN);
 		        TIM_SetCounter(TIM2, 0);
-		        TIM_SetCompare1(TIM2, PPM_STOP_LEN);
+		        TIM_SetCompare1(TIM2, PPM_RESTART_LEN);
 				TIM_Cmd(TIM2, ENABLE);
 				pulses_setup_ppm(PROTO_PPM16);
 			}
@@ -232,21 +273,31 @@ void pulses_setup(void)
   */
 void pulses_setup_ppm( uint8_t proto )
 {
-	// bail out when model is in flux (read from eeprom) to avoid miscomputation of chanel#/start and hence pointer gone wild
-	if( g_modelInvalid )
-		return;
+	// Keep the last settings when model is in flux (read from eeprom) to avoid miscomputation of chanel#/start and hence pointer gone wild
+	if( !g_modelInvalid )
+	{
+		ppm_cfg.start = g_model.ppmStart;
+		ppm_cfg.nch = g_model.ppmNCH;
+		ppm_cfg.delay = g_model.ppmDelay;
+		ppm_cfg.frame_len = g_model.ppmFrameLength;
+		ppm_cfg.ext = g_model.extendedLimits;
+	}
+
+	// Boot time to the first frame carrying mixer output.
+	if (g_pulses_first_ms == 0 && g_mixer_passes != 0)
+		g_pulses_first_ms = system_ticks;
 
 	int16_t PPM_range;
-	uint8_t startChan = g_model.ppmStart;
+	uint8_t startChan = ppm_cfg.start;
 	uint8_t i;
 	int16_t position = 0; // Running total so we can avoid resetting the timer count and avoid jitter.
 	  
 	// Total frame length = 22500usec
 	// each pulse is 0.5..2.5ms long including a 300us stop tail
 	uint16_t *ptr = (proto == PROTO_PPM) ? pulses_1us.pword : &pulses_1us.pword[PULSES_WORD_SIZE/2] ;
-	uint8_t p = g_model.ppmNCH; // Channels
+	uint8_t p = ppm_cfg.nch; // Channels
 
-	int32_t gap = 22500 + g_model.ppmFrameLength * 1000; // Minimum Framelen = 22.5 ms
+	int32_t gap = 22500 + ppm_cfg.frame_len * 1000; // Minimum Framelen = 22.5 ms
 
 	p += startChan;
 
@@ -256,15 +307,15 @@ void pulses_setup_ppm( uint8_t proto )
 		*ptr++ = position;
 	}
 
-	PPM_range = g_model.extendedLimits ? PPM_LIMIT_EXTENDED : PPM_LIMIT_NORMAL;   // range of 0.7 - 2.3ms or  0.8 - 2.2ms
+	PPM_range = ppm_cfg.ext ? PPM_LIMIT_EXTENDED : PPM_LIMIT_NORMAL;   // range of 0.7 - 2.3ms or  0.8 - 2.2ms
 	uint8_t start = (proto == PROTO_PPM16) ? p-8 : startChan;
 	// restore sanity if model got corrupt to avoid wild pointer 'ptr'
 	if( start >= NUM_CHNOUT ) start = NUM_CHNOUT-1;
-	if( p >= NUM_CHNOUT ) p = NUM_CHNOUT-1;
+	if( p > NUM_CHNOUT ) p = NUM_CHNOUT;
 	for (i = start; i < p; i++)
 	{
 		// Get the channel and limit the range.
-		int32_t v = g_chans[i];	// -1024 - 1024
+		int32_t v = failsafe_get(i);	// -1024 - 1024
 		if (v > PPM_range) v = PPM_range;
 		if (v < -PPM_range) v = -PPM_range;
 		v += PPM_CENTER;
@@ -300,6 +351,64 @@ void pulses_setup_ppm( uint8_t proto )
 		return;
 }
 
+/**
+  * @brief  Start the next frame.
+  * @note	Called with the timer stopped at the end of a frame.
+  * @param  None
+  * @retval None
+  */
+void pulses_restart(void)
+{
+    if ( (g_model.protocol == PROTO_PPM) || (g_model.protocol == PROTO_PPM16) )
+    {
+        // Reset and start the timer.
+        TIM_ClearITPendingBit(TIM2, TIM_FLAG_CC1);
+        TIM_SetCounter(TIM2, 0);
+        TIM_SetCompare1(TIM2, PPM_RESTART_LEN);
+        TIM_Cmd(TIM2, ENABLE);
+    }
+}
+
+/**
+  * @brief  Stop the PPM output at the end of the current frame.
+  * @note	Waits for the frame to end. Returns at once if no PPM is being
+  *         sent. Always follow with pulses_release(), the output may stop
+  *         after a wait that timed out.
+  * @param  None
+  * @retval true if the output is stopped
+  */
+bool pulses_hold(void)
+{
+	uint32_t start = system_ticks;
+
+	// The timer is stopped for the trainer slave.
+	if (!started || Current_protocol == PROTO_PPMSIM)
+		return false;
+
+	hold = true;
+	while (!held)
+		if (system_ticks - start > HOLD_WAIT_MS)
+			return false;
+	return true;
+}
+
+/**
+  * @brief  Carry on after pulses_hold().
+  * @note	The next frame starts now.
+  * @param  None
+  * @retval None
+  */
+void pulses_release(void)
+{
+	// Cleared first, from now on the ISR restarts the timer itself.
+	hold = false;
+	if (held)
+	{
+		held = false;
+		pulses_restart();
+	}
+}
+
 /**
   * @brief  Configure the trainer port and ISR in PPM output mode.
   * @note
@@ -316,7 +425,8 @@ void pulses_set_trainer_port_ppm()
 	gpioInit.GPIO_Speed = GPIO_Speed_50MHz;
 	GPIO_Init(GPIOA, &gpioInit);
 
-	TIM_Cmd(TIM2, DISABLE);
+	// Stop the capture, the PPM timer keeps running.
+	TIM_Cmd(TIM3, DISABLE);
 }
 
 /**
@@ -381,6 +491,9 @@ void TIM2_IRQHandler(void)
 	// If we're at the end of the sequence
     if (*pulsePtr == 0)
     {
+    	// The deep path, and the timer is stopped for it anyway.
+    	uint32_t mark = stack_isr_enter(STACK_ISR_PULSES);
+
     	// Go back to the beginning.
         pulsePtr = pulses_1us.pword;
         // Toggle the output level
@@ -391,14 +504,12 @@ void TIM2_IRQHandler(void)
 
         pulses_setup();
 
-        if ( (g_model.protocol == PROTO_PPM) || (g_model.protocol == PROTO_PPM16) )
-        {
-            // Reset and start the timer.
-	        TIM_ClearITPendingBit(TIM2, TIM_FLAG_CC1);
-	        TIM_SetCounter(TIM2, 0);
-	        TIM_SetCompare1(TIM2, PPM_STOP_LEN);
-            TIM_Cmd(TIM2, ENABLE);
-        }
+        if (hold)
+            held = true;
+        else
+            pulses_restart();
+
+        stack_isr_exit(STACK_ISR_PULSES, mark);
     }
     else
     {
@@ -407,7 +518,7 @@ void TIM2_IRQHandler(void)
     	pulsePtr++;
     }
 
-    heartbeat |= HEART_TIMER_PULSES;
+    watchdog_heartbeat(WATCHDOG_PULSES);
 }
 
 /**
@@ -439,6 +550,12 @@ void TIM3_IRQHandler(void)
         {
         	// -700 - 700 Max
             g_ppmIns[ppmInState++ - 1] = val * (g_eeGeneral.PPM_Multiplier + 10) / 10; // +/- 700 != 512, but close enough.
+            if (ppmInState > 8)
+            {
+                // Counted down by the failsafe every PPM-OUT frame.
+                ppmInValid = FAILSAFE_TRAINER_FRAMES;
+                capture_ppm_in();
+            }
         }
         else
         {
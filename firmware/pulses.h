@@ -19,10 +19,18 @@
 #ifndef PULSES_H
 #define PULSES_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #define PPM_LIMIT_NORMAL	500
 #define PPM_LIMIT_EXTENDED	800
 
+// ms from power on until the first frame with mixer output (0 = not yet).
+extern volatile uint16_t g_pulses_first_ms;
+
 void pulses_init(void);
 void pulses_setup(void);
+bool pulses_hold(void);
+void pulses_release(void);
 
 #endif // PULSES_H
@@ -0,0 +1,298 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * In-RAM flight data recorder.
+ * The mixer calls recorder_sample() after every pass. Every Nth pass
+ * (g_eeGeneral.recorderRate) the output channels and switches are
+ * delta encoded into a ring of small blocks, dropping the oldest block
+ * when full. With 8KB of RAM the ring holds somewhere between a few
+ * seconds (sticks moving) and a few minutes (sticks still).
+ *
+ * The ring is written to the spare space at the end of the EEPROM
+ * either from the menu or automatically after landing, which is taken
+ * to be the throttle held at idle for a few seconds after being raised.
+ * tools/recdecode.c turns an EEPROM dump back into CSV.
+ *
+ */
+
+#include <string.h>
+
+#include "recorder.h"
+#include "art6.h"
+#include "myeeprom.h"
+#include "sticks.h"
+#include "keypad.h"
+#include "tasks.h"
+#include "eeprom.h"
+
+#define LANDED_THRESHOLD	(-(RESX * 9) / 10)
+#define LANDED_PASSES		(5000 / RECORDER_MIXER_PERIOD_MS)
+
+static uint8_t buffer[RECORDER_BUFFER_SIZE];
+static uint8_t block;			// Block currently being filled.
+static uint8_t blocks_used;		// Number of blocks holding data (incl. current).
+static uint16_t bitpos;			// Bit offset within the current block.
+static uint16_t seq;
+static int16_t last[RECORDER_CHANNELS];
+static uint8_t last_sw;
+static uint8_t decimate;
+static volatile bool paused;
+
+static bool throttle_raised;
+static uint16_t landed_count;
+
+static void recorder_process(uint32_t data);
+
+/**
+  * @brief  Append bits to the current block, MSB first.
+  * @note
+  * @param  value: The bits to write (right aligned).
+  * @param  bits: Number of bits to write.
+  * @retval None
+  */
+static void recorder_put_bits(uint16_t value, uint8_t bits)
+{
+	uint8_t *blk = &buffer[block * RECORDER_BLOCK_SIZE];
+
+	while (bits--)
+	{
+		if (value & (1 << bits))
+			blk[bitpos >> 3] |= 0x80 >> (bitpos & 7);
+		bitpos++;
+	}
+}
+
+/**
+  * @brief  Start a new block, dropping the oldest if the ring is full.
+  * @note
+  * @param  None
+  * @retval None
+  */
+static void recorder_new_block(void)
+{
+	uint8_t *blk;
+
+	if (blocks_used != 0)
+		block = (block + 1) % RECORDER_BLOCKS;
+	if (blocks_used < RECORDER_BLOCKS)
+		blocks_used++;
+
+	blk = &buffer[block * RECORDER_BLOCK_SIZE];
+	memset(blk, 0, RECORDER_BLOCK_SIZE);
+	blk[0] = seq & 0xFF;
+	blk[1] = seq >> 8;
+	blk[2] = 0;
+	blk[3] = g_eeGeneral.recorderRate;
+	seq++;
+
+	bitpos = RECORDER_BLOCK_HDR * 8;
+	memset(last, 0, sizeof(last));
+	last_sw = 0xFF;
+}
+
+/**
+  * @brief  Encode one sample into the ring.
+  * @note
+  * @param  None
+  * @retval None
+  */
+static void recorder_encode(void)
+{
+	uint8_t i;
+	uint8_t sw;
+
+	if (blocks_used == 0 ||
+		bitpos + RECORDER_SAMPLE_MAX_BITS > RECORDER_BLOCK_SIZE * 8 ||
+		buffer[block * RECORDER_BLOCK_SIZE + 2] == 0xFF)
+	{
+		recorder_new_block();
+	}
+
+	for (i = 0; i < RECORDER_CHANNELS; i++)
+	{
+		int16_t v = g_chans[i];
+		int16_t d;
+
+		if (v > 2047) v = 2047;
+		if (v < -2048) v = -2048;
+		d = v - last[i];
+		last[i] = v;
+
+		if (d == 0)
+			recorder_put_bits(0, 1);
+		else if (d >= -8 && d <= 7)
+		{
+			recorder_put_bits(0x2, 2);
+			recorder_put_bits(d & 0x0F, 4);
+		}
+		else if (d >= -64 && d <= 63)
+		{
+			recorder_put_bits(0x6, 3);
+			recorder_put_bits(d & 0x7F, 7);
+		}
+		else
+		{
+			recorder_put_bits(0x7, 3);
+			recorder_put_bits(v & 0xFFF, 12);
+		}
+	}
+
+	sw = keypad_get_switches() & 0x0F;
+	if (sw == last_sw)
+		recorder_put_bits(0, 1);
+	else
+	{
+		recorder_put_bits(1, 1);
+		recorder_put_bits(sw, 4);
+		last_sw = sw;
+	}
+
+	buffer[block * RECORDER_BLOCK_SIZE + 2]++;
+}
+
+/**
+  * @brief  Watch the throttle and request a dump once landed.
+  * @note
+  * @param  None
+  * @retval None
+  */
+static void recorder_check_landed(void)
+{
+	int16_t thr = stick_data[THR_STICK];
+
+	if (g_eeGeneral.throttleReversed)
+		thr = -thr;
+
+	if (thr > LANDED_THRESHOLD)
+	{
+		throttle_raised = true;
+		landed_count = 0;
+	}
+	else if (throttle_raised && ++landed_count >= LANDED_PASSES)
+	{
+		throttle_raised = false;
+		landed_count = 0;
+		task_schedule(TASK_PROCESS_RECORDER, 0, 0);
+	}
+}
+
+/**
+  * @brief  Initialise the recorder.
+  * @note	Must be called after eeprom_init().
+  * @param  None
+  * @retval None
+  */
+void recorder_init(void)
+{
+	task_register(TASK_PROCESS_RECORDER, recorder_process);
+	recorder_clear();
+}
+
+/**
+  * @brief  Discard the recording held in RAM.
+  * @note
+  * @param  None
+  * @retval None
+  */
+void recorder_clear(void)
+{
+	paused = true;
+	block = 0;
+	blocks_used = 0;
+	bitpos = 0;
+	decimate = 0;
+	throttle_raised = false;
+	landed_count = 0;
+	paused = false;
+}
+
+/**
+  * @brief  Record the current mixer output.
+  * @note	This is called from the mixer (DMA completion IRQ),
+  *         so keep it short.
+  * @param  None
+  * @retval None
+  */
+void recorder_sample(void)
+{
+	if (paused || g_eeGeneral.recorderRate == 0)
+		return;
+
+	recorder_check_landed();
+
+	if (++decimate < g_eeGeneral.recorderRate)
+		return;
+	decimate = 0;
+
+	recorder_encode();
+}
+
+/**
+  * @brief  Write the ring to EEPROM, oldest block first.
+  * @note	Recording is paused while the dump is written.
+  * @param  None
+  * @retval None
+  */
+void recorder_flush(void)
+{
+	RecorderHeader hdr;
+	uint8_t first;
+	uint8_t i;
+
+	paused = true;
+
+	first = (block + RECORDER_BLOCKS + 1 - blocks_used) % RECORDER_BLOCKS;
+	for (i = 0; i < blocks_used; i++)
+	{
+		uint8_t b = (first + i) % RECORDER_BLOCKS;
+		eeprom_write(RECORDER_EEPROM_BASE + RECORDER_EEPROM_HDR + i * RECORDER_BLOCK_SIZE,
+				RECORDER_BLOCK_SIZE, &buffer[b * RECORDER_BLOCK_SIZE]);
+	}
+
+	hdr.magic = RECORDER_MAGIC;
+	hdr.version = RECORDER_VERSION;
+	hdr.blocks = blocks_used;
+	hdr.block_size = RECORDER_BLOCK_SIZE;
+	hdr.channels = RECORDER_CHANNELS;
+	hdr.period_ms = RECORDER_MIXER_PERIOD_MS;
+	eeprom_write(RECORDER_EEPROM_BASE, sizeof(hdr), &hdr);
+
+	paused = false;
+}
+
+/**
+  * @brief  Number of bytes of the ring in use.
+  * @note
+  * @param  None
+  * @retval Bytes used.
+  */
+uint16_t recorder_get_used(void)
+{
+	if (blocks_used == 0)
+		return 0;
+	return (blocks_used - 1) * RECORDER_BLOCK_SIZE + ((bitpos + 7) >> 3);
+}
+
+/**
+  * @brief  Task to dump the recording after landing.
+  * @note
+  * @param  data: Unused.
+  * @retval None
+  */
+static void recorder_process(uint32_t data)
+{
+	recorder_flush();
+}
@@ -0,0 +1,74 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _RECORDER_H
+#define _RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "eeprom.h"
+
+/*
+ * Flight recorder data format (shared with tools/recdecode.c).
+ *
+ * The RAM ring is split into fixed size blocks. Each block starts with a
+ * RECORDER_BLOCK_HDR byte header followed by MSB first bit packed samples.
+ * The predictor is reset at the start of every block, so a block can be
+ * decoded on its own and the oldest block can be dropped when the ring wraps.
+ *
+ * Per channel delta codes:
+ *   0                 delta == 0
+ *   10   + 4 bits     delta -8..7
+ *   110  + 7 bits     delta -64..63
+ *   111  + 12 bits    absolute value -2048..2047
+ * Switches:
+ *   0                 unchanged
+ *   1    + 4 bits     new switch bitmask
+ */
+
+#define RECORDER_CHANNELS		8
+#define RECORDER_BUFFER_SIZE	768
+#define RECORDER_BLOCK_SIZE		64
+#define RECORDER_BLOCKS			(RECORDER_BUFFER_SIZE / RECORDER_BLOCK_SIZE)
+#define RECORDER_BLOCK_HDR		4		// seq (LE16), samples, decimation
+#define RECORDER_SAMPLE_MAX_BITS	(RECORDER_CHANNELS * 15 + 5)
+
+#define RECORDER_MIXER_PERIOD_MS	20	// One sample slot per mixer pass.
+#define RECORDER_DEFAULT_RATE		5	// 10 samples per second.
+
+// EEPROM dump: one page of header then the blocks oldest first.
+#define RECORDER_MAGIC			0x5246	// "FR"
+#define RECORDER_VERSION		1
+#define RECORDER_EEPROM_HDR		32
+#define RECORDER_EEPROM_SIZE	(RECORDER_EEPROM_HDR + RECORDER_BUFFER_SIZE)
+#define RECORDER_EEPROM_BASE	(EEPROM_SIZE - RECORDER_EEPROM_SIZE)
+
+typedef struct
+{
+	uint16_t magic;
+	uint8_t version;
+	uint8_t blocks;			// Number of valid blocks that follow.
+	uint8_t block_size;
+	uint8_t channels;
+	uint16_t period_ms;		// Mixer period in ms.
+} RecorderHeader;
+
+void recorder_init(void);
+void recorder_sample(void);
+void recorder_flush(void);
+void recorder_clear(void);
+uint16_t recorder_get_used(void);
+
+#endif // _RECORDER_H
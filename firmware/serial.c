@@ -0,0 +1,478 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Debug / configuration link on USART1 (PA9 TX, PA10 RX).
+ * Both directions use DMA: RX runs continuously into a circular ring
+ * which a main loop task drains, TX sends one frame at a time and
+ * the completion IRQ frees the buffer.
+ * Nothing here runs in the mixer path and the task never waits for the
+ * UART, so a busy or disconnected host cannot stall the radio.
+ *
+ * The host sends one request and waits for its reply (see serial.h).
+ * Input capture records and telemetry are streamed unsolicited when
+ * enabled, in that order of priority.
+ *
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include <stm32f10x.h>
+#include <stm32f10x_rcc.h>
+#include <stm32f10x_gpio.h>
+#include <stm32f10x_misc.h>
+#include <stm32f10x_dma.h>
+#include <stm32f10x_usart.h>
+
+#include "serial.h"
+#include "tasks.h"
+#include "sticks.h"
+#include "mixer.h"
+#include "myeeprom.h"
+#include "eeprom.h"
+#include "modelimg.h"
+#include "art6.h"
+#include "capture.h"
+
+#define SERIAL_TASK_PERIOD	5
+#define RX_RING_SIZE		128
+
+static uint8_t rx_ring[RX_RING_SIZE];
+static uint16_t rx_tail;
+static uint8_t rx_frame[FRAME_MAX_ENCODED];
+static uint16_t rx_len;
+static bool rx_overflow;
+
+static uint8_t tx_buf[FRAME_MAX_ENCODED];
+static volatile bool tx_busy;
+static DMA_InitTypeDef tx_dma;
+
+// A reply waiting for the transmitter. New requests are not read until it has gone.
+static uint8_t reply[FRAME_MAX_PAYLOAD];
+static uint8_t reply_len;
+
+static uint8_t stream_period;
+static uint32_t stream_last;
+
+/**
+  * @brief  Initialise the serial link.
+  * @note
+  * @param  None
+  * @retval None
+  */
+void serial_init(void)
+{
+	GPIO_InitTypeDef gpioInit;
+	USART_InitTypeDef usartInit;
+	DMA_InitTypeDef dmaInit;
+	NVIC_InitTypeDef nvicInit;
+
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA, ENABLE);
+
+	// PA9 = TX, PA10 = RX
+	gpioInit.GPIO_Speed = GPIO_Speed_50MHz;
+	gpioInit.GPIO_Pin = GPIO_Pin_9;
+	gpioInit.GPIO_Mode = GPIO_Mode_AF_PP;
+	GPIO_Init(GPIOA, &gpioInit);
+	gpioInit.GPIO_Pin = GPIO_Pin_10;
+	gpioInit.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+	GPIO_Init(GPIOA, &gpioInit);
+
+	USART_StructInit(&usartInit);
+	usartInit.USART_BaudRate = SERIAL_BAUDRATE;
+	usartInit.USART_WordLength = USART_WordLength_8b;
+	usartInit.USART_StopBits = USART_StopBits_1;
+	usartInit.USART_Parity = USART_Parity_No;
+	usartInit.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
+	usartInit.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+	USART_Init(USART1, &usartInit);
+
+	// RX: DMA1 Channel 5, circular, never stopped.
+	DMA_DeInit(DMA1_Channel5);
+	DMA_StructInit(&dmaInit);
+	dmaInit.DMA_PeripheralBaseAddr = (uint32_t) &USART1->DR;
+	dmaInit.DMA_MemoryBaseAddr = (uint32_t) rx_ring;
+	dmaInit.DMA_DIR = DMA_DIR_PeripheralSRC;
+	dmaInit.DMA_BufferSize = RX_RING_SIZE;
+	dmaInit.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	dmaInit.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	dmaInit.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	dmaInit.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	dmaInit.DMA_Mode = DMA_Mode_Circular;
+	dmaInit.DMA_Priority = DMA_Priority_Low;
+	dmaInit.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(DMA1_Channel5, &dmaInit);
+	DMA_Cmd(DMA1_Channel5, ENABLE);
+
+	// TX: DMA1 Channel 4, set up per frame in serial_send().
+	DMA_DeInit(DMA1_Channel4);
+	tx_dma = dmaInit;
+	tx_dma.DMA_MemoryBaseAddr = (uint32_t) tx_buf;
+	tx_dma.DMA_DIR = DMA_DIR_PeripheralDST;
+	tx_dma.DMA_Mode = DMA_Mode_Normal;
+
+	nvicInit.NVIC_IRQChannel = DMA1_Channel4_IRQn;
+	nvicInit.NVIC_IRQChannelPreemptionPriority = 3;
+	nvicInit.NVIC_IRQChannelSubPriority = 3;
+	nvicInit.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&nvicInit);
+
+	USART_DMACmd(USART1, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE);
+	USART_Cmd(USART1, ENABLE);
+
+	task_register(TASK_PROCESS_SERIAL, serial_process);
+	task_schedule(TASK_PROCESS_SERIAL, 0, SERIAL_TASK_PERIOD);
+}
+
+/**
+  * @brief  Start sending a frame.
+  * @note	Returns immediately, the DMA does the rest.
+  * @param  payload: Message to send
+  * @param  length: Message length
+  * @retval true if the frame was queued, false if the transmitter is busy.
+  */
+static bool serial_send(const uint8_t *payload, uint8_t length)
+{
+	if (tx_busy)
+		return false;
+
+	tx_busy = true;
+	tx_dma.DMA_BufferSize = frame_encode(payload, length, tx_buf);
+	DMA_Init(DMA1_Channel4, &tx_dma);
+	DMA_ITConfig(DMA1_Channel4, DMA_IT_TC, ENABLE);
+	DMA_Cmd(DMA1_Channel4, ENABLE);
+
+	return true;
+}
+
+/**
+  * @brief  Queue a reply to the current request.
+  * @note
+  * @param  length: Length of the message in reply[]
+  * @retval None
+  */
+static void serial_reply(uint8_t length)
+{
+	reply_len = length;
+	if (serial_send(reply, reply_len))
+		reply_len = 0;
+}
+
+/**
+  * @brief  Queue an ACK for a request.
+  * @note
+  * @param  request: Request type being acknowledged
+  * @param  status: Result
+  * @retval None
+  */
+static void serial_ack(uint8_t request, SERIAL_STATUS status)
+{
+	reply[0] = MSG_ACK;
+	reply[1] = request;
+	reply[2] = status;
+	serial_reply(3);
+}
+
+/**
+  * @brief  Decode and act on a received frame.
+  * @note
+  * @param  buf: Encoded frame (without delimiter)
+  * @param  length: Encoded length
+  * @retval true if a valid request was handled.
+  */
+static bool serial_handle_frame(uint8_t *buf, uint16_t length)
+{
+	int16_t n = frame_decode(buf, length);
+	uint16_t offset;
+	uint8_t size;
+	uint8_t model;
+
+	// Corrupt frames are dropped, the host will retry.
+	if (n < 1)
+		return false;
+
+	switch (buf[0])
+	{
+	case MSG_PING:
+		reply[0] = MSG_PONG;
+		serial_reply(1);
+		break;
+
+	case MSG_INFO:
+	{
+		SerialInfo info;
+		info.type = MSG_INFO_DATA;
+		info.eeprom_size = EEPROM_SIZE;
+		info.general_size = sizeof(EEGeneral);
+		info.model_size = sizeof(ModelData);
+		info.max_models = MAX_MODELS;
+		info.curr_model = g_eeGeneral.currModel;
+		memcpy(reply, &info, sizeof(info));
+		serial_reply(sizeof(info));
+	}
+		break;
+
+	case MSG_STREAM:
+		if (n != 2) {
+			serial_ack(buf[0], SERIAL_ERR_LENGTH);
+			break;
+		}
+		stream_period = buf[1];
+		if (stream_period != 0 && stream_period < SERIAL_MIN_PERIOD)
+			stream_period = SERIAL_MIN_PERIOD;
+		serial_ack(buf[0], SERIAL_OK);
+		break;
+
+	case MSG_CAPTURE:
+		if (n != 2) {
+			serial_ack(buf[0], SERIAL_ERR_LENGTH);
+			break;
+		}
+		if (buf[1])
+			capture_start();
+		else
+			capture_stop();
+		serial_ack(buf[0], SERIAL_OK);
+		break;
+
+	case MSG_EE_READ:
+		if (n != 4) {
+			serial_ack(buf[0], SERIAL_ERR_LENGTH);
+			break;
+		}
+		offset = buf[1] | (buf[2] << 8);
+		size = buf[3];
+		if (size > SERIAL_MAX_DATA || offset + size > EEPROM_SIZE) {
+			serial_ack(buf[0], SERIAL_ERR_RANGE);
+			break;
+		}
+		reply[0] = MSG_EE_DATA;
+		reply[1] = buf[1];
+		reply[2] = buf[2];
+		eeprom_read(offset, size, &reply[3]);
+		serial_reply(3 + size);
+		break;
+
+	case MSG_EE_WRITE:
+		if (n < 3 || n - 3 > SERIAL_MAX_DATA) {
+			serial_ack(buf[0], SERIAL_ERR_LENGTH);
+			break;
+		}
+		offset = buf[1] | (buf[2] << 8);
+		size = n - 3;
+		if (offset + size > EEPROM_SIZE) {
+			serial_ack(buf[0], SERIAL_ERR_RANGE);
+			break;
+		}
+		eeprom_write(offset, size, &buf[3]);
+		serial_ack(buf[0], SERIAL_OK);
+		break;
+
+	case MSG_MODEL_READ:
+		if (n != 5) {
+			serial_ack(buf[0], SERIAL_ERR_LENGTH);
+			break;
+		}
+		model = buf[1];
+		offset = buf[2] | (buf[3] << 8);
+		size = buf[4];
+		if (model >= MAX_MODELS || size > SERIAL_MAX_DATA ||
+				offset + size > sizeof(ModelData)) {
+			serial_ack(buf[0], SERIAL_ERR_RANGE);
+			break;
+		}
+		reply[0] = MSG_EE_DATA;
+		reply[1] = buf[2];
+		reply[2] = buf[3];
+		eeprom_read_model_data(model, offset, size, &reply[3]);
+		serial_reply(3 + size);
+		break;
+
+	case MSG_IMG_READ:
+	{
+		uint16_t total;
+		if (n != 4) {
+			serial_ack(buf[0], SERIAL_ERR_LENGTH);
+			break;
+		}
+		model = buf[1];
+		offset = buf[2] | (buf[3] << 8);
+		if (model >= MAX_MODELS) {
+			serial_ack(buf[0], SERIAL_ERR_RANGE);
+			break;
+		}
+		total = eeprom_read_model_image(model, offset, SERIAL_MAX_DATA, &reply[5]);
+		size = 0;
+		if (offset < total)
+			size = (total - offset > SERIAL_MAX_DATA) ? SERIAL_MAX_DATA : total - offset;
+		reply[0] = MSG_IMG_DATA;
+		reply[1] = buf[2];
+		reply[2] = buf[3];
+		reply[3] = total & 0xFF;
+		reply[4] = total >> 8;
+		serial_reply(5 + size);
+	}
+		break;
+
+	case MSG_IMG_WRITE:
+	{
+		MODELIMG_STATUS status;
+		if (n < 6 || n - 6 > SERIAL_MAX_DATA) {
+			serial_ack(buf[0], SERIAL_ERR_LENGTH);
+			break;
+		}
+		model = buf[1];
+		offset = buf[2] | (buf[3] << 8);
+		if (model >= MAX_MODELS) {
+			serial_ack(buf[0], SERIAL_ERR_RANGE);
+			break;
+		}
+		status = modelimg_write(model, offset, buf[4] | (buf[5] << 8), &buf[6], n - 6);
+		if (status == MODELIMG_DONE)
+			serial_ack(buf[0], SERIAL_OK);
+		else if (status == MODELIMG_MORE)
+			serial_ack(buf[0], SERIAL_PENDING);
+		else
+			serial_ack(buf[0], SERIAL_ERR_DATA);
+	}
+		break;
+
+	default:
+		serial_ack(buf[0], SERIAL_ERR_UNKNOWN);
+		break;
+	}
+
+	return true;
+}
+
+/**
+  * @brief  Drain the RX ring, handling at most one request.
+  * @note
+  * @param  None
+  * @retval None
+  */
+static void serial_receive(void)
+{
+	uint16_t head = RX_RING_SIZE - DMA_GetCurrDataCounter(DMA1_Channel5);
+
+	while (rx_tail != head)
+	{
+		uint8_t b = rx_ring[rx_tail];
+		rx_tail = (rx_tail + 1) % RX_RING_SIZE;
+
+		if (b == 0)
+		{
+			bool handled = false;
+			if (!rx_overflow && rx_len != 0)
+				handled = serial_handle_frame(rx_frame, rx_len);
+			rx_len = 0;
+			rx_overflow = false;
+			if (handled)
+				return;
+		}
+		else if (rx_len < sizeof(rx_frame))
+			rx_frame[rx_len++] = b;
+		else
+			rx_overflow = true;
+	}
+}
+
+/**
+  * @brief  Send queued capture records.
+  * @note
+  * @param  None
+  * @retval true if a frame was sent.
+  */
+static bool serial_capture(void)
+{
+	uint8_t msg[FRAME_MAX_PAYLOAD];
+	uint8_t n;
+
+	if (tx_busy)
+		return false;
+
+	n = capture_read(msg + 1, sizeof(msg) - 1);
+	if (n == 0)
+		return false;
+
+	msg[0] = MSG_CAPTURE_DATA;
+	return serial_send(msg, n + 1);
+}
+
+/**
+  * @brief  Send a telemetry frame if one is due.
+  * @note
+  * @param  None
+  * @retval None
+  */
+static void serial_stream(void)
+{
+	SerialTelemetry t;
+	uint8_t i;
+
+	if (stream_period == 0 || tx_busy ||
+			system_ticks - stream_last < stream_period)
+		return;
+
+	t.type = MSG_TELEMETRY;
+	t.ticks = system_ticks;
+	for (i = 0; i < 8; i++)
+		t.chans[i] = g_chans[i];
+	for (i = 0; i < 7; i++)
+		t.sticks[i] = stick_data[i];
+	t.mixer_passes = g_mixer_passes;
+	t.mixer_us = g_mixer_us;
+	t.mixer_max_us = g_mixer_max_us;
+
+	if (serial_send((uint8_t*) &t, sizeof(t)))
+		stream_last = system_ticks;
+}
+
+/**
+  * @brief  Serial link task.
+  * @note
+  * @param  data: Unused.
+  * @retval None
+  */
+void serial_process(uint32_t data)
+{
+	if (reply_len != 0 && serial_send(reply, reply_len))
+		reply_len = 0;
+
+	if (reply_len == 0)
+		serial_receive();
+
+	// Replies take priority over capture, then telemetry.
+	if (reply_len == 0 && !serial_capture())
+		serial_stream();
+
+	task_schedule(TASK_PROCESS_SERIAL, 0, SERIAL_TASK_PERIOD);
+}
+
+/**
+  * @brief  USART DMA TX Complete Handler
+  * @note
+  * @param  None
+  * @retval None
+  */
+void DMA1_Channel4_IRQHandler(void)
+{
+	DMA_Cmd(DMA1_Channel4, DISABLE);
+	DMA_ClearFlag(DMA1_FLAG_TC4);
+	DMA_ClearITPendingBit(DMA1_IT_TC4);
+	tx_busy = false;
+}
@@ -0,0 +1,90 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include <stdint.h>
+
+#include "frame.h"
+
+#define SERIAL_BAUDRATE		115200
+
+/*
+ * Link protocol (shared with tools/artlink.c).
+ * Every payload starts with a message type. All values are little endian.
+ * Requests from the host have the top bit clear, replies from the radio
+ * have it set. Each request gets exactly one reply.
+ * Model images (MSG_IMG_*) are compressed, see modelimg.h.
+ */
+typedef enum
+{
+	MSG_PING		= 0x01,	// -> MSG_PONG
+	MSG_STREAM		= 0x02,	// u8 period (ms, 0 = off) -> MSG_ACK
+	MSG_EE_READ		= 0x03,	// u16 offset, u8 length -> MSG_EE_DATA
+	MSG_EE_WRITE	= 0x04,	// u16 offset, data -> MSG_ACK
+	MSG_MODEL_READ	= 0x05,	// u8 model, u16 offset, u8 length -> MSG_EE_DATA
+	MSG_INFO		= 0x07,	// -> MSG_INFO_DATA
+	MSG_IMG_READ	= 0x08,	// u8 model, u16 offset -> MSG_IMG_DATA
+	MSG_IMG_WRITE	= 0x09,	// u8 model, u16 offset, u16 total, data -> MSG_ACK
+	MSG_CAPTURE		= 0x0A,	// u8 on -> MSG_ACK, then MSG_CAPTURE_DATA
+
+	MSG_ACK			= 0x80,	// u8 request, u8 status
+	MSG_PONG		= 0x81,
+	MSG_TELEMETRY	= 0x82,	// SerialTelemetry
+	MSG_EE_DATA		= 0x83,	// u16 offset, data
+	MSG_INFO_DATA	= 0x87,	// SerialInfo
+	MSG_IMG_DATA	= 0x88,	// u16 offset, u16 total, data
+	MSG_CAPTURE_DATA = 0x8A, // Capture records, see capture.h
+} SERIAL_MSG;
+
+typedef enum
+{
+	SERIAL_OK = 0,
+	SERIAL_ERR_UNKNOWN,
+	SERIAL_ERR_RANGE,
+	SERIAL_ERR_LENGTH,
+	SERIAL_ERR_DATA,
+	SERIAL_PENDING,		// Image chunk accepted, more to come
+} SERIAL_STATUS;
+
+// Largest data block carried by EE_DATA / EE_WRITE / IMG_*.
+#define SERIAL_MAX_DATA		32
+#define SERIAL_MIN_PERIOD	10
+
+typedef struct __attribute__((packed))
+{
+	uint8_t type;
+	uint32_t ticks;
+	int16_t chans[8];
+	int16_t sticks[7];
+	uint32_t mixer_passes;
+	uint16_t mixer_us;
+	uint16_t mixer_max_us;
+} SerialTelemetry;
+
+typedef struct __attribute__((packed))
+{
+	uint8_t type;
+	uint16_t eeprom_size;
+	uint16_t general_size;
+	uint16_t model_size;
+	uint8_t max_models;
+	uint8_t curr_model;
+} SerialInfo;
+
+void serial_init(void);
+void serial_process(uint32_t data);
+
+#endif // _SERIAL_H
@@ -0,0 +1,188 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Stack and RAM measurement.
+ * At boot the free stack budget is filled with STACK_PAINT. The high
+ * water mark is the lowest word that no longer holds it.
+ * Selected ISRs are sampled every STACK_SAMPLE_EVERY calls: a window
+ * below the stack pointer is painted on entry and checked on exit. This
+ * counts what the ISR calls (not its own frame), plus anything that
+ * preempted it in the meantime. A result of the full window size is
+ * a lower bound.
+ * The window is checked for earlier use before it is repainted, so the
+ * overall high water mark is kept.
+ *
+ * Static RAM by module is reported at build time by tools/ramreport.awk.
+ *
+ */
+
+#include "stm32f10x.h"
+
+#include "stack.h"
+
+// End of .bss from the library's linker script, end of .noinit from noinit.ld.
+extern uint32_t _end;
+extern uint32_t _noinit_end;
+
+#define STATIC_END		(&_noinit_end > &_end ? &_noinit_end : &_end)
+
+#define STACK_TOP		(*(const uint32_t*) FLASH_BASE)	// Initial MSP
+
+static uint32_t *paint_floor;
+static uint16_t high_water;
+static uint16_t isr_max[STACK_ISR_END];
+static uint8_t isr_count[STACK_ISR_END];
+
+/**
+  * @brief  Find the deepest word used in a painted range.
+  * @note
+  * @param  from: Lowest word
+  * @param  to: One past the highest word
+  * @retval The first word that has been overwritten, or to.
+  */
+static uint32_t *stack_lowest_used(uint32_t *from, uint32_t *to)
+{
+	while (from < to && *from == STACK_PAINT)
+		from++;
+	return from;
+}
+
+static void stack_mark(uint32_t *lowest)
+{
+	uint16_t used = STACK_TOP - (uint32_t) lowest;
+
+	if (used > high_water)
+		high_water = used;
+}
+
+/**
+  * @brief  Paint the free stack.
+  * @note	Call first thing in main().
+  * @param  None
+  * @retval None
+  */
+void stack_init(void)
+{
+	uint32_t *p;
+	uint32_t *sp = (uint32_t*) __get_MSP();
+
+	paint_floor = (uint32_t*) (STACK_TOP - STACK_BUDGET);
+	// Painting .noinit would wipe the fault record.
+	if (paint_floor < STATIC_END)
+		paint_floor = STATIC_END;
+
+	// Leave our own frame alone.
+	for (p = paint_floor; p < sp - 4; p++)
+		*p = STACK_PAINT;
+}
+
+/**
+  * @brief  Get the deepest stack use since boot.
+  * @note
+  * @param  None
+  * @retval Bytes.
+  */
+uint16_t stack_get_used(void)
+{
+	stack_mark(stack_lowest_used(paint_floor, (uint32_t*) __get_MSP()));
+	return high_water;
+}
+
+/**
+  * @brief  Get the stack budget left over.
+  * @note	0 means the stack has probably run into static data.
+  * @param  None
+  * @retval Bytes.
+  */
+uint16_t stack_get_free(void)
+{
+	uint16_t size = STACK_TOP - (uint32_t) paint_floor;
+	uint16_t used = stack_get_used();
+
+	return used < size ? size - used : 0;
+}
+
+/**
+  * @brief  Get the RAM used by static data.
+  * @note
+  * @param  None
+  * @retval Bytes.
+  */
+uint16_t stack_get_static(void)
+{
+	return (uint32_t) STATIC_END - SRAM_BASE;
+}
+
+/**
+  * @brief  Get the deepest stack use seen by an ISR.
+  * @note
+  * @param  isr: The ISR
+  * @retval Bytes, 0 if not sampled yet.
+  */
+uint16_t stack_get_isr(STACK_ISR isr)
+{
+	return isr_max[isr];
+}
+
+/**
+  * @brief  Start measuring an ISR.
+  * @note	Call on entry, pass the result to stack_isr_exit().
+  * @param  isr: The ISR
+  * @retval Mark for stack_isr_exit(), 0 if this call isn't sampled.
+  */
+uint32_t stack_isr_enter(STACK_ISR isr)
+{
+	uint32_t *sp = (uint32_t*) __get_MSP();
+	uint32_t *p = sp - STACK_SAMPLE_WORDS;
+
+	if (++isr_count[isr] < STACK_SAMPLE_EVERY || paint_floor == 0)
+		return 0;
+	isr_count[isr] = 0;
+
+	if (p < paint_floor)
+		p = paint_floor;
+
+	stack_mark(stack_lowest_used(p, sp));
+	for (; p < sp; p++)
+		*p = STACK_PAINT;
+
+	return (uint32_t) sp;
+}
+
+/**
+  * @brief  Finish measuring an ISR.
+  * @note
+  * @param  isr: The ISR
+  * @param  mark: From stack_isr_enter()
+  * @retval None
+  */
+void stack_isr_exit(STACK_ISR isr, uint32_t mark)
+{
+	uint32_t *sp = (uint32_t*) mark;
+	uint32_t *p = sp - STACK_SAMPLE_WORDS;
+	uint16_t used;
+
+	if (mark == 0)
+		return;
+	if (p < paint_floor)
+		p = paint_floor;
+
+	p = stack_lowest_used(p, sp);
+	stack_mark(p);
+	used = (sp - p) * 4;
+	if (used > isr_max[isr])
+		isr_max[isr] = used;
+}
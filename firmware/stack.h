@@ -0,0 +1,49 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _STACK_H
+#define _STACK_H
+
+#include <stdint.h>
+
+/*
+ * RAM budget (also read by tools/ramreport.awk).
+ * Static data (.data, .bss, .noinit) must leave STACK_BUDGET bytes free
+ * at the top of RAM for the stack, which main and every ISR share.
+ */
+#define STACK_RAM_SIZE		8192	// STM32F100R8
+#define STACK_BUDGET		1536
+
+#define STACK_PAINT			0xC5C5C5C5
+#define STACK_SAMPLE_EVERY	32		// ISR calls per usage sample
+#define STACK_SAMPLE_WORDS	128		// Window measured below the ISR
+
+typedef enum
+{
+	STACK_ISR_MIXER,
+	STACK_ISR_PULSES,
+	STACK_ISR_TICK,
+	STACK_ISR_END
+} STACK_ISR;
+
+void stack_init(void);
+uint16_t stack_get_used(void);
+uint16_t stack_get_free(void);
+uint16_t stack_get_static(void);
+uint16_t stack_get_isr(STACK_ISR isr);
+
+uint32_t stack_isr_enter(STACK_ISR isr);
+void stack_isr_exit(STACK_ISR isr, uint32_t mark);
+
+#endif // _STACK_H
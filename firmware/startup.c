@@ -0,0 +1,153 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Startup safety checks (throttle and switch warnings).
+ * Pulses are sent from power on, but until the throttle is at idle and
+ * the switches are in their startup positions the mixer holds the
+ * throttle input at minimum (see startup_hold()). The checks run as a
+ * task, so nothing blocks while waiting and a radio that is already
+ * safe is released on the first check.
+ *
+ */
+
+#include "tasks.h"
+#include "startup.h"
+#include "sticks.h"
+#include "keypad.h"
+#include "sound.h"
+#include "gui.h"
+#include "myeeprom.h"
+#include "art6.h"
+#include "watchdog.h"
+
+#define STARTUP_PERIOD			50		// ms between checks
+#define STARTUP_BEEP_PERIOD		2000	// ms between warning beeps
+#define STARTUP_THR_DEADBAND	(RESX / 32)
+#define STARTUP_SWITCHES		(SWITCH_SWA | SWITCH_SWB | SWITCH_SWC | SWITCH_SWD)
+
+static volatile STARTUP_STATE state = STARTUP_WAIT;
+static uint8_t problems;
+static uint32_t next_beep;
+
+/**
+  * @brief  Initialise the startup checks.
+  * @note	Call after eeprom_init() and sticks_init().
+  * @param  None
+  * @retval None
+  */
+void startup_init(void)
+{
+	state = STARTUP_WAIT;
+	task_register(TASK_PROCESS_STARTUP, startup_process);
+
+	// Probably in the air, don't cut the throttle.
+	if (watchdog_recovered())
+	{
+		state = STARTUP_READY;
+		return;
+	}
+
+	// The sticks task has scaled its first readings by then.
+	task_schedule(TASK_PROCESS_STARTUP, 0, STARTUP_PERIOD);
+}
+
+/**
+  * @brief  Check the controls.
+  * @note
+  * @param  None
+  * @retval Problem bits (see startup_get_problems()).
+  */
+static uint8_t startup_check(void)
+{
+	uint8_t ret = 0;
+	int16_t thr = stick_data[THR_STICK];
+
+	if (g_eeGeneral.throttleReversed)
+		thr = -thr;
+
+	if (!g_eeGeneral.disableThrottleWarning && thr > -RESX + STARTUP_THR_DEADBAND)
+		ret |= STARTUP_THROTTLE;
+
+	if (!g_eeGeneral.disableSwitchWarning)
+		ret |= (keypad_get_switches() ^ g_eeGeneral.switchWarningStates) & STARTUP_SWITCHES;
+
+	return ret;
+}
+
+/**
+  * @brief  Startup check task.
+  * @note	Reschedules itself until the controls are safe.
+  * @param  data: Not used.
+  * @retval None
+  */
+void startup_process(uint32_t data)
+{
+	problems = startup_check();
+
+	if (problems == 0)
+	{
+		state = STARTUP_READY;
+		return;
+	}
+
+	if (state == STARTUP_WAIT)
+	{
+		state = STARTUP_HOLD;
+		next_beep = system_ticks;
+		gui_navigate(GUI_LAYOUT_STARTUP_CHECK);
+	}
+
+	if (system_ticks >= next_beep)
+	{
+		sound_play_tone(1000, 200);
+		next_beep = system_ticks + STARTUP_BEEP_PERIOD;
+	}
+
+	task_schedule(TASK_PROCESS_STARTUP, 0, STARTUP_PERIOD);
+}
+
+/**
+  * @brief  Get the state of the startup checks.
+  * @note
+  * @param  None
+  * @retval STARTUP_STATE
+  */
+STARTUP_STATE startup_get_state(void)
+{
+	return state;
+}
+
+/**
+  * @brief  Whether the outputs are held safe.
+  * @note	Called by the mixer on every pass.
+  * @param  None
+  * @retval true until the startup checks have passed.
+  */
+bool startup_hold(void)
+{
+	return state != STARTUP_READY;
+}
+
+/**
+  * @brief  What failed the last check.
+  * @note
+  * @param  None
+  * @retval STARTUP_THROTTLE and / or the KEYPAD_SWITCH bits of wrong switches.
+  */
+uint8_t startup_get_problems(void)
+{
+	return problems;
+}
@@ -0,0 +1,39 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _STARTUP_H
+#define _STARTUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum
+{
+	STARTUP_WAIT = 0,	// No stick readings yet
+	STARTUP_HOLD,		// Waiting for the controls to be made safe
+	STARTUP_READY,
+} STARTUP_STATE;
+
+// startup_get_problems() bits. The low bits are the KEYPAD_SWITCH
+// bits of switches not in their startup position.
+#define STARTUP_THROTTLE	0x80
+
+void startup_init(void);
+void startup_process(uint32_t data);
+
+STARTUP_STATE startup_get_state(void);
+bool startup_hold(void);
+uint8_t startup_get_problems(void);
+
+#endif // _STARTUP_H
@@ -21,6 +21,14 @@
  * task.
  * Calibration is also handled through an API to this module.
  *
+ * Calibration accumulates samples in the DMA interrupt while the
+ * mixer is stopped. The limits are taken from the few most extreme
+ * samples, dropping the outermost as noise. The centre and the
+ * optional half travel (linearisation) points are the mean of a
+ * window of samples, rejected if the variance shows the stick moving.
+ * The results are turned into per channel segment multipliers so
+ * that normalisation needs no divisions.
+ *
  */
 
 #include <stm32f10x.h>
@@ -39,11 +47,55 @@
 #include "mixer.h"
 #include "myeeprom.h"
 #include "art6.h"
+#include "watchdog.h"
+#include "stack.h"
+#include "capture.h"
 
 volatile uint16_t adc_data[STICK_ADC_CHANNELS];
 volatile int16_t stick_data[STICK_ADC_CHANNELS];
 
-static CAL_STATE cal_state = CAL_OFF;
+#define CAL_EXTREMES	4	// Samples kept at each limit, the outer 3 are dropped.
+#define CAL_WINDOW		32	// Samples per centre/half travel mean (640ms).
+#define CAL_STEADY_VAR	64	// Max variance (counts^2) of a released stick.
+#define CAL_HOLD_VAR	256	// Max variance of a stick held at half travel.
+#define CAL_MIN_SPAN	256	// Min counts from centre to either limit.
+#define CAL_LIN_MIN		25	// Half travel must read 25-75% of a linear side.
+#define CAL_LIN_MAX		75
+
+// Normalisation of one channel. Each side of the centre is split at
+// the half travel knee, and start/knee/end are counts from the centre.
+typedef struct {
+	int16_t centre;
+	int16_t start[2];	// [neg|pos] Deadband edge.
+	int16_t knee[2];
+	int16_t end[2];
+	uint32_t mul[2][2];	// [side][below|above knee] Output per count, Q16.
+} STICK_COEF;
+
+static STICK_COEF coef[STICK_ADC_CHANNELS];
+
+static volatile CAL_STATE cal_state = CAL_OFF;
+
+// Results of the current calibration, saved by sticks_calibrate(CAL_OFF).
+static ADC_CAL cal_work[STICK_ADC_CHANNELS];
+static int16_t lin_work[STICKS_TO_CENTRE][2];
+
+// Sample accumulators, written by the DMA interrupt.
+static union {
+	struct {
+		uint16_t lo[STICKS_TO_CALIBRATE][CAL_EXTREMES];	// Ascending
+		uint16_t hi[STICKS_TO_CALIBRATE][CAL_EXTREMES];	// Descending
+	} lim;
+	struct {
+		uint8_t n;
+		bool valid;
+		int16_t ref[STICKS_TO_CENTRE];
+		int32_t sum[STICKS_TO_CENTRE];
+		uint32_t sumsq[STICKS_TO_CENTRE];
+		int16_t mean[STICKS_TO_CENTRE];	// Last complete window
+		uint16_t var[STICKS_TO_CENTRE];
+	} win;
+} cal_acc;
 
 /**
  * @brief  Initialise the stick scanning.
@@ -150,6 +202,8 @@ void sticks_init(void) {
 	/* enable ADC triggering */
 	ADC_ExternalTrigConvCmd(ADC1, ENABLE);
 
+	sticks_apply_calibration();
+
 	task_register(TASK_PROCESS_STICKS, sticks_process);
 	task_schedule(TASK_PROCESS_STICKS, 0, 20);
 }
@@ -165,21 +219,28 @@ void sticks_process(uint32_t data) {
 	// Scale channels to -RESX to +RESX
 	// For GUI purpose only.
 	for (i = 0; i < STICK_ADC_CHANNELS; ++i) {
-		int tmp;
-		tmp = adc_data[i];
-		if (adc_data[i] >= g_eeGeneral.calData[i].centre) {
-			tmp -= g_eeGeneral.calData[i].centre;
-			tmp *= RESX;
-			stick_data[i] = tmp
-					/ (g_eeGeneral.calData[i].max
-							- g_eeGeneral.calData[i].centre);
+		const STICK_COEF *c = &coef[i];
+		int32_t d = adc_data[i] - c->centre;
+		uint8_t side = 1;
+		int32_t out;
+
+		if (d < 0) {
+			d = -d;
+			side = 0;
+		}
+
+		if (d <= c->start[side]) {
+			out = 0;
+		} else if (d < c->knee[side]) {
+			out = ((uint32_t)(d - c->start[side]) * c->mul[side][0]) >> 16;
 		} else {
-			tmp = g_eeGeneral.calData[i].centre - tmp;
-			tmp *= -RESX;
-			stick_data[i] = tmp
-					/ (g_eeGeneral.calData[i].centre
-							- g_eeGeneral.calData[i].min);
+			if (d > c->end[side])
+				d = c->end[side];
+			out = RESX / 2
+					+ (((uint32_t)(d - c->knee[side]) * c->mul[side][1]) >> 16);
 		}
+
+		stick_data[i] = side ? out : -out;
 	}
 
 	gui_update(UPDATE_STICKS);
@@ -187,28 +248,257 @@ void sticks_process(uint32_t data) {
 }
 
 /**
- * @brief  Calibrate the endpoints and centre of the sticks.
- * @note
- * @param  state: Calibration state to enter.
+ * @brief  Set up the normalisation of one side of a channel.
+ * @note   Output is RESX/2 at the knee and RESX at the end.
+ * @param  c: Channel coefficients.
+ * @param  side: 0 below the centre, 1 above.
+ * @param  end: Counts from the centre to the limit.
+ * @param  knee: Counts from the centre to half travel, 0 = linear.
+ * @param  deadband: Deadband in 0.1% of end.
  * @retval None
  */
-void sticks_calibrate(CAL_STATE state) {
+static void sticks_side_coef(STICK_COEF *c, uint8_t side, int32_t end,
+		int32_t knee, uint8_t deadband) {
+	int32_t start = end * deadband / 1000;
+
+	if (end < 4 || end > 4095) {
+		// Not calibrated, always output 0.
+		c->start[side] = c->knee[side] = c->end[side] = INT16_MAX;
+		c->mul[side][0] = c->mul[side][1] = 0;
+		return;
+	}
+
+	if (knee <= start + 1 || knee >= end - 1)
+		knee = start + (end - start) / 2;
+
+	c->start[side] = start;
+	c->knee[side] = knee;
+	c->end[side] = end;
+	// Round up so that the end reaches RESX.
+	c->mul[side][0] = (((uint32_t)RESX / 2 << 16) + knee - start - 1) / (knee - start);
+	c->mul[side][1] = (((uint32_t)RESX / 2 << 16) + end - knee - 1) / (end - knee);
+}
+
+/**
+ * @brief  Precompute the normalisation from the calibration data.
+ * @note   Call after g_eeGeneral calibration or deadband changes.
+ * @param  None
+ * @retval None
+ */
+void sticks_apply_calibration(void) {
+	uint8_t deadband = g_eeGeneral.stickDeadband;
 	int i;
 
-	cal_state = state;
+	if (deadband > STICK_DEADBAND_MAX)
+		deadband = STICK_DEADBAND_MAX;
+
+	for (i = 0; i < STICK_ADC_CHANNELS; ++i) {
+		int32_t centre = g_eeGeneral.calData[i].centre;
+		int32_t knee[2] = { 0, 0 };
+
+		if (i < STICKS_TO_CENTRE) {
+			if (g_eeGeneral.calLin[i][0])
+				knee[0] = centre - g_eeGeneral.calLin[i][0];
+			if (g_eeGeneral.calLin[i][1])
+				knee[1] = g_eeGeneral.calLin[i][1] - centre;
+		}
+
+		coef[i].centre = centre;
+		sticks_side_coef(&coef[i], 0, centre - g_eeGeneral.calData[i].min,
+				knee[0], (i < STICKS_TO_CENTRE) ? deadband : 0);
+		sticks_side_coef(&coef[i], 1, g_eeGeneral.calData[i].max - centre,
+				knee[1], (i < STICKS_TO_CENTRE) ? deadband : 0);
+	}
+}
+
+/**
+ * @brief  Clear the sample accumulators for a calibration phase.
+ * @note
+ * @param  state: Phase about to start.
+ * @retval None
+ */
+static void sticks_cal_reset(CAL_STATE state) {
+	int i, j;
 
 	if (state == CAL_LIMITS) {
 		for (i = 0; i < STICKS_TO_CALIBRATE; ++i) {
-			g_eeGeneral.calData[i].min = 0x7FFF;
-			g_eeGeneral.calData[i].max = 0;
-			g_eeGeneral.calData[i].centre = 2048;
+			for (j = 0; j < CAL_EXTREMES; ++j) {
+				cal_acc.lim.lo[i][j] = 0xFFFF;
+				cal_acc.lim.hi[i][j] = 0;
+			}
+		}
+	} else {
+		cal_acc.win.n = 0;
+		cal_acc.win.valid = false;
+		for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+			cal_acc.win.sum[i] = 0;
+			cal_acc.win.sumsq[i] = 0;
+		}
+	}
+}
+
+/**
+ * @brief  Take the limits from the limits phase.
+ * @note   Fails unless every control moved CAL_MIN_SPAN either way.
+ * @param  None
+ * @retval true if accepted.
+ */
+static bool sticks_cal_limits(void) {
+	int i;
+
+	for (i = 0; i < STICKS_TO_CALIBRATE; ++i) {
+		int32_t lo = cal_acc.lim.lo[i][CAL_EXTREMES - 1];
+		int32_t hi = cal_acc.lim.hi[i][CAL_EXTREMES - 1];
+		if (hi - lo < 2 * CAL_MIN_SPAN)
+			return false;
+	}
+
+	for (i = 0; i < STICKS_TO_CALIBRATE; ++i) {
+		cal_work[i].min = cal_acc.lim.lo[i][CAL_EXTREMES - 1];
+		cal_work[i].max = cal_acc.lim.hi[i][CAL_EXTREMES - 1];
+		// Final for the pots, the sticks get theirs from CAL_CENTER.
+		cal_work[i].centre = cal_work[i].min
+				+ (cal_work[i].max - cal_work[i].min) / 2;
+	}
+
+	// Battery
+	cal_work[i].min = 0;
+	cal_work[i].max = 3100;
+	cal_work[i].centre = 1550;
+
+	// Half travel points belong to the old limits.
+	for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+		lin_work[i][0] = 0;
+		lin_work[i][1] = 0;
+	}
+	return true;
+}
+
+/**
+ * @brief  Take the stick centres from the last window of samples.
+ * @note   Fails if a stick was moving or is too close to a limit.
+ * @param  None
+ * @retval true if accepted.
+ */
+static bool sticks_cal_centre(void) {
+	int i;
+
+	if (!cal_acc.win.valid)
+		return false;
+
+	for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+		int16_t mean = cal_acc.win.mean[i];
+		if (cal_acc.win.var[i] > CAL_STEADY_VAR
+				|| mean - cal_work[i].min < CAL_MIN_SPAN
+				|| cal_work[i].max - mean < CAL_MIN_SPAN)
+			return false;
+	}
+
+	for (i = 0; i < STICKS_TO_CENTRE; ++i)
+		cal_work[i].centre = cal_acc.win.mean[i];
+	return true;
+}
+
+/**
+ * @brief  Take half travel points from the last window of samples.
+ * @note   A stick is only taken if it is between CAL_LIN_MIN and
+ *         CAL_LIN_MAX of its side, so centred sticks are left alone.
+ * @param  None
+ * @retval true if accepted.
+ */
+static bool sticks_cal_linear(void) {
+	int i;
+
+	if (!cal_acc.win.valid)
+		return false;
+
+	for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+		if (cal_acc.win.var[i] > CAL_HOLD_VAR)
+			return false;
+	}
+
+	for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+		int32_t mean = cal_acc.win.mean[i];
+		int32_t d = mean - cal_work[i].centre;
+		int32_t end;
+		uint8_t side = 1;
+
+		if (d < 0) {
+			d = -d;
+			side = 0;
+			end = cal_work[i].centre - cal_work[i].min;
+		} else {
+			end = cal_work[i].max - cal_work[i].centre;
 		}
 
-		// Battery
-		g_eeGeneral.calData[i].min = 0;
-		g_eeGeneral.calData[i].max = 3100;
-		g_eeGeneral.calData[i].centre = 1550;
+		if (d * 100 >= end * CAL_LIN_MIN && d * 100 <= end * CAL_LIN_MAX)
+			lin_work[i][side] = mean;
 	}
+	return true;
+}
+
+/**
+ * @brief  Calibrate the endpoints and centre of the sticks.
+ * @note   Ends the current phase then starts the next. CAL_LINEAR
+ *         may be repeated to take a point for each side of each stick.
+ *         CAL_OFF saves the results into g_eeGeneral without taking a
+ *         point. If the current phase is rejected the state is kept.
+ * @param  state: Calibration state to enter.
+ * @retval true if the current phase was accepted.
+ */
+bool sticks_calibrate(CAL_STATE state) {
+	bool ok = true;
+	int i;
+
+	// The mixer is not running, hold off the sampling interrupt.
+	NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+
+	switch (state) {
+	case CAL_LIMITS:
+		break;
+	case CAL_CENTER:
+		ok = (cal_state == CAL_LIMITS) && sticks_cal_limits();
+		break;
+	case CAL_LINEAR:
+		if (cal_state == CAL_CENTER)
+			ok = sticks_cal_centre();
+		else
+			ok = (cal_state == CAL_LINEAR) && sticks_cal_linear();
+		break;
+	case CAL_OFF:
+		ok = (cal_state == CAL_LINEAR);
+		if (ok) {
+			for (i = 0; i < STICK_ADC_CHANNELS; ++i)
+				g_eeGeneral.calData[i] = cal_work[i];
+			for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+				g_eeGeneral.calLin[i][0] = lin_work[i][0];
+				g_eeGeneral.calLin[i][1] = lin_work[i][1];
+			}
+			sticks_apply_calibration();
+		}
+		break;
+	}
+
+	if (ok) {
+		sticks_cal_reset(state);
+		cal_state = state;
+	} else if (cal_state == CAL_CENTER || cal_state == CAL_LINEAR) {
+		// Start a fresh window for the retry.
+		sticks_cal_reset(cal_state);
+	}
+
+	NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+	return ok;
+}
+
+/**
+ * @brief  Abandon a calibration, keeping the saved one.
+ * @note
+ * @param  None
+ * @retval None
+ */
+void sticks_calibrate_abort(void) {
+	cal_state = CAL_OFF;
 }
 
 /**
@@ -252,6 +542,70 @@ uint16_t sticks_get_battery(void) {
 	return val;
 }
 
+/**
+ * @brief  Keep the CAL_EXTREMES highest and lowest samples.
+ * @note   Called from the DMA interrupt.
+ * @param  None
+ * @retval None
+ */
+static void sticks_sample_limits(void) {
+	int i, j;
+
+	for (i = 0; i < STICKS_TO_CALIBRATE; ++i) {
+		uint16_t v = adc_data[i];
+		uint16_t *lo = cal_acc.lim.lo[i];
+		uint16_t *hi = cal_acc.lim.hi[i];
+
+		if (v < lo[CAL_EXTREMES - 1]) {
+			for (j = CAL_EXTREMES - 1; j > 0 && lo[j - 1] > v; --j)
+				lo[j] = lo[j - 1];
+			lo[j] = v;
+		}
+		if (v > hi[CAL_EXTREMES - 1]) {
+			for (j = CAL_EXTREMES - 1; j > 0 && hi[j - 1] < v; --j)
+				hi[j] = hi[j - 1];
+			hi[j] = v;
+		}
+	}
+}
+
+/**
+ * @brief  Accumulate the stick mean and variance over CAL_WINDOW samples.
+ * @note   Called from the DMA interrupt. Samples are taken relative to
+ *         the first of the window to keep the sums small.
+ * @param  None
+ * @retval None
+ */
+static void sticks_sample_window(void) {
+	int i;
+
+	for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+		int32_t d;
+		if (cal_acc.win.n == 0)
+			cal_acc.win.ref[i] = adc_data[i];
+		d = adc_data[i] - cal_acc.win.ref[i];
+		cal_acc.win.sum[i] += d;
+		cal_acc.win.sumsq[i] += d * d;
+	}
+
+	if (++cal_acc.win.n < CAL_WINDOW)
+		return;
+
+	for (i = 0; i < STICKS_TO_CENTRE; ++i) {
+		int32_t sum = cal_acc.win.sum[i];
+		int64_t var = ((int64_t)cal_acc.win.sumsq[i] * CAL_WINDOW
+				- (int64_t)sum * sum) / (CAL_WINDOW * CAL_WINDOW);
+
+		cal_acc.win.mean[i] = cal_acc.win.ref[i]
+				+ (sum + ((sum < 0) ? -CAL_WINDOW / 2 : CAL_WINDOW / 2)) / CAL_WINDOW;
+		cal_acc.win.var[i] = (var > 0xFFFF) ? 0xFFFF : var;
+		cal_acc.win.sum[i] = 0;
+		cal_acc.win.sumsq[i] = 0;
+	}
+	cal_acc.win.n = 0;
+	cal_acc.win.valid = true;
+}
+
 /**
  * @brief  This function handles the DMA end of transfer
  *          and processing of ADC stick data then calls the mixer.
@@ -259,9 +613,12 @@ uint16_t sticks_get_battery(void) {
  * @retval None
  */
 void DMA1_Channel1_IRQHandler(void) {
+	uint32_t mark = stack_isr_enter(STACK_ISR_MIXER);
 
 	DMA_ClearFlag(DMA1_FLAG_TC1);
 	DMA_ClearITPendingBit(DMA_IT_TC);
+	watchdog_heartbeat(WATCHDOG_MIXER);
+	capture_adc();
 
 	// Don't run the mixer if we're calibrating
 	if (cal_state == CAL_OFF) {
@@ -269,28 +626,11 @@ void DMA1_Channel1_IRQHandler(void) {
 			// Run the mixer.
 			mixer_update();
 		}
-	} else // if (cal_state != CAL_OFF)
-	{
-		int i;
-		if (cal_state == CAL_LIMITS) {
-			for (i = 0; i < STICK_INPUT_CHANNELS; ++i) {
-				if (adc_data[i] < g_eeGeneral.calData[i].min)
-					g_eeGeneral.calData[i].min = adc_data[i];
-				if (adc_data[i] > g_eeGeneral.calData[i].max)
-					g_eeGeneral.calData[i].max = adc_data[i];
-			}
-		} else if (cal_state == CAL_CENTER) {
-			// Set the stick centres.
-			for (i = 0; i < STICKS_TO_CALIBRATE; ++i) {
-				g_eeGeneral.calData[i].centre = adc_data[i];
-			}
-
-			// Set the remaining centres.
-			for (i = STICKS_TO_CALIBRATE; i < STICK_INPUT_CHANNELS; ++i) {
-				g_eeGeneral.calData[i].centre = g_eeGeneral.calData[i].min
-						+ ((g_eeGeneral.calData[i].max
-								- g_eeGeneral.calData[i].min) / 2);
-			}
-		}
+	} else if (cal_state == CAL_LIMITS) {
+		sticks_sample_limits();
+	} else {
+		sticks_sample_window();
 	}
+
+	stack_isr_exit(STACK_ISR_MIXER, mark);
 }
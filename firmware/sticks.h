@@ -22,6 +22,9 @@
 #define STICK_INPUT_CHANNELS	6
 #define STICKS_TO_CALIBRATE		6
 #define STICKS_TO_TRIM			4
+#define STICKS_TO_CENTRE		4	// Sprung sticks, centred, linearised and deadbanded.
+
+#define STICK_DEADBAND_MAX		100	// 10.0% of half travel.
 
 #define RESX    (1<<10) // 1024
 #define RESXu   1024u
@@ -45,7 +48,8 @@ typedef enum
 {
 	CAL_OFF,
 	CAL_LIMITS,
-	CAL_CENTER
+	CAL_CENTER,
+	CAL_LINEAR
 } CAL_STATE;
 
 extern volatile uint16_t adc_data[STICK_ADC_CHANNELS];
@@ -54,7 +58,9 @@ extern volatile int16_t stick_data[STICK_ADC_CHANNELS];
 
 void sticks_init(void);
 void sticks_process(uint32_t data);
-void sticks_calibrate(CAL_STATE state);
+bool sticks_calibrate(CAL_STATE state);
+void sticks_calibrate_abort(void);
+void sticks_apply_calibration(void);
 int16_t sticks_get(STICK chan);
 int16_t sticks_get_percent(STICK chan);
 uint16_t sticks_get_battery(void);
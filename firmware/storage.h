@@ -0,0 +1,53 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _STORAGE_H
+#define _STORAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Non-volatile storage backends. Exactly one is built in, chosen with
+ * STORAGE_BACKEND, e.g. make CPPFLAGS=-DSTORAGE_BACKEND=STORAGE_FLASH
+ *
+ *   STORAGE_I2C    24C64 EEPROM on I2C1 (storage_i2c.c), the default
+ *   STORAGE_FLASH  log in the top pages of internal flash (storage_flash.c),
+ *                  the PPM output pauses for a frame while a page is erased
+ *   STORAGE_RAM    plain RAM, lost at reset (storage_ram.c), for bench
+ *                  and host builds
+ *
+ * All of them look like a byte addressed EEPROM of STORAGE_SIZE bytes
+ * that reads as 0xFF until written.
+ */
+#define STORAGE_I2C		1
+#define STORAGE_FLASH	2
+#define STORAGE_RAM		3
+
+#ifndef STORAGE_BACKEND
+#define STORAGE_BACKEND	STORAGE_I2C
+#endif
+
+#if STORAGE_BACKEND == STORAGE_FLASH
+// Bounded by the flash set aside for the log, see storage_flash.c
+#define STORAGE_SIZE	4096
+#else
+#define STORAGE_SIZE	8192
+#endif
+
+void storage_init(void);
+void storage_read(uint16_t offset, uint16_t length, void *buffer);
+bool storage_write(uint16_t offset, uint16_t length, const void *buffer);
+
+#endif // _STORAGE_H
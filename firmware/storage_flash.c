@@ -0,0 +1,443 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Storage backend in the internal flash.
+ *
+ * The storage is split into 32 byte blocks. Every write of a block appends
+ * a record to a log kept in the top STORAGE_FLASH_PAGES pages of flash and
+ * a RAM table points at the newest record of each block, so reads are a
+ * plain memcpy out of flash.
+ *
+ * Page:   u16 magic, u16 sequence, then RECORDS_PER_PAGE records.
+ * Record: u16 block, 16 x u16 data, u16 commit.
+ *
+ * A record only counts once its commit halfword has been programmed to 0,
+ * which is done last, so a write cut short by a reset is ignored and the
+ * previous copy of the block is used. Pages are reclaimed by copying their
+ * live records to the head and erasing them. One erased page is always
+ * kept spare for this.
+ *
+ * The CPU stalls on flash for about 20ms while a page is erased and for
+ * up to 70us for every halfword programmed, the PPM interrupt included.
+ * The PPM edges are set by that interrupt, so no flash is touched while a
+ * frame is being sent. storage_init() reclaims every page worth it before
+ * the output starts. After that the output is held at the end of a frame
+ * (pulses_hold()) for flash to be written, and the stall only lengthens
+ * its sync gap. A gap takes up to GAP_PROGRAMS halfwords, or one erase,
+ * and a longer write goes on in the gap of the next frame.
+ * tools/flashreport.awk fails the build if the firmware reaches
+ * STORAGE_FLASH_BASE.
+ *
+ */
+
+#include "storage.h"
+
+#if STORAGE_BACKEND == STORAGE_FLASH
+
+#include <string.h>
+
+#include <stm32f10x.h>
+#include <stm32f10x_flash.h>
+
+#include "watchdog.h"
+#include "pulses.h"
+
+#define STORAGE_FLASH_SIZE		0x10000		// STM32F100R8, 64KB
+#define STORAGE_FLASH_END		(FLASH_BASE + STORAGE_FLASH_SIZE)
+#define STORAGE_FLASH_PAGE_SIZE	1024
+#define STORAGE_FLASH_PAGES		8
+#define STORAGE_FLASH_BASE		(STORAGE_FLASH_END - STORAGE_FLASH_PAGES * STORAGE_FLASH_PAGE_SIZE)
+
+#define PAGE_MAGIC			0x4C53		// "SL"
+#define BLOCK_SIZE			32
+#define BLOCKS				(STORAGE_SIZE / BLOCK_SIZE)
+#define RECORD_SIZE			(2 + BLOCK_SIZE + 2)
+#define PAGE_HDR_SIZE		4
+#define RECORDS_PER_PAGE	((STORAGE_FLASH_PAGE_SIZE - PAGE_HDR_SIZE) / RECORD_SIZE)
+#define NO_RECORD			0xFFFF
+#define GAP_PROGRAMS		72			// Halfwords per sync gap, about 5ms
+
+typedef struct
+{
+	uint16_t block;
+	uint16_t data[BLOCK_SIZE / 2];
+	uint16_t commit;
+} FlashRecord;
+
+typedef struct
+{
+	uint16_t magic;
+	uint16_t seq;
+	FlashRecord record[RECORDS_PER_PAGE];
+} FlashPage;
+
+// Garbage collection needs every block live at once to fit in the pages
+// other than the spare, with at least one record to spare.
+typedef char storage_flash_fits[
+	(BLOCKS < (STORAGE_FLASH_PAGES - 1) * RECORDS_PER_PAGE) ? 1 : -1];
+
+#define PAGE(p)		((const FlashPage*) (STORAGE_FLASH_BASE + (p) * STORAGE_FLASH_PAGE_SIZE))
+
+// locals
+
+static uint16_t location[BLOCKS];	// Newest record, page * RECORDS_PER_PAGE + slot
+static uint8_t head = 0xFF;			// Page being appended to
+static uint8_t head_slot = RECORDS_PER_PAGE;
+static uint16_t head_seq;
+static uint8_t spare;				// Erased pages
+static uint8_t gap_left;			// Halfwords still allowed in this sync gap
+
+/**
+  * @brief  Check whether a page is entirely erased.
+  * @note
+  * @param  p: Page number
+  * @retval true if erased
+  */
+static bool storage_flash_blank(uint8_t p)
+{
+	const uint32_t *w = (const uint32_t*) PAGE(p);
+	uint16_t i;
+
+	for (i = 0; i < STORAGE_FLASH_PAGE_SIZE / 4; i++)
+		if (w[i] != 0xFFFFFFFF)
+			return false;
+	return true;
+}
+
+/**
+  * @brief  Program a halfword.
+  * @note	Flash must be unlocked.
+  * @param  address: Flash address
+  * @param  value: Halfword to write
+  * @retval false on a programming error
+  */
+static bool storage_flash_program(const volatile uint16_t *address, uint16_t value)
+{
+	return FLASH_ProgramHalfWord((uint32_t) address, value) == FLASH_COMPLETE;
+}
+
+/**
+  * @brief  Make sure the PPM output is held for flash to be programmed.
+  * @note	Moves on to the sync gap of the next frame once this one has
+  *         had its share. Before the output is started this does nothing.
+  * @param  programs: Halfwords about to be programmed, GAP_PROGRAMS for an
+  *         erase, which gets a gap of its own
+  * @retval None
+  */
+static void storage_flash_gap(uint8_t programs)
+{
+	if (gap_left >= programs)
+	{
+		gap_left -= programs;
+		return;
+	}
+	pulses_release();
+	pulses_hold();
+	gap_left = GAP_PROGRAMS - programs;
+}
+
+/**
+  * @brief  Age of a page, the head page is 0.
+  * @note
+  * @param  p: Page number
+  * @retval Number of pages opened since
+  */
+static uint16_t storage_flash_age(uint8_t p)
+{
+	return head_seq - PAGE(p)->seq;
+}
+
+/**
+  * @brief  Start appending to an erased page.
+  * @note	Flash must be unlocked.
+  * @param  None
+  * @retval false if there is no erased page or programming failed
+  */
+static bool storage_flash_open_page(void)
+{
+	uint8_t p;
+
+	for (p = 0; p < STORAGE_FLASH_PAGES; p++)
+		if (PAGE(p)->magic == 0xFFFF)
+			break;
+	if (p == STORAGE_FLASH_PAGES)
+		return false;
+
+	head_seq++;
+	storage_flash_gap(2);
+	if (!storage_flash_program(&PAGE(p)->seq, head_seq) ||
+			!storage_flash_program(&PAGE(p)->magic, PAGE_MAGIC))
+		return false;
+	head = p;
+	head_slot = 0;
+	spare--;
+	return true;
+}
+
+/**
+  * @brief  Append a record to the head page.
+  * @note	Flash must be unlocked and the head page must have room.
+  * @param  block: Block number
+  * @param  data: BLOCK_SIZE bytes, halfword aligned
+  * @retval false on a programming error
+  */
+static bool storage_flash_append(uint16_t block, const uint16_t *data)
+{
+	const FlashRecord *r = &PAGE(head)->record[head_slot];
+	uint8_t i;
+
+	// Whatever happens the slot is used now
+	head_slot++;
+
+	storage_flash_gap(RECORD_SIZE / 2);
+	if (!storage_flash_program(&r->block, block))
+		return false;
+	for (i = 0; i < BLOCK_SIZE / 2; i++)
+		if (!storage_flash_program(&r->data[i], data[i]))
+			return false;
+	if (!storage_flash_program(&r->commit, 0))
+		return false;
+
+	location[block] = head * RECORDS_PER_PAGE + (r - PAGE(head)->record);
+	return true;
+}
+
+/**
+  * @brief  Erase the page with the fewest live records.
+  * @note	Flash must be unlocked. The live records are first copied to the
+  *         head, going on in a new head page once it is full.
+  * @param  limit: Only a page with fewer live records than this is erased
+  * @retval false on a flash error, if there is nowhere to copy to or no
+  *         page is under the limit
+  */
+static bool storage_flash_collect(uint8_t limit)
+{
+	uint8_t live[STORAGE_FLASH_PAGES] = { 0 };
+	uint8_t victim = 0xFF;
+	uint8_t p, s;
+	uint16_t b;
+
+	for (b = 0; b < BLOCKS; b++)
+		if (location[b] != NO_RECORD)
+			live[location[b] / RECORDS_PER_PAGE]++;
+	for (p = 0; p < STORAGE_FLASH_PAGES; p++)
+		if (p != head && PAGE(p)->magic == PAGE_MAGIC &&
+				(victim == 0xFF || live[p] < live[victim]))
+			victim = p;
+	if (victim == 0xFF || live[victim] >= limit)
+		return false;
+
+	for (s = 0; s < RECORDS_PER_PAGE; s++)
+	{
+		const FlashRecord *r = &PAGE(victim)->record[s];
+		if (r->block >= BLOCKS || location[r->block] != victim * RECORDS_PER_PAGE + s)
+			continue;
+		if (head_slot == RECORDS_PER_PAGE && !storage_flash_open_page())
+			return false;
+		if (!storage_flash_append(r->block, r->data))
+			return false;
+	}
+
+	// Invalidate first so a half erased page is not mistaken for a valid one.
+	storage_flash_gap(GAP_PROGRAMS);
+	if (!storage_flash_program(&PAGE(victim)->magic, 0) ||
+			FLASH_ErasePage((uint32_t) PAGE(victim)) != FLASH_COMPLETE)
+		return false;
+	spare++;
+	return true;
+}
+
+/**
+  * @brief  Make room in the head page for one more record.
+  * @note	Flash must be unlocked. The last erased page is kept to collect
+  *         into, pages are reclaimed when it would be needed.
+  * @param  None
+  * @retval false on a flash error or if every record is live
+  */
+static bool storage_flash_make_room(void)
+{
+	if (head_slot < RECORDS_PER_PAGE)
+		return true;
+	while (spare < 2)
+	{
+		if (!storage_flash_collect(RECORDS_PER_PAGE))
+			return false;
+		watchdog_heartbeat(WATCHDOG_MAIN);
+	}
+	// Collecting may have opened a head page with room.
+	return head_slot < RECORDS_PER_PAGE || storage_flash_open_page();
+}
+
+/**
+  * @brief  Rebuild the block table from the log and reclaim pages.
+  * @note	Pages that are neither valid nor blank (erase cut short) are erased.
+  *         Must be called before the PPM output is started.
+  * @param  None
+  * @retval None
+  */
+void storage_init(void)
+{
+	uint8_t order[STORAGE_FLASH_PAGES];
+	uint8_t pages = 0;
+	uint8_t p, i, s;
+
+	memset(location, 0xFF, sizeof(location));
+	gap_left = 0;
+	spare = 0;
+	head = 0xFF;
+	head_slot = RECORDS_PER_PAGE;
+
+	FLASH_Unlock();
+	for (p = 0; p < STORAGE_FLASH_PAGES; p++)
+	{
+		if (PAGE(p)->magic == PAGE_MAGIC)
+		{
+			order[pages++] = p;
+			continue;
+		}
+		if (!storage_flash_blank(p))
+			FLASH_ErasePage((uint32_t) PAGE(p));
+		spare++;
+	}
+	FLASH_Lock();
+
+	if (pages == 0)
+		return;
+
+	// Find the newest page, then replay the others oldest first.
+	head = order[0];
+	for (i = 1; i < pages; i++)
+		if ((int16_t) (PAGE(order[i])->seq - PAGE(head)->seq) > 0)
+			head = order[i];
+	head_seq = PAGE(head)->seq;
+
+	for (i = 1; i < pages; i++)
+	{
+		uint8_t o = order[i];
+		int8_t j = i - 1;
+		while (j >= 0 && storage_flash_age(order[j]) < storage_flash_age(o))
+		{
+			order[j + 1] = order[j];
+			j--;
+		}
+		order[j + 1] = o;
+	}
+
+	for (i = 0; i < pages; i++)
+	{
+		p = order[i];
+		for (s = 0; s < RECORDS_PER_PAGE; s++)
+		{
+			const FlashRecord *r = &PAGE(p)->record[s];
+			if (r->block == 0xFFFF)
+				break;
+			if (r->commit == 0 && r->block < BLOCKS)
+				location[r->block] = p * RECORDS_PER_PAGE + s;
+		}
+		if (p == head)
+			head_slot = s;
+	}
+
+	// Pages at most half live are always worth reclaiming, fuller ones only
+	// to leave an erased page to write to besides the spare. This also
+	// finishes a collection cut short by a reset, which leaves no spare.
+	FLASH_Unlock();
+	while (storage_flash_collect(RECORDS_PER_PAGE / 2 + 1) ||
+			(spare < 2 && storage_flash_collect(RECORDS_PER_PAGE)))
+		watchdog_heartbeat(WATCHDOG_MAIN);
+	FLASH_Lock();
+}
+
+/**
+  * @brief  Read a block of data.
+  * @note
+  * @param  offset: Start byte address
+  * @param  length: Number of bytes
+  * @param  buffer: Destination buffer pointer
+  * @retval None
+  */
+void storage_read(uint16_t offset, uint16_t length, void *buffer)
+{
+	uint8_t *dst = buffer;
+
+	while (length)
+	{
+		uint16_t block = offset / BLOCK_SIZE;
+		uint16_t pos = offset % BLOCK_SIZE;
+		uint16_t n = BLOCK_SIZE - pos;
+		uint16_t loc = block < BLOCKS ? location[block] : NO_RECORD;
+
+		if (n > length)
+			n = length;
+		if (loc == NO_RECORD)
+			memset(dst, 0xFF, n);
+		else
+			memcpy(dst, (const uint8_t*) PAGE(loc / RECORDS_PER_PAGE)->record[loc % RECORDS_PER_PAGE].data + pos, n);
+
+		dst += n;
+		offset += n;
+		length -= n;
+	}
+}
+
+/**
+  * @brief  Write a block of data.
+  * @note	Blocks whose contents do not change are not rewritten. Returns
+  *         with the PPM output running again.
+  * @param  offset: Start byte address
+  * @param  length: Number of bytes
+  * @param  buffer: Source buffer pointer
+  * @retval false on a flash error or if the range is outside the storage
+  */
+bool storage_write(uint16_t offset, uint16_t length, const void *buffer)
+{
+	const uint8_t *src = buffer;
+	uint16_t data[BLOCK_SIZE / 2];
+	bool ok = true;
+
+	if (offset + length > STORAGE_SIZE)
+		return false;
+
+	gap_left = 0;
+	FLASH_Unlock();
+	while (length && ok)
+	{
+		uint16_t block = offset / BLOCK_SIZE;
+		uint16_t pos = offset % BLOCK_SIZE;
+		uint16_t n = BLOCK_SIZE - pos;
+
+		if (n > length)
+			n = length;
+
+		storage_read(block * BLOCK_SIZE, BLOCK_SIZE, data);
+		if (memcmp((uint8_t*) data + pos, src, n))
+		{
+			memcpy((uint8_t*) data + pos, src, n);
+			ok = storage_flash_make_room() && storage_flash_append(block, data);
+			watchdog_heartbeat(WATCHDOG_MAIN);
+		}
+
+		src += n;
+		offset += n;
+		length -= n;
+	}
+	FLASH_Lock();
+	pulses_release();
+
+	return ok;
+}
+
+#endif // STORAGE_BACKEND == STORAGE_FLASH
@@ -0,0 +1,550 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Storage backend for the 24C64 EEPROM on I2C1.
+ *
+ * This is an IRQ driven EEPROM driver (including I2C). Each read or write
+ * is one transaction, driven entirely from the I2C, DMA and TIM7
+ * interrupts, none of which wait for the bus. The caller waits for it to
+ * finish, there is only ever one.
+ *
+ * TIM7 ticks every STORAGE_I2C_TICK_US while a transaction is running. It
+ * starts pages once the bus is idle, paces the ACK polling that
+ * waits out the EEPROM's write cycle and retries after a NACK or bus
+ * error. A page that makes no progress for STORAGE_I2C_TIMEOUT ticks gets
+ * the bus recovered: SCL is clocked by hand until the EEPROM lets go of
+ * SDA (e.g. after a reset in the middle of a read), then a STOP is sent.
+ * If it times out again the transaction fails.
+ *
+ */
+
+#include "storage.h"
+
+#if STORAGE_BACKEND == STORAGE_I2C
+
+#include <stm32f10x.h>
+#include <stm32f10x_i2c.h>
+#include <stm32f10x_dma.h>
+#include <stm32f10x_gpio.h>
+#include <stm32f10x_rcc.h>
+#include <stm32f10x_tim.h>
+#include <stm32f10x_misc.h>
+
+#include "watchdog.h"
+
+#define EEPROM_PAGE_SIZE 32
+
+#define I2C_SCL		GPIO_Pin_6
+#define I2C_SDA		GPIO_Pin_7
+#define I2C_PINS	(I2C_SCL | I2C_SDA)
+
+#define EEPROM_ADDR 0xA0
+
+#define STORAGE_I2C_TICK_US		500
+// Longest a page may take, retries included. The write cycle is 5ms.
+#define STORAGE_I2C_TIMEOUT		(25000 / STORAGE_I2C_TICK_US)
+// SCL pulses that are always enough for the EEPROM to finish a byte.
+#define STORAGE_I2C_RECOVER_CLOCKS	9
+
+typedef enum _state {
+	STATE_IDLE,				// No transaction or recovery, the tick stops itself
+	STATE_WAIT,				// Next tick (re)starts the current page once the bus is idle
+	STATE_START,
+	STATE_ADDRESSED1,
+	STATE_ADDRESSED2,
+	STATE_RESTART,
+	STATE_TRANSFER_START,
+	STATE_TRANSFERRING,
+	STATE_POLLING,			// Addressing the EEPROM to see if the write cycle is over
+	STATE_RECOVER,			// Clocking the bus free, one half clock per tick
+} STATE;
+
+typedef enum {
+	TX_RUNNING,
+	TX_DONE,
+	TX_ERROR,
+} TX_STATUS;
+
+typedef struct {
+	uint16_t offset;
+	uint16_t length;
+	uint16_t done;			// Bytes transferred so far
+	uint16_t page;			// Bytes in the page being written
+	uint8_t *buffer;
+	uint8_t read;
+	volatile uint8_t status;
+} Transaction;
+
+
+// locals
+
+static volatile STATE state = STATE_IDLE;
+static volatile DMA_InitTypeDef g_dmaInit;
+
+static Transaction * volatile current;	// Set by storage_run(), cleared by the IRQs
+static bool polling;					// Waiting for a write cycle to finish
+static uint8_t ticks;					// Since the current page started
+static bool recovered;					// Bus recovery already tried for it
+static uint8_t recover_step;
+
+/**
+ * @brief  Configure the I2C block.
+ * @note   Also used to bring it back after a bus recovery.
+ * @param  None
+ * @retval None
+ */
+static void storage_i2c_setup(void) {
+	I2C_InitTypeDef i2cInit;
+
+	I2C_DeInit(I2C1);
+
+	I2C_StructInit(&i2cInit);
+	i2cInit.I2C_ClockSpeed = 200000;
+	I2C_Init(I2C1, &i2cInit);
+	I2C_Cmd(I2C1, ENABLE);
+
+	// Enable the event interrupt. Data goes by DMA, so no TXE/RXNE interrupts.
+	I2C_ITConfig(I2C1, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
+
+	I2C_DMACmd(I2C1, ENABLE);
+
+	I2C_AcknowledgeConfig(I2C1, ENABLE);
+}
+
+/**
+ * @brief  Hand the I2C pins to the I2C block or take them as GPIO.
+ * @note
+ * @param  mode: GPIO_Mode_AF_OD or GPIO_Mode_Out_OD
+ * @retval None
+ */
+static void storage_i2c_pins(GPIOMode_TypeDef mode) {
+	GPIO_InitTypeDef gpioInit;
+
+	GPIO_StructInit(&gpioInit);
+	gpioInit.GPIO_Speed = GPIO_Speed_2MHz;
+	gpioInit.GPIO_Pin = I2C_PINS;
+	gpioInit.GPIO_Mode = mode;
+	GPIO_SetBits(GPIOB, I2C_PINS);
+	GPIO_Init(GPIOB, &gpioInit);
+}
+
+/**
+ * @brief  Initialise the I2C bus and EEPROM.
+ * @note
+ * @param  None
+ * @retval None
+ */
+void storage_init(void) {
+	NVIC_InitTypeDef nvicInit;
+	DMA_InitTypeDef dmaInit;
+	TIM_TimeBaseInitTypeDef timInit;
+
+	// Enable the I2C block clocks and setup the pins.
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1 | RCC_APB1Periph_TIM7, ENABLE);
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	storage_i2c_pins(GPIO_Mode_AF_OD);
+	storage_i2c_setup();
+
+	// Configure the Interrupt to the lowest priority
+	nvicInit.NVIC_IRQChannelPreemptionPriority = 0x05;
+	nvicInit.NVIC_IRQChannelSubPriority = 0x00;
+	nvicInit.NVIC_IRQChannelCmd = ENABLE;
+	nvicInit.NVIC_IRQChannel = I2C1_EV_IRQn;
+	NVIC_Init(&nvicInit);
+	nvicInit.NVIC_IRQChannel = I2C1_ER_IRQn;
+	NVIC_Init(&nvicInit);
+
+	// Enable the TX and RX DMA channel IRQs
+	nvicInit.NVIC_IRQChannel = DMA1_Channel6_IRQn;
+	NVIC_Init(&nvicInit);
+	nvicInit.NVIC_IRQChannel = DMA1_Channel7_IRQn;
+	NVIC_Init(&nvicInit);
+
+	// Same priority as the I2C so the two never interrupt each other.
+	nvicInit.NVIC_IRQChannel = TIM7_IRQn;
+	NVIC_Init(&nvicInit);
+
+	// DMA Configuration
+	DMA_DeInit(DMA1_Channel6);	// TX
+	DMA_DeInit(DMA1_Channel7);	// RX
+	DMA_ITConfig(DMA1_Channel6, DMA_IT_TC, ENABLE);
+	DMA_ITConfig(DMA1_Channel7, DMA_IT_TC, ENABLE);
+
+	DMA_StructInit(&dmaInit);
+	dmaInit.DMA_PeripheralBaseAddr = (uint32_t) &I2C1->DR;
+	dmaInit.DMA_DIR = DMA_DIR_PeripheralSRC;
+	dmaInit.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	dmaInit.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	dmaInit.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	dmaInit.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	dmaInit.DMA_Mode = DMA_Mode_Normal;
+	dmaInit.DMA_Priority = DMA_Priority_Medium;
+	dmaInit.DMA_M2M = DMA_M2M_Disable;
+	g_dmaInit = dmaInit;
+
+	// Transaction tick, 1MHz time base
+	TIM_DeInit(TIM7);
+	TIM_TimeBaseStructInit(&timInit);
+	timInit.TIM_Prescaler = 23;
+	timInit.TIM_Period = STORAGE_I2C_TICK_US - 1;
+	TIM_TimeBaseInit(TIM7, &timInit);
+	TIM_ClearITPendingBit(TIM7, TIM_IT_Update);
+	TIM_ITConfig(TIM7, TIM_IT_Update, ENABLE);
+
+	state = STATE_IDLE;
+}
+
+/**
+ * @brief  Run a transaction and wait for it.
+ * @note   Called from the main loop only.
+ * @param  t: Transaction
+ * @retval true if it completed
+ */
+static bool storage_run(Transaction *t) {
+	// A bus recovery after a failed transaction may still be going.
+	while (state != STATE_IDLE)
+		;
+
+	t->done = 0;
+	t->status = TX_RUNNING;
+	polling = false;
+	recovered = false;
+	ticks = 0;
+	current = t;
+	state = STATE_WAIT;
+
+	// The tick starts it
+	TIM_Cmd(TIM7, ENABLE);
+	NVIC_SetPendingIRQ(TIM7_IRQn);
+
+	while (t->status == TX_RUNNING)
+		;
+	return t->status == TX_DONE;
+}
+
+/**
+ * @brief  Read a block of data from EEPROM.
+ * @note
+ * @param  offset: EEPROM start byte address
+ * @param  length: number of bytes
+ * @param  buffer: Destination buffer pointer
+ * @retval None
+ */
+void storage_read(uint16_t offset, uint16_t length, void *buffer) {
+	Transaction t;
+
+	if (length == 0)
+		return;
+	t.offset = offset;
+	t.length = length;
+	t.buffer = buffer;
+	t.read = 1;
+	storage_run(&t);
+}
+
+/**
+ * @brief  Write a block of data to EEPROM.
+ * @note   Split into page writes by the IRQ handlers.
+ * @param  offset: EEPROM start byte address
+ * @param  length: number of bytes
+ * @param  buffer: Source buffer pointer
+ * @retval false if the EEPROM did not respond
+ */
+bool storage_write(uint16_t offset, uint16_t length, const void *buffer) {
+	Transaction t;
+
+	if (length == 0)
+		return true;
+	t.offset = offset;
+	t.length = length;
+	t.buffer = (uint8_t*) buffer;
+	t.read = 0;
+	return storage_run(&t);
+}
+
+/**
+ * @brief  Finish the current transaction.
+ * @note   IRQ context.
+ * @param  status: TX_DONE or TX_ERROR
+ * @retval None
+ */
+static void storage_i2c_finish(TX_STATUS status) {
+	if (status == TX_DONE)
+		watchdog_heartbeat(WATCHDOG_MAIN);
+	current->status = status;
+	current = 0;
+	state = STATE_IDLE;
+}
+
+/**
+ * @brief  Stop whatever the bus is doing and try the page again next tick.
+ * @note   IRQ context. Used after a NACK or bus error.
+ * @param  None
+ * @retval None
+ */
+static void storage_i2c_retry(void) {
+	DMA_Cmd(DMA1_Channel6, DISABLE);
+	DMA_Cmd(DMA1_Channel7, DISABLE);
+	I2C_GenerateSTOP(I2C1, ENABLE);
+	state = STATE_WAIT;
+}
+
+/**
+ * @brief  Start the next step of the current transaction.
+ * @note   IRQ context, the bus must be idle.
+ * @param  None
+ * @retval None
+ */
+static void storage_i2c_start(void) {
+	state = polling ? STATE_POLLING : STATE_START;
+	I2C_GenerateSTART(I2C1, ENABLE);
+}
+
+/**
+ * @brief  One half clock of bus recovery.
+ * @note   IRQ context. SCL is pulsed until the EEPROM lets go of SDA,
+ *         then a STOP is sent and the pins go back to the I2C block.
+ * @param  None
+ * @retval None
+ */
+static void storage_i2c_recover(void) {
+	uint8_t step = recover_step++;
+
+	if (step == 0) {
+		// Take the pins, both released (high)
+		I2C_Cmd(I2C1, DISABLE);
+		storage_i2c_pins(GPIO_Mode_Out_OD);
+	} else if (step <= 2 * STORAGE_I2C_RECOVER_CLOCKS) {
+		if (step & 1) {
+			GPIO_ResetBits(GPIOB, I2C_SCL);
+		} else {
+			GPIO_SetBits(GPIOB, I2C_SCL);
+			// Skip the rest of the clocks once SDA is free.
+			if (GPIO_ReadInputDataBit(GPIOB, I2C_SDA))
+				recover_step = 2 * STORAGE_I2C_RECOVER_CLOCKS + 1;
+		}
+	} else if (step == 2 * STORAGE_I2C_RECOVER_CLOCKS + 1) {
+		// STOP: SDA rises while SCL is high
+		GPIO_ResetBits(GPIOB, I2C_SCL);
+		GPIO_ResetBits(GPIOB, I2C_SDA);
+	} else if (step == 2 * STORAGE_I2C_RECOVER_CLOCKS + 2) {
+		GPIO_SetBits(GPIOB, I2C_SCL);
+	} else {
+		GPIO_SetBits(GPIOB, I2C_SDA);
+		storage_i2c_pins(GPIO_Mode_AF_OD);
+		storage_i2c_setup();
+		state = current ? STATE_WAIT : STATE_IDLE;
+	}
+}
+
+/**
+ * @brief  Transaction tick
+ * @note   Starts pages, paces ACK polling and times out transactions
+ *         that are stuck.
+ * @param  None
+ * @retval None
+ */
+void TIM7_IRQHandler(void) {
+	TIM_ClearITPendingBit(TIM7, TIM_IT_Update);
+
+	if (state == STATE_RECOVER) {
+		storage_i2c_recover();
+		return;
+	}
+
+	if (current == 0) {
+		state = STATE_IDLE;
+		TIM_Cmd(TIM7, DISABLE);
+		return;
+	}
+
+	if (++ticks > STORAGE_I2C_TIMEOUT) {
+		// No progress. Free the bus and try once more before giving up.
+		DMA_Cmd(DMA1_Channel6, DISABLE);
+		DMA_Cmd(DMA1_Channel7, DISABLE);
+		if (recovered)
+			storage_i2c_finish(TX_ERROR);
+		recovered = true;
+		ticks = 0;
+		recover_step = 0;
+		state = STATE_RECOVER;
+		return;
+	}
+
+	if (state == STATE_WAIT && !I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY))
+		storage_i2c_start();
+}
+
+/**
+ * @brief  I2C Error Handler
+ * @note   A NACK while polling means the write cycle is still going,
+ *         anything else is retried from the start of the page.
+ * @param  None
+ * @retval None
+ */
+void I2C1_ER_IRQHandler(void) {
+	uint32_t event = I2C_GetLastEvent(I2C1);
+
+	I2C_ClearFlag(I2C1, I2C_FLAG_AF | I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR | I2C_FLAG_TIMEOUT);
+
+	if (state == STATE_IDLE || state == STATE_WAIT || state == STATE_RECOVER)
+		return;
+	if (event & (I2C_FLAG_AF | I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR | I2C_FLAG_TIMEOUT))
+		storage_i2c_retry();
+}
+
+/**
+ * @brief  I2C Event Handler
+ * @note	This drives the EEPROM access logic and starts the DMA.
+ * @param  None
+ * @retval None
+ */
+void I2C1_EV_IRQHandler(void) {
+	uint32_t event = I2C_GetLastEvent(I2C1);
+	uint16_t addr;
+#define ISEV(EV) ((event & EV)==EV)
+
+	if (current == 0)
+		return;
+	addr = current->offset + current->done;
+
+	switch (state) {
+	case STATE_START:
+		if (ISEV(I2C_EVENT_MASTER_MODE_SELECT)) {
+			state = STATE_ADDRESSED1;
+			I2C_Send7bitAddress(I2C1, EEPROM_ADDR, I2C_Direction_Transmitter);
+		}
+		break;
+
+	case STATE_ADDRESSED1:
+		if (ISEV(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED)) {
+			state = STATE_ADDRESSED2;
+			I2C_SendData(I2C1, (addr >> 8) & 0xFF);
+		}
+		break;
+
+	case STATE_ADDRESSED2:
+		if (ISEV(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {
+			I2C_SendData(I2C1, addr & 0xFF);
+			state = current->read ? STATE_RESTART : STATE_TRANSFER_START;
+		}
+		break;
+
+	case STATE_RESTART:
+		if (ISEV(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {
+			I2C_GenerateSTART(I2C1, ENABLE);
+		} else if (ISEV(I2C_EVENT_MASTER_MODE_SELECT)) {
+			state = STATE_TRANSFER_START;
+			I2C_Send7bitAddress(I2C1, EEPROM_ADDR, I2C_Direction_Receiver);
+		}
+		break;
+
+	case STATE_TRANSFER_START:
+		if ((event & I2C_FLAG_ADDR) || // already master, only ADDR now hence this does not work: ISEV(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED) ||
+			ISEV(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {
+			DMA_Channel_TypeDef *channel;
+			uint16_t length = current->length;
+
+			if (!current->read) {
+				// A write must not cross a page boundary.
+				length = EEPROM_PAGE_SIZE - (addr % EEPROM_PAGE_SIZE);
+				if (current->length - current->done < length)
+					length = current->length - current->done;
+				current->page = length;
+			}
+
+			state = STATE_TRANSFERRING;
+			g_dmaInit.DMA_MemoryBaseAddr = (uint32_t) current->buffer + current->done;
+			g_dmaInit.DMA_BufferSize = length;
+			g_dmaInit.DMA_DIR = current->read ? DMA_DIR_PeripheralSRC : DMA_DIR_PeripheralDST;
+			channel = current->read ? DMA1_Channel7 : DMA1_Channel6;
+			DMA_Cmd(channel, DISABLE);
+			DMA_ClearFlag(DMA1_FLAG_TC7);
+			DMA_ClearFlag(DMA1_FLAG_TC6);
+			DMA_Init(channel, (DMA_InitTypeDef*)&g_dmaInit);
+			I2C_DMALastTransferCmd(I2C1, ENABLE);
+			DMA_Cmd(channel, ENABLE);
+		}
+		break;
+
+	case STATE_TRANSFERRING:
+		// write finished, the EEPROM now starts its write cycle
+		if (!current->read && ISEV(I2C_EVENT_MASTER_BYTE_TRANSMITTED) &&
+				DMA_GetCurrDataCounter(DMA1_Channel6) == 0) {
+			I2C_GenerateSTOP(I2C1, ENABLE);
+			polling = true;
+			state = STATE_WAIT;
+		}
+		break;
+
+	case STATE_POLLING:
+		// addressing the eeprom successfully marks the end of write
+		if (ISEV(I2C_EVENT_MASTER_MODE_SELECT)) {
+			I2C_Send7bitAddress(I2C1, EEPROM_ADDR, I2C_Direction_Transmitter);
+		} else if (ISEV(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED)) {
+			I2C_GenerateSTOP(I2C1, ENABLE);
+			polling = false;
+			ticks = 0;
+			// A long write is progress, not a stalled main loop.
+			watchdog_heartbeat(WATCHDOG_MAIN);
+			current->done += current->page;
+			if (current->done == current->length)
+				storage_i2c_finish(TX_DONE);
+			else
+				state = STATE_WAIT;
+		}
+		break;
+
+	case STATE_IDLE:
+	case STATE_WAIT:
+	case STATE_RECOVER:
+		break;
+	}
+}
+
+/**
+ * @brief  I2C DMA TX Complete Handler
+ * @note
+ * @param  None
+ * @retval None
+ */
+void DMA1_Channel6_IRQHandler(void) {
+	DMA_Cmd(DMA1_Channel6, DISABLE);
+	DMA_ClearFlag(DMA1_FLAG_TC6);
+	DMA_ClearITPendingBit(DMA_IT_TC);
+	// dma finished transferring to the I2C but the I2C did not finished yet
+}
+
+/**
+ * @brief  I2C DMA RX Complete Handler
+ * @note
+ * @param  None
+ * @retval None
+ */
+void DMA1_Channel7_IRQHandler(void) {
+	DMA_Cmd(DMA1_Channel7, DISABLE);
+	DMA_ClearFlag(DMA1_FLAG_TC7);
+	DMA_ClearITPendingBit(DMA_IT_TC);
+	I2C_GenerateSTOP(I2C1, ENABLE);
+	if (current != 0 && current->read && state == STATE_TRANSFERRING) {
+		current->done = current->length;
+		storage_i2c_finish(TX_DONE);
+	}
+}
+
+#endif // STORAGE_BACKEND == STORAGE_I2C
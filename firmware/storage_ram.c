@@ -0,0 +1,75 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Storage backend in RAM. Nothing survives a reset, and STORAGE_SIZE
+ * does not fit next to the rest of the firmware in the radio's RAM, so
+ * this is for host and bench builds that have no EEPROM.
+ *
+ */
+
+#include "storage.h"
+
+#if STORAGE_BACKEND == STORAGE_RAM
+
+#include <string.h>
+
+// locals
+
+static uint8_t storage[STORAGE_SIZE];
+
+/**
+  * @brief  Start with blank storage.
+  * @note
+  * @param  None
+  * @retval None
+  */
+void storage_init(void)
+{
+	memset(storage, 0xFF, sizeof(storage));
+}
+
+/**
+  * @brief  Read a block of data.
+  * @note
+  * @param  offset: Start byte address
+  * @param  length: Number of bytes
+  * @param  buffer: Destination buffer pointer
+  * @retval None
+  */
+void storage_read(uint16_t offset, uint16_t length, void *buffer)
+{
+	if (offset + length > STORAGE_SIZE)
+		length = offset < STORAGE_SIZE ? STORAGE_SIZE - offset : 0;
+	memcpy(buffer, &storage[offset], length);
+}
+
+/**
+  * @brief  Write a block of data.
+  * @note
+  * @param  offset: Start byte address
+  * @param  length: Number of bytes
+  * @param  buffer: Source buffer pointer
+  * @retval false if the range is outside the storage
+  */
+bool storage_write(uint16_t offset, uint16_t length, const void *buffer)
+{
+	if (offset + length > STORAGE_SIZE)
+		return false;
+	memcpy(&storage[offset], buffer, length);
+	return true;
+}
+
+#endif // STORAGE_BACKEND == STORAGE_RAM
@@ -13,214 +13,33 @@
  * Author: Richard Taylor (richard@artaylor.co.uk)
  */
 
+/* Description:
+ *
+ * The GUI strings live in strings.txt and are made into one flash pool
+ * (strings_pool.c) by tools/strpool. Each string is found by table and
+ * index through 16 bit offsets, so no pointer tables are needed in RAM.
+ *
+ */
+
 #include "stm32f10x.h"
 #include "strings.h"
 
-const char *switches[NUM_SWITCHES+1] = {
-		"---",
-		"SWA",
-		"SWB",
-		"SWC",
-		"SWD",
-};
-
-const char *sticks[NUM_STICKS] = {
-		"AIL",
-		"ELE",
-		"THR",
-		"RUD",
-};
-
-const char *pots[NUM_POTS] = {
-		"VRA",
-		"VRB",
-};
-
-const char *sources[SRC_MAX] = {
-		"HALF",
-		"FULL",
-		"CYC",	// CYC1-CYC3
-		"PPM",	// PPM1-PPM8
-		"CH",	// CH1-CH16
-		"ch"	// Trainer SRC
-};
-
-const char * mix_warm[MIX_WARN_MAX] = {
-		"off"
-		"W1",
-		"W2",
-		"W3",
-};
-
-const char * mix_src[MIX_SRC_MAX] = {
-		"off",
-		"AIL",
-		"ELE",
-		"THR",
-		"RUD",
-		"VRA",
-		"VRB",
-		"???",
-		"???",
-		"MAX", // 9
-		"FULL", // 10
-		"CYC1", // 11
-		"CYC2", // 12
-		"CYC3",	// 13
-		"PPM1",
-		"PPM2",
-		"PPM3",
-		"PPM4",
-		"PPM5",
-		"PPM6",
-		"PPM7",
-		"PPM8",
-		"CH1", // CHAN_BASE
-		"CH2",
-		"CH3",
-		"CH4",
-		"CH5",
-		"CH6",
-		"CH7",
-		"CH8",
-		// CHOUT_BASE
-};
-
-const char *mix_mode_hdr = "mode";
-const char *mix_mode[MIX_MODE_MAX] = {
-		"off",
-		"+=",
-		"*=",
-		":=",
-};
-
-const char *menu_on_off[4] = {
-		"OFF",
-		"ON",
-		"off",
-		"on"
-};
-
-const char *channel_order[CHAN_ORDER_MAX] = {
-		"ATER",
-		"AETR",
-		"RTEA",
-		"RETA",
-};
-
-const char *system_menu_beeper[BEEPER_MAX] = {
-		"Silent",
-		"NoKey",
-		"Normal",
-};
-
-const char *msg[GUI_MSG_MAX] = {
-		"",
-		"Press [OK] to start Calibration.",
-		"Move all controls to their extents then press [OK].",
-		"Centre the sticks then press [OK].",
-		"OK",
-		"Operation Cancelled.",
-		"OK:Save Cancel:Abort",
-		"Please zero throttle to continue.",
-		"Calibration data invalid, please calibrate the sticks.",
-		"OK to preset the model?",
-		"Preset\nInsert\nDelete\nCopy\nPaste\n",
-
-		// Headings (System)
-		"RADIO SETUP",
-		"TRAINER",
-		"VERSION",
-		"DIAGNOSTICS",
-		"ANALOG",
-		"CALIBRATION",
-
-		// Headings (Model)
-		"MODELSEL",
-		"SETUP ",
-		"HELI SETUP",
-		"EXPO/DR",
-		"MIXER",
-		"LIMITS",
-		"CURVES",
-		"CUSTOM SWITCHES",
-		"SAFETY SWITCHES",
-		"TEMPLATES",
-		"EDIT MIX",
-		"CURVE nn",
-};
-
-const char *system_menu_list1[SYS_MENU_LIST1_LEN] = {
-		"Owner Name",
-		"Beeper",
-		"Volume",
-		"Contrast",
-		"Battery Warning",
-		"Inactivity Alarm",
-		"Throttle Reverse",
-		"Minute beep",
-		"Beep countdown",
-		"Flash on beep",
-		"Light switch",
-		"Backlight invert",
-		"Light off after",
-		"Light on Stk Mv",
-		"Splash Screen",
-		"Throttle Warning",
-		"Switch Warning",
-		"Default Sw",
-		"Memory Warning",
-		"Alarm Warning",
-		"Enable PPMSIM",
-		"Mode",
-};
-
-const char *model_menu_list1[MOD_MENU_LIST1_LEN] = {
-		"Model Name",
-		"Timer Mode",
-		"Timer Dir",
-		"Timer Value",
-		"Trainer Ok",
-		"Thro Trim",
-		"Thro Expo",
-		"Thrim Incr"
-		"Ext Limits"
-};
-
-const char *mixer_edit_list1[MIXER_EDIT_LIST1_LEN] = {
-		"Source",
-		"Weight",
-		"Offset",
-		"Trim ON",
-		"Curve",
-		"Switch",
-		"Phase",
-		"Warning",
-		"Multpx",
-		"Delay Up",
-		"Delay Dn",
-		"Slow Up",
-		"Slow Dn"
-
-};
-
-
-const char* timer_modes[] = {
-		"Off",
-		"Abs",
-		"Stk",
-		"Stk%",
-		"Sw/!Sw",
-		"!m_sw/!m_sw"
-};
-
-const char* dir_labels[] = {
-		"Down",
-		"Up",
-};
-
-
-const char* inverse_labels[] = {
-		"---",
-		"INV"
-};
+/**
+  * @brief  Look up a GUI string.
+  * @param  table: STR_TABLE
+  * @param  index: String within the table.
+  * @retval The string, "???" if out of range.
+  */
+const char *str_get(STR_TABLE table, uint8_t index)
+{
+	uint16_t i;
+
+	if (table >= STR_TABLE_MAX)
+		return "???";
+
+	i = str_table[table] + index;
+	if (i >= str_table[table + 1])
+		return "???";
+
+	return &str_pool[str_index[i]];
+}
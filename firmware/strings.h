@@ -13,15 +13,17 @@
  * Author: Richard Taylor (richard@artaylor.co.uk)
  */
 
-#ifndef _STRINGS_H
-#define _STRINGS_H
+#ifndef _ART6_STRINGS_H
+#define _ART6_STRINGS_H
+
+#include <stdint.h>
 
 #define NUM_STICKS		4
 #define NUM_POTS		2
 #define NUM_SWITCHES	4
 
-#define SYS_MENU_LIST1_LEN	22
-#define MOD_MENU_LIST1_LEN	9
+#define SYS_MENU_LIST1_LEN	25
+#define MOD_MENU_LIST1_LEN	10
 #define MIXER_EDIT_LIST1_LEN 13
 #define MIX_SRC_MAX 29
 #define MIX_WARN_MAX 4
@@ -31,6 +33,8 @@ typedef enum {
 	GUI_MSG_CAL_OK_START,
 	GUI_MSG_CAL_MOVE_EXTENTS,
 	GUI_MSG_CAL_CENTRE,
+	GUI_MSG_CAL_LINEAR,
+	GUI_MSG_CAL_STEADY,
 	GUI_MSG_OK,
 	GUI_MSG_CANCELLED,
 	GUI_MSG_OK_CANCEL,
@@ -38,14 +42,22 @@ typedef enum {
 	GUI_MSG_EEPROM_INVALID,
 	GUI_MSG_OK_TO_RESET_MODEL,
 	GUI_MSG_ROW_MENU,
+	GUI_MSG_EEPROM_FULL,
+	GUI_MSG_SET_SWITCHES,
+	GUI_MSG_FAULT_RESET,
+	GUI_MSG_NO_FAULT,
+	GUI_MSG_EEPROM_WRITE,
 
 	// Headings (System Menu)
 	GUI_HDG_RADIO_SETUP,
 	GUI_HDG_TRAINER,
 	GUI_HDG_VERSION,
 	GUI_HDG_DIAG,
+	GUI_HDG_FAULT,
+	GUI_HDG_MEMORY,
 	GUI_HDG_ANALOG,
 	GUI_HDG_CALIBRATION,
+	GUI_HDG_MONITOR,
 
 	// Headings (Model Menu)
 	GUI_HDG_MODELSEL,
@@ -58,6 +70,7 @@ typedef enum {
 	GUI_HDG_CUST_SW,
 	GUI_HDG_SAFE_SW,
 	GUI_HDG_TEMPLATES,
+	GUI_HDG_FAILSAFE,
 	GUI_HDG_EDIT_MIX,
 	GUI_HDG_CURVE_EDIT,
 
@@ -70,8 +83,11 @@ enum _menu_page {
 	SYS_PAGE_TRAINER,
 	SYS_PAGE_VERSION,
 	SYS_PAGE_DIAG,
+	SYS_PAGE_FAULT,
+	SYS_PAGE_MEMORY,
 	SYS_PAGE_ANA,
 	SYS_PAGE_CAL,
+	SYS_PAGE_MONITOR,
 };
 
 enum _model_page {
@@ -85,6 +101,7 @@ enum _model_page {
 	MOD_PAGE_CUST_SW,
 	MOD_PAGE_SAFE_SW,
 	MOD_PAGE_TEMPLATES,
+	MOD_PAGE_FAILSAFE,
 	MOD_PAGE_MIX_EDIT,
 	MOD_PAGE_CURVE_EDIT,
 };
@@ -114,23 +131,40 @@ enum _menu_beeper {
 	BEEPER_SILENT = 0, BEEPER_NOKEY, BEEPER_NORMAL, BEEPER_MAX
 };
 
-extern const char *switches[NUM_SWITCHES + 1];
-extern const char *sticks[NUM_STICKS];
-extern const char *pots[NUM_POTS];
-extern const char *sources[SRC_MAX];
-extern const char *mix_mode_hdr;
-extern const char *mix_mode[MIX_MODE_MAX];
-extern const char *mix_src[MIX_SRC_MAX];
-extern const char *mix_warn[MIX_WARN_MAX];
-extern const char *menu_on_off[4];
-extern const char *channel_order[CHAN_ORDER_MAX];
-extern const char *system_menu_beeper[BEEPER_MAX];
-extern const char *msg[GUI_MSG_MAX];
-extern const char *system_menu_list1[SYS_MENU_LIST1_LEN];
-extern const char *model_menu_list1[MOD_MENU_LIST1_LEN];
-extern const char *mixer_edit_list1[MIXER_EDIT_LIST1_LEN];
-extern const char *timer_modes[];
-extern const char *dir_labels[];
-extern const char *inverse_labels[];
-
-#endif // _STRINGS_H
+enum _trim_inc {
+	TRIM_INC_EXP = 0, TRIM_INC_FINE, TRIM_INC_MEDIUM, TRIM_INC_COARSE, TRIM_INC_MAX
+};
+
+// String tables, in strings.txt order.
+typedef enum {
+	STR_SWITCHES = 0,
+	STR_STICKS,
+	STR_POTS,
+	STR_SOURCES,
+	STR_MIX_WARN,
+	STR_MIX_SRC,
+	STR_MIX_MODE_HDR,
+	STR_MIX_MODE,
+	STR_ON_OFF,
+	STR_CHAN_ORDER,
+	STR_BEEPER,
+	STR_TRIM_INC,
+	STR_MSG,
+	STR_SYS_MENU_LIST1,
+	STR_MOD_MENU_LIST1,
+	STR_MIXER_EDIT_LIST1,
+	STR_TIMER_MODES,
+	STR_DIR,
+	STR_INVERSE,
+	STR_FAILSAFE_MODES,
+	STR_TABLE_MAX
+} STR_TABLE;
+
+// Made by tools/strpool, see strings_pool.c.
+extern const char str_pool[];
+extern const uint16_t str_index[];
+extern const uint16_t str_table[STR_TABLE_MAX + 1];
+
+const char *str_get(STR_TABLE table, uint8_t index);
+
+#endif // _ART6_STRINGS_H
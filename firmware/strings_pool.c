@@ -0,0 +1,259 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * GUI string pool, see strings.h.
+ * Made by tools/strpool from strings.txt, do not edit.
+ *
+ */
+
+#include <stdint.h>
+
+#include "strings.h"
+#include "failsafe.h"
+
+// 171 strings, 152 stored, 1634 bytes.
+const char str_pool[1634] =
+	"Hold sticks at half travel, press [OK]. [SEL] when done.\0"
+	"Calibration data invalid, please calibrate the sticks.\0"
+	"Move all controls to their extents then press [OK].\0"
+	"Reset after a fault. Details on the FAULT page.\0"
+	"Storage write failed, changes not saved.\0"
+	"Hold the sticks steady then press [OK].\0"
+	"Set the switches as shown to continue.\0"
+	"Model memory full, model not saved.\0"
+	"Centre the sticks then press [OK].\0"
+	"Please zero throttle to continue.\0"
+	"Press [OK] to start Calibration.\0"
+	"Preset\nInsert\nDelete\nCopy\nPaste\n\0"
+	"OK to preset the model?\0"
+	"Operation Cancelled.\0"
+	"OK:Save Cancel:Abort\0"
+	"No fault recorded.\0"
+	"Inactivity Alarm\0"
+	"Throttle Reverse\0"
+	"Backlight invert\0"
+	"Throttle Warning\0"
+	"CUSTOM SWITCHES\0"
+	"SAFETY SWITCHES\0"
+	"Battery Warning\0"
+	"Light off after\0"
+	"Light on Stk Mv\0"
+	"Flight recorder\0"
+	"Beep countdown\0"
+	"Switch Warning\0"
+	"Memory Warning\0"
+	"Save recording\0"
+	"Stick Deadband\0"
+	"Flash on beep\0"
+	"Splash Screen\0"
+	"Alarm Warning\0"
+	"Enable PPMSIM\0"
+	"Light switch\0"
+	"Trims>Offset\0"
+	"RADIO SETUP\0"
+	"DIAGNOSTICS\0"
+	"CALIBRATION\0"
+	"Minute beep\0"
+	"Timer Value\0"
+	"!m_sw/!m_sw\0"
+	"HELI SETUP\0"
+	"Owner Name\0"
+	"Default Sw\0"
+	"Model Name\0"
+	"Timer Mode\0"
+	"Trainer Ok\0"
+	"Ext Limits\0"
+	"TEMPLATES\0"
+	"Timer Dir\0"
+	"Thro Trim\0"
+	"Thro Expo\0"
+	"Trim Step\0"
+	"MODELSEL\0"
+	"FAILSAFE\0"
+	"EDIT MIX\0"
+	"CURVE nn\0"
+	"Contrast\0"
+	"Delay Up\0"
+	"Delay Dn\0"
+	"TRAINER\0"
+	"VERSION\0"
+	"MONITOR\0"
+	"EXPO/DR\0"
+	"Trim ON\0"
+	"Slow Up\0"
+	"Slow Dn\0"
+	"Silent\0"
+	"Normal\0"
+	"Medium\0"
+	"Coarse\0"
+	"MEMORY\0"
+	"ANALOG\0"
+	"SETUP \0"
+	"LIMITS\0"
+	"CURVES\0"
+	"Beeper\0"
+	"Volume\0"
+	"Source\0"
+	"Weight\0"
+	"Switch\0"
+	"Multpx\0"
+	"Sw/!Sw\0"
+	"Preset\0"
+	"NoKey\0"
+	"FAULT\0"
+	"MIXER\0"
+	"Curve\0"
+	"Phase\0"
+	"HALF\0"
+	"FULL\0"
+	"CYC1\0"
+	"CYC2\0"
+	"CYC3\0"
+	"PPM1\0"
+	"PPM2\0"
+	"PPM3\0"
+	"PPM4\0"
+	"PPM5\0"
+	"PPM6\0"
+	"PPM7\0"
+	"PPM8\0"
+	"mode\0"
+	"ATER\0"
+	"AETR\0"
+	"RTEA\0"
+	"RETA\0"
+	"Fine\0"
+	"Stk%\0"
+	"Down\0"
+	"Hold\0"
+	"Ramp\0"
+	"---\0"
+	"SWA\0"
+	"SWB\0"
+	"SWC\0"
+	"SWD\0"
+	"AIL\0"
+	"ELE\0"
+	"THR\0"
+	"RUD\0"
+	"VRA\0"
+	"VRB\0"
+	"CYC\0"
+	"PPM\0"
+	"off\0"
+	"???\0"
+	"MAX\0"
+	"CH1\0"
+	"CH2\0"
+	"CH3\0"
+	"CH4\0"
+	"CH5\0"
+	"CH6\0"
+	"CH7\0"
+	"OFF\0"
+	"Exp\0"
+	"Off\0"
+	"Abs\0"
+	"Stk\0"
+	"INV\0"
+	"CH\0"
+	"W1\0"
+	"W2\0"
+	"W3\0"
+	"+=\0"
+	"*=\0"
+	":=\0"
+	"on\0"
+	"OK";
+
+const uint16_t str_index[171] = {
+	// STR_SWITCHES
+	1491, 1495, 1499, 1503, 1507,
+	// STR_STICKS
+	1511, 1515, 1519, 1523,
+	// STR_POTS
+	1527, 1531,
+	// STR_SOURCES
+	1376, 1381, 1535, 1539, 1607, 893,
+	// STR_MIX_WARN
+	1543, 1610, 1613, 1616,
+	// STR_MIX_SRC
+	1543, 1511, 1515, 1519, 1523, 1527, 1531, 1547, 1547, 1551, 1381, 1386,
+	1391, 1396, 1401, 1406, 1411, 1416, 1421, 1426, 1431, 1436, 1555, 1559,
+	1563, 1567, 1571, 1575, 1579,
+	// STR_MIX_MODE_HDR
+	1441,
+	// STR_MIX_MODE
+	1543, 1619, 1622, 1625,
+	// STR_ON_OFF
+	1583, 942, 1543, 1628,
+	// STR_CHAN_ORDER
+	1446, 1451, 1456, 1461,
+	// STR_BEEPER
+	1227, 1346, 1234,
+	// STR_TRIM_INC
+	1587, 1466, 1241, 1248,
+	// STR_MSG
+	56, 437, 112, 368, 0, 253, 1631, 527, 548, 403, 57, 503,
+	470, 332, 293, 164, 569, 212, 909, 1171, 1179, 921, 1352, 1255,
+	1262, 933, 1187, 1108, 1269, 981, 1195, 1358, 1276, 1283, 656, 672,
+	1058, 1117, 1126, 1135,
+	// STR_SYS_MENU_LIST1
+	992, 1290, 1297, 1144, 688, 588, 605, 945, 752, 827, 883, 622,
+	704, 720, 841, 639, 767, 1003, 782, 855, 869, 1031, 736, 797,
+	812,
+	// STR_MOD_MENU_LIST1
+	1014, 1025, 1068, 957, 1036, 1078, 1088, 1098, 1047, 896,
+	// STR_MIXER_EDIT_LIST1
+	1304, 1311, 902, 1203, 1364, 1318, 1370, 648, 1325, 1153, 1162, 1211,
+	1219,
+	// STR_TIMER_MODES
+	1591, 1595, 1599, 1471, 1332, 969,
+	// STR_DIR
+	1476, 1159,
+	// STR_INVERSE
+	1491, 1603,
+	// STR_FAILSAFE_MODES
+	1481, 1339, 1486,
+};
+
+const uint16_t str_table[STR_TABLE_MAX + 1] = {
+	0, 5, 9, 11, 17, 21, 50, 51, 55, 59, 63, 66,
+	70, 110, 135, 145, 158, 164, 166, 168,
+	171
+};
+
+typedef char str_tables_match[(STR_TABLE_MAX == 20) ? 1 : -1];
+typedef char str_SWITCHES_length[(STR_SWITCHES == 0 && 5 == (NUM_SWITCHES + 1)) ? 1 : -1];
+typedef char str_STICKS_length[(STR_STICKS == 1 && 4 == (NUM_STICKS)) ? 1 : -1];
+typedef char str_POTS_length[(STR_POTS == 2 && 2 == (NUM_POTS)) ? 1 : -1];
+typedef char str_SOURCES_length[(STR_SOURCES == 3 && 6 == (SRC_MAX)) ? 1 : -1];
+typedef char str_MIX_WARN_length[(STR_MIX_WARN == 4 && 4 == (MIX_WARN_MAX)) ? 1 : -1];
+typedef char str_MIX_SRC_length[(STR_MIX_SRC == 5 && 29 == (MIX_SRC_MAX)) ? 1 : -1];
+typedef char str_MIX_MODE_HDR_length[(STR_MIX_MODE_HDR == 6 && 1 == (1)) ? 1 : -1];
+typedef char str_MIX_MODE_length[(STR_MIX_MODE == 7 && 4 == (MIX_MODE_MAX)) ? 1 : -1];
+typedef char str_ON_OFF_length[(STR_ON_OFF == 8 && 4 == (4)) ? 1 : -1];
+typedef char str_CHAN_ORDER_length[(STR_CHAN_ORDER == 9 && 4 == (CHAN_ORDER_MAX)) ? 1 : -1];
+typedef char str_BEEPER_length[(STR_BEEPER == 10 && 3 == (BEEPER_MAX)) ? 1 : -1];
+typedef char str_TRIM_INC_length[(STR_TRIM_INC == 11 && 4 == (TRIM_INC_MAX)) ? 1 : -1];
+typedef char str_MSG_length[(STR_MSG == 12 && 40 == (GUI_MSG_MAX)) ? 1 : -1];
+typedef char str_SYS_MENU_LIST1_length[(STR_SYS_MENU_LIST1 == 13 && 25 == (SYS_MENU_LIST1_LEN)) ? 1 : -1];
+typedef char str_MOD_MENU_LIST1_length[(STR_MOD_MENU_LIST1 == 14 && 10 == (MOD_MENU_LIST1_LEN)) ? 1 : -1];
+typedef char str_MIXER_EDIT_LIST1_length[(STR_MIXER_EDIT_LIST1 == 15 && 13 == (MIXER_EDIT_LIST1_LEN)) ? 1 : -1];
+typedef char str_TIMER_MODES_length[(STR_TIMER_MODES == 16 && 6 == (6)) ? 1 : -1];
+typedef char str_DIR_length[(STR_DIR == 17 && 2 == (2)) ? 1 : -1];
+typedef char str_INVERSE_length[(STR_INVERSE == 18 && 2 == (2)) ? 1 : -1];
+typedef char str_FAILSAFE_MODES_length[(STR_FAILSAFE_MODES == 19 && 3 == (FAILSAFE_MODE_MAX)) ? 1 : -1];
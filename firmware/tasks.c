@@ -107,6 +107,17 @@ void task_process_all(void)
 	}
 }
 
+/**
+  * @brief  Get the task being run.
+  * @note	For the fault record.
+  * @param  None
+  * @retval The task, or TASK_END between tasks.
+  */
+Tasks task_current(void)
+{
+	return task;
+}
+
 /**
   * @brief  Delay timer using the system tick timer
   * @param  delay: delay in ms.
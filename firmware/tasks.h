@@ -28,6 +28,9 @@ typedef enum
 	TASK_PROCESS_STICKS,
 	TASK_PROCESS_GUI,
 	TASK_PROCESS_EEPROM,
+	TASK_PROCESS_RECORDER,
+	TASK_PROCESS_SERIAL,
+	TASK_PROCESS_STARTUP,
 	TASK_END
 } Tasks;
 
@@ -36,6 +39,7 @@ void task_register(Tasks task, void (*fn)(uint32_t));
 void task_schedule(Tasks task, uint32_t data, uint32_t time_ms);
 void task_deschedule(Tasks task);
 void task_process_all(void);
+Tasks task_current(void);
 
 // Utility functions (implemented in main.c)
 void delay_ms(uint32_t delay);
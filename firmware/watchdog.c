@@ -0,0 +1,226 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Lockup supervision.
+ * The mixer ISR, the PPM timer ISR and the main loop each set a heartbeat
+ * byte. The SysTick handler checks them every WATCHDOG_PERIOD and only
+ * feeds the independent watchdog when every expected source has beaten.
+ * If one stays silent for WATCHDOG_MISSES checks, the fault handler
+ * records which one (and the task that was running) and resets.
+ * If the supervisor itself stops, the IWDG resets the radio and
+ * crash_init() records that instead.
+ *
+ * While everything is alive the channel outputs are copied to RAM that
+ * survives the reset. After a watchdog or fault reset mixer_init()
+ * starts from them and the startup checks are skipped, so the model
+ * gets its last good positions as soon as PPM restarts.
+ *
+ */
+
+#include <stm32f10x.h>
+#include <stm32f10x_rcc.h>
+#include <stm32f10x_iwdg.h>
+#include <stm32f10x_dbgmcu.h>
+
+#include "art6.h"
+#include "crash.h"
+#include "watchdog.h"
+
+#define WATCHDOG_LSI_HZ		40000
+#define WATCHDOG_PRESCALER	32
+#define WATCHDOG_RELOAD		(WATCHDOG_TIMEOUT * (WATCHDOG_LSI_HZ / WATCHDOG_PRESCALER) / 1000)
+#define WATCHDOG_PRIORITY	2
+
+#define SNAPSHOT_MAGIC		0x474F4F44	// "GOOD"
+
+typedef struct
+{
+	uint32_t magic;
+	int16_t chans[NUM_CHNOUT];
+	uint32_t check;
+} WatchdogSnapshot;
+
+volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+
+static WatchdogSnapshot snapshot CRASH_NOINIT;
+static volatile uint8_t expected = WATCHDOG_ALL;
+static bool running;
+static bool stalled;
+static bool iwdg_reset;
+static bool recovered;
+static uint8_t misses;
+static uint8_t period;
+
+static uint32_t watchdog_snapshot_check(void)
+{
+	const uint16_t *p = (const uint16_t*) snapshot.chans;
+	uint32_t sum = snapshot.magic;
+	uint8_t i;
+
+	for (i = 0; i < NUM_CHNOUT; i++)
+		sum = (sum << 1 | sum >> 31) + p[i];
+	return ~sum;
+}
+
+/**
+  * @brief  Find out why we reset.
+  * @note	Call before mixer_init(). Doesn't start the watchdog.
+  * @param  None
+  * @retval None
+  */
+void watchdog_init(void)
+{
+	iwdg_reset = RCC_GetFlagStatus(RCC_FLAG_IWDGRST) == SET;
+
+	// Software resets come from the fault handler. A debugger reset
+	// looks the same, but costs nothing more than a skipped check.
+	if ((iwdg_reset || RCC_GetFlagStatus(RCC_FLAG_SFTRST) == SET) &&
+			snapshot.magic == SNAPSHOT_MAGIC &&
+			snapshot.check == watchdog_snapshot_check())
+		recovered = true;
+
+	RCC_ClearFlag();
+	snapshot.magic = 0;
+}
+
+/**
+  * @brief  Start the independent watchdog and the supervisor.
+  * @note	Call once everything is running. The IWDG can't be stopped.
+  * @param  None
+  * @retval None
+  */
+void watchdog_start(void)
+{
+	uint8_t i;
+
+	// Don't bite while halted in the debugger.
+	DBGMCU_Config(DBGMCU_IWDG_STOP, ENABLE);
+
+	IWDG_WriteAccessCmd(IWDG_WriteAccess_Enable);
+	IWDG_SetPrescaler(IWDG_Prescaler_32);
+	IWDG_SetReload(WATCHDOG_RELOAD);
+	IWDG_ReloadCounter();
+	IWDG_Enable();
+
+	// The supervisor runs in SysTick. Keep it above the main loop
+	// peripherals so a spinning storage or serial ISR still gets caught.
+	NVIC_SetPriority(SysTick_IRQn, WATCHDOG_PRIORITY);
+	NVIC_SetPriority(PendSV_IRQn, WATCHDOG_PRIORITY);
+
+	for (i = 0; i < WATCHDOG_SOURCES; i++)
+		g_watchdog_beats[i] = 0;
+	running = true;
+}
+
+/**
+  * @brief  Say whether a source should be beating.
+  * @note	The PPM timer is stopped in some modes.
+  * @param  source: WATCHDOG_* bits
+  * @param  expect: true to supervise them
+  * @retval None
+  */
+void watchdog_expect(uint8_t source, bool expect)
+{
+	if (expect)
+		expected |= source;
+	else
+		expected &= ~source;
+}
+
+/**
+  * @brief  Check the heartbeats.
+  * @note	Called from the SysTick handler every ms.
+  * @param  None
+  * @retval None
+  */
+void watchdog_tick(void)
+{
+	uint8_t missing;
+	uint8_t i;
+
+	if (!running || stalled || ++period < WATCHDOG_PERIOD)
+		return;
+	period = 0;
+	missing = expected;
+
+	// Only a byte that is set is cleared, a beat coming in between the
+	// two has already been counted.
+	for (i = 0; i < WATCHDOG_SOURCES; i++)
+		if (g_watchdog_beats[i])
+		{
+			g_watchdog_beats[i] = 0;
+			missing &= ~(1 << i);
+		}
+
+	if (missing == 0)
+	{
+		misses = 0;
+		IWDG_ReloadCounter();
+
+		snapshot.magic = SNAPSHOT_MAGIC;
+		for (i = 0; i < NUM_CHNOUT; i++)
+			snapshot.chans[i] = g_chans[i];
+		snapshot.check = watchdog_snapshot_check();
+		return;
+	}
+
+	if (++misses < WATCHDOG_MISSES)
+		return;
+
+	// Record and reset, from the context that stopped beating.
+	stalled = true;
+	crash_watchdog(missing);
+}
+
+/**
+  * @brief  Was the last reset the IWDG?
+  * @note	Valid after watchdog_init().
+  * @param  None
+  * @retval true if the supervisor itself stopped.
+  */
+bool watchdog_caused_reset(void)
+{
+	return iwdg_reset;
+}
+
+/**
+  * @brief  Are we restarting after a lockup or fault?
+  * @note	Valid after watchdog_init().
+  * @param  None
+  * @retval true if there are last good outputs to restore.
+  */
+bool watchdog_recovered(void)
+{
+	return recovered;
+}
+
+/**
+  * @brief  Copy the last good outputs to the channels.
+  * @note	Called from mixer_init().
+  * @param  None
+  * @retval true if the channels were restored.
+  */
+bool watchdog_restore_chans(void)
+{
+	uint8_t i;
+
+	if (!recovered)
+		return false;
+
+	for (i = 0; i < NUM_CHNOUT; i++)
+		g_chans[i] = snapshot.chans[i];
+	return true;
+}
@@ -0,0 +1,57 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _WATCHDOG_H
+#define _WATCHDOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Heartbeat sources. Each must beat at least once every WATCHDOG_PERIOD
+// while it is expected. Also used in CrashRecord.stalled.
+#define WATCHDOG_MIXER		0x01	// Stick scan / mixer ISR
+#define WATCHDOG_PULSES		0x02	// PPM timer ISR
+#define WATCHDOG_MAIN		0x04	// Main loop and storage
+#define WATCHDOG_ALL		0x07
+#define WATCHDOG_SOURCES	3
+
+#define WATCHDOG_PERIOD		100		// ms between checks
+#define WATCHDOG_MISSES		3		// Failed checks before giving up
+#define WATCHDOG_TIMEOUT	500		// ms, IWDG
+
+// One byte per source, so a beat is a single store that no other
+// source or the check can undo.
+extern volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+
+/**
+  * @brief  Report that a source is alive.
+  * @note	Can be called from ISR or main loop.
+  * @param  source: WATCHDOG_* bit, only one
+  * @retval None
+  */
+static inline void watchdog_heartbeat(uint8_t source)
+{
+	g_watchdog_beats[__builtin_ctz(source)] = 1;
+}
+
+void watchdog_init(void);
+void watchdog_start(void);
+void watchdog_expect(uint8_t source, bool expect);
+void watchdog_tick(void);
+
+bool watchdog_caused_reset(void);
+bool watchdog_recovered(void);
+bool watchdog_restore_chans(void);
+
+#endif // _WATCHDOG_H
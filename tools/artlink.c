@@ -0,0 +1,586 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host client for the radio's serial link (firmware/serial.c).
+ * Connect a 3.3V USB serial adapter to the UART pads (PA9/PA10).
+ *
+ * Build:  cc -o artlink artlink.c ../firmware/frame.c
+ * Usage:  artlink <device> ping
+ *         artlink <device> info
+ *         artlink <device> stream [period_ms]      CSV to stdout, ^C to stop
+ *         artlink <device> dump <file>             whole EEPROM to file
+ *         artlink <device> load <file>             whole EEPROM from file
+ *         artlink <device> model-get <n> <file>
+ *         artlink <device> backup <file>           all models, compressed
+ *         artlink <device> restore <file>
+ *         artlink <device> model-copy <from> <to>
+ *         artlink <device> capture <file> [seconds]   inputs, for tools/replay
+ *
+ * Models are stored compressed (see firmware/modelimg.h). model-get
+ * fetches one decoded, backup/restore/model-copy move the images as is.
+ * Raw EEPROM writes (load) take effect after the radio is restarted,
+ * a restore of the current model is picked up within a second.
+ * A capture saves the stored settings and current model, then the stick,
+ * key and trainer inputs until the time is up or ^C (see capture.h).
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/select.h>
+
+#include "../firmware/serial.h"
+#include "../firmware/capture.h"
+
+#ifndef TIMEOUT_MS
+#define TIMEOUT_MS	500		// tools/linktest uses less
+#endif
+#define RETRIES		3
+
+static int fd;
+static uint8_t rx_frame[FRAME_MAX_ENCODED];
+static unsigned rx_len;
+
+static int open_port(const char *dev)
+{
+	struct termios tio;
+
+	fd = open(dev, O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		perror(dev);
+		return -1;
+	}
+
+	// A PTY or file stand-in is fine, just skip the line setup.
+	if (tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, B115200);
+		cfsetospeed(&tio, B115200);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tcsetattr(fd, TCSANOW, &tio);
+		tcflush(fd, TCIOFLUSH);
+	}
+
+	return 0;
+}
+
+static int send_msg(const uint8_t *payload, unsigned length)
+{
+	uint8_t out[FRAME_MAX_ENCODED];
+	unsigned n = frame_encode(payload, length, out);
+
+	return write(fd, out, n) == (ssize_t) n ? 0 : -1;
+}
+
+/* Wait for a valid frame. Returns payload length, 0 on timeout. */
+static int recv_msg(uint8_t *payload, int timeout_ms)
+{
+	for (;;) {
+		struct timeval tv = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+		fd_set set;
+		uint8_t b;
+
+		FD_ZERO(&set);
+		FD_SET(fd, &set);
+		if (select(fd + 1, &set, NULL, NULL, &tv) <= 0)
+			return 0;
+		if (read(fd, &b, 1) != 1)
+			return 0;
+
+		if (b != 0) {
+			if (rx_len < sizeof(rx_frame))
+				rx_frame[rx_len++] = b;
+			else
+				rx_len = sizeof(rx_frame) + 1;	// overflow, wait for delimiter
+			continue;
+		}
+
+		if (rx_len > 0 && rx_len <= sizeof(rx_frame)) {
+			int n = frame_decode(rx_frame, rx_len);
+			rx_len = 0;
+			if (n > 0) {
+				memcpy(payload, rx_frame, n);
+				return n;
+			}
+		}
+		rx_len = 0;
+	}
+}
+
+/* Send a request and wait for the reply of the given type, retrying on timeout. */
+static int request(const uint8_t *req, unsigned length, uint8_t reply_type,
+		uint8_t *reply)
+{
+	int tries, n;
+
+	for (tries = 0; tries < RETRIES; tries++) {
+		if (send_msg(req, length) < 0)
+			return -1;
+		while ((n = recv_msg(reply, TIMEOUT_MS)) > 0) {
+			if (reply[0] == reply_type)
+				return n;
+			if (reply[0] == MSG_ACK && n == 3 && reply[1] == req[0]) {
+				fprintf(stderr, "request 0x%02x failed: %d\n", req[0], reply[2]);
+				return -1;
+			}
+			// Anything else is telemetry, skip it.
+		}
+	}
+
+	fprintf(stderr, "no reply to request 0x%02x\n", req[0]);
+	return -1;
+}
+
+static int expect_ack(const uint8_t *req, unsigned length)
+{
+	uint8_t reply[FRAME_MAX_PAYLOAD];
+	int n = request(req, length, MSG_ACK, reply);
+
+	if (n != 3 || reply[1] != req[0] || reply[2] != SERIAL_OK)
+		return -1;
+	return 0;
+}
+
+static int get_info(SerialInfo *info)
+{
+	uint8_t req = MSG_INFO;
+	uint8_t reply[FRAME_MAX_PAYLOAD];
+
+	if (request(&req, 1, MSG_INFO_DATA, reply) != sizeof(*info))
+		return -1;
+	memcpy(info, reply, sizeof(*info));
+	return 0;
+}
+
+/* Read from the EEPROM (model < 0) or a stored model. */
+static int read_block(int model, unsigned offset, uint8_t *buf, unsigned length)
+{
+	uint8_t req[5], reply[FRAME_MAX_PAYLOAD];
+	unsigned done = 0;
+
+	while (done < length) {
+		unsigned size = length - done;
+		unsigned reqlen;
+		int n;
+
+		if (size > SERIAL_MAX_DATA)
+			size = SERIAL_MAX_DATA;
+		if (model < 0) {
+			req[0] = MSG_EE_READ;
+			req[1] = (offset + done) & 0xFF;
+			req[2] = (offset + done) >> 8;
+			req[3] = size;
+			reqlen = 4;
+		} else {
+			req[0] = MSG_MODEL_READ;
+			req[1] = model;
+			req[2] = (offset + done) & 0xFF;
+			req[3] = (offset + done) >> 8;
+			req[4] = size;
+			reqlen = 5;
+		}
+
+		n = request(req, reqlen, MSG_EE_DATA, reply);
+		if (n != (int) (3 + size))
+			return -1;
+		memcpy(buf + done, reply + 3, size);
+		done += size;
+	}
+	return 0;
+}
+
+/* Write to the EEPROM. */
+static int write_block(unsigned offset, const uint8_t *buf, unsigned length)
+{
+	uint8_t req[3 + SERIAL_MAX_DATA];
+	unsigned done = 0;
+
+	while (done < length) {
+		unsigned size = length - done;
+
+		if (size > SERIAL_MAX_DATA)
+			size = SERIAL_MAX_DATA;
+		req[0] = MSG_EE_WRITE;
+		req[1] = (offset + done) & 0xFF;
+		req[2] = (offset + done) >> 8;
+		memcpy(req + 3, buf + done, size);
+
+		if (expect_ack(req, 3 + size) < 0)
+			return -1;
+		done += size;
+		fprintf(stderr, "\r%u/%u", done, length);
+	}
+	fprintf(stderr, "\n");
+	return 0;
+}
+
+/* Fetch the compressed image of a model. Returns its length or -1. */
+static int read_image(int model, uint8_t *buf, unsigned size)
+{
+	uint8_t req[4], reply[FRAME_MAX_PAYLOAD];
+	unsigned done = 0, total;
+
+	do {
+		int n;
+
+		req[0] = MSG_IMG_READ;
+		req[1] = model;
+		req[2] = done & 0xFF;
+		req[3] = done >> 8;
+		n = request(req, 4, MSG_IMG_DATA, reply);
+		if (n < 5)
+			return -1;
+		total = reply[3] | (reply[4] << 8);
+		if (total > size || done + (n - 5) > total)
+			return -1;
+		memcpy(buf + done, reply + 5, n - 5);
+		done += n - 5;
+		if (n == 5 && done < total)
+			return -1;
+	} while (done < total);
+
+	return total;
+}
+
+/* Send a compressed image into a model slot. An empty image clears it. */
+static int write_image(int model, const uint8_t *buf, unsigned length)
+{
+	uint8_t req[6 + SERIAL_MAX_DATA], reply[FRAME_MAX_PAYLOAD];
+	unsigned done = 0;
+
+	do {
+		unsigned size = length - done;
+		int n;
+
+		if (size > SERIAL_MAX_DATA)
+			size = SERIAL_MAX_DATA;
+		req[0] = MSG_IMG_WRITE;
+		req[1] = model;
+		req[2] = done & 0xFF;
+		req[3] = done >> 8;
+		req[4] = length & 0xFF;
+		req[5] = length >> 8;
+		memcpy(req + 6, buf + done, size);
+
+		n = request(req, 6 + size, MSG_ACK, reply);
+		if (n != 3 || reply[1] != MSG_IMG_WRITE)
+			return -1;
+		done += size;
+		if (reply[2] == SERIAL_OK && done == length)
+			return 0;
+		if (reply[2] != SERIAL_PENDING) {
+			fprintf(stderr, "model %d: image rejected (%d)\n", model, reply[2]);
+			return -1;
+		}
+	} while (done < length);
+
+	fprintf(stderr, "model %d: image incomplete\n", model);
+	return -1;
+}
+
+/*
+ * Backup file: for each model, u8 model number, u16 image length (LE), image.
+ */
+static int do_backup(const SerialInfo *info, const char *name)
+{
+	static uint8_t img[0x10000];
+	unsigned raw = 0, packed = 0;
+	FILE *f = fopen(name, "wb");
+	int m, len;
+
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+	for (m = 0; m < info->max_models; m++) {
+		len = read_image(m, img, sizeof(img));
+		if (len < 0) {
+			fprintf(stderr, "model %d: read failed\n", m);
+			fclose(f);
+			return -1;
+		}
+		fputc(m, f);
+		fputc(len & 0xFF, f);
+		fputc(len >> 8, f);
+		fwrite(img, 1, len, f);
+		raw += info->model_size;
+		packed += len;
+	}
+	fprintf(stderr, "%d models, %u bytes (%u uncompressed)\n", m, packed, raw);
+	return fclose(f);
+}
+
+static int do_restore(const SerialInfo *info, const char *name)
+{
+	static uint8_t img[0x10000];
+	FILE *f = fopen(name, "rb");
+	int m, lo, hi, count = 0;
+
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+	while ((m = fgetc(f)) != EOF) {
+		unsigned len;
+
+		lo = fgetc(f);
+		hi = fgetc(f);
+		if (hi == EOF || m >= info->max_models)
+			break;
+		len = lo | (hi << 8);
+		if (fread(img, 1, len, f) != len || write_image(m, img, len) < 0)
+			break;
+		count++;
+	}
+	if (m != EOF) {
+		fprintf(stderr, "%s: restore failed at model %d\n", name, count);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+	fprintf(stderr, "%d models restored\n", count);
+	return 0;
+}
+
+static int read_file(const char *name, uint8_t *buf, unsigned length)
+{
+	FILE *f = fopen(name, "rb");
+	size_t n;
+
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+	n = fread(buf, 1, length, f);
+	fclose(f);
+	if (n != length) {
+		fprintf(stderr, "%s: expected %u bytes\n", name, length);
+		return -1;
+	}
+	return 0;
+}
+
+static int write_file(const char *name, const uint8_t *buf, unsigned length)
+{
+	FILE *f = fopen(name, "wb");
+
+	if (!f || fwrite(buf, 1, length, f) != length) {
+		perror(name);
+		if (f)
+			fclose(f);
+		return -1;
+	}
+	return fclose(f);
+}
+
+static int do_stream(int period)
+{
+	uint8_t req[2] = { MSG_STREAM, period };
+	uint8_t msg[FRAME_MAX_PAYLOAD];
+	SerialTelemetry t;
+	int i, n;
+
+	if (expect_ack(req, 2) < 0)
+		return -1;
+
+	printf("ticks");
+	for (i = 0; i < 8; i++)
+		printf(",ch%d", i + 1);
+	for (i = 0; i < 7; i++)
+		printf(",stick%d", i + 1);
+	printf(",mixer_passes,mixer_us,mixer_max_us\n");
+
+	for (;;) {
+		n = recv_msg(msg, 2000);
+		if (n == 0) {
+			fprintf(stderr, "stream stopped\n");
+			return -1;
+		}
+		if (msg[0] != MSG_TELEMETRY || n != sizeof(t))
+			continue;
+		memcpy(&t, msg, sizeof(t));
+		printf("%u", t.ticks);
+		for (i = 0; i < 8; i++)
+			printf(",%d", t.chans[i]);
+		for (i = 0; i < 7; i++)
+			printf(",%d", t.sticks[i]);
+		printf(",%u,%u,%u\n", t.mixer_passes, t.mixer_us, t.mixer_max_us);
+		fflush(stdout);
+	}
+}
+
+static volatile sig_atomic_t interrupted;
+
+static void on_interrupt(int sig)
+{
+	(void) sig;
+	interrupted = 1;
+}
+
+static int do_capture(const SerialInfo *info, const char *name, int seconds)
+{
+	static uint8_t buf[0x10000];
+	uint8_t req[2] = { MSG_CAPTURE, 1 };
+	uint8_t msg[FRAME_MAX_PAYLOAD];
+	unsigned counts[CAPTURE_LOST + 1] = { 0 };
+	unsigned lost = 0;
+	CaptureFileHdr hdr;
+	time_t end = time(NULL) + seconds;
+	FILE *f;
+	int ret = 0;
+
+	f = fopen(name, "wb");
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+
+	// Settings and model as stored, which is what the radio runs
+	// unless they were edited and not yet saved.
+	hdr.magic = CAPTURE_MAGIC;
+	hdr.version = CAPTURE_VERSION;
+	hdr.general_size = info->general_size;
+	hdr.model_size = info->model_size;
+	fwrite(&hdr, sizeof(hdr), 1, f);
+	if (read_block(-1, 0, buf, info->general_size) < 0)
+		goto fail;
+	fwrite(buf, info->general_size, 1, f);
+	if (read_block(info->curr_model, 0, buf, info->model_size) < 0)
+		goto fail;
+	fwrite(buf, info->model_size, 1, f);
+
+	signal(SIGINT, on_interrupt);
+	if (expect_ack(req, 2) < 0)
+		goto fail;
+	fprintf(stderr, "capturing, ^C to stop\n");
+
+	while (!interrupted && (seconds == 0 || time(NULL) < end)) {
+		int n = recv_msg(msg, 1000);
+		int i;
+
+		if (n == 0 && interrupted)
+			break;
+		if (n == 0) {
+			fprintf(stderr, "capture stopped\n");
+			ret = -1;
+			break;
+		}
+		if (msg[0] != MSG_CAPTURE_DATA)
+			continue;
+		fwrite(msg + 1, n - 1, 1, f);
+
+		for (i = 1; i < n; ) {
+			uint8_t size = capture_length(msg[i]);
+			if (size == 0 || i + size > n)
+				break;
+			counts[msg[i]]++;
+			if (msg[i] == CAPTURE_LOST)
+				lost += msg[i + sizeof(CaptureHdr)] | (msg[i + sizeof(CaptureHdr) + 1] << 8);
+			i += size;
+		}
+		fprintf(stderr, "\r%u scans, %u keys, %u trainer frames",
+				counts[CAPTURE_ADC], counts[CAPTURE_KEY], counts[CAPTURE_PPM_IN]);
+	}
+	fprintf(stderr, "\n");
+	if (lost)
+		fprintf(stderr, "%u records lost\n", lost);
+
+	req[1] = 0;
+	if (expect_ack(req, 2) < 0)
+		ret = -1;
+	if (fclose(f) != 0)
+		return -1;
+	return ret;
+
+fail:
+	fclose(f);
+	return -1;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s <device> ping | info | stream [ms] | dump <file> | "
+			"load <file> | model-get <n> <file> | "
+			"backup <file> | restore <file> | model-copy <from> <to> | "
+			"capture <file> [seconds]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	static uint8_t buf[0x10000];	// Any size the radio can report
+	SerialInfo info;
+	const char *cmd;
+
+	if (argc < 3)
+		usage(argv[0]);
+	if (open_port(argv[1]) < 0)
+		return 1;
+	cmd = argv[2];
+
+	if (!strcmp(cmd, "ping")) {
+		uint8_t req = MSG_PING, reply[FRAME_MAX_PAYLOAD];
+		if (request(&req, 1, MSG_PONG, reply) < 0)
+			return 1;
+		printf("pong\n");
+		return 0;
+	}
+
+	if (!strcmp(cmd, "stream"))
+		return do_stream(argc > 3 ? atoi(argv[3]) : 20) < 0;
+
+	if (get_info(&info) < 0)
+		return 1;
+	if (!strcmp(cmd, "info")) {
+		printf("eeprom %u bytes, general %u bytes, model %u bytes, %u models, current %u\n",
+				info.eeprom_size, info.general_size, info.model_size,
+				info.max_models, info.curr_model);
+	} else if (!strcmp(cmd, "dump") && argc == 4) {
+		if (read_block(-1, 0, buf, info.eeprom_size) < 0 ||
+				write_file(argv[3], buf, info.eeprom_size) < 0)
+			return 1;
+	} else if (!strcmp(cmd, "load") && argc == 4) {
+		if (read_file(argv[3], buf, info.eeprom_size) < 0 ||
+				write_block(0, buf, info.eeprom_size) < 0)
+			return 1;
+	} else if (!strcmp(cmd, "model-get") && argc == 5) {
+		if (read_block(atoi(argv[3]), 0, buf, info.model_size) < 0 ||
+				write_file(argv[4], buf, info.model_size) < 0)
+			return 1;
+	} else if (!strcmp(cmd, "backup") && argc == 4) {
+		if (do_backup(&info, argv[3]) < 0)
+			return 1;
+	} else if (!strcmp(cmd, "restore") && argc == 4) {
+		if (do_restore(&info, argv[3]) < 0)
+			return 1;
+	} else if (!strcmp(cmd, "model-copy") && argc == 5) {
+		int len = read_image(atoi(argv[3]), buf, sizeof(buf));
+		if (len < 0 || write_image(atoi(argv[4]), buf, len) < 0)
+			return 1;
+	} else if (!strcmp(cmd, "capture") && (argc == 4 || argc == 5)) {
+		if (do_capture(&info, argv[3], argc == 5 ? atoi(argv[4]) : 0) < 0)
+			return 1;
+	} else
+		usage(argv[0]);
+
+	return 0;
+}
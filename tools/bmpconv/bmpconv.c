@@ -0,0 +1,445 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host side converter for the GUI bitmaps (firmware/bitmap.h).
+ * Each asset is name=file, where file is an uncompressed 1, 24 or 32 bit
+ * .bmp (dark pixels are set), or a C array of lcd_buffer order bytes as
+ * written by LCD Assistant, given as name=file:WxH. The packed bitmaps
+ * are written to stdout as C.
+ *
+ * With -t nothing is written. Instead each asset is drawn with the
+ * firmware's bitmap_draw() at every y offset and op, and checked against
+ * a plain pixel by pixel draw, then timed against a memcpy of the
+ * unpacked image. -a prints the assets as text to check the threshold.
+ *
+ * Build:  cc -O2 -o bmpconv bmpconv.c ../../firmware/bitmap.c
+ * Usage:  bmpconv [-t] [-a] [-n loops] name=file[:WxH] ... > assets.c
+ *
+ * firmware/assets.c is made in the firmware directory with
+ *   bmpconv logo=logo.bmp radio_settings=radio_settings.bmp
+ *           model_settings=model_settings.bmp > assets.c
+ * art_font.bmp converts as well, but the font stays unpacked in
+ * lcd_font_medium.h as glyphs are looked up by index.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../../firmware/lcd.h"
+#include "../../firmware/bitmap.h"
+
+#define MAX_ASSETS		16
+#define MAX_SIZE		255
+
+typedef struct
+{
+	const char *name;
+	const char *file;
+	int width, height;
+	uint8_t raw[MAX_SIZE * ((MAX_SIZE + 7) / 8)];	// lcd_buffer order
+	size_t raw_len;
+	uint8_t packed[BITMAP_HDR_LEN + 2 * MAX_SIZE * ((MAX_SIZE + 7) / 8)];
+	size_t packed_len;
+} Asset;
+
+uint8_t lcd_buffer[LCD_WIDTH * LCD_HEIGHT / 8];
+
+static Asset assets[MAX_ASSETS];
+static int n_assets;
+
+static uint32_t get_le(const uint8_t *p, int n)
+{
+	uint32_t v = 0;
+
+	while (n--)
+		v = (v << 8) | p[n];
+	return v;
+}
+
+static void set_pixel(Asset *a, int x, int y)
+{
+	a->raw[x + (y / 8) * a->width] |= 1 << (y % 8);
+}
+
+static bool get_pixel(const Asset *a, int x, int y)
+{
+	return (a->raw[x + (y / 8) * a->width] >> (y % 8)) & 1;
+}
+
+static void *read_file(const char *name, size_t *len)
+{
+	FILE *f = fopen(name, "rb");
+	uint8_t *buf;
+	long n;
+
+	if (!f) {
+		perror(name);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	n = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	buf = malloc(n + 1);
+	if (fread(buf, 1, n, f) != (size_t)n) {
+		perror(name);
+		exit(1);
+	}
+	buf[n] = 0;
+	fclose(f);
+	*len = n;
+	return buf;
+}
+
+/**
+  * @brief  Load a .bmp, dark pixels are set.
+  * @note	Only uncompressed (BI_RGB or BI_BITFIELDS) 1, 24 and 32 bit.
+  */
+static void load_bmp(Asset *a)
+{
+	size_t len;
+	uint8_t *buf = read_file(a->file, &len);
+	uint32_t offset, hdr, bpp, comp, stride;
+	int32_t h;
+	int x, y;
+
+	if (len < 54 || buf[0] != 'B' || buf[1] != 'M') {
+		fprintf(stderr, "%s: not a bmp\n", a->file);
+		exit(1);
+	}
+	offset = get_le(buf + 10, 4);
+	hdr = get_le(buf + 14, 4);
+	a->width = (int32_t)get_le(buf + 18, 4);
+	h = (int32_t)get_le(buf + 22, 4);
+	a->height = h < 0 ? -h : h;
+	bpp = get_le(buf + 28, 2);
+	comp = get_le(buf + 30, 4);
+	stride = ((a->width * bpp + 31) / 32) * 4;
+
+	if ((bpp != 1 && bpp != 24 && bpp != 32) || (comp != 0 && comp != 3)
+			|| a->width <= 0 || a->width > MAX_SIZE || a->height > MAX_SIZE
+			|| offset + stride * a->height > len) {
+		fprintf(stderr, "%s: unsupported bmp (%ux%u, %u bit, compression %u)\n",
+				a->file, a->width, a->height, bpp, comp);
+		exit(1);
+	}
+
+	memset(a->raw, 0, sizeof(a->raw));
+	for (y = 0; y < a->height; ++y) {
+		// Bottom up unless the height is negative.
+		const uint8_t *row = buf + offset + stride * (h < 0 ? y : a->height - 1 - y);
+
+		for (x = 0; x < a->width; ++x) {
+			unsigned lum;
+
+			if (bpp == 1) {
+				const uint8_t *pal = buf + 14 + hdr + 4 * ((row[x / 8] >> (7 - x % 8)) & 1);
+				lum = (pal[0] + pal[1] + pal[2]) / 3;
+			} else {
+				const uint8_t *px = row + x * (bpp / 8);
+				lum = (px[0] + px[1] + px[2]) / 3;
+			}
+			if (lum < 128)
+				set_pixel(a, x, y);
+		}
+	}
+	a->raw_len = a->width * ((a->height + 7) / 8);
+	free(buf);
+}
+
+/**
+  * @brief  Load lcd_buffer order bytes from the 0xNN values in a C array.
+  */
+static void load_array(Asset *a)
+{
+	size_t len, n = 0;
+	char *buf = read_file(a->file, &len);
+	char *p = buf;
+
+	a->raw_len = a->width * ((a->height + 7) / 8);
+	while ((p = strstr(p, "0x")) != NULL && n < a->raw_len)
+		a->raw[n++] = strtoul(p, &p, 16);
+	if (n != a->raw_len) {
+		fprintf(stderr, "%s: %zu bytes, expected %zu\n", a->file, n, a->raw_len);
+		exit(1);
+	}
+	free(buf);
+}
+
+/**
+  * @brief  PackBits, runs of 3 or more are worth a token.
+  */
+static void pack(Asset *a)
+{
+	const uint8_t *in = a->raw;
+	size_t n = a->raw_len, i = 0;
+	uint8_t *out = a->packed;
+
+	*out++ = a->width;
+	*out++ = a->height;
+	while (i < n) {
+		size_t run = 1, lit;
+
+		while (i + run < n && run < BITMAP_RUN_MAX && in[i + run] == in[i])
+			run++;
+		if (run >= 3) {
+			*out++ = 257 - run;
+			*out++ = in[i];
+			i += run;
+			continue;
+		}
+
+		// Literal up to the next run of 3.
+		for (lit = 0; i + lit < n && lit < BITMAP_RUN_MAX; ++lit) {
+			if (i + lit + 2 < n && in[i + lit] == in[i + lit + 1]
+					&& in[i + lit] == in[i + lit + 2])
+				break;
+		}
+		*out++ = lit - 1;
+		memcpy(out, in + i, lit);
+		out += lit;
+		i += lit;
+	}
+	a->packed_len = out - a->packed;
+}
+
+static void write_c(void)
+{
+	int i;
+	size_t j;
+
+	printf("/*\n"
+			" *                  Copyright 2014 ARTaylor.co.uk\n"
+			" *\n"
+			" * This program is free software; you can redistribute it and/or modify\n"
+			" * it under the terms of the GNU General Public License version 3 as\n"
+			" * published by the Free Software Foundation.\n"
+			" *\n"
+			" * This program is distributed in the hope that it will be useful,\n"
+			" * but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+			" * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+			" * GNU General Public License for more details.\n"
+			" *\n"
+			" */\n\n"
+			"/* Description:\n"
+			" *\n"
+			" * Packed GUI bitmaps, see bitmap.h.\n"
+			" * Made by tools/bmpconv, do not edit.\n"
+			" *\n"
+			" */\n\n"
+			"#include \"assets.h\"\n");
+
+	for (i = 0; i < n_assets; ++i) {
+		const Asset *a = &assets[i];
+
+		printf("\n// %s, %dx%d, %zu bytes unpacked\n", a->file, a->width, a->height, a->raw_len);
+		printf("const uint8_t asset_%s[%zu] = {", a->name, a->packed_len);
+		for (j = 0; j < a->packed_len; ++j)
+			printf("%s0x%02X%s", (j % 16) ? " " : "\n\t", a->packed[j],
+					(j + 1 < a->packed_len) ? "," : "");
+		printf("\n};\n");
+	}
+}
+
+static void print_ascii(const Asset *a)
+{
+	int x, y;
+
+	printf("%s: %dx%d\n", a->name, a->width, a->height);
+	for (y = 0; y < a->height; ++y) {
+		for (x = 0; x < a->width; ++x)
+			putchar(get_pixel(a, x, y) ? '#' : '.');
+		putchar('\n');
+	}
+}
+
+/**
+  * @brief  What bitmap_draw() should do, a pixel at a time.
+  */
+static void reference_draw(const Asset *a, uint8_t *buf, int x0, int y0, LCD_OP op)
+{
+	int x, y;
+
+	for (y = 0; y < a->height; ++y) {
+		for (x = 0; x < a->width; ++x) {
+			int sx = x0 + x, sy = y0 + y;
+			uint8_t *dst, bit;
+
+			if (!get_pixel(a, x, y) || sx >= LCD_WIDTH || sy >= LCD_HEIGHT)
+				continue;
+			dst = &buf[sx + (sy / 8) * LCD_WIDTH];
+			bit = 1 << (sy % 8);
+			if (op == LCD_OP_SET)
+				*dst |= bit;
+			else if (op == LCD_OP_CLR)
+				*dst &= ~bit;
+			else if (op == LCD_OP_XOR)
+				*dst ^= bit;
+		}
+	}
+}
+
+static double now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/**
+  * @brief  Check and time the decoder on an asset.
+  * @retval Number of mismatches.
+  */
+static int test_asset(const Asset *a, int loops)
+{
+	static const LCD_OP ops[] = { LCD_OP_SET, LCD_OP_CLR, LCD_OP_XOR };
+	uint8_t expect[sizeof(lcd_buffer)];
+	int errors = 0;
+	int x, y, o, i;
+	double t0, t_draw, t_draw3, t_copy;
+	uint8_t y8 = (a->height <= LCD_HEIGHT - 8) ? 3 : 0;
+
+	// Every y offset and op, from blank, full and a pattern, and clipped.
+	for (x = 0; x < LCD_WIDTH; x += LCD_WIDTH / 2 - 1) {
+		for (y = 0; y < LCD_HEIGHT; ++y) {
+			for (o = 0; o < 3; ++o) {
+				static const uint8_t fill[] = { 0x00, 0xFF, 0xA5 };
+
+				for (i = 0; i < 3; ++i) {
+					memset(lcd_buffer, fill[i], sizeof(lcd_buffer));
+					memcpy(expect, lcd_buffer, sizeof(lcd_buffer));
+					bitmap_draw(a->packed, x, y, ops[o]);
+					reference_draw(a, expect, x, y, ops[o]);
+					if (memcmp(expect, lcd_buffer, sizeof(lcd_buffer)) != 0) {
+						if (errors++ < 5)
+							fprintf(stderr, "%s: mismatch at %d,%d op %d fill %02x\n",
+									a->name, x, y, ops[o], fill[i]);
+					}
+				}
+			}
+		}
+	}
+
+	t0 = now_ns();
+	for (i = 0; i < loops; ++i)
+		bitmap_draw(a->packed, 0, 0, LCD_OP_SET);
+	t_draw = (now_ns() - t0) / loops;
+
+	t0 = now_ns();
+	for (i = 0; i < loops; ++i)
+		bitmap_draw(a->packed, 0, y8, LCD_OP_XOR);
+	t_draw3 = (now_ns() - t0) / loops;
+
+	// What the old code did, only on a page boundary.
+	t0 = now_ns();
+	for (i = 0; i < loops; ++i) {
+		for (y = 0; y < (a->height + 7) / 8; ++y)
+			memcpy(&lcd_buffer[y * LCD_WIDTH], &a->raw[y * a->width], a->width);
+		__asm__ volatile("" ::: "memory");
+	}
+	t_copy = (now_ns() - t0) / loops;
+
+	printf("%-16s %3dx%-3d raw %5zu packed %5zu (%3.0f%%)  draw %6.0f ns, y+%d xor %6.0f ns, memcpy %5.0f ns\n",
+			a->name, a->width, a->height, a->raw_len, a->packed_len,
+			100.0 * a->packed_len / a->raw_len, t_draw, y8, t_draw3, t_copy);
+	return errors;
+}
+
+int main(int argc, char **argv)
+{
+	bool test = false, ascii = false;
+	int loops = 20000;
+	size_t raw = 0, packed = 0;
+	int errors = 0;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "tan:")) != -1) {
+		switch (opt) {
+		case 't':
+			test = true;
+			break;
+		case 'a':
+			ascii = true;
+			break;
+		case 'n':
+			loops = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t] [-a] [-n loops] name=file[:WxH] ...\n", argv[0]);
+			return 1;
+		}
+	}
+
+	for (i = optind; i < argc && n_assets < MAX_ASSETS; ++i) {
+		Asset *a = &assets[n_assets++];
+		char *arg = strdup(argv[i]);
+		char *eq = strchr(arg, '=');
+		char *dim;
+
+		if (!eq) {
+			fprintf(stderr, "%s: expected name=file\n", arg);
+			return 1;
+		}
+		*eq = 0;
+		a->name = arg;
+		a->file = eq + 1;
+		dim = strrchr(a->file, ':');
+		if (dim) {
+			*dim = 0;
+			if (sscanf(dim + 1, "%dx%d", &a->width, &a->height) != 2
+					|| a->width <= 0 || a->width > MAX_SIZE
+					|| a->height <= 0 || a->height > MAX_SIZE) {
+				fprintf(stderr, "%s: bad size %s\n", a->file, dim + 1);
+				return 1;
+			}
+			load_array(a);
+		} else {
+			load_bmp(a);
+		}
+		pack(a);
+		raw += a->raw_len;
+		packed += a->packed_len;
+	}
+
+	if (n_assets == 0) {
+		fprintf(stderr, "usage: %s [-t] [-a] [-n loops] name=file[:WxH] ...\n", argv[0]);
+		return 1;
+	}
+
+	if (ascii) {
+		for (i = 0; i < n_assets; ++i)
+			print_ascii(&assets[i]);
+	}
+
+	if (test) {
+		for (i = 0; i < n_assets; ++i)
+			errors += test_asset(&assets[i], loops);
+		printf("total raw %zu packed %zu, saved %zu bytes\n", raw, packed, raw - packed);
+		if (errors)
+			printf("%d mismatches\n", errors);
+		return errors ? 1 : 0;
+	}
+
+	if (!ascii)
+		write_c();
+	return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host side decoder for fault records (firmware/crash.c).
+ * Reads either a full EEPROM image or just the fault record and prints
+ * the registers, the decoded fault status and the possible call stack.
+ * Given the firmware ELF, code addresses are shown as function+offset
+ * (feed them to addr2line -e for file and line).
+ *
+ * Build:  cc -o crashdecode crashdecode.c
+ * Usage:  crashdecode eeprom.bin [ar-t6-firmware.elf]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <elf.h>
+
+#include "../firmware/crash.h"
+#include "../firmware/tasks.h"
+#include "../firmware/watchdog.h"
+
+typedef struct
+{
+	uint32_t addr;
+	uint32_t size;
+	const char *name;
+} Symbol;
+
+static Symbol *symbols;
+static size_t n_symbols;
+
+static void *load_file(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	void *data;
+	long size;
+
+	if (!f) {
+		perror(path);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = malloc(size ? size : 1);
+	if (!data || fread(data, 1, size, f) != (size_t) size) {
+		fprintf(stderr, "%s: read failed\n", path);
+		exit(1);
+	}
+	fclose(f);
+	*len = size;
+	return data;
+}
+
+/* Collect the function symbols of a 32 bit little endian ELF. */
+static void load_symbols(const char *path)
+{
+	size_t len;
+	const uint8_t *elf = load_file(path, &len);
+	const Elf32_Ehdr *eh = (const Elf32_Ehdr*) elf;
+	const Elf32_Shdr *sh;
+	int i;
+
+	if (len < sizeof(*eh) || memcmp(eh->e_ident, ELFMAG, SELFMAG) ||
+			eh->e_ident[EI_CLASS] != ELFCLASS32 || eh->e_ident[EI_DATA] != ELFDATA2LSB ||
+			eh->e_shoff + (size_t) eh->e_shnum * sizeof(*sh) > len) {
+		fprintf(stderr, "%s: not a 32 bit little endian ELF\n", path);
+		exit(1);
+	}
+	sh = (const Elf32_Shdr*) (elf + eh->e_shoff);
+
+	for (i = 0; i < eh->e_shnum; i++) {
+		const Elf32_Sym *sym;
+		const char *strtab;
+		size_t n, j;
+
+		if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh->e_shnum)
+			continue;
+		if (sh[i].sh_offset + sh[i].sh_size > len ||
+				sh[sh[i].sh_link].sh_offset + sh[sh[i].sh_link].sh_size > len)
+			continue;
+		sym = (const Elf32_Sym*) (elf + sh[i].sh_offset);
+		strtab = (const char*) elf + sh[sh[i].sh_link].sh_offset;
+		n = sh[i].sh_size / sizeof(*sym);
+
+		symbols = realloc(symbols, (n_symbols + n) * sizeof(*symbols));
+		for (j = 0; j < n; j++) {
+			if (ELF32_ST_TYPE(sym[j].st_info) != STT_FUNC ||
+					sym[j].st_name >= sh[sh[i].sh_link].sh_size)
+				continue;
+			// Thumb functions have bit 0 set.
+			symbols[n_symbols].addr = sym[j].st_value & ~1u;
+			symbols[n_symbols].size = sym[j].st_size;
+			symbols[n_symbols].name = strtab + sym[j].st_name;
+			n_symbols++;
+		}
+	}
+
+	if (!n_symbols)
+		fprintf(stderr, "%s: no function symbols\n", path);
+}
+
+static void print_addr(const char *label, uint32_t addr)
+{
+	uint32_t a = addr & ~1u;
+	const Symbol *best = 0;
+	size_t i;
+
+	printf("%-8s 0x%08x", label, addr);
+	for (i = 0; i < n_symbols; i++) {
+		const Symbol *s = &symbols[i];
+		if (a >= s->addr && (a < s->addr + s->size || (s->size == 0 && a == s->addr)))
+			best = s;
+	}
+	if (best)
+		printf("  %s+0x%x", best->name, a - best->addr);
+	printf("\n");
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static const char *exception_name(uint32_t n)
+{
+	switch (n) {
+	case 0: return "Watchdog reset";
+	case 3: return "HardFault";
+	case 4: return "MemManage";
+	case 5: return "BusFault";
+	case 6: return "UsageFault";
+	case 14: return "Lockup";
+	default: return "?";
+	}
+}
+
+static const char *task_name(uint16_t n)
+{
+	static const char *names[] = {
+		"keypad", "sticks", "gui", "eeprom", "recorder", "serial", "startup",
+	};
+
+	if (n == TASK_END)
+		return "none";
+	return n < sizeof(names) / sizeof(names[0]) ? names[n] : "?";
+}
+
+static void print_stalled(uint16_t stalled)
+{
+	if (stalled & WATCHDOG_MIXER)
+		printf("  mixer ISR stopped\n");
+	if (stalled & WATCHDOG_PULSES)
+		printf("  PPM timer ISR stopped\n");
+	if (stalled & WATCHDOG_MAIN)
+		printf("  main loop stopped\n");
+}
+
+static void print_cfsr(uint32_t cfsr, uint32_t hfsr)
+{
+	static const struct { uint32_t bit; const char *text; } bits[] = {
+		{ 1u << 0,  "IACCVIOL: instruction access violation" },
+		{ 1u << 1,  "DACCVIOL: data access violation" },
+		{ 1u << 3,  "MUNSTKERR: fault unstacking" },
+		{ 1u << 4,  "MSTKERR: fault stacking" },
+		{ 1u << 7,  "MMARVALID: MMFAR holds the address" },
+		{ 1u << 8,  "IBUSERR: instruction bus error" },
+		{ 1u << 9,  "PRECISERR: precise data bus error" },
+		{ 1u << 10, "IMPRECISERR: imprecise data bus error" },
+		{ 1u << 11, "UNSTKERR: bus fault unstacking" },
+		{ 1u << 12, "STKERR: bus fault stacking (stack overflow?)" },
+		{ 1u << 15, "BFARVALID: BFAR holds the address" },
+		{ 1u << 16, "UNDEFINSTR: undefined instruction" },
+		{ 1u << 17, "INVSTATE: invalid state (ARM mode / bad function pointer?)" },
+		{ 1u << 18, "INVPC: invalid EXC_RETURN" },
+		{ 1u << 19, "NOCP: no coprocessor" },
+		{ 1u << 24, "UNALIGNED: unaligned access" },
+		{ 1u << 25, "DIVBYZERO: divide by zero" },
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(bits) / sizeof(bits[0]); i++)
+		if (cfsr & bits[i].bit)
+			printf("         %s\n", bits[i].text);
+	if (hfsr & (1u << 1))
+		printf("         VECTTBL: vector table read fault\n");
+	if (hfsr & (1u << 30))
+		printf("         FORCED: escalated from a configurable fault\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const uint8_t *image, *p;
+	CrashRecord c;
+	uint32_t *w = (uint32_t*) &c;
+	size_t len, i;
+
+	if (argc != 2 && argc != 3) {
+		fprintf(stderr, "usage: %s <eeprom.bin | fault.bin> [firmware.elf]\n", argv[0]);
+		return 1;
+	}
+
+	image = load_file(argv[1], &len);
+	if (len == EEPROM_SIZE)
+		p = image + CRASH_EEPROM_BASE;
+	else if (len >= sizeof(CrashRecord))
+		p = image;
+	else {
+		fprintf(stderr, "%s: file too short\n", argv[1]);
+		return 1;
+	}
+
+	// The record is all 32 bit words apart from version / count
+	// and stalled / task.
+	for (i = 0; i < sizeof(c) / 4; i++)
+		w[i] = get32(p + i * 4);
+	c.version = p[4] | (p[5] << 8);
+	c.count = p[6] | (p[7] << 8);
+	i = offsetof(CrashRecord, stalled);
+	c.stalled = p[i] | (p[i + 1] << 8);
+	c.task = p[i + 2] | (p[i + 3] << 8);
+
+	if (c.magic != CRASH_MAGIC || c.version != CRASH_VERSION || c.check != crash_checksum(&c)) {
+		fprintf(stderr, "%s: no fault record found\n", argv[1]);
+		return 1;
+	}
+
+	if (argc == 3)
+		load_symbols(argv[2]);
+
+	printf("%s after %u.%03us (fault %u since format)\n", exception_name(c.exception),
+			c.ticks / 1000, c.ticks % 1000, c.count);
+	if (c.exception == 0) {
+		printf("the supervisor stopped, no context was saved\n");
+		return 0;
+	}
+	printf("task %s\n", task_name(c.task));
+	print_stalled(c.stalled);
+	print_addr("pc", c.pc);
+	print_addr("lr", c.lr);
+	printf("r0 0x%08x  r1 0x%08x  r2 0x%08x  r3 0x%08x\n", c.r0, c.r1, c.r2, c.r3);
+	printf("r12 0x%08x  sp 0x%08x  psr 0x%08x  exc_return 0x%08x\n",
+			c.r12, c.sp, c.psr, c.exc_return);
+	printf("cfsr 0x%08x  hfsr 0x%08x  mmfar 0x%08x  bfar 0x%08x\n",
+			c.cfsr, c.hfsr, c.mmfar, c.bfar);
+	print_cfsr(c.cfsr, c.hfsr);
+
+	printf("stack (possible return addresses, innermost first):\n");
+	for (i = 0; i < CRASH_STACK_WORDS && c.stack[i]; i++)
+		print_addr("", c.stack[i]);
+
+	return 0;
+}
+
+/* Same as the firmware, see crash.c. */
+uint32_t crash_checksum(const CrashRecord *rec)
+{
+	const uint32_t *p = (const uint32_t*) rec;
+	uint32_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < offsetof(CrashRecord, check) / 4; i++)
+		sum += p[i];
+	return ~sum;
+}
@@ -0,0 +1,676 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host simulation of the EEPROM driver (firmware/storage_i2c.c).
+ *
+ * The I2C block, the two DMA channels, TIM7, the I2C pins and a 24C64
+ * are modelled at the level the driver sees them. The driver's interrupt
+ * handlers run one at a time on a second thread against simulated time,
+ * while the main thread makes random reads and writes through the normal
+ * storage API and checks every read against what was written.
+ *
+ * Faults are injected at the given rates, per thousand bus operations:
+ *   nack   the EEPROM does not acknowledge its address
+ *   berr   bus error during a byte
+ *   stuck  the EEPROM holds SDA low during a read until SCL is clocked
+ *   lost   an address phase never completes (lost interrupt)
+ *
+ * Build:  cc -no-pie -pthread -I../hoststub -o eesim eesim.c ../../firmware/storage_i2c.c
+ * Usage:  eesim [ops] [nack] [berr] [stuck] [lost]
+ *
+ * The driver passes buffer addresses through 32 bit DMA registers, so the
+ * test buffers and the stack of the thread using the driver are kept in
+ * the low 4GB (hence -no-pie).
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "stm32f10x.h"
+#include "../../firmware/storage.h"
+#include "../../firmware/watchdog.h"
+
+#define EE_SIZE			8192
+#define EE_PAGE			32
+#define EE_WRITE_US		5000
+#define BYTE_US			45		// 9 clocks at 200kHz
+#define COND_US			5		// START or STOP
+#define TICK_US			500
+#define STORM_LIMIT		1000	// Interrupts without time moving on
+
+// Driver interrupt handlers
+void I2C1_EV_IRQHandler(void);
+void I2C1_ER_IRQHandler(void);
+void DMA1_Channel6_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
+void TIM7_IRQHandler(void);
+
+// SR1 / SR2 bits
+#define SR1_SB		0x0001
+#define SR1_ADDR	0x0002
+#define SR1_BTF		0x0004
+#define SR1_TXE		0x0080
+#define SR1_BERR	0x0100
+#define SR1_AF		0x0400
+#define SR1_ERRORS	0x4F00
+#define SR2_MSL		0x0001
+#define SR2_BUSY	0x0002
+#define SR2_TRA		0x0004
+
+#define SCL			GPIO_Pin_6
+#define SDA			GPIO_Pin_7
+
+typedef enum { OP_START, OP_STOP, OP_ADDR, OP_BYTE, OP_DMA_TX, OP_DMA_RX } Op;
+
+typedef struct {
+	bool enabled;
+	uint8_t *mem;
+	uint16_t count;
+	bool tc;
+} Dma;
+
+static I2C_TypeDef i2c1_regs;
+static GPIO_TypeDef gpiob_regs;
+static DMA_Channel_TypeDef dma6_regs, dma7_regs;
+static TIM_TypeDef tim7_regs;
+I2C_TypeDef *I2C1 = &i2c1_regs;
+GPIO_TypeDef *GPIOB = &gpiob_regs;
+DMA_Channel_TypeDef *DMA1_Channel6 = &dma6_regs, *DMA1_Channel7 = &dma7_regs;
+TIM_TypeDef *TIM7 = &tim7_regs;
+
+// Heartbeats set by the driver (watchdog.h)
+volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+
+static pthread_mutex_t lock;
+static volatile bool quit;
+static uint64_t now;
+
+// Fault rates, per thousand
+static int rate_nack, rate_berr, rate_stuck, rate_lost;
+
+// I2C block and bus
+static bool i2c_on, evt_it, err_it;
+static uint16_t sr1, sr2;
+static struct { Op op; uint8_t data; } fifo[8];
+static int fifo_n;
+static uint64_t fifo_end;
+static GPIOMode_TypeDef pin_mode = GPIO_Mode_AF_OD;
+static uint16_t pin_out = SCL | SDA;
+
+static Dma dma6, dma7;
+
+static bool tim_on, tim_pending;
+static uint64_t tim_next;
+
+// 24C64
+static uint8_t ee[EE_SIZE];
+static uint16_t ee_ptr;
+static int ee_mode;			// 0 idle, 1 receiving a write, 2 sending
+static int ee_addr_bytes;
+static uint8_t ee_page[EE_PAGE];
+static bool ee_page_set[EE_PAGE];
+static uint64_t ee_busy_until;
+static int stuck;			// SCL pulses before SDA is released
+
+// Statistics
+static unsigned long n_pages, n_polls, n_nack, n_berr, n_stuck, n_lost, n_recover, n_irq;
+
+static bool fault(int rate)
+{
+	return rate && rand() % 1000 < rate;
+}
+
+static unsigned duration(Op op)
+{
+	return (op == OP_START || op == OP_STOP) ? COND_US : BYTE_US;
+}
+
+static void push(Op op, uint8_t data)
+{
+	if (fifo_n == (int) (sizeof(fifo) / sizeof(fifo[0]))) {
+		fprintf(stderr, "eesim: bus request overflow\n");
+		exit(2);
+	}
+	if (fifo_n == 0)
+		fifo_end = now + duration(op);
+	fifo[fifo_n].op = op;
+	fifo[fifo_n].data = data;
+	fifo_n++;
+}
+
+static void flush(bool dma_only)
+{
+	int i, n = 0;
+	bool head_kept = false;
+
+	for (i = 0; i < fifo_n; i++) {
+		if (dma_only && fifo[i].op != OP_DMA_TX && fifo[i].op != OP_DMA_RX) {
+			if (i == 0)
+				head_kept = true;
+			fifo[n++] = fifo[i];
+		}
+	}
+	if (n && !head_kept)
+		fifo_end = now + duration(fifo[0].op);
+	fifo_n = n;
+}
+
+static void ee_receive(uint8_t b)
+{
+	if (ee_mode != 1)
+		return;
+	if (ee_addr_bytes < 2) {
+		ee_ptr = ((ee_ptr << 8) | b) % EE_SIZE;
+		ee_addr_bytes++;
+		return;
+	}
+	// Writes wrap around within the page
+	ee_page[ee_ptr % EE_PAGE] = b;
+	ee_page_set[ee_ptr % EE_PAGE] = true;
+	ee_ptr = (ee_ptr & ~(EE_PAGE - 1)) | ((ee_ptr + 1) % EE_PAGE);
+}
+
+static void ee_stop(void)
+{
+	int i;
+	bool any = false;
+
+	if (ee_mode == 1) {
+		for (i = 0; i < EE_PAGE; i++) {
+			if (ee_page_set[i]) {
+				ee[(ee_ptr & ~(EE_PAGE - 1)) + i] = ee_page[i];
+				any = true;
+			}
+		}
+		if (any) {
+			ee_busy_until = now + EE_WRITE_US;
+			n_pages++;
+		}
+	}
+	memset(ee_page_set, 0, sizeof(ee_page_set));
+	ee_mode = 0;
+}
+
+/* A bus operation has finished. */
+static void complete(void)
+{
+	Op op = fifo[0].op;
+	uint8_t data = fifo[0].data;
+
+	memmove(fifo, fifo + 1, --fifo_n * sizeof(fifo[0]));
+	if (fifo_n)
+		fifo_end = now + duration(fifo[0].op);
+
+	switch (op) {
+	case OP_START:
+		sr1 |= SR1_SB;
+		sr2 |= SR2_MSL | SR2_BUSY;
+		// A repeated START turns a write into a random read
+		memset(ee_page_set, 0, sizeof(ee_page_set));
+		ee_mode = 0;
+		break;
+
+	case OP_STOP:
+		ee_stop();
+		sr1 &= SR1_ERRORS;
+		sr2 = stuck ? SR2_BUSY : 0;
+		break;
+
+	case OP_ADDR:
+		if (fault(rate_lost)) {
+			n_lost++;
+			break;
+		}
+		if (now < ee_busy_until) {
+			n_polls++;
+			sr1 |= SR1_AF;
+			break;
+		}
+		if (fault(rate_nack)) {
+			n_nack++;
+			sr1 |= SR1_AF;
+			break;
+		}
+		sr1 |= SR1_ADDR;
+		if (data == I2C_Direction_Transmitter) {
+			sr1 |= SR1_TXE;
+			sr2 |= SR2_TRA;
+			ee_mode = 1;
+			ee_addr_bytes = 0;
+		} else {
+			sr2 &= ~SR2_TRA;
+			ee_mode = 2;
+		}
+		break;
+
+	case OP_BYTE:
+	case OP_DMA_TX:
+		if (fault(rate_berr)) {
+			n_berr++;
+			sr1 |= SR1_BERR;
+			ee_mode = 0;
+			flush(true);
+			break;
+		}
+		if (op == OP_DMA_TX) {
+			if (!dma6.enabled)
+				break;
+			data = *dma6.mem++;
+			if (--dma6.count == 0)
+				dma6.tc = true;
+			else
+				push(OP_DMA_TX, 0);
+		}
+		ee_receive(data);
+		if (fifo_n == 0)
+			sr1 |= SR1_TXE | SR1_BTF;
+		break;
+
+	case OP_DMA_RX:
+		if (!dma7.enabled || ee_mode != 2)
+			break;
+		if (fault(rate_stuck)) {
+			// Reset mid byte, the EEPROM keeps driving SDA
+			n_stuck++;
+			stuck = 1 + rand() % 9;
+			sr2 |= SR2_BUSY;
+			flush(false);
+			break;
+		}
+		*dma7.mem++ = ee[ee_ptr];
+		ee_ptr = (ee_ptr + 1) % EE_SIZE;
+		if (--dma7.count == 0)
+			dma7.tc = true;
+		else
+			push(OP_DMA_RX, 0);
+		break;
+	}
+}
+
+/* Interrupt controller and clock: runs the driver's handlers. */
+static void *hardware(void *arg)
+{
+	unsigned storm = 0;
+
+	(void) arg;
+	while (!quit) {
+		bool irq = true;
+
+		pthread_mutex_lock(&lock);
+		if (tim_pending) {
+			tim_pending = false;
+			TIM7_IRQHandler();
+		} else if (dma6.tc) {
+			DMA1_Channel6_IRQHandler();
+		} else if (dma7.tc) {
+			DMA1_Channel7_IRQHandler();
+		} else if (i2c_on && err_it && (sr1 & SR1_ERRORS)) {
+			I2C1_ER_IRQHandler();
+		} else if (i2c_on && evt_it && (sr1 & (SR1_SB | SR1_ADDR | SR1_BTF))) {
+			I2C1_EV_IRQHandler();
+		} else {
+			irq = false;
+		}
+
+		if (irq) {
+			n_irq++;
+			if (++storm > STORM_LIMIT) {
+				fprintf(stderr, "eesim: interrupt storm, SR1 %04x SR2 %04x\n", sr1, sr2);
+				exit(2);
+			}
+			pthread_mutex_unlock(&lock);
+			continue;
+		}
+		storm = 0;
+
+		if (fifo_n || tim_on) {
+			uint64_t next = fifo_n ? fifo_end : UINT64_MAX;
+			if (tim_on && tim_next < next)
+				next = tim_next;
+			now = next;
+			if (tim_on && now >= tim_next) {
+				tim_pending = true;
+				tim_next += TICK_US;
+			}
+			if (fifo_n && now >= fifo_end)
+				complete();
+			pthread_mutex_unlock(&lock);
+		} else {
+			pthread_mutex_unlock(&lock);
+			sched_yield();
+		}
+	}
+	return 0;
+}
+
+/******************************************************************************
+ * Peripheral library
+ */
+
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state) { (void) periph; (void) state; }
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void) periph; (void) state; }
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state) { (void) periph; (void) state; }
+void NVIC_Init(NVIC_InitTypeDef *init) { (void) init; }
+
+void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+	pthread_mutex_lock(&lock);
+	if (irq == TIM7_IRQn)
+		tim_pending = true;
+	pthread_mutex_unlock(&lock);
+}
+
+void GPIO_StructInit(GPIO_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+
+void GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init)
+{
+	(void) gpio;
+	if (init->GPIO_Mode == GPIO_Mode_Out_OD && pin_mode != GPIO_Mode_Out_OD)
+		n_recover++;
+	pin_mode = init->GPIO_Mode;
+}
+
+void GPIO_SetBits(GPIO_TypeDef *gpio, uint16_t pins)
+{
+	(void) gpio;
+	// A rising SCL clocks one bit out of a stuck EEPROM
+	if (pin_mode == GPIO_Mode_Out_OD && (pins & SCL) && !(pin_out & SCL) && stuck)
+		stuck--;
+	pin_out |= pins;
+}
+
+void GPIO_ResetBits(GPIO_TypeDef *gpio, uint16_t pins)
+{
+	(void) gpio;
+	pin_out &= ~pins;
+}
+
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef *gpio, uint16_t pin)
+{
+	(void) gpio;
+	if (pin == SDA && stuck)
+		return 0;
+	return (pin_out & pin) ? 1 : 0;
+}
+
+void I2C_DeInit(I2C_TypeDef *i2c)
+{
+	(void) i2c;
+	i2c_on = evt_it = err_it = false;
+	flush(false);
+	sr1 = 0;
+	sr2 = stuck ? SR2_BUSY : 0;
+	ee_mode = 0;
+}
+
+void I2C_StructInit(I2C_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void I2C_Init(I2C_TypeDef *i2c, I2C_InitTypeDef *init) { (void) i2c; (void) init; }
+
+void I2C_Cmd(I2C_TypeDef *i2c, FunctionalState state)
+{
+	if (state)
+		i2c_on = true;
+	else
+		I2C_DeInit(i2c);
+}
+
+void I2C_ITConfig(I2C_TypeDef *i2c, uint16_t it, FunctionalState state)
+{
+	(void) i2c;
+	if (it & I2C_IT_EVT)
+		evt_it = state;
+	if (it & I2C_IT_ERR)
+		err_it = state;
+	if (it & I2C_IT_BUF) {
+		fprintf(stderr, "eesim: buffer interrupts are not modelled\n");
+		exit(2);
+	}
+}
+
+void I2C_DMACmd(I2C_TypeDef *i2c, FunctionalState state) { (void) i2c; (void) state; }
+void I2C_DMALastTransferCmd(I2C_TypeDef *i2c, FunctionalState state) { (void) i2c; (void) state; }
+void I2C_AcknowledgeConfig(I2C_TypeDef *i2c, FunctionalState state) { (void) i2c; (void) state; }
+
+void I2C_GenerateSTART(I2C_TypeDef *i2c, FunctionalState state)
+{
+	(void) i2c;
+	if (!state || !i2c_on)
+		return;
+	sr1 &= ~(SR1_BTF | SR1_TXE);
+	// The bus never looks free while SDA is held low
+	if (!stuck)
+		push(OP_START, 0);
+}
+
+void I2C_GenerateSTOP(I2C_TypeDef *i2c, FunctionalState state)
+{
+	(void) i2c;
+	if (!state || !i2c_on)
+		return;
+	sr1 &= ~(SR1_BTF | SR1_TXE);
+	push(OP_STOP, 0);
+}
+
+void I2C_Send7bitAddress(I2C_TypeDef *i2c, uint8_t address, uint8_t direction)
+{
+	(void) i2c;
+	(void) address;
+	sr1 &= ~SR1_SB;
+	push(OP_ADDR, direction);
+}
+
+void I2C_SendData(I2C_TypeDef *i2c, uint8_t data)
+{
+	(void) i2c;
+	sr1 &= ~(SR1_TXE | SR1_BTF);
+	push(OP_BYTE, data);
+}
+
+uint32_t I2C_GetLastEvent(I2C_TypeDef *i2c)
+{
+	uint32_t event = sr1 | ((uint32_t) sr2 << 16);
+
+	(void) i2c;
+	// Reading SR1 then SR2 clears ADDR
+	sr1 &= ~SR1_ADDR;
+	return event;
+}
+
+FlagStatus I2C_GetFlagStatus(I2C_TypeDef *i2c, uint32_t flag)
+{
+	(void) i2c;
+	if (flag & 0x10000000)
+		return (sr1 & flag & 0xFFFF) ? SET : RESET;
+	return (sr2 & (flag >> 16)) ? SET : RESET;
+}
+
+void I2C_ClearFlag(I2C_TypeDef *i2c, uint32_t flag)
+{
+	(void) i2c;
+	sr1 &= ~(flag & SR1_ERRORS);
+}
+
+static Dma *dma(DMA_Channel_TypeDef *ch)
+{
+	return ch == DMA1_Channel6 ? &dma6 : &dma7;
+}
+
+void DMA_DeInit(DMA_Channel_TypeDef *ch) { memset(dma(ch), 0, sizeof(Dma)); }
+void DMA_StructInit(DMA_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state) { (void) ch; (void) it; (void) state; }
+void DMA_ClearITPendingBit(uint32_t it) { (void) it; }
+
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init)
+{
+	Dma *d = dma(ch);
+
+	if ((ch == DMA1_Channel6) != (init->DMA_DIR == DMA_DIR_PeripheralDST)) {
+		fprintf(stderr, "eesim: DMA direction does not match the channel\n");
+		exit(2);
+	}
+	d->mem = (uint8_t*) (uintptr_t) init->DMA_MemoryBaseAddr;
+	d->count = init->DMA_BufferSize;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state)
+{
+	Dma *d = dma(ch);
+
+	if (state && !d->enabled && d->count) {
+		if (ch == DMA1_Channel6) {
+			sr1 &= ~(SR1_BTF | SR1_TXE);
+			push(OP_DMA_TX, 0);
+		} else {
+			push(OP_DMA_RX, 0);
+		}
+	}
+	if (!state && d->enabled)
+		flush(true);
+	d->enabled = state;
+}
+
+void DMA_ClearFlag(uint32_t flag)
+{
+	if (flag & DMA1_FLAG_TC6)
+		dma6.tc = false;
+	if (flag & DMA1_FLAG_TC7)
+		dma7.tc = false;
+}
+
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch)
+{
+	return dma(ch)->count;
+}
+
+void TIM_DeInit(TIM_TypeDef *tim) { (void) tim; tim_on = tim_pending = false; }
+void TIM_TimeBaseStructInit(TIM_TimeBaseInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init) { (void) tim; (void) init; }
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state) { (void) tim; (void) it; (void) state; }
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it) { (void) tim; (void) it; }
+
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state)
+{
+	(void) tim;
+	pthread_mutex_lock(&lock);
+	if (state && !tim_on)
+		tim_next = now + TICK_US;
+	tim_on = state;
+	pthread_mutex_unlock(&lock);
+}
+
+/******************************************************************************
+ * Test
+ */
+
+static unsigned long ops = 20000;
+static uint8_t ref[EE_SIZE];
+static uint8_t buf[128];
+static unsigned long n_reads, n_read_fail, n_writes, n_write_fail, n_mismatch;
+
+static void *application(void *arg)
+{
+	unsigned long i;
+
+	(void) arg;
+	storage_init();
+	for (i = 0; i < ops; i++) {
+		uint16_t len = 1 + rand() % 96;
+		uint16_t off = rand() % (EE_SIZE - len);
+		uint16_t j;
+
+		if (rand() & 1) {
+			for (j = 0; j < len; j++)
+				buf[j] = rand();
+			n_writes++;
+			if (storage_write(off, len, buf)) {
+				memcpy(ref + off, buf, len);
+			} else {
+				// Part of it may have made it, take what is there.
+				n_write_fail++;
+				pthread_mutex_lock(&lock);
+				memcpy(ref + off, ee + off, len);
+				pthread_mutex_unlock(&lock);
+			}
+		} else {
+			unsigned long recovered = n_recover;
+
+			n_reads++;
+			storage_read(off, len, buf);
+			if (memcmp(buf, ref + off, len) == 0)
+				continue;
+			// The driver gives up after a second timeout in one transaction
+			if (n_recover - recovered >= 2) {
+				n_read_fail++;
+			} else {
+				n_mismatch++;
+				fprintf(stderr, "read %u+%u does not match\n", off, len);
+			}
+		}
+	}
+	quit = true;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_mutexattr_t attr;
+	pthread_attr_t app_attr;
+	pthread_t hw, app;
+	size_t stack_size = 1 << 20;
+	void *stack;
+
+	if (argc > 1) ops = strtoul(argv[1], 0, 0);
+	if (argc > 2) rate_nack = atoi(argv[2]);
+	if (argc > 3) rate_berr = atoi(argv[3]);
+	if (argc > 4) rate_stuck = atoi(argv[4]);
+	if (argc > 5) rate_lost = atoi(argv[5]);
+
+	memset(ee, 0xFF, sizeof(ee));
+	memset(ref, 0xFF, sizeof(ref));
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&lock, &attr);
+
+	stack = mmap(0, stack_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+	if (stack == MAP_FAILED) {
+		perror("mmap");
+		return 2;
+	}
+	pthread_attr_init(&app_attr);
+	pthread_attr_setstack(&app_attr, stack, stack_size);
+
+	pthread_create(&hw, 0, hardware, 0);
+	pthread_create(&app, &app_attr, application, 0);
+	pthread_join(app, 0);
+	pthread_join(hw, 0);
+
+	printf("%lu reads (%lu failed), %lu writes (%lu failed), %lu mismatches\n",
+			n_reads, n_read_fail, n_writes, n_write_fail, n_mismatch);
+	printf("%lu pages, %lu polls, %lu interrupts, %.1fs simulated\n",
+			n_pages, n_polls, n_irq, now / 1e6);
+	printf("faults: %lu nack, %lu berr, %lu stuck, %lu lost, %lu bus recoveries\n",
+			n_nack, n_berr, n_stuck, n_lost, n_recover);
+	return n_mismatch != 0;
+}
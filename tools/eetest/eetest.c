@@ -0,0 +1,522 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host test of the model store (firmware/eeprom.c and modelimg.c) on the
+ * RAM storage backend.
+ *
+ * eeprom.c is included so a simulated reboot can reset its state. The
+ * storage is kept over it, storage_init() is wrapped so eeprom_init()
+ * does not wipe it. storage_write() is wrapped to cut the
+ * power after a given number of writes, leaving the last one torn.
+ *
+ * Covers saving and loading models across a reboot, compaction of a
+ * fragmented pool, a save refused when the pool is full and random edits
+ * with power cuts, after which each model must be as before or after the
+ * edit. Settings and models in the old fixed-slot layout are converted,
+ * with the power cut after every write in turn, and must come out the
+ * same once the conversion has been finished by a second power on.
+ *
+ * Build:  cc -funsigned-char -DSTORAGE_BACKEND=STORAGE_RAM -I../../firmware
+ *             -Wl,--wrap=storage_init,--wrap=storage_write -o eetest eetest.c
+ *             ../../firmware/modelimg.c ../../firmware/storage_ram.c
+ * Usage:  eetest [rounds] [seed]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <setjmp.h>
+
+#include "eeprom.c"
+
+void __real_storage_init(void);
+bool __real_storage_write(uint16_t offset, uint16_t length, const void *buffer);
+
+volatile EEGeneral g_eeGeneral;
+volatile ModelData g_model;
+volatile uint8_t g_modelInvalid;
+volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+
+static int popups[256];
+static long writes_left = -1;		// Storage writes until the power cut, -1 = none
+static jmp_buf power_cut;
+static ModelData stored[MAX_MODELS];	// What each slot should read back as
+static int failures;
+
+/*
+ * Firmware stubs
+ */
+
+void __wrap_storage_init(void)
+{
+}
+
+bool __wrap_storage_write(uint16_t offset, uint16_t length, const void *buffer)
+{
+	if (writes_left == 0)
+	{
+		__real_storage_write(offset, rand() % (length + 1), buffer);
+		longjmp(power_cut, 1);
+	}
+	if (writes_left > 0)
+		writes_left--;
+	return __real_storage_write(offset, length, buffer);
+}
+
+void gui_popup(GUI_MSG msg, int16_t timeout)
+{
+	popups[msg]++;
+}
+
+GUI_LAYOUT gui_get_layout(void)
+{
+	return GUI_LAYOUT_MAIN1;
+}
+
+void task_register(Tasks task, void (*fn)(uint32_t))
+{
+}
+
+void task_schedule(Tasks task, uint32_t data, uint32_t time_ms)
+{
+}
+
+void lcd_set_cursor(uint8_t x, uint8_t y)
+{
+}
+
+void lcd_write_char(uint8_t c, LCD_OP op, uint16_t flags)
+{
+}
+
+void lcd_update(void)
+{
+}
+
+bool mixer_trim_pending(void)
+{
+	return false;
+}
+
+void mixer_hold_model(bool hold)
+{
+}
+
+/*
+ * Helpers
+ */
+
+static void fail(const char *test, const char *what, int model)
+{
+	if (failures++ >= 10)
+		return;
+	if (model < 0)
+		printf("eetest: %s: %s\n", test, what);
+	else
+		printf("eetest: %s: model %d %s\n", test, model, what);
+}
+
+/**
+  * @brief  Power on, the storage is kept.
+  */
+static void boot(void)
+{
+	currModel = 0xFF;
+	memset((void*) &g_eeGeneral, 0, sizeof(g_eeGeneral));
+	memset((void*) &g_model, 0, sizeof(g_model));
+	eeprom_init();
+}
+
+/**
+  * @brief  Blank storage and a fresh start.
+  */
+static void wipe(void)
+{
+	uint8_t m;
+
+	__real_storage_init();
+	boot();
+	for (m = 0; m < MAX_MODELS; m++)
+		eeprom_read_model_data(m, 0, sizeof(stored[m]), &stored[m]);
+}
+
+/**
+  * @brief  Select a model and let the eeprom task load it.
+  */
+static void select_model(uint8_t model)
+{
+	g_eeGeneral.currModel = model;
+	eeprom_process(0);
+}
+
+/**
+  * @brief  Change g_model, the more changes the longer its image.
+  */
+static void edit_model(uint8_t model, uint16_t changes)
+{
+	while (changes--)
+		((uint8_t*) &g_model)[rand() % offsetof(ModelData, chkSum)] = rand();
+	g_model.name[0] = 'a' + model % 26;
+	g_model.name[MODEL_NAME_LEN-1] = 0;
+}
+
+/**
+  * @brief  Save g_model through the eeprom task.
+  * @retval true if the save went through, no popup
+  */
+static bool save_model(uint8_t model)
+{
+	int full = popups[GUI_MSG_EEPROM_FULL];
+	int write = popups[GUI_MSG_EEPROM_WRITE];
+
+	eeprom_process(0);
+	if (popups[GUI_MSG_EEPROM_FULL] != full || popups[GUI_MSG_EEPROM_WRITE] != write)
+		return false;
+	memcpy(&stored[model], (void*) &g_model, sizeof(stored[model]));
+	return true;
+}
+
+/**
+  * @brief  Check every slot reads back as expected.
+  */
+static void check_models(const char *test)
+{
+	ModelData got;
+	uint8_t m;
+
+	for (m = 0; m < MAX_MODELS; m++)
+	{
+		eeprom_read_model_data(m, 0, sizeof(got), &got);
+		if (memcmp(&got, &stored[m], sizeof(got)))
+			fail(test, "reads back wrong", m);
+	}
+}
+
+static uint16_t image_length(uint8_t model)
+{
+	return eeprom_read_model_image(model, 0, 0, 0);
+}
+
+/*
+ * Tests
+ */
+
+/**
+  * @brief  Models saved, then loaded after a reboot.
+  */
+static void test_save_load(void)
+{
+	uint8_t m;
+
+	wipe();
+	for (m = 0; m < MAX_MODELS; m += 3)
+	{
+		select_model(m);
+		edit_model(m, 1 + rand() % 40);
+		if (!save_model(m))
+			fail("save/load", "not saved", m);
+	}
+	boot();
+	check_models("save/load");
+
+	// Loaded into g_model as the firmware does.
+	for (m = 0; m < MAX_MODELS; m++)
+	{
+		g_eeGeneral.currModel = m;
+		eeprom_load_current_model();
+		if (memcmp((void*) &g_model, &stored[m], sizeof(g_model)) && image_length(m))
+			fail("save/load", "loads wrong", m);
+	}
+}
+
+/**
+  * @brief  Fill the pool with models the same size, until full.
+  * @retval number of models saved
+  */
+static uint8_t fill_pool(const char *test, uint16_t changes)
+{
+	uint8_t m;
+
+	wipe();
+	for (m = 0; m < MAX_MODELS; m++)
+	{
+		select_model(m);
+		edit_model(m, changes);
+		if (!save_model(m))
+			break;
+	}
+	if (m == 0 || m == MAX_MODELS)
+		fail(test, "pool not filled", m);
+	return m;
+}
+
+/**
+  * @brief  A model only fits once the models are packed together.
+  */
+static void test_compaction(void)
+{
+	uint8_t count = fill_pool("compaction", 100);
+	uint8_t m, big = count;
+	ModelImgEncoder enc;
+	ModelData image;
+	uint16_t length = 0;
+
+	if (count == MAX_MODELS)
+		return;
+	// Every other model goes, leaving gaps of one image each.
+	for (m = 0; m < count; m += 2)
+	{
+		eeprom_model_image_clear(m);
+		eeprom_read_model_data(m, 0, sizeof(stored[m]), &stored[m]);
+	}
+
+	select_model(big);
+	edit_model(big, 400);
+
+	// Measured as eeprom_save_model() does, with the checksum it will get.
+	memcpy(&image, (void*) &g_model, sizeof(image));
+	image.chkSum = eeprom_calc_chksum(&image, sizeof(image) - 2);
+	modelimg_encode_start(&enc, model_put_count, &length);
+	modelimg_encode(&enc, (const uint8_t*) &image, sizeof(image));
+	modelimg_encode_end(&enc);
+	if (model_find_space(PAGES(length)) >= 0)
+		fail("compaction", "fits a gap, compaction not tested", big);
+
+	if (!save_model(big))
+		fail("compaction", "not saved", big);
+	boot();
+	check_models("compaction");
+}
+
+/**
+  * @brief  A save that does not fit keeps the old copy.
+  */
+static void test_pool_full(void)
+{
+	uint8_t count = fill_pool("pool full", 100);
+	int full = popups[GUI_MSG_EEPROM_FULL];
+	uint8_t m = count / 2;
+
+	if (count == MAX_MODELS)
+		return;
+	select_model(m);
+	edit_model(m, 400);
+	if (save_model(m))
+		fail("pool full", "saved, pool not full", m);
+	if (popups[GUI_MSG_EEPROM_FULL] == full)
+		fail("pool full", "no popup", m);
+	check_models("pool full");
+	boot();
+	check_models("pool full");
+}
+
+/**
+  * @brief  Random edits, the power cut at random during the save.
+  */
+static void test_power_cuts(long rounds)
+{
+	ModelData before, after;
+	long round;
+
+	wipe();
+	for (round = 0; round < rounds; round++)
+	{
+		uint8_t m = rand() % MAX_MODELS;
+
+		select_model(m);
+		memcpy(&before, &stored[m], sizeof(before));
+		edit_model(m, rand() % (rand() % 8 ? 32 : 300));
+		memcpy(&after, (void*) &g_model, sizeof(after));
+		after.chkSum = eeprom_calc_chksum(&after, sizeof(after) - 2);
+
+		writes_left = rand() % 4 ? -1 : rand() % 12;
+		if (setjmp(power_cut) == 0)
+			save_model(m);
+		writes_left = -1;
+
+		boot();
+		// Either copy is fine, whichever it is must stay.
+		eeprom_read_model_data(m, 0, sizeof(stored[m]), &stored[m]);
+		if (memcmp(&stored[m], &before, sizeof(before)) && memcmp(&stored[m], &after, sizeof(after)))
+			fail("power cuts", "neither old nor new", m);
+		check_models("power cuts");
+	}
+}
+
+/**
+  * @brief  Settings as the old layout stored them, no calLin, recorderRate
+  *         or stickDeadband.
+  */
+static void legacy_put_general(const EEGeneral *g)
+{
+	const uint8_t *src = (const uint8_t*) g;
+	const uint16_t cal = offsetof(EEGeneral, calLin);
+	uint8_t old[LEGACY_GENERAL_SIZE];
+	uint16_t length = 0, chksum;
+
+	memcpy(&old[length], src, cal);
+	length += cal;
+	memcpy(&old[length], src + cal + sizeof(g->calLin), offsetof(EEGeneral, recorderRate) - cal - sizeof(g->calLin));
+	length += offsetof(EEGeneral, recorderRate) - cal - sizeof(g->calLin);
+	chksum = eeprom_calc_chksum(old, length);
+	memcpy(&old[length], &chksum, sizeof(chksum));
+	__real_storage_write(0, sizeof(old), old);
+}
+
+/**
+  * @brief  A model as the old layout stored it, int8_t trims and no failsafe.
+  */
+static void legacy_put_model(uint8_t slot, const ModelData *m, const int8_t *trims)
+{
+	const uint8_t *src = (const uint8_t*) m;
+	const uint16_t tail = offsetof(ModelData, failsafe) + sizeof(m->failsafe);
+	uint8_t old[LEGACY_MODEL_SIZE];
+	uint16_t length = 0, chksum;
+
+	memcpy(&old[length], src, offsetof(ModelData, trim));
+	length += offsetof(ModelData, trim);
+	memcpy(&old[length], trims, 4);
+	length += 4;
+	memcpy(&old[length], src + offsetof(ModelData, curves5), offsetof(ModelData, failsafe) - offsetof(ModelData, curves5));
+	length += offsetof(ModelData, failsafe) - offsetof(ModelData, curves5);
+	memcpy(&old[length], src + tail, sizeof(ModelData) - 2 - tail);
+	length += sizeof(ModelData) - 2 - tail;
+	chksum = eeprom_calc_chksum(old, length);
+	memcpy(&old[length], &chksum, sizeof(chksum));
+	__real_storage_write(LEGACY_MODEL_ADDR(slot), sizeof(old), old);
+}
+
+/**
+  * @brief  Old layout settings and models, converted with the power cut
+  *         after each write in turn.
+  */
+static void test_legacy(void)
+{
+	static const uint8_t slots[] = { 0, 2, 7, LEGACY_MODELS - 1 };
+	static uint8_t old[EEPROM_SIZE];
+	EEGeneral general, want_general;
+	ModelData want[sizeof(slots)];
+	int failed = failures;
+	long cut;
+	uint8_t i, n;
+
+	// Stick mode 1 puts the throttle on stick 1.
+	memset(&general, 0, sizeof(general));
+	strcpy(general.ownerName, "legacy");
+	general.currModel = 2;
+	general.contrast = (LCD_CONTRAST_MIN + LCD_CONTRAST_MAX) / 2;
+	general.vBatCalib = 100;
+	general.stickMode = 1;
+	general.throttleReversed = 1;
+	memcpy(&want_general, &general, sizeof(want_general));
+	want_general.recorderRate = RECORDER_DEFAULT_RATE;
+	want_general.chkSum = eeprom_calc_chksum(&want_general, sizeof(want_general) - 2);
+
+	__real_storage_init();
+	legacy_put_general(&general);
+	for (n = 0; n < sizeof(slots); n++)
+	{
+		ModelData m;
+		int8_t trims[4] = { 125, -125, 40, -7 };
+
+		memcpy(&m, &g_modelDefaults, sizeof(m));
+		memset(m.failsafe, 0x5A, sizeof(m.failsafe));
+		for (i = 0; i < 20; i++)
+			((uint8_t*) &m)[offsetof(ModelData, curves5) + rand() % (offsetof(ModelData, failsafe) - offsetof(ModelData, curves5))] = rand();
+		m.name[0] = 'A' + n;
+		m.thrTrim = n & 1;
+		m.trimInc = n == 2 ? 7 : TRIM_INC_COARSE;
+		legacy_put_model(slots[n], &m, trims);
+
+		// Ordinary trims doubled, the throttle idle trim four times to
+		// keep the idle point.
+		memcpy(&want[n], &m, sizeof(want[n]));
+		want[n].trim[0] = 250;
+		want[n].trim[1] = m.thrTrim ? -500 : -250;
+		want[n].trim[2] = 80;
+		want[n].trim[3] = -14;
+		if (n == 2)
+			want[n].trimInc = g_modelDefaults.trimInc;
+		memcpy(want[n].failsafe, g_modelDefaults.failsafe, sizeof(want[n].failsafe));
+		want[n].chkSum = eeprom_calc_chksum(&want[n], sizeof(want[n]) - 2);
+	}
+	storage_read(0, sizeof(old), old);
+
+	for (cut = 0; ; cut++)
+	{
+		char test[32];
+		bool done = false;
+
+		snprintf(test, sizeof(test), "legacy, cut after %ld", cut);
+		__real_storage_init();
+		__real_storage_write(0, sizeof(old), old);
+		writes_left = cut;
+		if (setjmp(power_cut) == 0)
+		{
+			boot();
+			done = true;
+		}
+		writes_left = -1;
+		if (!done)
+			boot();
+
+		if (model_index.legacy)
+			fail(test, "conversion not finished", -1);
+		if (memcmp((void*) &g_eeGeneral, &want_general, sizeof(want_general)))
+			fail(test, "settings differ", -1);
+		for (i = n = 0; i < MAX_MODELS; i++)
+		{
+			ModelData got;
+
+			if (n < sizeof(slots) && i == slots[n])
+			{
+				eeprom_read_model_data(i, 0, sizeof(got), &got);
+				if (memcmp(&got, &want[n], sizeof(got)))
+					fail(test, "differs", i);
+				n++;
+			}
+			else if (image_length(i))
+				fail(test, "where there was none", i);
+		}
+		if (done || failures != failed)
+			break;
+	}
+	if (cut < 10 && failures == failed)
+		fail("legacy", "too few writes to cut", -1);
+}
+
+int main(int argc, char **argv)
+{
+	long rounds = argc > 1 ? atol(argv[1]) : 5000;
+
+	srand(argc > 2 ? atoi(argv[2]) : 1);
+
+	test_save_load();
+	test_compaction();
+	test_pool_full();
+	test_power_cuts(rounds);
+	test_legacy();
+
+	if (failures)
+	{
+		printf("eetest: %d failures\n", failures);
+		return 1;
+	}
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,134 @@
+#
+#                  Copyright 2014 ARTaylor.co.uk
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+
+# Description:
+#
+# Flash used by the firmware image, from the GNU ld map file, checked
+# against the pages firmware/storage_flash.c keeps for its log.
+# Counts every output section loaded into flash, including the initial
+# values of .data. ld gives .bss and the like a load address too, but
+# they take no flash.
+# Exits with 1 if the flash storage backend is linked in and the image
+# reaches STORAGE_FLASH_BASE.
+#
+# Run by the firmware build (all-local in firmware/Makefile.am), or:
+# Usage:  awk -f flashreport.awk firmware/storage_flash.c ar-t6-firmware.map
+#
+
+function hex(s,    v, i, c)
+{
+	v = 0
+	s = tolower(s)
+	sub(/^0x/, "", s)
+	for (i = 1; i <= length(s); i++) {
+		c = index("0123456789abcdef", substr(s, i, 1))
+		if (c == 0)
+			break
+		v = v * 16 + c - 1
+	}
+	return v
+}
+
+function number(s)
+{
+	return (s ~ /^0[xX]/) ? hex(s) : s + 0
+}
+
+# Output section at addr, size long, loaded at load (0 = addr).
+function place(name, addr, size, load)
+{
+	if (name ~ /^\.(bss|noinit|heap|stack)/ || name == "._user_heap_stack")
+		return
+	if (load == 0)
+		load = addr
+	size = hex(size)
+	load = hex(load)
+	if (size == 0 || load < FLASH_BASE || load >= FLASH_BASE + flash_size)
+		return
+	if (load + size > end) {
+		end = load + size
+		last = name
+	}
+}
+
+BEGIN {
+	FLASH_BASE = 134217728		# 0x08000000 on every STM32
+}
+
+# Layout from storage_flash.c
+FNR == NR {
+	if ($1 == "#define" && $2 == "STORAGE_FLASH_SIZE")
+		flash_size = number($3)
+	if ($1 == "#define" && $2 == "STORAGE_FLASH_PAGE_SIZE")
+		page_size = number($3)
+	if ($1 == "#define" && $2 == "STORAGE_FLASH_PAGES")
+		pages = number($3)
+	next
+}
+
+/^Linker script and memory map/ {
+	in_map = 1
+	next
+}
+
+!in_map {
+	next
+}
+
+# Output section name too long for one line, the rest follows.
+pending != "" {
+	if ($1 ~ /^0x/)
+		place(pending, $1, $2, ($3 == "load" && $4 == "address") ? $5 : 0)
+	pending = ""
+	next
+}
+
+/^\./ {
+	if (NF == 1)
+		pending = $1
+	else if ($2 ~ /^0x/)
+		place($1, $2, $3, ($4 == "load" && $5 == "address") ? $6 : 0)
+	next
+}
+
+# The backend is built in when its module has code.
+/^ \.text/ && /storage_flash\.o/ {
+	if (NF == 1) {
+		getline
+		size = $2
+	} else
+		size = $3
+	if (hex(size) != 0)
+		backend = 1
+}
+
+END {
+	if (!flash_size || !page_size || !pages) {
+		print "flashreport: no STORAGE_FLASH_SIZE / _PAGE_SIZE / _PAGES found" > "/dev/stderr"
+		exit 1
+	}
+
+	used = end - FLASH_BASE
+	limit = flash_size - pages * page_size
+	printf("Flash %d, image %d (ends with %s), storage log %d\n",
+			flash_size, used, last, flash_size - limit)
+	if (!backend) {
+		printf("Flash storage not built in, %d spare\n", flash_size - used)
+		exit 0
+	}
+	printf("Flash storage built in: image limit %d, %d spare\n", limit, limit - used)
+	if (used > limit) {
+		printf("flashreport: image is %d bytes into the storage log\n", used - limit) > "/dev/stderr"
+		exit 1
+	}
+}
@@ -0,0 +1,288 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host simulation of the flash storage backend (firmware/storage_flash.c).
+ *
+ * The log pages are an array mapped where the driver expects them, at the
+ * top of the 64KB flash from FLASH_BASE. A halfword can only be programmed
+ * when erased, or to 0, as on the STM32.
+ * The main run makes random writes through the normal storage API, checks
+ * every read against what was written and fails if a write is refused, if
+ * flash is programmed or erased with the PPM output running and not held,
+ * or if a write returns with the output still held.
+ *
+ * Then every write of the main run is repeated from the flash it started
+ * with, with a reset after each halfword it programs, and part way through
+ * each page it erases. After each reset the storage is brought up again,
+ * itself cut short by a second reset at a random point, and then once
+ * more. Every block must then read as before the write or as written, and
+ * the write must succeed when made again.
+ *
+ * Build:  cc -DSTORAGE_BACKEND=STORAGE_FLASH -I../hoststub -I../../firmware -o flashsim
+ *             flashsim.c ../../firmware/storage_flash.c
+ * Usage:  flashsim [writes] [seed]
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+
+#include "stm32f10x.h"
+#include "storage.h"
+#include "pulses.h"
+#include "watchdog.h"
+
+#define SIM_PAGE_SIZE	1024
+#define SIM_LOG_SIZE	8192		// STORAGE_FLASH_PAGES * STORAGE_FLASH_PAGE_SIZE
+#define SIM_LOG_ADDR	(FLASH_BASE + 0x10000 - SIM_LOG_SIZE)
+#define MAX_LENGTH		100
+
+volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+
+static uint16_t *flash;				// SIM_LOG_SIZE bytes at SIM_LOG_ADDR
+static bool unlocked;
+static long budget = -1;			// Flash operations until a reset, -1 = none
+static jmp_buf reset;
+static bool ppm_running;			// PPM output started, erases must hold it
+static bool ppm_held;
+static long gap_programs;			// Halfwords programmed in this hold
+static long programs, erases, running_erases, resets, holds, max_gap;
+
+typedef struct
+{
+	uint16_t offset;
+	uint16_t length;
+	uint8_t data[MAX_LENGTH];
+} Write;
+
+/**
+  * @brief  Stop the simulation.
+  */
+static void fail(const char *what, long write, long cut)
+{
+	printf("flashsim: %s (write %ld, reset after %ld)\n", what, write, cut);
+	exit(1);
+}
+
+/**
+  * @brief  Count a flash operation against the reset budget.
+  * @retval true if the reset comes now
+  */
+static bool flash_cut(void)
+{
+	if (budget < 0)
+		return false;
+	return --budget == 0;
+}
+
+void FLASH_Unlock(void)
+{
+	unlocked = true;
+}
+
+void FLASH_Lock(void)
+{
+	unlocked = false;
+}
+
+FLASH_Status FLASH_ProgramHalfWord(uint32_t address, uint16_t data)
+{
+	uint16_t *p = &flash[(address - SIM_LOG_ADDR) / 2];
+
+	if (!unlocked || address < SIM_LOG_ADDR || address >= SIM_LOG_ADDR + SIM_LOG_SIZE || (address & 1))
+		return FLASH_ERROR_WRP;
+	if (*p != 0xFFFF && data != 0)
+		return FLASH_ERROR_PG;
+	if (ppm_running && !ppm_held)
+		fail("halfword programmed with the PPM output running", -1, -1);
+	if (ppm_held && ++gap_programs > max_gap)
+		max_gap = gap_programs;
+	*p = data;
+	programs++;
+	if (flash_cut())
+		longjmp(reset, 1);
+	return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ErasePage(uint32_t address)
+{
+	uint16_t *p = &flash[(address - SIM_LOG_ADDR) / 2];
+
+	if (!unlocked || address < SIM_LOG_ADDR || address >= SIM_LOG_ADDR + SIM_LOG_SIZE ||
+			(address - SIM_LOG_ADDR) % SIM_PAGE_SIZE)
+		return FLASH_ERROR_WRP;
+	if (ppm_running && !ppm_held)
+		fail("page erased with the PPM output running", -1, -1);
+	if (flash_cut())
+	{
+		// Cut short, part of the page is erased.
+		memset(p, 0xFF, SIM_PAGE_SIZE / 3);
+		longjmp(reset, 1);
+	}
+	memset(p, 0xFF, SIM_PAGE_SIZE);
+	erases++;
+	if (ppm_running)
+		running_erases++;
+	return FLASH_COMPLETE;
+}
+
+bool pulses_hold(void)
+{
+	ppm_held = ppm_running;
+	gap_programs = 0;
+	if (ppm_held)
+		holds++;
+	return ppm_held;
+}
+
+void pulses_release(void)
+{
+	ppm_held = false;
+}
+
+/**
+  * @brief  Power on: bring the storage up before the PPM output starts.
+  */
+static void boot(void)
+{
+	ppm_running = false;
+	ppm_held = false;
+	storage_init();
+	ppm_running = true;
+}
+
+/**
+  * @brief  Check the storage against its contents before and after a write.
+  * @note	Each block must be wholly one or the other.
+  */
+static void check_blocks(const uint8_t *before, const Write *w, long write, long cut)
+{
+	static uint8_t got[STORAGE_SIZE];
+	uint8_t after[32];
+	uint16_t b;
+
+	storage_read(0, STORAGE_SIZE, got);
+	for (b = 0; b < STORAGE_SIZE / 32; b++)
+	{
+		uint16_t i;
+		memcpy(after, &before[b * 32], 32);
+		for (i = 0; i < 32; i++)
+		{
+			uint16_t a = b * 32 + i;
+			if (a >= w->offset && a < w->offset + w->length)
+				after[i] = w->data[a - w->offset];
+		}
+		if (memcmp(&got[b * 32], &before[b * 32], 32) && memcmp(&got[b * 32], after, 32))
+			fail("block neither old nor new", write, cut);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	long writes = argc > 1 ? atol(argv[1]) : 2000;
+	unsigned seed = argc > 2 ? atoi(argv[2]) : 1;
+	uint8_t (*flash_before)[SIM_LOG_SIZE];
+	uint8_t (*ref_before)[STORAGE_SIZE];
+	static uint8_t ref[STORAGE_SIZE], got[STORAGE_SIZE];
+	Write *w;
+	long i, cut;
+
+	flash = mmap((void*) (uintptr_t) SIM_LOG_ADDR, SIM_LOG_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	flash_before = malloc(writes * sizeof(*flash_before));
+	ref_before = malloc(writes * sizeof(*ref_before));
+	w = malloc(writes * sizeof(*w));
+	if (flash != (void*) (uintptr_t) SIM_LOG_ADDR || !flash_before || !ref_before || !w)
+	{
+		printf("flashsim: no memory for the flash array\n");
+		return 1;
+	}
+	srand(seed);
+
+	// Main run, a few values only so some writes change nothing.
+	memset(flash, 0xFF, SIM_LOG_SIZE);
+	memset(ref, 0xFF, sizeof(ref));
+	boot();
+	for (i = 0; i < writes; i++)
+	{
+		uint16_t n;
+
+		w[i].length = 1 + rand() % MAX_LENGTH;
+		w[i].offset = rand() % (STORAGE_SIZE - w[i].length + 1);
+		for (n = 0; n < w[i].length; n++)
+			w[i].data[n] = rand() % 4;
+		memcpy(flash_before[i], flash, SIM_LOG_SIZE);
+		memcpy(ref_before[i], ref, sizeof(ref));
+
+		if (!storage_write(w[i].offset, w[i].length, w[i].data))
+			fail("write refused", i, -1);
+		if (ppm_held)
+			fail("PPM output left held", i, -1);
+		memcpy(&ref[w[i].offset], w[i].data, w[i].length);
+		storage_read(0, STORAGE_SIZE, got);
+		if (memcmp(got, ref, sizeof(ref)))
+			fail("read back differs", i, -1);
+	}
+	printf("%ld writes, %ld halfwords programmed, %ld pages erased (%ld with PPM running)\n",
+			writes, programs, erases, running_erases);
+	printf("%ld sync gaps held, at most %ld halfwords in one\n", holds, max_gap);
+	if (running_erases == 0)
+		fail("no page reclaimed at runtime", -1, -1);
+
+	// Every write again, with a reset after each flash operation.
+	for (i = 0; i < writes; i++)
+	{
+		for (cut = 1; ; cut++)
+		{
+			memcpy(flash, flash_before[i], SIM_LOG_SIZE);
+			boot();
+
+			budget = cut;
+			if (setjmp(reset) == 0)
+			{
+				bool ok = storage_write(w[i].offset, w[i].length, w[i].data);
+				budget = -1;
+				if (!ok)
+					fail("write refused", i, cut);
+				break;
+			}
+			resets++;
+
+			// Power on again, that too cut short.
+			budget = 1 + rand() % 64;
+			if (setjmp(reset) == 0)
+				boot();
+			budget = -1;
+			boot();
+			check_blocks(ref_before[i], &w[i], i, cut);
+
+			if (!storage_write(w[i].offset, w[i].length, w[i].data))
+				fail("write refused after a reset", i, cut);
+			memcpy(ref, ref_before[i], sizeof(ref));
+			memcpy(&ref[w[i].offset], w[i].data, w[i].length);
+			storage_read(0, STORAGE_SIZE, got);
+			if (memcmp(got, ref, sizeof(ref)))
+				fail("read back differs after a reset", i, cut);
+		}
+	}
+	printf("%ld resets, ok\n", resets);
+	return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host side generator for the font tables in firmware/fonts.c, made
+ * from the 5x7 glyphs in lcd_font_medium.h:
+ *  - font_prop: where the ink starts and its width for each glyph, so
+ *    text can be drawn proportionally from the 5x7 glyphs.
+ *  - font_large: the digits and time/number punctuation scaled to
+ *    10x14 with Scale2x, which rounds off the diagonals that a plain
+ *    pixel double leaves as steps. Digits keep the full width so numbers
+ *    do not shift as they count.
+ *
+ * -a prints the large glyphs as text instead.
+ *
+ * Build:  cc -o fontconv fontconv.c
+ * Usage:  fontconv [-a] > fonts.c
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "../../firmware/lcd.h"
+#include "../../firmware/fonts.h"
+#include "../../firmware/lcd_font_medium.h"
+
+#define GLYPHS			(sizeof(font_medium) / CHAR_WIDTH)
+
+#define PROP_SPACE		2		// Width of a blank glyph
+
+typedef char glyphs_match[(GLYPHS == FONT_GLYPHS) ? 1 : -1];
+
+static uint16_t large[FONT_LARGE_COUNT][FONT_LARGE_WIDTH];
+static uint8_t large_metrics[FONT_LARGE_COUNT];
+
+static bool src_pixel(uint8_t c, int x, int y)
+{
+	if (x < 0 || x >= CHAR_WIDTH || y < 0 || y >= 8)
+		return false;
+	return (font_medium[c * CHAR_WIDTH + x] >> y) & 1;
+}
+
+/**
+  * @brief  Scale2x one glyph into large[].
+  */
+static void scale2x(uint8_t c, uint16_t *cols)
+{
+	int x, y;
+
+	for (x = 0; x < CHAR_WIDTH; ++x)
+	{
+		cols[2 * x] = cols[2 * x + 1] = 0;
+		for (y = 0; y < 8; ++y)
+		{
+			bool p = src_pixel(c, x, y);
+			bool a = src_pixel(c, x, y - 1);
+			bool b = src_pixel(c, x + 1, y);
+			bool l = src_pixel(c, x - 1, y);
+			bool d = src_pixel(c, x, y + 1);
+			bool e0 = (l == a && l != d && a != b) ? a : p;
+			bool e1 = (a == b && a != l && b != d) ? b : p;
+			bool e2 = (d == l && d != b && l != a) ? l : p;
+			bool e3 = (b == d && b != a && d != l) ? d : p;
+
+			cols[2 * x] |= (e0 << (2 * y)) | (e2 << (2 * y + 1));
+			cols[2 * x + 1] |= (e1 << (2 * y)) | (e3 << (2 * y + 1));
+		}
+	}
+}
+
+/**
+  * @brief  Ink extent of n columns as (lead << 4) | width.
+  * @param  blank: Width given when there is no ink.
+  */
+static uint8_t metrics(const uint16_t *cols, int n, int blank)
+{
+	int first = n, last = -1;
+	int x;
+
+	for (x = 0; x < n; ++x)
+	{
+		if (cols[x] != 0)
+		{
+			if (first == n)
+				first = x;
+			last = x;
+		}
+	}
+	if (last < 0)
+		return blank;
+	return (first << 4) | (last - first + 1);
+}
+
+static void build(void)
+{
+	int i, x;
+
+	for (i = 0; i < FONT_LARGE_COUNT; ++i)
+	{
+		uint8_t c = FONT_LARGE_FIRST + i;
+
+		scale2x(c, large[i]);
+		if (c >= '0' && c <= '9')
+		{
+			large_metrics[i] = FONT_LARGE_WIDTH;
+		}
+		else
+		{
+			// Punctuation is cut to its ink plus a column each side.
+			uint8_t m = metrics(large[i], FONT_LARGE_WIDTH, FONT_LARGE_WIDTH / 2);
+			uint8_t lead = m >> 4;
+			uint8_t width = m & 0x0F;
+
+			if (lead > 0)
+			{
+				lead--;
+				width++;
+			}
+			if (lead + width < FONT_LARGE_WIDTH)
+				width++;
+			large_metrics[i] = (lead << 4) | width;
+		}
+		for (x = 0; x < FONT_LARGE_WIDTH; ++x)
+			large[i][x] &= (1 << FONT_LARGE_HEIGHT) - 1;
+	}
+}
+
+static void print_ascii(void)
+{
+	int i, x, y;
+
+	for (i = 0; i < FONT_LARGE_COUNT; ++i)
+	{
+		uint8_t lead = large_metrics[i] >> 4;
+		uint8_t width = large_metrics[i] & 0x0F;
+
+		printf("'%c' lead %d width %d\n", FONT_LARGE_FIRST + i, lead, width);
+		for (y = 0; y < FONT_LARGE_HEIGHT; ++y)
+		{
+			for (x = 0; x < FONT_LARGE_WIDTH; ++x)
+				putchar((large[i][x] >> y) & 1 ? '#' : (x < lead || x >= lead + width) ? ' ' : '.');
+			putchar('\n');
+		}
+	}
+}
+
+static void write_c(void)
+{
+	unsigned i, x, p;
+
+	printf("/*\n"
+			" *                  Copyright 2014 ARTaylor.co.uk\n"
+			" *\n"
+			" * This program is free software; you can redistribute it and/or modify\n"
+			" * it under the terms of the GNU General Public License version 3 as\n"
+			" * published by the Free Software Foundation.\n"
+			" *\n"
+			" * This program is distributed in the hope that it will be useful,\n"
+			" * but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+			" * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+			" * GNU General Public License for more details.\n"
+			" *\n"
+			" */\n\n"
+			"/* Description:\n"
+			" *\n"
+			" * Font tables, see fonts.h.\n"
+			" * Made by tools/fontconv from lcd_font_medium.h, do not edit.\n"
+			" *\n"
+			" */\n\n"
+			"#include \"fonts.h\"\n\n");
+
+	printf("const uint8_t font_prop[FONT_GLYPHS] = {");
+	for (i = 0; i < GLYPHS; ++i)
+	{
+		uint16_t cols[CHAR_WIDTH];
+
+		for (x = 0; x < CHAR_WIDTH; ++x)
+			cols[x] = font_medium[i * CHAR_WIDTH + x];
+		printf("%s0x%02X,", (i % 12) ? " " : "\n\t", metrics(cols, CHAR_WIDTH, PROP_SPACE));
+	}
+	printf("\n};\n\n");
+
+	printf("const uint8_t font_large_metrics[FONT_LARGE_COUNT] = {");
+	for (i = 0; i < FONT_LARGE_COUNT; ++i)
+		printf("%s0x%02X,", (i % 12) ? " " : "\n\t", large_metrics[i]);
+	printf("\n};\n\n");
+
+	printf("const uint8_t font_large[FONT_LARGE_COUNT * FONT_LARGE_STRIDE] = {\n");
+	for (i = 0; i < FONT_LARGE_COUNT; ++i)
+	{
+		printf("\t// '%c'\n", FONT_LARGE_FIRST + i);
+		for (p = 0; p < FONT_LARGE_PAGES; ++p)
+		{
+			printf("\t");
+			for (x = 0; x < FONT_LARGE_WIDTH; ++x)
+				printf("0x%02X,%s", (large[i][x] >> (8 * p)) & 0xFF,
+						(x + 1 < FONT_LARGE_WIDTH) ? " " : "\n");
+		}
+	}
+	printf("};\n");
+}
+
+int main(int argc, char **argv)
+{
+	bool ascii = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a")) != -1) {
+		switch (opt) {
+		case 'a':
+			ascii = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-a] > fonts.c\n", argv[0]);
+			return 1;
+		}
+	}
+
+	build();
+	if (ascii)
+		print_ascii();
+	else
+		write_c();
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * Just enough of the STM32 standard peripheral library for the host tools
+ * (eesim, flashsim, linktest, replay, ppmcheck, wcet) to build firmware
+ * drivers. The values are the real ones. The functions are implemented
+ * by the peripheral models in each tool, a tool only defines the ones the
+ * drivers it builds call.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_H
+#define _HOSTSTUB_STM32F10X_H
+
+#include <stdint.h>
+
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+typedef enum { RESET = 0, SET = !RESET } FlagStatus;
+
+typedef enum {
+	DMA1_Channel1_IRQn = 11,
+	DMA1_Channel4_IRQn = 14,
+	DMA1_Channel5_IRQn = 15,
+	DMA1_Channel6_IRQn = 16,
+	DMA1_Channel7_IRQn = 17,
+	TIM2_IRQn = 28,
+	TIM3_IRQn = 29,
+	I2C1_EV_IRQn = 31,
+	I2C1_ER_IRQn = 32,
+	TIM7_IRQn = 55,
+} IRQn_Type;
+
+// Only the registers a model reads back.
+typedef struct { volatile uint32_t ODR; } GPIO_TypeDef;
+typedef struct { volatile uint32_t CNDTR; } DMA_Channel_TypeDef;
+typedef struct { volatile uint16_t SR; } TIM_TypeDef;
+typedef struct { volatile uint32_t DR; } ADC_TypeDef;
+typedef struct { volatile uint16_t SR1, SR2, DR; } I2C_TypeDef;
+typedef struct { volatile uint16_t SR, DR; } USART_TypeDef;
+typedef struct { volatile uint32_t CTRL, LOAD, VAL; } SysTick_Type;
+
+extern GPIO_TypeDef *GPIOA, *GPIOB;
+extern DMA_Channel_TypeDef *DMA1_Channel1, *DMA1_Channel4, *DMA1_Channel5;
+extern DMA_Channel_TypeDef *DMA1_Channel6, *DMA1_Channel7;
+extern TIM_TypeDef *TIM2, *TIM3, *TIM4, *TIM7;
+extern ADC_TypeDef *ADC1;
+extern I2C_TypeDef *I2C1;
+extern USART_TypeDef *USART1;
+extern SysTick_Type *SysTick;
+extern uint32_t SystemCoreClock;
+
+#define FLASH_BASE		((uint32_t) 0x08000000)
+
+// As stm32f10x_conf.h does in the firmware build.
+#include "stm32f10x_rcc.h"
+#include "stm32f10x_misc.h"
+#include "stm32f10x_gpio.h"
+#include "stm32f10x_dma.h"
+#include "stm32f10x_tim.h"
+#include "stm32f10x_adc.h"
+#include "stm32f10x_i2c.h"
+#include "stm32f10x_usart.h"
+#include "stm32f10x_flash.h"
+
+#endif // _HOSTSTUB_STM32F10X_H
@@ -0,0 +1,47 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * ADC, see stm32f10x.h.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_ADC_H
+#define _HOSTSTUB_STM32F10X_ADC_H
+
+#include "stm32f10x.h"
+
+typedef struct {
+	uint32_t ADC_Mode;
+	FunctionalState ADC_ScanConvMode, ADC_ContinuousConvMode;
+	uint32_t ADC_ExternalTrigConv, ADC_DataAlign;
+	uint8_t ADC_NbrOfChannel;
+} ADC_InitTypeDef;
+
+#define ADC_Channel_0					0x00
+#define ADC_SampleTime_239Cycles5		0x07
+#define ADC_ExternalTrigConv_T4_CC4		0x000A0000
+
+void ADC_DeInit(ADC_TypeDef *adc);
+void ADC_StructInit(ADC_InitTypeDef *init);
+void ADC_Init(ADC_TypeDef *adc, ADC_InitTypeDef *init);
+void ADC_RegularChannelConfig(ADC_TypeDef *adc, uint8_t channel, uint8_t rank, uint8_t time);
+void ADC_Cmd(ADC_TypeDef *adc, FunctionalState state);
+void ADC_DMACmd(ADC_TypeDef *adc, FunctionalState state);
+void ADC_ResetCalibration(ADC_TypeDef *adc);
+FlagStatus ADC_GetResetCalibrationStatus(ADC_TypeDef *adc);
+void ADC_StartCalibration(ADC_TypeDef *adc);
+FlagStatus ADC_GetCalibrationStatus(ADC_TypeDef *adc);
+void ADC_ExternalTrigConvCmd(ADC_TypeDef *adc, FunctionalState state);
+
+#endif // _HOSTSTUB_STM32F10X_ADC_H
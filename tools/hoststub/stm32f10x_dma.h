@@ -0,0 +1,60 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * DMA, see stm32f10x.h.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_DMA_H
+#define _HOSTSTUB_STM32F10X_DMA_H
+
+#include "stm32f10x.h"
+
+typedef struct {
+	uint32_t DMA_PeripheralBaseAddr, DMA_MemoryBaseAddr, DMA_DIR, DMA_BufferSize;
+	uint32_t DMA_PeripheralInc, DMA_MemoryInc, DMA_PeripheralDataSize, DMA_MemoryDataSize;
+	uint32_t DMA_Mode, DMA_Priority, DMA_M2M;
+} DMA_InitTypeDef;
+
+#define DMA_DIR_PeripheralDST			0x0010
+#define DMA_DIR_PeripheralSRC			0x0000
+#define DMA_PeripheralInc_Disable		0x0000
+#define DMA_MemoryInc_Enable			0x0080
+#define DMA_PeripheralDataSize_Byte		0x0000
+#define DMA_PeripheralDataSize_HalfWord	0x0100
+#define DMA_MemoryDataSize_Byte			0x0000
+#define DMA_MemoryDataSize_HalfWord		0x0400
+#define DMA_Mode_Normal					0x0000
+#define DMA_Mode_Circular				0x0020
+#define DMA_Priority_Low				0x0000
+#define DMA_Priority_Medium				0x1000
+#define DMA_Priority_VeryHigh			0x3000
+#define DMA_M2M_Disable					0x0000
+#define DMA_IT_TC						0x0002
+#define DMA1_FLAG_TC1					0x00000002
+#define DMA1_FLAG_TC4					0x00002000
+#define DMA1_FLAG_TC6					0x00200000
+#define DMA1_FLAG_TC7					0x02000000
+#define DMA1_IT_TC4						0x00002000
+
+void DMA_DeInit(DMA_Channel_TypeDef *ch);
+void DMA_StructInit(DMA_InitTypeDef *init);
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init);
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state);
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state);
+void DMA_ClearFlag(uint32_t flag);
+void DMA_ClearITPendingBit(uint32_t it);
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch);
+
+#endif // _HOSTSTUB_STM32F10X_DMA_H
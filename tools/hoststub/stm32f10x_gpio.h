@@ -0,0 +1,51 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * GPIO, see stm32f10x.h.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_GPIO_H
+#define _HOSTSTUB_STM32F10X_GPIO_H
+
+#include "stm32f10x.h"
+
+typedef enum { GPIO_Speed_10MHz = 1, GPIO_Speed_2MHz, GPIO_Speed_50MHz } GPIOSpeed_TypeDef;
+typedef enum {
+	GPIO_Mode_AIN = 0x00,
+	GPIO_Mode_IN_FLOATING = 0x04,
+	GPIO_Mode_IPU = 0x48,
+	GPIO_Mode_Out_OD = 0x14,
+	GPIO_Mode_Out_PP = 0x10,
+	GPIO_Mode_AF_OD = 0x1C,
+	GPIO_Mode_AF_PP = 0x18,
+} GPIOMode_TypeDef;
+typedef struct {
+	uint16_t GPIO_Pin;
+	GPIOSpeed_TypeDef GPIO_Speed;
+	GPIOMode_TypeDef GPIO_Mode;
+} GPIO_InitTypeDef;
+
+#define GPIO_Pin_6	0x0040
+#define GPIO_Pin_7	0x0080
+#define GPIO_Pin_9	0x0200
+#define GPIO_Pin_10	0x0400
+
+void GPIO_StructInit(GPIO_InitTypeDef *init);
+void GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init);
+void GPIO_SetBits(GPIO_TypeDef *gpio, uint16_t pins);
+void GPIO_ResetBits(GPIO_TypeDef *gpio, uint16_t pins);
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef *gpio, uint16_t pin);
+
+#endif // _HOSTSTUB_STM32F10X_GPIO_H
@@ -0,0 +1,68 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * I2C, see stm32f10x.h.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_I2C_H
+#define _HOSTSTUB_STM32F10X_I2C_H
+
+#include "stm32f10x.h"
+
+typedef struct {
+	uint32_t I2C_ClockSpeed;
+	uint16_t I2C_Mode, I2C_DutyCycle, I2C_OwnAddress1, I2C_Ack, I2C_AcknowledgedAddress;
+} I2C_InitTypeDef;
+
+#define I2C_IT_BUF		0x0400
+#define I2C_IT_EVT		0x0200
+#define I2C_IT_ERR		0x0100
+#define I2C_Direction_Transmitter	0x00
+#define I2C_Direction_Receiver		0x01
+#define I2C_FLAG_TRA		0x00040004
+#define I2C_FLAG_BUSY		0x00020002
+#define I2C_FLAG_MSL		0x00010001
+#define I2C_FLAG_TIMEOUT	0x10004000
+#define I2C_FLAG_OVR		0x10000800
+#define I2C_FLAG_AF			0x10000400
+#define I2C_FLAG_ARLO		0x10000200
+#define I2C_FLAG_BERR		0x10000100
+#define I2C_FLAG_TXE		0x10000080
+#define I2C_FLAG_RXNE		0x10000040
+#define I2C_FLAG_BTF		0x10000004
+#define I2C_FLAG_ADDR		0x10000002
+#define I2C_FLAG_SB			0x10000001
+#define I2C_EVENT_MASTER_MODE_SELECT					0x00030001
+#define I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED		0x00070082
+#define I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED			0x00030002
+#define I2C_EVENT_MASTER_BYTE_TRANSMITTED				0x00070084
+
+void I2C_DeInit(I2C_TypeDef *i2c);
+void I2C_StructInit(I2C_InitTypeDef *init);
+void I2C_Init(I2C_TypeDef *i2c, I2C_InitTypeDef *init);
+void I2C_Cmd(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_ITConfig(I2C_TypeDef *i2c, uint16_t it, FunctionalState state);
+void I2C_DMACmd(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_DMALastTransferCmd(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_AcknowledgeConfig(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_GenerateSTART(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_GenerateSTOP(I2C_TypeDef *i2c, FunctionalState state);
+void I2C_Send7bitAddress(I2C_TypeDef *i2c, uint8_t address, uint8_t direction);
+void I2C_SendData(I2C_TypeDef *i2c, uint8_t data);
+uint32_t I2C_GetLastEvent(I2C_TypeDef *i2c);
+FlagStatus I2C_GetFlagStatus(I2C_TypeDef *i2c, uint32_t flag);
+void I2C_ClearFlag(I2C_TypeDef *i2c, uint32_t flag);
+
+#endif // _HOSTSTUB_STM32F10X_I2C_H
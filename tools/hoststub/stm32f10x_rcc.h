@@ -0,0 +1,39 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * Peripheral clocks, see stm32f10x.h.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_RCC_H
+#define _HOSTSTUB_STM32F10X_RCC_H
+
+#include "stm32f10x.h"
+
+#define RCC_APB1Periph_TIM2		0x00000001
+#define RCC_APB1Periph_TIM3		0x00000002
+#define RCC_APB1Periph_TIM4		0x00000004
+#define RCC_APB1Periph_TIM7		0x00000020
+#define RCC_APB1Periph_I2C1		0x00200000
+#define RCC_APB2Periph_GPIOA	0x00000004
+#define RCC_APB2Periph_GPIOB	0x00000008
+#define RCC_APB2Periph_ADC1		0x00000200
+#define RCC_APB2Periph_USART1	0x00004000
+#define RCC_AHBPeriph_DMA1		0x00000001
+
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state);
+
+#endif // _HOSTSTUB_STM32F10X_RCC_H
@@ -0,0 +1,61 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * Timers, see stm32f10x.h.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_TIM_H
+#define _HOSTSTUB_STM32F10X_TIM_H
+
+#include "stm32f10x.h"
+
+typedef struct {
+	uint16_t TIM_Prescaler, TIM_CounterMode, TIM_Period, TIM_ClockDivision;
+	uint8_t TIM_RepetitionCounter;
+} TIM_TimeBaseInitTypeDef;
+typedef struct {
+	uint16_t TIM_OCMode, TIM_OutputState, TIM_OutputNState, TIM_Pulse;
+	uint16_t TIM_OCPolarity, TIM_OCNPolarity, TIM_OCIdleState, TIM_OCNIdleState;
+} TIM_OCInitTypeDef;
+typedef struct {
+	uint16_t TIM_Channel, TIM_ICPolarity, TIM_ICSelection, TIM_ICPrescaler, TIM_ICFilter;
+} TIM_ICInitTypeDef;
+
+#define TIM_CounterMode_Up			0x0000
+#define TIM_OCMode_PWM1				0x0060
+#define TIM_OutputState_Enable		0x0001
+#define TIM_OCPolarity_Low			0x0002
+#define TIM_Channel_2				0x0004
+#define TIM_IT_Update				0x0001
+#define TIM_FLAG_CC1				0x0002
+
+void TIM_DeInit(TIM_TypeDef *tim);
+void TIM_TimeBaseStructInit(TIM_TimeBaseInitTypeDef *init);
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init);
+void TIM_OCStructInit(TIM_OCInitTypeDef *init);
+void TIM_OC1Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init);
+void TIM_OC4Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init);
+void TIM_ICStructInit(TIM_ICInitTypeDef *init);
+void TIM_ICInit(TIM_TypeDef *tim, TIM_ICInitTypeDef *init);
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state);
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it);
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state);
+void TIM_SetAutoreload(TIM_TypeDef *tim, uint16_t value);
+void TIM_SetCounter(TIM_TypeDef *tim, uint16_t value);
+void TIM_SetCompare1(TIM_TypeDef *tim, uint16_t value);
+uint16_t TIM_GetCounter(TIM_TypeDef *tim);
+uint16_t TIM_GetCapture1(TIM_TypeDef *tim);
+
+#endif // _HOSTSTUB_STM32F10X_TIM_H
@@ -0,0 +1,44 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*
+ * USART, see stm32f10x.h.
+ */
+
+#ifndef _HOSTSTUB_STM32F10X_USART_H
+#define _HOSTSTUB_STM32F10X_USART_H
+
+#include "stm32f10x.h"
+
+typedef struct {
+	uint32_t USART_BaudRate;
+	uint16_t USART_WordLength, USART_StopBits, USART_Parity, USART_Mode;
+	uint16_t USART_HardwareFlowControl;
+} USART_InitTypeDef;
+
+#define USART_WordLength_8b					0x0000
+#define USART_StopBits_1					0x0000
+#define USART_Parity_No						0x0000
+#define USART_Mode_Rx						0x0004
+#define USART_Mode_Tx						0x0008
+#define USART_HardwareFlowControl_None		0x0000
+#define USART_DMAReq_Tx						0x0080
+#define USART_DMAReq_Rx						0x0040
+
+void USART_StructInit(USART_InitTypeDef *init);
+void USART_Init(USART_TypeDef *usart, USART_InitTypeDef *init);
+void USART_DMACmd(USART_TypeDef *usart, uint16_t req, FunctionalState state);
+void USART_Cmd(USART_TypeDef *usart, FunctionalState state);
+
+#endif // _HOSTSTUB_STM32F10X_USART_H
@@ -0,0 +1,433 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host loopback test of the serial link: the artlink client code against
+ * the firmware (firmware/serial.c, frame.c and the model store on the RAM
+ * storage backend) over a pseudo terminal.
+ *
+ * First frame.c is checked on its own: the CRC against the standard check
+ * value, COBS/CRC round trips of every payload length and single byte
+ * errors, which must be rejected.
+ *
+ * Then the radio runs in a child process on the PTY master, the USART and
+ * its two DMA channels modelled at the level serial.c sees them. It starts
+ * with a few models stored. The client, tools/artlink.c included here,
+ * uses the slave. It checks ping and info, that garbage and corrupt frames
+ * are dropped, raw EEPROM writes and reads, model download and upload,
+ * a rejected image and a backup and restore of every model.
+ * While it does, every rx-th frame to the radio and every tx-th frame
+ * from it gets a byte changed, so the client has to retry.
+ *
+ * Build:  cc -no-pie -funsigned-char -DSTORAGE_BACKEND=STORAGE_RAM -I../hoststub -I../../firmware
+ *             -o linktest linktest.c ../../firmware/serial.c ../../firmware/frame.c
+ *             ../../firmware/eeprom.c ../../firmware/modelimg.c
+ *             ../../firmware/storage_ram.c
+ * Usage:  linktest [rx] [tx]
+ *
+ * serial.c passes buffer addresses through 32 bit DMA registers, so its
+ * buffers are kept in the low 4GB (hence -no-pie).
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "stm32f10x.h"
+
+// The client, with its main() out of the way and a shorter timeout.
+#define TIMEOUT_MS	20
+#define main artlink_main
+#include "../artlink.c"
+#undef main
+
+#include "myeeprom.h"
+#include "eeprom.h"
+#include "gui.h"
+#include "lcd.h"
+#include "tasks.h"
+#include "mixer.h"
+#include "watchdog.h"
+
+#define MODELS_STORED	4		// Models the radio starts with
+#define COPY_TO			10		// Models uploaded to this slot on
+#define REJECT_TO		20		// Slot a corrupt image is sent to
+
+// Firmware, run as tasks on the radio
+void eeprom_process(uint32_t data);
+void DMA1_Channel4_IRQHandler(void);
+
+static int failures;
+
+/******************************************************************************
+ * Radio
+ */
+
+volatile EEGeneral g_eeGeneral;
+volatile ModelData g_model;
+volatile uint8_t g_modelInvalid;
+volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+volatile uint32_t system_ticks;
+volatile int16_t g_chans[NUM_CHNOUT];
+volatile int16_t stick_data[STICK_ADC_CHANNELS];
+volatile uint32_t g_mixer_passes;
+volatile uint16_t g_mixer_us;
+volatile uint16_t g_mixer_max_us;
+
+static USART_TypeDef usart1;
+static GPIO_TypeDef gpioa;
+static DMA_Channel_TypeDef dma4, dma5;
+USART_TypeDef *USART1 = &usart1;
+GPIO_TypeDef *GPIOA = &gpioa;
+DMA_Channel_TypeDef *DMA1_Channel4 = &dma4, *DMA1_Channel5 = &dma5;
+
+// DMA channel 4 sends, 5 receives into a ring.
+static struct {
+	uint8_t *mem;
+	uint16_t size;
+	bool enabled;
+} dma_tx, dma_rx;
+
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void) periph; (void) state; }
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state) { (void) periph; (void) state; }
+void NVIC_Init(NVIC_InitTypeDef *init) { (void) init; }
+void GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init) { (void) gpio; (void) init; }
+void USART_StructInit(USART_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void USART_Init(USART_TypeDef *usart, USART_InitTypeDef *init) { (void) usart; (void) init; }
+void USART_DMACmd(USART_TypeDef *usart, uint16_t req, FunctionalState state) { (void) usart; (void) req; (void) state; }
+void USART_Cmd(USART_TypeDef *usart, FunctionalState state) { (void) usart; (void) state; }
+void DMA_DeInit(DMA_Channel_TypeDef *ch) { ch->CNDTR = 0; }
+void DMA_StructInit(DMA_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state) { (void) ch; (void) it; (void) state; }
+void DMA_ClearFlag(uint32_t flag) { (void) flag; }
+void DMA_ClearITPendingBit(uint32_t it) { (void) it; }
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch) { return ch->CNDTR; }
+
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init)
+{
+	if ((ch == DMA1_Channel4) != (init->DMA_DIR == DMA_DIR_PeripheralDST) ||
+			(ch == DMA1_Channel5) != (init->DMA_Mode == DMA_Mode_Circular)) {
+		fprintf(stderr, "linktest: DMA set up wrong for the channel\n");
+		exit(2);
+	}
+	(ch == DMA1_Channel4 ? &dma_tx : &dma_rx)->mem = (uint8_t*) (uintptr_t) init->DMA_MemoryBaseAddr;
+	(ch == DMA1_Channel4 ? &dma_tx : &dma_rx)->size = init->DMA_BufferSize;
+	ch->CNDTR = init->DMA_BufferSize;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state)
+{
+	(ch == DMA1_Channel4 ? &dma_tx : &dma_rx)->enabled = state;
+}
+
+void capture_start(void) { }
+void capture_stop(void) { }
+uint8_t capture_read(uint8_t *buf, uint8_t length) { (void) buf; (void) length; return 0; }
+
+void task_register(Tasks task, void (*fn)(uint32_t)) { (void) task; (void) fn; }
+void task_schedule(Tasks task, uint32_t data, uint32_t time_ms) { (void) task; (void) data; (void) time_ms; }
+void gui_popup(GUI_MSG msg, int16_t timeout) { (void) msg; (void) timeout; }
+GUI_LAYOUT gui_get_layout(void) { return GUI_LAYOUT_MAIN1; }
+void lcd_set_cursor(uint8_t x, uint8_t y) { (void) x; (void) y; }
+void lcd_write_char(uint8_t c, LCD_OP op, uint16_t flags) { (void) c; (void) op; (void) flags; }
+void lcd_update(void) { }
+bool mixer_trim_pending(void) { return false; }
+void mixer_hold_model(bool hold) { (void) hold; }
+
+/**
+  * @brief  Change a byte of every n-th frame passing through.
+  * @param  count: Frames so far in this direction
+  * @param  pos: Position in the current frame
+  */
+static uint8_t corrupt(uint8_t b, unsigned n, unsigned *count, unsigned *pos)
+{
+	if (b == 0) {
+		(*count)++;
+		*pos = 0;
+		return b;
+	}
+	if (n && *count % n == n - 1 && (*pos)++ == 1)
+		b ^= 0x10;
+	return b;
+}
+
+/**
+  * @brief  The radio: a few models stored, then the serial task forever.
+  */
+static void radio(int fd, unsigned rx_every, unsigned tx_every)
+{
+	unsigned rx_count = 0, rx_pos = 0, tx_count = 0, tx_pos = 0;
+	uint8_t m;
+
+	storage_init();
+	eeprom_init();
+	for (m = 0; m < MODELS_STORED; m++) {
+		uint16_t n = 20 + 60 * m;
+		g_eeGeneral.currModel = m;
+		eeprom_process(0);
+		while (n--)
+			((uint8_t*) &g_model)[rand() % offsetof(ModelData, chkSum)] = rand();
+		g_model.name[MODEL_NAME_LEN-1] = 0;
+		eeprom_process(0);
+	}
+
+	serial_init();
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	for (;;) {
+		struct pollfd p = { fd, POLLIN, 0 };
+		uint8_t buf[16];
+		ssize_t i, n;
+
+		poll(&p, 1, 1);
+		n = read(fd, buf, sizeof(buf));
+		for (i = 0; i < n && dma_rx.enabled; i++) {
+			dma_rx.mem[dma_rx.size - DMA1_Channel5->CNDTR] = corrupt(buf[i], rx_every, &rx_count, &rx_pos);
+			if (--DMA1_Channel5->CNDTR == 0)
+				DMA1_Channel5->CNDTR = dma_rx.size;
+		}
+
+		system_ticks++;
+		serial_process(0);
+
+		if (dma_tx.enabled) {
+			for (i = 0; i < dma_tx.size; i++)
+				dma_tx.mem[i] = corrupt(dma_tx.mem[i], tx_every, &tx_count, &tx_pos);
+			if (write(fd, dma_tx.mem, dma_tx.size) != dma_tx.size)
+				exit(2);
+			DMA1_Channel4_IRQHandler();
+		}
+	}
+}
+
+/******************************************************************************
+ * Tests
+ */
+
+static void check(bool ok, const char *what)
+{
+	if (!ok && failures++ < 10)
+		printf("linktest: %s\n", what);
+}
+
+/**
+  * @brief  COBS/CRC framing on its own.
+  */
+static void test_frames(void)
+{
+	static const uint8_t check_value[] = "123456789";
+	uint8_t payload[FRAME_MAX_PAYLOAD], out[FRAME_MAX_ENCODED], buf[FRAME_MAX_ENCODED];
+	uint16_t length, n, i;
+	int16_t got;
+	int round;
+
+	check(frame_crc16(check_value, 9) == 0x29B1, "CRC-16/CCITT check value");
+
+	for (length = 0; length <= FRAME_MAX_PAYLOAD; length++) {
+		for (round = 0; round < 20; round++) {
+			// From no zeros at all to nothing else.
+			for (i = 0; i < length; i++)
+				payload[i] = rand() % 20 < round ? 0 : 1 + rand() % 255;
+
+			n = frame_encode(payload, length, out);
+			check(n <= FRAME_MAX_ENCODED, "encoded frame too long");
+			check(memchr(out, 0, n - 1) == 0 && out[n - 1] == 0, "zero inside a frame");
+
+			memcpy(buf, out, n);
+			got = frame_decode(buf, n - 1);
+			check(got == length && memcmp(buf, payload, length) == 0, "round trip");
+
+			// A changed data byte must be caught by the CRC. A changed
+			// code byte moves the zeros, it must not overrun.
+			for (i = 0; i < n - 1; i++) {
+				uint16_t code;
+				bool is_code = false;
+
+				for (code = 0; code < n - 1; code += out[code])
+					if (code == i)
+						is_code = true;
+				memcpy(buf, out, n);
+				buf[i] ^= 1 << rand() % 8;
+				got = frame_decode(buf, n - 1);
+				check(got <= (int16_t) (n - 1 - FRAME_CRC_LEN), "decode overrun");
+				if (!is_code)
+					check(got < 0, "changed byte not caught");
+			}
+		}
+	}
+}
+
+/**
+  * @brief  A frame sent as is, and its reply.
+  * @param  tries: Times to send it while there is no reply
+  * @retval reply length, 0 if none
+  */
+static int exchange(const uint8_t *out, unsigned length, uint8_t *reply, int tries)
+{
+	int n = 0;
+
+	while (n == 0 && tries--)
+		if (write(fd, out, length) == (ssize_t) length)
+			n = recv_msg(reply, TIMEOUT_MS);
+	return n;
+}
+
+/**
+  * @brief  Link basics and frames the radio must drop.
+  */
+static void test_link(SerialInfo *info)
+{
+	uint8_t req[FRAME_MAX_PAYLOAD], reply[FRAME_MAX_PAYLOAD];
+	uint8_t out[FRAME_MAX_ENCODED + 200];
+	unsigned i, n;
+
+	req[0] = MSG_PING;
+	check(request(req, 1, MSG_PONG, reply) == 1, "no reply to ping");
+
+	check(get_info(info) == 0, "no reply to info");
+	check(info->eeprom_size == EEPROM_SIZE && info->general_size == sizeof(EEGeneral) &&
+			info->model_size == sizeof(ModelData) && info->max_models == MAX_MODELS,
+			"info does not match the firmware");
+
+	// A bad CRC gets no reply.
+	n = frame_encode(req, 1, out);
+	out[1] ^= 0x01;
+	check(exchange(out, n, reply, 1) == 0, "corrupt frame answered");
+
+	// Nor does a frame longer than any request, the next one does.
+	for (i = 0; i < sizeof(out) - 1; i++)
+		out[i] = 1 + rand() % 255;
+	out[i] = 0;
+	check(exchange(out, sizeof(out), reply, 1) == 0, "overlong frame answered");
+	n = frame_encode(req, 1, out);
+	check(exchange(out, n, reply, RETRIES) == 1 && reply[0] == MSG_PONG, "no ping after garbage");
+
+	req[0] = 0x7F;
+	n = frame_encode(req, 1, out);
+	check(exchange(out, n, reply, RETRIES) == 3 && reply[0] == MSG_ACK && reply[1] == 0x7F &&
+			reply[2] == SERIAL_ERR_UNKNOWN, "unknown request not refused");
+}
+
+/**
+  * @brief  Raw EEPROM write and read back, in the flight recorder area.
+  */
+static void test_eeprom(const SerialInfo *info)
+{
+	uint8_t data[100], back[100];
+	unsigned i, offset = info->eeprom_size - sizeof(data);
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = rand();
+	check(write_block(offset, data, sizeof(data)) == 0, "EEPROM write failed");
+	check(read_block(-1, offset, back, sizeof(back)) == 0 &&
+			memcmp(data, back, sizeof(data)) == 0, "EEPROM reads back wrong");
+}
+
+/**
+  * @brief  Models downloaded, uploaded to other slots, backed up and restored.
+  */
+static void test_models(const SerialInfo *info)
+{
+	static uint8_t image[MODELS_STORED][0x1000], back[0x1000];
+	static ModelData model[MODELS_STORED], copy;
+	int length[MODELS_STORED], n;
+	char backup[] = "/tmp/linktest.XXXXXX";
+	uint8_t m;
+
+	for (m = 0; m < MODELS_STORED; m++) {
+		length[m] = read_image(m, image[m], sizeof(image[m]));
+		check(length[m] > 0, "no model image");
+		check(read_block(m, 0, (uint8_t*) &model[m], sizeof(model[m])) == 0, "model read failed");
+		if (length[m] <= 0)
+			return;
+
+		check(write_image(COPY_TO + m, image[m], length[m]) == 0, "model upload failed");
+		n = read_image(COPY_TO + m, back, sizeof(back));
+		check(n == length[m] && memcmp(back, image[m], n) == 0, "uploaded image differs");
+		check(read_block(COPY_TO + m, 0, (uint8_t*) &copy, sizeof(copy)) == 0 &&
+				memcmp(&copy, &model[m], sizeof(copy)) == 0, "uploaded model differs");
+	}
+
+	// A corrupt image is refused and the slot left as it was.
+	memcpy(back, image[MODELS_STORED - 1], length[MODELS_STORED - 1]);
+	back[length[MODELS_STORED - 1] / 2] ^= 0x55;
+	check(write_image(REJECT_TO, back, length[MODELS_STORED - 1]) < 0, "corrupt image taken");
+	check(read_image(REJECT_TO, back, sizeof(back)) == 0, "corrupt image stored");
+
+	n = mkstemp(backup);
+	if (n < 0)
+		return;
+	close(n);
+	check(do_backup(info, backup) == 0, "backup failed");
+	for (m = 0; m < MODELS_STORED; m++) {
+		check(write_image(m, 0, 0) == 0 && write_image(COPY_TO + m, 0, 0) == 0, "clear failed");
+		check(read_image(m, back, sizeof(back)) == 0, "model not cleared");
+	}
+	check(do_restore(info, backup) == 0, "restore failed");
+	for (m = 0; m < MODELS_STORED; m++) {
+		n = read_image(m, back, sizeof(back));
+		check(n == length[m] && memcmp(back, image[m], n) == 0, "restored image differs");
+		n = read_image(COPY_TO + m, back, sizeof(back));
+		check(n == length[m] && memcmp(back, image[m], n) == 0, "restored copy differs");
+	}
+	unlink(backup);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned rx_every = argc > 1 ? atoi(argv[1]) : 7;
+	unsigned tx_every = argc > 2 ? atoi(argv[2]) : 5;
+	SerialInfo info;
+	pid_t pid;
+	int master;
+
+	srand(1);
+	test_frames();
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+			open_port(ptsname(master)) < 0) {
+		perror("linktest: pty");
+		return 2;
+	}
+
+	pid = fork();
+	if (pid == 0) {
+		close(fd);
+		radio(master, rx_every, tx_every);
+	}
+	close(master);
+
+	test_link(&info);
+	test_eeprom(&info);
+	test_models(&info);
+
+	kill(pid, SIGTERM);
+	waitpid(pid, 0, 0);
+
+	if (failures) {
+		printf("linktest: %d failures\n", failures);
+		return 1;
+	}
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,864 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host test of the PPM encoder (firmware/pulses.c).
+ *
+ * pulses.c runs against a model of TIM2 and the PPM-OUT pin, with random
+ * outputs in g_chans every frame and random ppmNCH, ppmStart, ppmDelay,
+ * ppmFrameLength and extendedLimits every few frames. The waveform is then
+ * decoded as a receiver sees it, from the leading edge of one stop pulse
+ * to the next, and each frame is checked against the settings and outputs
+ * it was built from:
+ *   count   channels in the frame
+ *   width   each channel is its clipped output + 1500 + the stop pulse
+ *   stop    every stop pulse is ppmDelay long
+ *   sync    the gap makes up the frame length, and is at least 9ms
+ * While it runs, every compare value is checked against the timer:
+ *   buffer  more compare values in a frame than pulses_1us holds
+ *   behind  a compare value at or behind the count (a 60ms glitch)
+ *   hang    no end of frame for 100ms
+ *
+ * With -x the settings cover the whole of their fields, as a corrupt
+ * model would, and only the timer checks apply. The first two frames
+ * after pulses_init() are not decoded: the ISR only sets its output
+ * polarity at the first end of frame.
+ *
+ * With -f each setting also gets random failsafe settings and runs for
+ * longer, with one of: the mixer stopping for a while, a model load
+ * (g_modelInvalid, with g_model scrambled until it ends), or the mixer
+ * using PPM-IN while trainer frames on TIM3 stop. The channels each
+ * frame should carry come from a model of the failsafe kept here, and
+ *   failsafe  g_failsafe gives the reasons the model expects
+ * is checked as each frame is built.
+ *
+ * The summary also gives the host time taken by the pulse ISR, for the
+ * edges and for the end of frame, where the next frame is built.
+ *
+ * Build:  cc -no-pie -I../hoststub -o ppmcheck ppmcheck.c ../../firmware/pulses.c
+ *             ../../firmware/failsafe.c
+ *         (add -fsanitize=address to catch writes past pulses_1us)
+ * Usage:  ppmcheck [-x] [-f] [-n settings] [-s seed] [-v file.vcd]
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "stm32f10x.h"
+#include "../../firmware/myeeprom.h"
+#include "../../firmware/pulses.h"
+#include "../../firmware/watchdog.h"
+#include "../../firmware/stack.h"
+#include "../../firmware/capture.h"
+#include "../../firmware/failsafe.h"
+
+#define PPM_OUT_PIN		(1 << 11)	// pulses.c PPM_OUT
+#define PULSES_WORDS	72			// pulses.c PULSES_WORD_SIZE
+#define CENTER			1500
+#define MIN_GAP			9000
+#define SYNC_DETECT		5000		// Longer than any channel
+#define HANG_US			100000
+#define WARMUP			2
+#define FRAMES_PER_SETTING	3
+#define FAILSAFE_FRAMES		40		// Frames per setting with -f
+#define SHOW_ERRORS		10
+#define NEVER			UINT64_MAX
+
+void TIM2_IRQHandler(void);
+void TIM3_IRQHandler(void);
+
+// Firmware globals owned by modules that are not built here
+volatile EEGeneral g_eeGeneral;
+volatile ModelData g_model;
+volatile uint8_t g_modelInvalid;
+volatile uint32_t system_ticks;
+volatile uint32_t g_mixer_passes;
+volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+uint8_t SlaveMode;
+
+static GPIO_TypeDef gpioa;
+static TIM_TypeDef tim2, tim3, tim4;
+GPIO_TypeDef *GPIOA = &gpioa;
+TIM_TypeDef *TIM2 = &tim2, *TIM3 = &tim3, *TIM4 = &tim4;
+
+typedef enum
+{
+	ERR_COUNT,
+	ERR_WIDTH,
+	ERR_STOP,
+	ERR_SYNC,
+	ERR_BUFFER,
+	ERR_BEHIND,
+	ERR_HANG,
+	ERR_FAILSAFE,
+	ERR_END
+} ERR;
+
+static const char *err_names[ERR_END] =
+{
+	"count", "width", "stop", "sync", "buffer", "behind", "hang", "failsafe",
+};
+
+// What each frame was built from, taken at the end of the one before.
+typedef struct
+{
+	uint64_t time;
+	int8_t nch, delay, frame_len;
+	uint8_t start, ext;
+	int16_t chans[NUM_CHNOUT];	// As sent, after the failsafe
+	uint8_t failsafe;		// Expected g_failsafe
+	unsigned loads;			// Compare values used
+} Frame;
+
+typedef struct
+{
+	uint64_t time;
+	bool level;
+} Edge;
+
+static uint64_t now;
+static bool extreme;
+static bool failsafe;
+
+// What the firmware should be doing, for checking the frames.
+static struct
+{
+	// Settings of the last valid model, which pulses.c keeps using.
+	int8_t nch, delay, frame_len;
+	uint8_t start, ext;
+	FailsafeData policy[NUM_CHNOUT];
+
+	int16_t hold[NUM_CHNOUT];
+	unsigned ramp;
+	unsigned late;			// Frames without a mixer pass
+	uint32_t passes;
+	unsigned trainer_age;	// Frames since a trainer frame
+	bool trainer_used;		// As last told by the mixer
+} ref = { .trainer_age = 1000 };
+static bool trainer_mixed;	// Mixer uses PPM-IN
+
+static uint16_t tim3_capture;
+static unsigned long failsafe_frames[3];
+
+// TIM2 at 1MHz, compare channel 1 only
+static struct
+{
+	bool on;
+	uint64_t base;
+	uint16_t cnt;
+	uint16_t arr, ccr;
+	uint64_t fired;
+} ppm_tim = { .fired = NEVER };
+
+static Frame *frames;
+static size_t n_frames, max_frames;
+static Edge *edges;
+static size_t n_edges, max_edges;
+
+static unsigned long errors[ERR_END];
+static unsigned long checked;
+static uint32_t rng = 1;
+
+static struct
+{
+	unsigned long n;
+	uint64_t min, max, total;
+} isr_edge = { .min = NEVER }, isr_frame = { .min = NEVER };
+
+static void *grow(void *p, size_t *max, size_t size)
+{
+	*max = *max ? *max * 2 : 1024;
+	p = realloc(p, *max * size);
+	if (!p)
+	{
+		perror("realloc");
+		exit(1);
+	}
+	return p;
+}
+
+static uint32_t rnd(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return rng;
+}
+
+static int rnd_range(int lo, int hi)
+{
+	return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+static void error(ERR err, size_t frame, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+static void error(ERR err, size_t frame, const char *fmt, ...)
+{
+	va_list ap;
+	unsigned long total = 0;
+	int i;
+
+	for (i = 0; i < ERR_END; ++i)
+		total += errors[i];
+	errors[err]++;
+	if (total >= SHOW_ERRORS)
+		return;
+
+	if (frame < n_frames)
+	{
+		const Frame *f = &frames[frame];
+		fprintf(stderr, "frame %zu at %llu us (nch %d start %u delay %d len %d ext %u): %s: ",
+				frame, (unsigned long long)f->time, f->nch, f->start, f->delay,
+				f->frame_len, f->ext, err_names[err]);
+	}
+	else
+		fprintf(stderr, "%llu us: %s: ", (unsigned long long)now, err_names[err]);
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+/*
+ * Peripheral model
+ */
+
+static void ppm_pin(GPIO_TypeDef *gpio, uint16_t pins, bool level)
+{
+	if (gpio != GPIOA || !(pins & PPM_OUT_PIN))
+		return;
+	if (((gpio->ODR & PPM_OUT_PIN) != 0) == level)
+		return;
+
+	gpio->ODR ^= PPM_OUT_PIN;
+	if (n_edges == max_edges)
+		edges = grow(edges, &max_edges, sizeof(*edges));
+	edges[n_edges].time = now;
+	edges[n_edges].level = level;
+	n_edges++;
+}
+
+void GPIO_SetBits(GPIO_TypeDef *gpio, uint16_t pins) { ppm_pin(gpio, pins, true); }
+void GPIO_ResetBits(GPIO_TypeDef *gpio, uint16_t pins) { ppm_pin(gpio, pins, false); }
+
+uint16_t TIM_GetCounter(TIM_TypeDef *tim)
+{
+	if (tim != TIM2)
+		return 0;
+	return ppm_tim.on ? (uint16_t)(now - ppm_tim.base) : ppm_tim.cnt;
+}
+
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state)
+{
+	if (tim != TIM2 || (state == ENABLE) == ppm_tim.on)
+		return;
+
+	if (state == ENABLE)
+		ppm_tim.base = now - ppm_tim.cnt;
+	else
+		ppm_tim.cnt = TIM_GetCounter(TIM2);
+	ppm_tim.on = (state == ENABLE);
+}
+
+/**
+  * @brief  Work out what the frame pulses.c just built should carry.
+  * @note	The failsafe has run once for the frame, as this model does.
+  * @param  f: Frame to fill in.
+  * @retval None
+  */
+static void expect_frame(Frame *f)
+{
+	int i;
+
+	if (!g_modelInvalid)
+	{
+		ref.nch = g_model.ppmNCH;
+		ref.start = g_model.ppmStart;
+		ref.delay = g_model.ppmDelay;
+		ref.frame_len = g_model.ppmFrameLength;
+		ref.ext = g_model.extendedLimits;
+		for (i = 0; i < NUM_CHNOUT; ++i)
+			ref.policy[i] = g_model.failsafe[i];
+	}
+	f->nch = ref.nch;
+	f->start = ref.start;
+	f->delay = ref.delay;
+	f->frame_len = ref.frame_len;
+	f->ext = ref.ext;
+
+	ref.late = (g_mixer_passes == ref.passes) ? ref.late + 1 : 0;
+	ref.passes = g_mixer_passes;
+	ref.trainer_age++;
+
+	f->failsafe = 0;
+	if (ref.late >= FAILSAFE_LATE_FRAMES)
+		f->failsafe |= FAILSAFE_MIXER;
+	if (g_modelInvalid)
+		f->failsafe |= FAILSAFE_MODEL;
+	if (ref.trainer_used && ref.trainer_age >= FAILSAFE_TRAINER_FRAMES)
+		f->failsafe |= FAILSAFE_TRAINER;
+
+	if (!f->failsafe)
+	{
+		ref.ramp = 0;
+		for (i = 0; i < NUM_CHNOUT; ++i)
+			f->chans[i] = ref.hold[i] = g_chans[i];
+		return;
+	}
+
+	ref.ramp++;
+	for (i = 0; i < NUM_CHNOUT; ++i)
+	{
+		const FailsafeData *p = &ref.policy[i];
+		int preset = p->value * RESX / 100;
+		int hold = ref.hold[i];
+
+		if (p->mode == FAILSAFE_PRESET
+				|| (p->mode == FAILSAFE_RAMP && ref.ramp >= p->frames))
+			f->chans[i] = preset;
+		else if (p->mode == FAILSAFE_RAMP)
+			f->chans[i] = hold + (preset - hold) * (int)ref.ramp / p->frames;
+		else
+			f->chans[i] = hold;
+	}
+}
+
+void TIM_SetCounter(TIM_TypeDef *tim, uint16_t value)
+{
+	Frame *f;
+	int i;
+
+	if (tim != TIM2)
+		return;
+
+	ppm_tim.cnt = value;
+	ppm_tim.base = now - value;
+	if (value != 0)
+		return;
+
+	// pulses.c restarts the count for every frame, once it is built.
+	if (n_frames == max_frames)
+		frames = grow(frames, &max_frames, sizeof(*frames));
+	f = &frames[n_frames++];
+	f->time = now;
+	expect_frame(f);
+	f->loads = 0;
+
+	if (g_failsafe != f->failsafe)
+		error(ERR_FAILSAFE, n_frames - 1, "reasons %02x, expected %02x",
+				g_failsafe, f->failsafe);
+	for (i = 0; i < 3; ++i)
+		if (f->failsafe & (1 << i))
+			failsafe_frames[i]++;
+}
+
+void TIM_SetAutoreload(TIM_TypeDef *tim, uint16_t value)
+{
+	if (tim == TIM2)
+		ppm_tim.arr = value;
+}
+
+void TIM_SetCompare1(TIM_TypeDef *tim, uint16_t value)
+{
+	if (tim != TIM2)
+		return;
+
+	ppm_tim.ccr = value;
+	if (n_frames == 0)
+		return;
+
+	if (++frames[n_frames - 1].loads == PULSES_WORDS + 1)
+		error(ERR_BUFFER, n_frames - 1, "more than %d compare values", PULSES_WORDS);
+	if (value <= TIM_GetCounter(TIM2) || value > ppm_tim.arr)
+		error(ERR_BEHIND, n_frames - 1, "compare %u, count %u, reload %u",
+				value, TIM_GetCounter(TIM2), ppm_tim.arr);
+}
+
+static uint64_t ppm_next_irq(void)
+{
+	if (!ppm_tim.on)
+		return NEVER;
+	if (ppm_tim.base + ppm_tim.ccr < now
+			|| (ppm_tim.base + ppm_tim.ccr == now && ppm_tim.fired == now))
+		ppm_tim.base += (uint32_t)ppm_tim.arr + 1;
+	return ppm_tim.base + ppm_tim.ccr;
+}
+
+uint16_t TIM_GetCapture1(TIM_TypeDef *tim) { (void)tim; return tim3_capture; }
+
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void NVIC_Init(NVIC_InitTypeDef *init) { (void)init; }
+void GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init) { (void)gpio; (void)init; }
+void TIM_DeInit(TIM_TypeDef *tim) { (void)tim; }
+void TIM_TimeBaseStructInit(TIM_TimeBaseInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_OCStructInit(TIM_OCInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_OC1Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_ICStructInit(TIM_ICInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_ICInit(TIM_TypeDef *tim, TIM_ICInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state) { (void)tim; (void)it; (void)state; }
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it) { (void)tim; (void)it; }
+
+/*
+ * Firmware modules that are not built here
+ */
+
+void watchdog_expect(uint8_t source, bool expect) { (void)source; (void)expect; }
+uint32_t stack_isr_enter(STACK_ISR isr) { (void)isr; return 0; }
+void stack_isr_exit(STACK_ISR isr, uint32_t mark) { (void)isr; (void)mark; }
+void capture_ppm_in(void) { }
+
+/*
+ * Test
+ */
+
+static void random_failsafe(void)
+{
+	int i;
+
+	// Mode 3 is out of range, and should hold.
+	for (i = 0; i < NUM_CHNOUT; ++i)
+	{
+		g_model.failsafe[i].mode = rnd_range(0, 3);
+		g_model.failsafe[i].frames = rnd_range(0, 20);
+		g_model.failsafe[i].value = rnd_range(-100, 100);
+	}
+}
+
+static void random_settings(void)
+{
+	if (extreme)
+	{
+		g_model.protocol = rnd_range(PROTO_PPM, PROTO_PPM16);
+		g_model.ppmNCH = (int8_t)rnd();
+		g_model.ppmDelay = (int8_t)rnd();
+		g_model.ppmFrameLength = (int8_t)rnd();
+	}
+	else
+	{
+		g_model.ppmNCH = rnd_range(1, NUM_CHNOUT);
+		g_model.ppmDelay = rnd_range(-4, 10);			// 100 - 800us stop
+		g_model.ppmFrameLength = rnd_range(-12, 7);		// 10.5 - 29.5ms
+	}
+	g_model.ppmStart = rnd_range(0, 7);
+	g_model.extendedLimits = rnd() & 1;
+	if (failsafe)
+		random_failsafe();
+}
+
+/**
+  * @brief  A mixer pass.
+  * @param  None
+  * @retval None
+  */
+static void random_chans(void)
+{
+	int i;
+
+	// Some of them past the limits.
+	for (i = 0; i < NUM_CHNOUT; ++i)
+		g_chans[i] = rnd_range(-1100, 1100);
+	g_mixer_passes++;
+	ref.trainer_used = trainer_mixed;
+	failsafe_ppm_in_used(trainer_mixed);
+}
+
+/**
+  * @brief  Send a trainer frame into the TIM3 capture ISR.
+  * @note	A 10ms sync then 8 centred channels, at 2 counts per us. The
+  *			ISR does not handle the capture wrapping, so each frame starts
+  *			from a stray edge at 0.
+  * @param  None
+  * @retval None
+  */
+static void trainer_frame(void)
+{
+	int i;
+
+	tim3_capture = 0;
+	TIM3_IRQHandler();
+	tim3_capture += 2 * 10000;
+	TIM3_IRQHandler();
+	for (i = 0; i < 8; ++i)
+	{
+		tim3_capture += 2 * CENTER;
+		TIM3_IRQHandler();
+	}
+	ref.trainer_age = 0;
+}
+
+/**
+  * @brief  Run the pulse ISR until the next end of frame.
+  * @param  None
+  * @retval false if the frame never ends.
+  */
+static bool run_frame(void)
+{
+	size_t frame = n_frames;
+	uint64_t limit = now + HANG_US;
+	struct timespec t0, t1;
+	uint64_t t, ns;
+
+	while (n_frames == frame)
+	{
+		t = ppm_next_irq();
+		if (t > limit)
+		{
+			error(ERR_HANG, frame - 1, "no end of frame");
+			return false;
+		}
+
+		now = t;
+		system_ticks = now / 1000;
+		ppm_tim.fired = now;
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		TIM2_IRQHandler();
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		ns = (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000 + t1.tv_nsec - t0.tv_nsec;
+		if (n_frames == frame)
+		{
+			isr_edge.n++;
+			isr_edge.total += ns;
+			if (ns < isr_edge.min) isr_edge.min = ns;
+			if (ns > isr_edge.max) isr_edge.max = ns;
+		}
+		else
+		{
+			isr_frame.n++;
+			isr_frame.total += ns;
+			if (ns < isr_frame.min) isr_frame.min = ns;
+			if (ns > isr_frame.max) isr_frame.max = ns;
+		}
+	}
+	return true;
+}
+
+/**
+  * @brief  Run one setting with a random failsafe event.
+  * @param  None
+  * @retval false if a frame never ends.
+  */
+static bool failsafe_setting(void)
+{
+	int event = rnd_range(0, 3);
+	int from = rnd_range(0, FAILSAFE_FRAMES / 2);
+	int to = from + rnd_range(1, FAILSAFE_FRAMES / 2);
+	int f;
+
+	trainer_mixed = (event == 3);
+
+	for (f = 0; f < FAILSAFE_FRAMES; ++f)
+	{
+		bool in_event = (f >= from && f < to);
+
+		if (!run_frame())
+			return false;
+
+		switch (event)
+		{
+		case 1:		// Mixer stops
+			if (!in_event)
+				random_chans();
+			break;
+		case 2:		// Model load, which scrambles g_model as it goes
+			if (in_event)
+			{
+				g_modelInvalid = 1;
+				g_model.ppmNCH = (int8_t)rnd();
+				g_model.ppmStart = rnd();
+				g_model.ppmDelay = (int8_t)rnd();
+				g_model.ppmFrameLength = (int8_t)rnd();
+				g_model.extendedLimits = rnd();
+				g_model.failsafe[rnd() % NUM_CHNOUT].mode = rnd();
+			}
+			else if (g_modelInvalid)
+			{
+				random_settings();
+				g_modelInvalid = 0;
+			}
+			random_chans();
+			break;
+		case 3:		// Trainer lost, and back if it ends in time
+			if (!in_event)
+				trainer_frame();
+			random_chans();
+			break;
+		default:
+			random_chans();
+			break;
+		}
+	}
+
+	// A load always ends with a valid model.
+	if (g_modelInvalid)
+	{
+		random_settings();
+		g_modelInvalid = 0;
+	}
+	return true;
+}
+
+static int stop_len(const Frame *f)
+{
+	return 300 + f->delay * 50;				// pulses.c PPM_STOP_LEN
+}
+
+static int channel_len(const Frame *f, int ch)
+{
+	int range = f->ext ? PPM_LIMIT_EXTENDED : PPM_LIMIT_NORMAL;
+	int v = f->chans[ch];
+
+	if (v > range) v = range;
+	if (v < -range) v = -range;
+	return CENTER + v;
+}
+
+static size_t frame_at(uint64_t time)
+{
+	size_t lo = 0, hi = n_frames;
+
+	// Last frame started at or before time.
+	while (hi - lo > 1)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (frames[mid].time <= time)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+  * @brief  Decode the waveform and check every frame.
+  * @note	Stop pulses are low, or high with pulsePol set.
+  * @param  None
+  * @retval None
+  */
+static void check_waveform(void)
+{
+	bool stop = g_model.pulsePol;
+	uint64_t *marks;
+	size_t n_marks = 0, i, m;
+
+	marks = malloc((n_edges + 1) * sizeof(*marks));
+	if (!marks)
+	{
+		perror("malloc");
+		exit(1);
+	}
+
+	// Stop pulses: start times, and widths while we are here.
+	for (i = 0; i < n_edges; ++i)
+	{
+		if (edges[i].level != stop)
+			continue;
+		marks[n_marks++] = edges[i].time;
+
+		if (i + 1 < n_edges)
+		{
+			size_t frame = frame_at(edges[i].time);
+			int width = edges[i + 1].time - edges[i].time;
+			if (frame >= WARMUP && width != stop_len(&frames[frame]))
+				error(ERR_STOP, frame, "stop pulse %d us, expected %d",
+						width, stop_len(&frames[frame]));
+		}
+	}
+
+	// Frames run from the end of one sync gap to the end of the next.
+	for (m = 1; m < n_marks; )
+	{
+		size_t first = m, frame;
+		const Frame *f, *prev;
+		int count = 0, expect, ch, total = 0, req, gap;
+
+		while (m < n_marks && marks[m] - marks[m - 1] < SYNC_DETECT)
+			m++;
+		if (m >= n_marks)
+			break;
+
+		frame = frame_at(marks[m]);
+		m++;
+		if (frame < WARMUP || frame + 1 >= n_frames)
+			continue;
+
+		f = &frames[frame];
+		prev = &frames[frame - 1];
+		checked++;
+
+		expect = f->nch;
+		if (expect < 0)
+			expect = 0;
+		if (expect > NUM_CHNOUT - f->start)
+			expect = NUM_CHNOUT - f->start;
+
+		count = (m - 1) - first;
+		if (count != expect)
+		{
+			error(ERR_COUNT, frame, "%d channels, expected %d", count, expect);
+			continue;
+		}
+
+		// The first channel follows the last stop pulse of the frame before.
+		for (ch = 0; ch < count; ++ch)
+		{
+			int width = marks[first + ch] - marks[first + ch - 1];
+			int want = channel_len(f, f->start + ch) + stop_len(ch ? f : prev);
+
+			if (width != want)
+				error(ERR_WIDTH, frame, "channel %d is %d us, expected %d",
+						f->start + ch + 1, width, want);
+			total += channel_len(f, f->start + ch) + stop_len(f);
+		}
+
+		req = 22500 + f->frame_len * 1000;
+		gap = req - total;
+		if (gap < MIN_GAP)
+			gap = MIN_GAP;
+		gap += stop_len(count ? f : prev);
+		if ((int)(marks[m - 1] - marks[m - 2]) != gap)
+			error(ERR_SYNC, frame, "sync %d us, expected %d",
+					(int)(marks[m - 1] - marks[m - 2]), gap);
+	}
+
+	free(marks);
+}
+
+static void write_vcd(const char *path)
+{
+	FILE *f = fopen(path, "w");
+	size_t i;
+
+	if (!f)
+	{
+		perror(path);
+		return;
+	}
+
+	fprintf(f, "$timescale 1us $end\n$scope module pulses $end\n");
+	fprintf(f, "$var wire 1 ! ppm_out $end\n$upscope $end\n$enddefinitions $end\n");
+	fprintf(f, "#0\n$dumpvars\n0!\n$end\n");
+	for (i = 0; i < n_edges; ++i)
+		fprintf(f, "#%llu\n%d!\n", (unsigned long long)edges[i].time, edges[i].level);
+	fclose(f);
+}
+
+static void print_isr(const char *name, unsigned long n, uint64_t min, uint64_t max, uint64_t total)
+{
+	if (n)
+		fprintf(stderr, "%s: %lu, ns min %llu avg %llu max %llu\n", name, n,
+				(unsigned long long)min, (unsigned long long)(total / n),
+				(unsigned long long)max);
+}
+
+int main(int argc, char **argv)
+{
+	const char *vcd = NULL;
+	unsigned long settings = 1000, s;
+	unsigned long total = 0;
+	int opt, i, f;
+
+	rng = time(NULL);
+	while ((opt = getopt(argc, argv, "xfn:s:v:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'x':
+			extreme = true;
+			break;
+		case 'f':
+			failsafe = true;
+			break;
+		case 'n':
+			settings = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			rng = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			vcd = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-x] [-f] [-n settings] [-s seed] [-v file.vcd]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (rng == 0)
+		rng = 1;
+	fprintf(stderr, "seed %u\n", rng);
+
+	// The defaults of a new model.
+	g_model.protocol = PROTO_PPM;
+	g_model.extendedLimits = true;
+	g_model.ppmFrameLength = 8;
+	g_model.ppmDelay = 6;
+	g_model.ppmNCH = 8;
+	g_model.pulsePol = rnd() & 1;
+	random_chans();
+	pulses_init();
+
+	for (s = 0; s < settings; ++s)
+	{
+		if (failsafe)
+		{
+			if (!failsafe_setting())
+				break;
+			random_settings();
+			continue;
+		}
+
+		for (f = 0; f < FRAMES_PER_SETTING; ++f)
+		{
+			if (!run_frame())
+				break;
+			random_chans();
+		}
+		if (f < FRAMES_PER_SETTING)
+			break;
+		random_settings();
+	}
+	run_frame();
+
+	if (!extreme)
+		check_waveform();
+	if (vcd)
+		write_vcd(vcd);
+
+	fprintf(stderr, "%zu frames, %zu edges, %lu frames decoded\n", n_frames, n_edges, checked);
+	if (failsafe)
+		fprintf(stderr, "failsafe frames: mixer %lu, model %lu, trainer %lu\n",
+				failsafe_frames[0], failsafe_frames[1], failsafe_frames[2]);
+	print_isr("edge isr", isr_edge.n, isr_edge.min, isr_edge.max, isr_edge.total);
+	print_isr("frame isr", isr_frame.n, isr_frame.min, isr_frame.max, isr_frame.total);
+	for (i = 0; i < ERR_END; ++i)
+	{
+		if (errors[i])
+			fprintf(stderr, "%s errors: %lu\n", err_names[i], errors[i]);
+		total += errors[i];
+	}
+
+	return total ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#
+#                  Copyright 2014 ARTaylor.co.uk
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+
+# Description:
+#
+# Static RAM by module, from the GNU ld map file, checked against the
+# RAM size and stack budget in firmware/stack.h.
+# Counts the .data, .bss and .noinit output sections. Library members
+# are grouped by archive, alignment padding is shown as (fill).
+# Exits with 1 if static data no longer leaves room for the stack.
+#
+# Run by the firmware build (all-local in firmware/Makefile.am), or:
+# Usage:  awk -f ramreport.awk firmware/stack.h ar-t6-firmware.map
+#
+
+function module(path)
+{
+	sub(/^.*\//, "", path)
+	sub(/\(.*\)$/, "", path)
+	sub(/^ar_t6_firmware-/, "", path)
+	sub(/\.o$/, "", path)
+	return path
+}
+
+function add(path, size)
+{
+	size = hex(size)
+	if (size == 0)
+		return
+	m = (path == "(fill)") ? path : module(path)
+	if (!(m in total))
+		modules[++n_modules] = m
+	total[m] += size
+	bytes[m, section] += size
+	sum[section] += size
+}
+
+function hex(s,    v, i, c)
+{
+	v = 0
+	s = tolower(s)
+	sub(/^0x/, "", s)
+	for (i = 1; i <= length(s); i++) {
+		c = index("0123456789abcdef", substr(s, i, 1))
+		if (c == 0)
+			break
+		v = v * 16 + c - 1
+	}
+	return v
+}
+
+# Budget from stack.h
+FNR == NR {
+	if ($1 == "#define" && $2 == "STACK_RAM_SIZE")
+		ram_size = $3 + 0
+	if ($1 == "#define" && $2 == "STACK_BUDGET")
+		budget = $3 + 0
+	next
+}
+
+/^Linker script and memory map/ {
+	in_map = 1
+	next
+}
+
+!in_map {
+	next
+}
+
+# Output section (or anything else at the start of a line)
+/^[^ ]/ {
+	section = ($1 == ".data" || $1 == ".bss" || $1 == ".noinit") ? $1 : ""
+	pending = ""
+	next
+}
+
+section == "" {
+	next
+}
+
+# Input section name too long for one line, the rest follows.
+NF == 1 && $1 ~ /^\./ {
+	pending = $1
+	next
+}
+
+pending != "" && $1 ~ /^0x/ && NF >= 3 {
+	add($3, $2)
+	pending = ""
+	next
+}
+
+$1 == "*fill*" {
+	add("(fill)", $3)
+	next
+}
+
+($1 ~ /^\./ || $1 == "COMMON") && NF >= 4 {
+	add($4, $3)
+	next
+}
+
+END {
+	if (!ram_size || !budget) {
+		print "ramreport: no STACK_RAM_SIZE / STACK_BUDGET found" > "/dev/stderr"
+		exit 1
+	}
+
+	# Largest first
+	for (i = 1; i <= n_modules; i++)
+		for (j = i + 1; j <= n_modules; j++)
+			if (total[modules[j]] > total[modules[i]]) {
+				t = modules[i]; modules[i] = modules[j]; modules[j] = t
+			}
+
+	printf("%-16s %6s %6s %6s %6s\n", "Static RAM", ".data", ".bss", ".noinit", "total")
+	for (i = 1; i <= n_modules; i++) {
+		m = modules[i]
+		printf("%-16s %6d %6d %6d %6d\n", m,
+				bytes[m, ".data"], bytes[m, ".bss"], bytes[m, ".noinit"], total[m])
+	}
+	used = sum[".data"] + sum[".bss"] + sum[".noinit"]
+	printf("%-16s %6d %6d %6d %6d\n", "total",
+			sum[".data"], sum[".bss"], sum[".noinit"], used)
+
+	limit = ram_size - budget
+	printf("RAM %d, stack budget %d: static limit %d, %d spare\n",
+			ram_size, budget, limit, limit - used)
+	if (used > limit) {
+		printf("ramreport: static RAM is %d bytes over budget\n", used - limit) > "/dev/stderr"
+		exit 1
+	}
+}
@@ -0,0 +1,146 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host side decoder for the flight recorder (firmware/recorder.c).
+ * Reads either a full EEPROM image or just the recorder region and
+ * writes the samples as CSV to stdout.
+ *
+ * Build:  cc -o recdecode recdecode.c
+ * Usage:  recdecode eeprom.bin > flight.csv
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../firmware/recorder.h"
+
+static const uint8_t *bits_data;
+static unsigned bits_pos;
+
+static unsigned get_bits(unsigned n)
+{
+	unsigned v = 0;
+
+	while (n--) {
+		v = (v << 1) | ((bits_data[bits_pos >> 3] >> (7 - (bits_pos & 7))) & 1);
+		bits_pos++;
+	}
+	return v;
+}
+
+static int sign_extend(unsigned v, unsigned bits)
+{
+	if (v & (1u << (bits - 1)))
+		return (int) v - (1 << bits);
+	return (int) v;
+}
+
+int main(int argc, char *argv[])
+{
+	static uint8_t image[EEPROM_SIZE];
+	const uint8_t *region;
+	RecorderHeader hdr;
+	unsigned long time_ms = 0;
+	size_t len;
+	FILE *f;
+	int b, i;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <eeprom.bin | recorder.bin>\n", argv[0]);
+		return 1;
+	}
+
+	f = fopen(argv[1], "rb");
+	if (!f) {
+		perror(argv[1]);
+		return 1;
+	}
+	len = fread(image, 1, sizeof(image), f);
+	fclose(f);
+
+	if (len == EEPROM_SIZE)
+		region = &image[RECORDER_EEPROM_BASE];
+	else if (len >= RECORDER_EEPROM_HDR)
+		region = image;
+	else {
+		fprintf(stderr, "%s: file too short\n", argv[1]);
+		return 1;
+	}
+
+	// The header is little endian, the same as the target.
+	hdr.magic = region[0] | (region[1] << 8);
+	hdr.version = region[2];
+	hdr.blocks = region[3];
+	hdr.block_size = region[4];
+	hdr.channels = region[5];
+	hdr.period_ms = region[6] | (region[7] << 8);
+
+	if (hdr.magic != RECORDER_MAGIC || hdr.version != RECORDER_VERSION) {
+		fprintf(stderr, "%s: no recording found\n", argv[1]);
+		return 1;
+	}
+	if (hdr.block_size != RECORDER_BLOCK_SIZE || hdr.channels != RECORDER_CHANNELS ||
+			hdr.blocks > RECORDER_BLOCKS ||
+			(size_t) (RECORDER_EEPROM_HDR + hdr.blocks * hdr.block_size) > len - (region - image)) {
+		fprintf(stderr, "%s: unsupported or truncated recording\n", argv[1]);
+		return 1;
+	}
+
+	printf("time_ms");
+	for (i = 0; i < RECORDER_CHANNELS; i++)
+		printf(",ch%d", i + 1);
+	printf(",swa,swb,swc,swd\n");
+
+	for (b = 0; b < hdr.blocks; b++) {
+		const uint8_t *blk = region + RECORDER_EEPROM_HDR + b * RECORDER_BLOCK_SIZE;
+		unsigned samples = blk[2];
+		unsigned step = blk[3] * hdr.period_ms;
+		int last[RECORDER_CHANNELS] = { 0 };
+		unsigned sw = 0;
+		unsigned s;
+
+		bits_data = blk;
+		bits_pos = RECORDER_BLOCK_HDR * 8;
+
+		for (s = 0; s < samples; s++) {
+			for (i = 0; i < RECORDER_CHANNELS; i++) {
+				if (!get_bits(1))
+					continue;
+				if (!get_bits(1))
+					last[i] += sign_extend(get_bits(4), 4);
+				else if (!get_bits(1))
+					last[i] += sign_extend(get_bits(7), 7);
+				else
+					last[i] = sign_extend(get_bits(12), 12);
+			}
+			if (get_bits(1))
+				sw = get_bits(4);
+
+			printf("%lu", time_ms);
+			for (i = 0; i < RECORDER_CHANNELS; i++)
+				printf(",%d", last[i]);
+			for (i = 0; i < 4; i++)
+				printf(",%u", (sw >> i) & 1);
+			printf("\n");
+
+			time_ms += step;
+		}
+	}
+
+	return 0;
+}
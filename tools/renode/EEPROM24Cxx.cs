@@ -0,0 +1,130 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * 24Cxx I2C EEPROM with two address bytes, as used by
+ * firmware/storage_i2c.c. Writes wrap within a page, reads run on
+ * through the whole array. Writes complete at once.
+ *
+ * Set BackingFile to keep the contents between runs; it is loaded when
+ * set and saved at the end of every write.
+ *
+ */
+
+using System;
+using System.IO;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+
+namespace Antmicro.Renode.Peripherals.I2C
+{
+    public class EEPROM24Cxx : II2CPeripheral
+    {
+        public EEPROM24Cxx(int size = 8192, int pageSize = 32)
+        {
+            if(size <= 0 || (size & (size - 1)) != 0 || pageSize <= 0 || (pageSize & (pageSize - 1)) != 0)
+            {
+                throw new ArgumentException("size and pageSize must be powers of two");
+            }
+            this.pageSize = pageSize;
+            memory = new byte[size];
+            Erase();
+        }
+
+        public void Reset()
+        {
+            addressBytes = 0;
+            address = 0;
+            written = false;
+        }
+
+        public void Erase()
+        {
+            for(var i = 0; i < memory.Length; i++)
+            {
+                memory[i] = 0xFF;
+            }
+        }
+
+        public void Write(byte[] data)
+        {
+            foreach(var b in data)
+            {
+                if(addressBytes == 0)
+                {
+                    address = b << 8;
+                    addressBytes++;
+                }
+                else if(addressBytes == 1)
+                {
+                    address = (address | b) & (memory.Length - 1);
+                    addressBytes++;
+                }
+                else
+                {
+                    memory[address] = b;
+                    address = (address & ~(pageSize - 1)) | ((address + 1) & (pageSize - 1));
+                    written = true;
+                }
+            }
+        }
+
+        public byte[] Read(int count = 1)
+        {
+            var result = new byte[count];
+            for(var i = 0; i < count; i++)
+            {
+                result[i] = memory[address];
+                address = (address + 1) & (memory.Length - 1);
+            }
+            return result;
+        }
+
+        public void FinishTransmission()
+        {
+            addressBytes = 0;
+            if(written && backingFile != null)
+            {
+                File.WriteAllBytes(backingFile, memory);
+            }
+            written = false;
+        }
+
+        public string BackingFile
+        {
+            get { return backingFile; }
+            set
+            {
+                backingFile = value;
+                if(backingFile != null && File.Exists(backingFile))
+                {
+                    var data = File.ReadAllBytes(backingFile);
+                    if(data.Length != memory.Length)
+                    {
+                        this.Log(LogLevel.Warning, "{0} is {1} bytes, expected {2}", backingFile, data.Length, memory.Length);
+                    }
+                    Array.Copy(data, memory, Math.Min(data.Length, memory.Length));
+                }
+            }
+        }
+
+        private readonly byte[] memory;
+        private readonly int pageSize;
+        private string backingFile;
+        private int address;
+        private int addressBytes;
+        private bool written;
+    }
+}
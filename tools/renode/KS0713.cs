@@ -0,0 +1,241 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * KS0713 132x65 LCD controller on the bit-banged parallel bus of
+ * firmware/lcd.c. GPIO 0-7 are D0-D7, then RD (E), WR, A0, RES and CS1.
+ * A byte is taken when CS1 goes high again, as a command when A0 is low.
+ *
+ * "lcd Show" prints the panel, "lcd Dump @file.pbm" saves it.
+ *
+ */
+
+using System;
+using System.IO;
+using System.Text;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+
+namespace Antmicro.Renode.Peripherals.Miscellaneous
+{
+    public class KS0713 : IGPIOReceiver
+    {
+        public KS0713()
+        {
+            ram = new byte[Pages, Columns];
+            pins = new bool[PinCount];
+            Reset();
+        }
+
+        public void Reset()
+        {
+            Array.Clear(pins, 0, pins.Length);
+            ResetRegisters();
+        }
+
+        public void OnGPIO(int number, bool value)
+        {
+            if(number < 0 || number >= PinCount)
+            {
+                this.Log(LogLevel.Warning, "Unexpected GPIO {0}", number);
+                return;
+            }
+
+            var was = pins[number];
+            pins[number] = value;
+
+            if(number == ResPin && was && !value)
+            {
+                ResetRegisters();
+            }
+            else if(number == Cs1Pin && !was && value && pins[ResPin] && !pins[WrPin])
+            {
+                byte data = 0;
+                for(var i = 0; i < 8; i++)
+                {
+                    if(pins[i])
+                    {
+                        data |= (byte)(1 << i);
+                    }
+                }
+
+                if(pins[A0Pin])
+                {
+                    WriteData(data);
+                }
+                else
+                {
+                    WriteCommand(data);
+                }
+            }
+        }
+
+        public bool GetPixel(int x, int y)
+        {
+            if(!displayOn)
+            {
+                return false;
+            }
+            if(allOn)
+            {
+                return true;
+            }
+
+            var column = segReverse ? Columns - 1 - x : x;
+            var line = (y + startLine) % (Pages * 8);
+            var on = (ram[line / 8, column] & (1 << (line % 8))) != 0;
+            return on != inverse;
+        }
+
+        public string Show()
+        {
+            var sb = new StringBuilder();
+            for(var y = 0; y < Height; y++)
+            {
+                for(var x = 0; x < Width; x++)
+                {
+                    sb.Append(GetPixel(x, y) ? '#' : '.');
+                }
+                sb.Append('\n');
+            }
+            return sb.ToString();
+        }
+
+        public void Dump(string path)
+        {
+            using(var writer = new StreamWriter(path))
+            {
+                writer.Write("P1\n{0} {1}\n", Width, Height);
+                for(var y = 0; y < Height; y++)
+                {
+                    for(var x = 0; x < Width; x++)
+                    {
+                        writer.Write(GetPixel(x, y) ? "1 " : "0 ");
+                    }
+                    writer.Write('\n');
+                }
+            }
+        }
+
+        public byte Contrast { get; private set; }
+
+        private void ResetRegisters()
+        {
+            page = 0;
+            column = 0;
+            startLine = 0;
+            segReverse = false;
+            inverse = false;
+            allOn = false;
+            displayOn = false;
+            pendingCommand = 0;
+        }
+
+        private void WriteData(byte data)
+        {
+            if(column < Columns)
+            {
+                ram[page, column++] = data;
+            }
+        }
+
+        private void WriteCommand(byte cmd)
+        {
+            // Second byte of a two byte command.
+            if(pendingCommand != 0)
+            {
+                if(pendingCommand == SetRefVoltage)
+                {
+                    Contrast = cmd;
+                }
+                pendingCommand = 0;
+                return;
+            }
+
+            if(cmd == SetRefVoltage || (cmd & 0xFE) == StaticIndicator)
+            {
+                pendingCommand = cmd;
+            }
+            else if((cmd & 0xF0) == 0xB0)
+            {
+                page = (cmd & 0x0F) % Pages;
+            }
+            else if((cmd & 0xF0) == 0x10)
+            {
+                column = (column & 0x0F) | ((cmd & 0x0F) << 4);
+            }
+            else if((cmd & 0xF0) == 0x00)
+            {
+                column = (column & 0xF0) | (cmd & 0x0F);
+            }
+            else if((cmd & 0xC0) == 0x40)
+            {
+                startLine = cmd & 0x3F;
+            }
+            else if((cmd & 0xFE) == 0xA0)
+            {
+                segReverse = (cmd & 1) != 0;
+            }
+            else if((cmd & 0xFE) == 0xA6)
+            {
+                inverse = (cmd & 1) != 0;
+            }
+            else if((cmd & 0xFE) == 0xA4)
+            {
+                allOn = (cmd & 1) != 0;
+            }
+            else if((cmd & 0xFE) == 0xAE)
+            {
+                displayOn = (cmd & 1) != 0;
+            }
+            else if(cmd == SoftReset)
+            {
+                // Leaves the display RAM and the on / off state alone.
+                page = 0;
+                column = 0;
+                startLine = 0;
+            }
+            // Bias, power control, resistor ratio, SHL and read-modify-write
+            // change nothing we can show.
+        }
+
+        private readonly byte[,] ram;
+        private readonly bool[] pins;
+
+        private int page;
+        private int column;
+        private int startLine;
+        private bool segReverse;
+        private bool inverse;
+        private bool allOn;
+        private bool displayOn;
+        private byte pendingCommand;
+
+        private const int Width = 128;
+        private const int Height = 64;
+        private const int Pages = 8;
+        private const int Columns = 132;
+
+        private const int PinCount = 13;
+        private const int WrPin = 9;
+        private const int A0Pin = 10;
+        private const int ResPin = 11;
+        private const int Cs1Pin = 12;
+
+        private const byte SetRefVoltage = 0x81;
+        private const byte StaticIndicator = 0xAC;
+        private const byte SoftReset = 0xE2;
+    }
+}
@@ -0,0 +1,160 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Logic analyser for the PPM pins. GPIO 0 is PPM_OUT (PA11), GPIO 1 is
+ * PPM_IN (PA7), which mirrors PPM_OUT when the trainer port is an output.
+ *
+ * Every level change is written, with its virtual time in us, to the VCD
+ * file given in OutputFile. "ppm Stats" prints the edge count and the
+ * shortest and longest PPM_OUT frame seen, measured between the long
+ * end-of-frame gaps.
+ *
+ */
+
+using System;
+using System.IO;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+
+namespace Antmicro.Renode.Peripherals.Miscellaneous
+{
+    public class PPMAnalyser : IGPIOReceiver
+    {
+        public PPMAnalyser(IMachine machine)
+        {
+            this.machine = machine;
+            levels = new bool[Signals.Length];
+            lastEdge = new ulong[Signals.Length];
+            Reset();
+        }
+
+        public void Reset()
+        {
+            Array.Clear(levels, 0, levels.Length);
+            Array.Clear(lastEdge, 0, lastEdge.Length);
+            edges = 0;
+            frameStart = 0;
+            frameMin = ulong.MaxValue;
+            frameMax = 0;
+            lastTime = ulong.MaxValue;
+        }
+
+        public void OnGPIO(int number, bool value)
+        {
+            if(number < 0 || number >= Signals.Length)
+            {
+                this.Log(LogLevel.Warning, "Unexpected GPIO {0}", number);
+                return;
+            }
+            if(levels[number] == value)
+            {
+                return;
+            }
+
+            var now = machine.LocalTimeSource.ElapsedVirtualTime.TotalMicroseconds;
+            var width = now - lastEdge[number];
+            levels[number] = value;
+            lastEdge[number] = now;
+
+            if(number == 0)
+            {
+                edges++;
+                // A frame starts at the first edge after the sync gap.
+                if(width >= SyncGap)
+                {
+                    if(frameStart != 0)
+                    {
+                        var length = now - frameStart;
+                        frameMin = Math.Min(frameMin, length);
+                        frameMax = Math.Max(frameMax, length);
+                    }
+                    frameStart = now;
+                }
+            }
+
+            if(writer != null)
+            {
+                if(now != lastTime)
+                {
+                    writer.Write("#{0}\n", now);
+                    lastTime = now;
+                }
+                writer.Write("{0}{1}\n", value ? '1' : '0', Ids[number]);
+            }
+        }
+
+        public string OutputFile
+        {
+            get { return outputFile; }
+            set
+            {
+                Close();
+                outputFile = value;
+                if(outputFile == null)
+                {
+                    return;
+                }
+
+                writer = new StreamWriter(outputFile) { AutoFlush = true };
+                writer.Write("$timescale 1us $end\n$scope module fst6 $end\n");
+                for(var i = 0; i < Signals.Length; i++)
+                {
+                    writer.Write("$var wire 1 {0} {1} $end\n", Ids[i], Signals[i]);
+                }
+                writer.Write("$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+                for(var i = 0; i < Signals.Length; i++)
+                {
+                    writer.Write("{0}{1}\n", levels[i] ? '1' : '0', Ids[i]);
+                }
+                writer.Write("$end\n");
+                lastTime = 0;
+            }
+        }
+
+        public void Close()
+        {
+            if(writer != null)
+            {
+                writer.Dispose();
+                writer = null;
+            }
+        }
+
+        public string Stats()
+        {
+            if(frameMax == 0)
+            {
+                return string.Format("{0} edges, no complete frame", edges);
+            }
+            return string.Format("{0} edges, frame {1}-{2} us", edges, frameMin, frameMax);
+        }
+
+        private readonly IMachine machine;
+        private readonly bool[] levels;
+        private readonly ulong[] lastEdge;
+        private StreamWriter writer;
+        private string outputFile;
+        private ulong edges;
+        private ulong frameStart;
+        private ulong frameMin;
+        private ulong frameMax;
+        private ulong lastTime;
+
+        private const ulong SyncGap = 4000;
+        private static readonly string[] Signals = { "ppm_out", "ppm_in" };
+        private static readonly char[] Ids = { '!', '"' };
+    }
+}
@@ -0,0 +1,207 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * STM32F1 ADC1 with the stick, pot and battery voltages set from the
+ * monitor, e.g. "adc1 SetChannel 2 300".
+ *
+ * Only what firmware/sticks.c uses is there: a regular scan sequence,
+ * calibration (completes at once) and a DMA request per conversion. The
+ * TIM4 CC4 trigger is not wired up; when external triggering is enabled
+ * the scan runs every triggerPeriod ms (20) on its own, which is what TIM4 is
+ * set up to do.
+ *
+ */
+
+using System;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.Timers;
+using Antmicro.Renode.Time;
+
+namespace Antmicro.Renode.Peripherals.Analog
+{
+    public class StickADC : IDoubleWordPeripheral, IKnownSize
+    {
+        public StickADC(IMachine machine, int triggerPeriod = 20)
+        {
+            DMARequest = new GPIO();
+            channels = new ushort[ChannelCount];
+            trigger = new LimitTimer(machine.ClockSource, 1000, this, "trigger", (ulong)triggerPeriod,
+                    direction: Direction.Ascending, eventEnabled: true, autoUpdate: true);
+            trigger.LimitReached += Convert;
+
+            for(var i = 0; i < ChannelCount; i++)
+            {
+                channels[i] = 2048;
+            }
+            Reset();
+        }
+
+        public void Reset()
+        {
+            trigger.Reset();
+            sr = cr1 = cr2 = dr = 0;
+            sqr1 = sqr2 = sqr3 = 0;
+            DMARequest.Unset();
+        }
+
+        public void SetChannel(int channel, ushort value)
+        {
+            if(channel < 0 || channel >= ChannelCount)
+            {
+                throw new ArgumentException("No such channel");
+            }
+            channels[channel] = (ushort)(value & 0xFFF);
+        }
+
+        public ushort GetChannel(int channel)
+        {
+            return channels[channel];
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch((Registers)offset)
+            {
+            case Registers.Status:
+                return sr;
+            case Registers.Control1:
+                return cr1;
+            case Registers.Control2:
+                // Calibration is instant.
+                return cr2 & ~(Cr2Cal | Cr2ResetCal | Cr2SwStart);
+            case Registers.Sequence1:
+                return sqr1;
+            case Registers.Sequence2:
+                return sqr2;
+            case Registers.Sequence3:
+                return sqr3;
+            case Registers.Data:
+                sr &= ~SrEndOfConversion;
+                return dr;
+            default:
+                this.Log(LogLevel.Noisy, "Read from unmodelled register 0x{0:X}", offset);
+                return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch((Registers)offset)
+            {
+            case Registers.Status:
+                // Bits are cleared by writing zero.
+                sr &= value;
+                break;
+            case Registers.Control1:
+                cr1 = value;
+                break;
+            case Registers.Control2:
+                cr2 = value;
+                trigger.Enabled = (cr2 & Cr2AdOn) != 0 && (cr2 & Cr2ExtTrig) != 0;
+                if((cr2 & Cr2AdOn) != 0 && (cr2 & Cr2SwStart) != 0)
+                {
+                    Convert();
+                }
+                break;
+            case Registers.Sequence1:
+                sqr1 = value;
+                break;
+            case Registers.Sequence2:
+                sqr2 = value;
+                break;
+            case Registers.Sequence3:
+                sqr3 = value;
+                break;
+            default:
+                this.Log(LogLevel.Noisy, "Write to unmodelled register 0x{0:X}: 0x{1:X}", offset, value);
+                break;
+            }
+        }
+
+        public long Size => 0x400;
+
+        public GPIO DMARequest { get; }
+
+        private void Convert()
+        {
+            var length = (int)((sqr1 >> 20) & 0xF) + 1;
+
+            for(var rank = 0; rank < length; rank++)
+            {
+                uint sq;
+                if(rank < 6)
+                {
+                    sq = sqr3 >> (5 * rank);
+                }
+                else if(rank < 12)
+                {
+                    sq = sqr2 >> (5 * (rank - 6));
+                }
+                else
+                {
+                    sq = sqr1 >> (5 * (rank - 12));
+                }
+
+                var channel = (int)(sq & 0x1F);
+                dr = channel < ChannelCount ? channels[channel] : 0u;
+                sr |= SrEndOfConversion | SrStarted;
+
+                if((cr2 & Cr2Dma) != 0)
+                {
+                    DMARequest.Set();
+                    DMARequest.Unset();
+                }
+
+                // Without scan mode only the first rank is converted.
+                if((cr1 & Cr1Scan) == 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        private readonly ushort[] channels;
+        private readonly LimitTimer trigger;
+
+        private uint sr, cr1, cr2, dr;
+        private uint sqr1, sqr2, sqr3;
+
+        private const int ChannelCount = 18;
+
+        private const uint SrEndOfConversion = 1u << 1;
+        private const uint SrStarted = 1u << 4;
+        private const uint Cr1Scan = 1u << 8;
+        private const uint Cr2AdOn = 1u << 0;
+        private const uint Cr2Cal = 1u << 2;
+        private const uint Cr2ResetCal = 1u << 3;
+        private const uint Cr2Dma = 1u << 8;
+        private const uint Cr2ExtTrig = 1u << 20;
+        private const uint Cr2SwStart = 1u << 22;
+
+        private enum Registers : long
+        {
+            Status = 0x00,
+            Control1 = 0x04,
+            Control2 = 0x08,
+            Sequence1 = 0x2C,
+            Sequence2 = 0x30,
+            Sequence3 = 0x34,
+            Data = 0x4C,
+        }
+    }
+}
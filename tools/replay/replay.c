@@ -0,0 +1,514 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Replays a capture taken with "artlink capture" through the real stick
+ * normalisation, mixer and PPM encoder (firmware/sticks.c, mixer.c and
+ * pulses.c) on the host, against simulated time.
+ *
+ * The settings and model stored in the trace are loaded, then each record
+ * is applied at its capture time:
+ *   ADC     adc_data and the switches are set, the sticks are normalised
+ *           and the DMA handler runs the mixer
+ *   KEY     trim keys go to mixer_input_trim() and the instant trim keys
+ *           to mixer_instant_trim(), the GUI is not simulated
+ *   PPM_IN  g_ppmIns is set from the decoded trainer frame
+ * TIM2 and the PPM-OUT pin are modelled, so the pulse ISR runs when the
+ * hardware would run it.
+ *
+ * Every PPM frame is printed as its start time and the time of each edge
+ * from that start, all in us. The summary gives a CRC of all frames, so
+ * that two builds can be compared on the same trace, and the host time
+ * taken by each mixer pass (not a measure of target cycles).
+ *
+ * Build:  cc -no-pie -I../hoststub -o replay replay.c ../../firmware/sticks.c
+ *             ../../firmware/mixer.c ../../firmware/pulses.c
+ *             ../../firmware/failsafe.c
+ * Usage:  replay [-q] trace
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "stm32f10x.h"
+#include "../../firmware/myeeprom.h"
+#include "../../firmware/sticks.h"
+#include "../../firmware/mixer.h"
+#include "../../firmware/pulses.h"
+#include "../../firmware/keypad.h"
+#include "../../firmware/tasks.h"
+#include "../../firmware/gui.h"
+#include "../../firmware/sound.h"
+#include "../../firmware/startup.h"
+#include "../../firmware/recorder.h"
+#include "../../firmware/watchdog.h"
+#include "../../firmware/stack.h"
+#include "../../firmware/capture.h"
+
+#define PPM_OUT_PIN		(1 << 11)	// pulses.c PPM_OUT
+#define MAX_EDGES		64
+#define NEVER			UINT64_MAX
+
+// Firmware interrupt handlers
+void TIM2_IRQHandler(void);
+void DMA1_Channel1_IRQHandler(void);
+
+// Firmware globals owned by modules that are not built here
+volatile EEGeneral g_eeGeneral;
+volatile ModelData g_model;
+volatile uint8_t g_modelInvalid;
+volatile uint32_t system_ticks;
+volatile uint8_t g_watchdog_beats[WATCHDOG_SOURCES];
+uint8_t SlaveMode;
+
+// Peripherals
+static GPIO_TypeDef gpioa;
+static TIM_TypeDef tim2, tim3, tim4;
+static ADC_TypeDef adc1;
+static DMA_Channel_TypeDef dma1_ch1;
+static SysTick_Type systick = { 0, 23999, 0 };
+GPIO_TypeDef *GPIOA = &gpioa;
+TIM_TypeDef *TIM2 = &tim2, *TIM3 = &tim3, *TIM4 = &tim4;
+ADC_TypeDef *ADC1 = &adc1;
+DMA_Channel_TypeDef *DMA1_Channel1 = &dma1_ch1;
+SysTick_Type *SysTick = &systick;
+uint32_t SystemCoreClock = 24000000;
+
+static uint64_t now;				// us
+static uint8_t switch_state;
+static bool quiet;
+
+// TIM2 at 1MHz, compare channel 1 only
+static struct
+{
+	bool on;
+	uint64_t base;		// Time at which the counter was 0
+	uint16_t cnt;		// Count while stopped
+	uint16_t arr, ccr;
+	uint64_t fired;		// Time of the last interrupt
+} ppm_tim = { .fired = NEVER };
+
+// The frame being generated
+static uint64_t frame_start;
+static uint32_t edges[MAX_EDGES];
+static unsigned n_edges;
+
+// Summary
+static unsigned long frames;
+static uint32_t crc = 0xFFFFFFFF;
+static unsigned long passes;
+static uint64_t ns_min = NEVER, ns_max, ns_total;
+
+/*
+ * Output
+ */
+
+static void crc_add(uint32_t v)
+{
+	int i, b;
+
+	for (i = 0; i < 4; ++i)
+	{
+		crc ^= (v >> (i * 8)) & 0xFF;
+		for (b = 0; b < 8; ++b)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+}
+
+static void frame_end(void)
+{
+	unsigned i;
+
+	if (n_edges == 0)
+		return;
+
+	frames++;
+	crc_add((uint32_t)frame_start);
+	crc_add(n_edges);
+	for (i = 0; i < n_edges; ++i)
+		crc_add(edges[i]);
+
+	if (!quiet)
+	{
+		printf("%llu", (unsigned long long)frame_start);
+		for (i = 0; i < n_edges; ++i)
+			printf(" %u", edges[i]);
+		printf("\n");
+	}
+
+	n_edges = 0;
+}
+
+static void ppm_pin(GPIO_TypeDef *gpio, uint16_t pins, bool level)
+{
+	if (gpio != GPIOA || !(pins & PPM_OUT_PIN))
+		return;
+	if (((gpio->ODR & PPM_OUT_PIN) != 0) == level)
+		return;
+
+	gpio->ODR ^= PPM_OUT_PIN;
+	if (n_edges == 0)
+		frame_start = now;
+	if (n_edges < MAX_EDGES)
+		edges[n_edges++] = now - frame_start;
+}
+
+/*
+ * Peripheral model
+ */
+
+void GPIO_SetBits(GPIO_TypeDef *gpio, uint16_t pins) { ppm_pin(gpio, pins, true); }
+void GPIO_ResetBits(GPIO_TypeDef *gpio, uint16_t pins) { ppm_pin(gpio, pins, false); }
+
+uint16_t TIM_GetCounter(TIM_TypeDef *tim)
+{
+	if (tim != TIM2)
+		return 0;
+	return ppm_tim.on ? (uint16_t)(now - ppm_tim.base) : ppm_tim.cnt;
+}
+
+void TIM_Cmd(TIM_TypeDef *tim, FunctionalState state)
+{
+	if (tim != TIM2 || (state == ENABLE) == ppm_tim.on)
+		return;
+
+	if (state == ENABLE)
+		ppm_tim.base = now - ppm_tim.cnt;
+	else
+		ppm_tim.cnt = TIM_GetCounter(TIM2);
+	ppm_tim.on = (state == ENABLE);
+}
+
+void TIM_SetCounter(TIM_TypeDef *tim, uint16_t value)
+{
+	if (tim != TIM2)
+		return;
+
+	// pulses.c restarts the count at the start of every frame.
+	if (value == 0)
+		frame_end();
+
+	ppm_tim.cnt = value;
+	ppm_tim.base = now - value;
+}
+
+void TIM_SetAutoreload(TIM_TypeDef *tim, uint16_t value)
+{
+	if (tim == TIM2)
+		ppm_tim.arr = value;
+}
+
+void TIM_SetCompare1(TIM_TypeDef *tim, uint16_t value)
+{
+	if (tim == TIM2)
+		ppm_tim.ccr = value;
+}
+
+/**
+  * @brief  Get the time of the next TIM2 compare interrupt.
+  * @note	Rolls the counter over at ARR when the compare value has
+  *         already been passed.
+  * @param  None
+  * @retval Time in us, NEVER when the timer is stopped.
+  */
+static uint64_t ppm_next_irq(void)
+{
+	if (!ppm_tim.on)
+		return NEVER;
+	if (ppm_tim.base + ppm_tim.ccr < now
+			|| (ppm_tim.base + ppm_tim.ccr == now && ppm_tim.fired == now))
+		ppm_tim.base += (uint32_t)ppm_tim.arr + 1;
+	return ppm_tim.base + ppm_tim.ccr;
+}
+
+uint16_t TIM_GetCapture1(TIM_TypeDef *tim) { (void)tim; return 0; }
+
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void NVIC_Init(NVIC_InitTypeDef *init) { (void)init; }
+void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+void NVIC_DisableIRQ(IRQn_Type irq) { (void)irq; }
+void GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init) { (void)gpio; (void)init; }
+
+void ADC_DeInit(ADC_TypeDef *adc) { (void)adc; }
+void ADC_StructInit(ADC_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void ADC_Init(ADC_TypeDef *adc, ADC_InitTypeDef *init) { (void)adc; (void)init; }
+void ADC_RegularChannelConfig(ADC_TypeDef *adc, uint8_t channel, uint8_t rank, uint8_t time)
+{
+	(void)adc; (void)channel; (void)rank; (void)time;
+}
+void ADC_Cmd(ADC_TypeDef *adc, FunctionalState state) { (void)adc; (void)state; }
+void ADC_DMACmd(ADC_TypeDef *adc, FunctionalState state) { (void)adc; (void)state; }
+void ADC_ResetCalibration(ADC_TypeDef *adc) { (void)adc; }
+FlagStatus ADC_GetResetCalibrationStatus(ADC_TypeDef *adc) { (void)adc; return RESET; }
+void ADC_StartCalibration(ADC_TypeDef *adc) { (void)adc; }
+FlagStatus ADC_GetCalibrationStatus(ADC_TypeDef *adc) { (void)adc; return RESET; }
+void ADC_ExternalTrigConvCmd(ADC_TypeDef *adc, FunctionalState state) { (void)adc; (void)state; }
+
+void DMA_DeInit(DMA_Channel_TypeDef *ch) { (void)ch; }
+void DMA_StructInit(DMA_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init) { (void)ch; (void)init; }
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state) { (void)ch; (void)state; }
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state) { (void)ch; (void)it; (void)state; }
+void DMA_ClearFlag(uint32_t flag) { (void)flag; }
+void DMA_ClearITPendingBit(uint32_t it) { (void)it; }
+
+void TIM_DeInit(TIM_TypeDef *tim) { (void)tim; }
+void TIM_TimeBaseStructInit(TIM_TimeBaseInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_TimeBaseInit(TIM_TypeDef *tim, TIM_TimeBaseInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_OCStructInit(TIM_OCInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_OC1Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_OC4Init(TIM_TypeDef *tim, TIM_OCInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_ICStructInit(TIM_ICInitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void TIM_ICInit(TIM_TypeDef *tim, TIM_ICInitTypeDef *init) { (void)tim; (void)init; }
+void TIM_ITConfig(TIM_TypeDef *tim, uint16_t it, FunctionalState state) { (void)tim; (void)it; (void)state; }
+void TIM_ClearITPendingBit(TIM_TypeDef *tim, uint16_t it) { (void)tim; (void)it; }
+
+/*
+ * Firmware modules that are not built here
+ */
+
+uint8_t keypad_get_switches(void) { return switch_state; }
+bool keypad_get_switch(KEYPAD_SWITCH sw) { return sw == 0 || (switch_state & sw); }
+void keypad_cancel_repeat(void) { }
+void sound_play_tone(uint16_t freq, uint16_t duration) { (void)freq; (void)duration; }
+void sound_play_tune(TUNE index) { (void)index; }
+void gui_update(UPDATE_TYPE type) { (void)type; }
+void task_register(Tasks task, void (*fn)(uint32_t)) { (void)task; (void)fn; }
+void task_schedule(Tasks task, uint32_t data, uint32_t time_ms) { (void)task; (void)data; (void)time_ms; }
+void recorder_sample(void) { }
+void monitor_sample(void) { }
+bool startup_hold(void) { return false; }
+void watchdog_expect(uint8_t source, bool expect) { (void)source; (void)expect; }
+bool watchdog_restore_chans(void) { return false; }
+uint32_t stack_isr_enter(STACK_ISR isr) { (void)isr; return 0; }
+void stack_isr_exit(STACK_ISR isr, uint32_t mark) { (void)isr; (void)mark; }
+void capture_adc(void) { }
+void capture_ppm_in(void) { }
+
+/*
+ * Replay
+ */
+
+/**
+  * @brief  Run the pulse ISR up to a point in time.
+  * @param  until: Time in us.
+  * @retval None
+  */
+static void run_until(uint64_t until)
+{
+	uint64_t t;
+
+	while ((t = ppm_next_irq()) <= until)
+	{
+		now = t;
+		system_ticks = now / 1000;
+		ppm_tim.fired = now;
+		TIM2_IRQHandler();
+	}
+
+	now = until;
+	system_ticks = now / 1000;
+}
+
+static void mixer_pass(void)
+{
+	struct timespec t0, t1;
+	uint64_t ns;
+
+	// On the radio this is the 20ms sticks task, between mixer passes.
+	sticks_process(0);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	DMA1_Channel1_IRQHandler();
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	ns = (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000 + t1.tv_nsec - t0.tv_nsec;
+	if (ns < ns_min) ns_min = ns;
+	if (ns > ns_max) ns_max = ns;
+	ns_total += ns;
+	passes++;
+}
+
+static int replay(const uint8_t *data, size_t size)
+{
+	size_t pos = 0;
+	unsigned long records = 0;
+
+	while (pos < size)
+	{
+		uint8_t type = data[pos];
+		uint8_t len = capture_length(type);
+		CaptureHdr hdr;
+		int i;
+
+		if (len == 0 || pos + len > size)
+		{
+			fprintf(stderr, "bad record at offset %zu\n", pos);
+			return -1;
+		}
+
+		memcpy(&hdr, &data[pos], sizeof(hdr));
+		run_until(hdr.time);
+
+		switch (type)
+		{
+		case CAPTURE_ADC:
+		{
+			CaptureAdc rec;
+			memcpy(&rec, &data[pos], sizeof(rec));
+			for (i = 0; i < STICK_ADC_CHANNELS; ++i)
+				adc_data[i] = rec.adc[i];
+			switch_state = rec.switches;
+			mixer_pass();
+			break;
+		}
+		case CAPTURE_KEY:
+		{
+			CaptureKey rec;
+			memcpy(&rec, &data[pos], sizeof(rec));
+			if (rec.key & TRIM_KEYS)
+				mixer_input_trim(rec.key);
+			else if (rec.key & KEY_OK_LONG)
+				mixer_instant_trim();
+			else if (rec.key & KEY_CANCEL_LONG)
+				mixer_instant_trim_undo();
+			break;
+		}
+		case CAPTURE_PPM_IN:
+		{
+			CapturePpmIn rec;
+			memcpy(&rec, &data[pos], sizeof(rec));
+			for (i = 0; i < CAPTURE_PPM_CHANNELS; ++i)
+				g_ppmIns[i] = rec.ppm[i];
+			break;
+		}
+		case CAPTURE_LOST:
+		{
+			CaptureLost rec;
+			memcpy(&rec, &data[pos], sizeof(rec));
+			fprintf(stderr, "warning: %u records lost at %u us\n", rec.count, rec.hdr.time);
+			break;
+		}
+		}
+
+		pos += len;
+		records++;
+	}
+
+	frame_end();
+	fprintf(stderr, "%lu records, %llu ms\n", records, (unsigned long long)now / 1000);
+	return 0;
+}
+
+static uint8_t *load(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *buf;
+	long len;
+
+	if (!f)
+		return NULL;
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	rewind(f);
+
+	buf = malloc(len > 0 ? len : 1);
+	if (buf && fread(buf, 1, len, f) != (size_t)len)
+	{
+		free(buf);
+		buf = NULL;
+	}
+	fclose(f);
+
+	*size = len;
+	return buf;
+}
+
+int main(int argc, char **argv)
+{
+	CaptureFileHdr hdr;
+	const char *path;
+	uint8_t *data;
+	size_t size, pos;
+
+	if (argc == 3 && strcmp(argv[1], "-q") == 0)
+	{
+		quiet = true;
+		path = argv[2];
+	}
+	else if (argc == 2)
+		path = argv[1];
+	else
+	{
+		fprintf(stderr, "usage: %s [-q] trace\n", argv[0]);
+		return 2;
+	}
+
+	data = load(path, &size);
+	if (!data)
+	{
+		perror(path);
+		return 1;
+	}
+
+	if (size < sizeof(hdr))
+	{
+		fprintf(stderr, "%s: too short\n", path);
+		return 1;
+	}
+	memcpy(&hdr, data, sizeof(hdr));
+	if (hdr.magic != CAPTURE_MAGIC || hdr.version != CAPTURE_VERSION)
+	{
+		fprintf(stderr, "%s: not a version %d capture\n", path, CAPTURE_VERSION);
+		return 1;
+	}
+	if (hdr.general_size != sizeof(EEGeneral) || hdr.model_size != sizeof(ModelData)
+			|| size < sizeof(hdr) + hdr.general_size + hdr.model_size)
+	{
+		fprintf(stderr, "%s: settings are %u/%u bytes, this build expects %zu/%zu\n",
+				path, hdr.general_size, hdr.model_size, sizeof(EEGeneral), sizeof(ModelData));
+		return 1;
+	}
+
+	pos = sizeof(hdr);
+	memcpy((void *)&g_eeGeneral, &data[pos], sizeof(EEGeneral));
+	pos += sizeof(EEGeneral);
+	memcpy((void *)&g_model, &data[pos], sizeof(ModelData));
+	pos += sizeof(ModelData);
+
+	// Same order as main().
+	mixer_init();
+	sticks_apply_calibration();
+	pulses_init();
+
+	if (replay(&data[pos], size - pos) != 0)
+		return 1;
+
+	fprintf(stderr, "%lu frames, crc %08x\n", frames, ~crc);
+	if (passes)
+		fprintf(stderr, "%lu mixer passes, ns min %llu avg %llu max %llu\n", passes,
+				(unsigned long long)ns_min, (unsigned long long)(ns_total / passes),
+				(unsigned long long)ns_max);
+
+	free(data);
+	return 0;
+}
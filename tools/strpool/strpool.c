@@ -0,0 +1,343 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Host side generator for the GUI string pool (firmware/strings.h).
+ * Reads the string tables (firmware/strings.txt) and writes C for one
+ * pool of NUL terminated strings, an offset for each string and the
+ * first string of each table. A string the same as, or the tail of,
+ * another shares its bytes. The output checks that each table is
+ * STR_<NAME> in strings.h and has the length given for it.
+ *
+ * Build:  cc -o strpool strpool.c
+ * Usage:  strpool [-s] strings.txt > strings_pool.c
+ *         -s prints the sizes against one pointer per string instead.
+ *
+ * firmware/strings_pool.c is made in the firmware directory with
+ *   strpool strings.txt > strings_pool.c
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#define MAX_STRINGS		1024
+#define MAX_TABLES		64
+#define MAX_INCLUDES	16
+#define MAX_LINE		512
+
+typedef struct
+{
+	char *text;				// Decoded
+	size_t len;
+	long offset;			// In the pool, -1 until placed
+} Str;
+
+typedef struct
+{
+	char name[64];
+	char length[128];		// C expression
+	int first;
+} Table;
+
+static Str strs[MAX_STRINGS];
+static int n_strs;
+static Table tables[MAX_TABLES];
+static int n_tables;
+static char includes[MAX_INCLUDES][128];
+static int n_includes;
+
+// Unique strings in pool order.
+static int pool[MAX_STRINGS];
+static int n_pool;
+static long pool_len;
+
+static const char *file;
+static int line_no;
+
+static void fail(const char *why)
+{
+	fprintf(stderr, "%s:%d: %s\n", file, line_no, why);
+	exit(1);
+}
+
+static char *trim(char *s)
+{
+	char *e;
+
+	while (isspace((unsigned char)*s))
+		s++;
+	e = s + strlen(s);
+	while (e > s && isspace((unsigned char)e[-1]))
+		*--e = 0;
+	return s;
+}
+
+/**
+  * @brief  Decode a C string literal.
+  * @note	Knows \n, \t, \\, \", \' and \xHH, which is all the GUI uses.
+  * @retval The text after the literal.
+  */
+static char *parse_literal(char *p, Str *s)
+{
+	char buf[MAX_LINE];
+	size_t n = 0;
+
+	p++;
+	while (*p != '"') {
+		char c = *p++;
+
+		if (c == 0)
+			fail("unterminated string");
+		if (c == '\\') {
+			c = *p++;
+			switch (c) {
+			case 'n': c = '\n'; break;
+			case 't': c = '\t'; break;
+			case '\\': case '"': case '\'': break;
+			case 'x': c = (char)strtoul(p, &p, 16); break;
+			default: fail("unknown escape");
+			}
+		}
+		if (c == 0)
+			fail("NUL in a string");
+		buf[n++] = c;
+	}
+	s->text = malloc(n + 1);
+	memcpy(s->text, buf, n);
+	s->text[n] = 0;
+	s->len = n;
+	s->offset = -1;
+	return p + 1;
+}
+
+static void parse(FILE *f)
+{
+	char buf[MAX_LINE];
+
+	while (fgets(buf, sizeof(buf), f)) {
+		char *p = trim(buf);
+
+		line_no++;
+		if (*p == 0 || *p == '#' || strncmp(p, "//", 2) == 0)
+			continue;
+
+		if (strncmp(p, "include ", 8) == 0) {
+			if (n_includes == MAX_INCLUDES)
+				fail("too many includes");
+			snprintf(includes[n_includes++], sizeof(includes[0]), "%s", trim(p + 8));
+		} else if (strncmp(p, "table ", 6) == 0) {
+			Table *t = &tables[n_tables];
+			char *name = trim(p + 6);
+			char *len = name + strcspn(name, " \t");
+
+			if (n_tables == MAX_TABLES)
+				fail("too many tables");
+			if (*len == 0)
+				fail("expected table NAME LENGTH");
+			*len++ = 0;
+			snprintf(t->name, sizeof(t->name), "%s", name);
+			snprintf(t->length, sizeof(t->length), "%s", trim(len));
+			t->first = n_strs;
+			n_tables++;
+		} else if (*p == '"') {
+			if (n_tables == 0)
+				fail("string before the first table");
+			if (n_strs == MAX_STRINGS)
+				fail("too many strings");
+			p = trim(parse_literal(p, &strs[n_strs++]));
+			if (*p != 0 && strncmp(p, "//", 2) != 0)
+				fail("junk after the string");
+		} else {
+			fail("expected include, table or a string");
+		}
+	}
+}
+
+static int by_length(const void *a, const void *b)
+{
+	const Str *sa = &strs[*(const int*)a];
+	const Str *sb = &strs[*(const int*)b];
+
+	if (sa->len != sb->len)
+		return sa->len < sb->len ? 1 : -1;
+	return *(const int*)a - *(const int*)b;
+}
+
+/**
+  * @brief  Place the strings, longest first so shorter tails can share.
+  */
+static void build_pool(void)
+{
+	int order[MAX_STRINGS];
+	int i, j;
+
+	for (i = 0; i < n_strs; ++i)
+		order[i] = i;
+	qsort(order, n_strs, sizeof(order[0]), by_length);
+
+	for (i = 0; i < n_strs; ++i) {
+		Str *s = &strs[order[i]];
+
+		for (j = 0; j < n_pool; ++j) {
+			const Str *p = &strs[pool[j]];
+
+			if (p->len >= s->len && strcmp(p->text + p->len - s->len, s->text) == 0) {
+				s->offset = p->offset + p->len - s->len;
+				break;
+			}
+		}
+		if (s->offset < 0) {
+			s->offset = pool_len;
+			pool_len += s->len + 1;
+			pool[n_pool++] = order[i];
+		}
+	}
+
+}
+
+static void print_escaped(const char *s)
+{
+	for (; *s; ++s) {
+		unsigned char c = *s;
+
+		if (c == '\n')
+			printf("\\n");
+		else if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < ' ' || c > '~')
+			printf("\\%03o", c);
+		else
+			putchar(c);
+	}
+}
+
+static void write_c(void)
+{
+	int i, t;
+
+	printf("/*\n"
+			" *                  Copyright 2014 ARTaylor.co.uk\n"
+			" *\n"
+			" * This program is free software; you can redistribute it and/or modify\n"
+			" * it under the terms of the GNU General Public License version 3 as\n"
+			" * published by the Free Software Foundation.\n"
+			" *\n"
+			" * This program is distributed in the hope that it will be useful,\n"
+			" * but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+			" * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+			" * GNU General Public License for more details.\n"
+			" *\n"
+			" */\n\n"
+			"/* Description:\n"
+			" *\n"
+			" * GUI string pool, see strings.h.\n"
+			" * Made by tools/strpool from %s, do not edit.\n"
+			" *\n"
+			" */\n\n"
+			"#include <stdint.h>\n\n"
+			"#include \"strings.h\"\n", file);
+	for (i = 0; i < n_includes; ++i)
+		printf("#include \"%s\"\n", includes[i]);
+
+	printf("\n// %d strings, %d stored, %ld bytes.\n", n_strs, n_pool, pool_len);
+	printf("const char str_pool[%ld] =\n", pool_len);
+	for (i = 0; i < n_pool; ++i) {
+		printf("\t\"");
+		print_escaped(strs[pool[i]].text);
+		printf("%s\"%s\n", (i + 1 < n_pool) ? "\\0" : "", (i + 1 < n_pool) ? "" : ";");
+	}
+
+	printf("\nconst uint16_t str_index[%d] = {", n_strs);
+	for (t = 0; t < n_tables; ++t) {
+		int end = (t + 1 < n_tables) ? tables[t + 1].first : n_strs;
+
+		printf("\n\t// STR_%s", tables[t].name);
+		for (i = tables[t].first; i < end; ++i)
+			printf("%s%ld,", ((i - tables[t].first) % 12) ? " " : "\n\t", strs[i].offset);
+	}
+	printf("\n};\n");
+
+	printf("\nconst uint16_t str_table[STR_TABLE_MAX + 1] = {");
+	for (t = 0; t < n_tables; ++t)
+		printf("%s%d,", (t % 12) ? " " : "\n\t", tables[t].first);
+	printf("\n\t%d\n};\n\n", n_strs);
+
+	// Build time checks, in the style of eeprom.c.
+	printf("typedef char str_tables_match[(STR_TABLE_MAX == %d) ? 1 : -1];\n", n_tables);
+	for (t = 0; t < n_tables; ++t) {
+		int end = (t + 1 < n_tables) ? tables[t + 1].first : n_strs;
+
+		printf("typedef char str_%s_length[(STR_%s == %d && %d == (%s)) ? 1 : -1];\n",
+				tables[t].name, tables[t].name, t, end - tables[t].first, tables[t].length);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bool sizes = false;
+	FILE *f;
+	long text = 0;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "s")) != -1) {
+		switch (opt) {
+		case 's':
+			sizes = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-s] strings.txt > strings_pool.c\n", argv[0]);
+			return 1;
+		}
+	}
+	if (optind + 1 != argc) {
+		fprintf(stderr, "usage: %s [-s] strings.txt > strings_pool.c\n", argv[0]);
+		return 1;
+	}
+
+	file = argv[optind];
+	f = fopen(file, "r");
+	if (!f) {
+		perror(file);
+		return 1;
+	}
+	parse(f);
+	fclose(f);
+	if (n_tables == 0)
+		fail("no tables");
+
+	build_pool();
+	if (pool_len > 0xFFFF)
+		fail("pool over 64KB");
+
+	if (sizes) {
+		for (i = 0; i < n_strs; ++i)
+			text += strs[i].len + 1;
+		printf("%d strings in %d tables\n", n_strs, n_tables);
+		printf("pointers: %ld text + %d pointers = %ld bytes\n",
+				text, n_strs * 4, text + n_strs * 4);
+		printf("pool:     %ld text + %d offsets + %d tables = %ld bytes\n",
+				pool_len, n_strs * 2, (n_tables + 1) * 2,
+				pool_len + n_strs * 2 + (n_tables + 1) * 2);
+		return 0;
+	}
+
+	write_c();
+	return 0;
+}
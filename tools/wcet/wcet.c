@@ -0,0 +1,550 @@
+/*
+ *                  Copyright 2014 ARTaylor.co.uk
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/* Description:
+ *
+ * Searches for the model that makes the mixer (perOut() in
+ * firmware/mixer.c) take longest.
+ *
+ * mixer.c is built with -fsanitize-coverage=trace-pc, so every basic
+ * block it runs calls __sanitizer_cov_trace_pc(), where it is counted.
+ * The cost of a mixer pass is the number of blocks it ran. That does not
+ * depend on the host's load or caches, so the same case always gives the
+ * same cost; it is a measure of the path taken, not of target cycles.
+ * Calls out of mixer.c (switches, sounds) are not counted.
+ *
+ * A case is a model, the general settings (trainer, throttle reverse)
+ * and the seed of the inputs. Each case runs in a fresh process for a
+ * number of passes, 10ms apart, with random sticks, pots, switches and
+ * trainer inputs, and costs its most expensive pass. Random cases within
+ * the ranges the menus allow are tried first, then the worst one found is
+ * mutated, keeping each mutation that costs no less.
+ *
+ * The worst case can be saved with -o and run again with -m. With -l the
+ * exit code is 1 when the worst cost is over the limit, so a saved case
+ * and its cost can gate changes to the mixer:
+ *   wcet -m worst.wcet -l 5000
+ *
+ * Build:  cc -no-pie -I../hoststub -c -fsanitize-coverage=trace-pc ../../firmware/mixer.c
+ *         cc -no-pie -I../hoststub -o wcet wcet.c mixer.o
+ *         (add -fsanitize=address to both to catch reads out of the tables)
+ * Usage:  wcet [-n random] [-i mutations] [-p passes] [-s seed]
+ *              [-m case] [-o case] [-l limit]
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "stm32f10x.h"
+#include "../../firmware/myeeprom.h"
+#include "../../firmware/sticks.h"
+#include "../../firmware/mixer.h"
+#include "../../firmware/keypad.h"
+#include "../../firmware/sound.h"
+#include "../../firmware/strings.h"
+
+#define WCET_MAGIC		0x54454357	// "WCET"
+#define WCET_VERSION	1
+#define PASS_MS			10			// Every pass sees the 10ms tick
+
+typedef struct __attribute__((packed))
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t general_size;
+	uint16_t model_size;
+	uint16_t passes;
+	uint32_t inputs;		// Seed of the inputs
+} WcetHdr;
+
+typedef struct
+{
+	EEGeneral general;
+	ModelData model;
+	uint32_t inputs;
+} Case;
+
+typedef struct
+{
+	bool ok;				// False if the case crashed
+	uint64_t blocks;		// Most blocks in one pass
+	uint32_t pass;			// Which pass
+	uint64_t ns;			// Host time of that pass
+} Cost;
+
+// Firmware globals owned by modules that are not built here
+volatile EEGeneral g_eeGeneral;
+volatile ModelData g_model;
+volatile uint32_t system_ticks;
+volatile int16_t stick_data[STICK_ADC_CHANNELS];
+volatile int16_t g_ppmIns[8];
+volatile int16_t g_chans[NUM_CHNOUT];
+
+static SysTick_Type systick = { 0, 23999, 0 };
+SysTick_Type *SysTick = &systick;
+uint32_t SystemCoreClock = 24000000;
+
+static uint64_t blocks;
+static uint8_t switch_state;
+static uint32_t rng, rng_in;
+static unsigned passes = 50;
+
+void __sanitizer_cov_trace_pc(void)
+{
+	blocks++;
+}
+
+/*
+ * Firmware modules that are not built here
+ */
+
+bool keypad_get_switch(KEYPAD_SWITCH sw) { return sw == 0 || (switch_state & sw); }
+void keypad_cancel_repeat(void) { }
+void sound_play_tone(uint16_t freq, uint16_t duration) { (void)freq; (void)duration; }
+void sound_play_tune(TUNE index) { (void)index; }
+uint16_t sticks_get_battery(void) { return 100; }
+void recorder_sample(void) { }
+void monitor_sample(void) { }
+void failsafe_ppm_in_used(bool used) { (void)used; }
+bool startup_hold(void) { return false; }
+bool watchdog_restore_chans(void) { return false; }
+void NVIC_DisableIRQ(IRQn_Type irq) { (void)irq; }
+void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+
+/*
+ * Cases
+ */
+
+static uint32_t xorshift(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static uint32_t rnd(void)
+{
+	return xorshift(&rng);
+}
+
+static int fit(int v, int lo, int hi)
+{
+	if (v < lo || v > hi)
+		v = lo + abs(v) % (hi - lo + 1);
+	return v;
+}
+
+/**
+  * @brief  Bring every field perOut() reads into the range the menus allow.
+  * @note	A destCh of 0 still ends the mix list. Curves 1..6 are the
+  *         built in ones and 7 the first curve table; the 4 bit field
+  *         holds no more.
+  * @param  c: The case to fix.
+  * @retval None
+  */
+static void case_fix(Case *c)
+{
+	ModelData *m = &c->model;
+	EEGeneral *g = &c->general;
+	int i, j, k;
+
+	for (i = 0; i < MAX_MIXERS; ++i)
+	{
+		MixData *md = &m->mixData[i];
+
+		md->destCh = fit(md->destCh, 0, NUM_CHNOUT);
+		md->srcRaw = fit(md->srcRaw, 0, MIX_SRC_MAX - 1);
+		md->weight = fit(md->weight, -125, 125);
+		md->sOffset = fit(md->sOffset, -125, 125);
+		md->swtch = fit(md->swtch, 0, NUM_SWITCHES);
+		md->curve = fit(md->curve, 0, 7);
+		md->mixWarn = fit(md->mixWarn, 0, 1);
+	}
+
+	for (i = 0; i < NUM_CHNOUT; ++i)
+	{
+		m->limitData[i].min = fit(m->limitData[i].min, -100, 100);
+		m->limitData[i].max = fit(m->limitData[i].max, -100, 100);
+		m->limitData[i].offset = fit(m->limitData[i].offset, -100, 100);
+		m->safetySw[i].opt.ss.swtch = fit(m->safetySw[i].opt.ss.swtch, 0, NUM_SWITCHES);
+		m->safetySw[i].opt.ss.val = fit(m->safetySw[i].opt.ss.val, -125, 125);
+	}
+
+	for (i = 0; i < 4; ++i)
+	{
+		ExpoData *ed = &m->expoData[i];
+
+		for (j = 0; j < 3; ++j)
+			for (k = 0; k < 2; ++k)
+			{
+				ed->expo[j][DR_EXPO][k] = fit(ed->expo[j][DR_EXPO][k], -100, 100);
+				ed->expo[j][DR_WEIGHT][k] = fit(ed->expo[j][DR_WEIGHT][k], -100, 0);
+			}
+		ed->drSw1 = fit(ed->drSw1, 0, NUM_SWITCHES);
+		ed->drSw2 = fit(ed->drSw2, 0, NUM_SWITCHES);
+		m->trim[i] = fit(m->trim[i], -MIXER_TRIM_LIMIT, MIXER_TRIM_LIMIT);
+
+		g->trainer.mix[i].swtch = fit(g->trainer.mix[i].swtch, 0, NUM_SWITCHES);
+		g->trainer.mix[i].mode = fit(g->trainer.mix[i].mode, 0, 2);
+		g->trainer.calib[i] = fit(g->trainer.calib[i], -500, 500);
+	}
+
+	for (i = 0; i < MAX_CURVE5; ++i)
+		for (j = 0; j < 5; ++j)
+			m->curves5[i][j] = fit(m->curves5[i][j], -100, 100);
+	for (i = 0; i < MAX_CURVE9; ++i)
+		for (j = 0; j < 9; ++j)
+			m->curves9[i][j] = fit(m->curves9[i][j], -100, 100);
+
+	m->swashType = fit(m->swashType, 0, SWASH_TYPE_90);
+	m->swashRingValue = fit(m->swashRingValue, 0, 100);
+	m->swashCollectiveSource = fit(m->swashCollectiveSource, 0, MIX_SRC_MAX - 1);
+}
+
+static void case_random(Case *c)
+{
+	uint8_t *p;
+	size_t i;
+
+	p = (uint8_t *)&c->general;
+	for (i = 0; i < sizeof(c->general); ++i)
+		p[i] = rnd();
+	p = (uint8_t *)&c->model;
+	for (i = 0; i < sizeof(c->model); ++i)
+		p[i] = rnd();
+	c->inputs = rnd() | 1;
+	case_fix(c);
+}
+
+/**
+  * @brief  Change a case a little.
+  * @note	Mostly a few bytes of the model, sometimes the trainer
+  *         settings or the inputs.
+  * @param  c: The case to change.
+  * @retval None
+  */
+static void case_mutate(Case *c)
+{
+	unsigned n = 1 + rnd() % 4;
+
+	switch (rnd() % 8)
+	{
+	case 0:
+		c->inputs = rnd() | 1;
+		break;
+	case 1:
+		while (n--)
+			((uint8_t *)&c->general.trainer)[rnd() % sizeof(c->general.trainer)] = rnd();
+		c->general.throttleReversed = rnd();
+		break;
+	default:
+		while (n--)
+			((uint8_t *)&c->model)[rnd() % sizeof(c->model)] = rnd();
+		break;
+	}
+	case_fix(c);
+}
+
+/*
+ * Cost
+ */
+
+static int16_t random_input(int16_t limit)
+{
+	// Ends and centre are where the branches are.
+	switch (xorshift(&rng_in) % 4)
+	{
+	case 0:
+		return -limit;
+	case 1:
+		return limit;
+	default:
+		return (int16_t)(xorshift(&rng_in) % (2 * limit + 1)) - limit;
+	}
+}
+
+static void run_case(const Case *c, Cost *cost)
+{
+	struct timespec t0, t1;
+	unsigned pass;
+	int i;
+
+	memcpy((void *)&g_eeGeneral, &c->general, sizeof(g_eeGeneral));
+	memcpy((void *)&g_model, &c->model, sizeof(g_model));
+	rng_in = c->inputs;
+	system_ticks = 0;
+	mixer_init();
+
+	for (pass = 0; pass < passes; ++pass)
+	{
+		uint64_t start;
+
+		for (i = 0; i < STICK_ADC_CHANNELS; ++i)
+			stick_data[i] = random_input(RESX);
+		for (i = 0; i < 8; ++i)
+			g_ppmIns[i] = random_input(500);
+		switch_state = xorshift(&rng_in);
+		system_ticks += PASS_MS;
+
+		start = blocks;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		mixer_update();
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		if (blocks - start > cost->blocks)
+		{
+			cost->blocks = blocks - start;
+			cost->pass = pass;
+			cost->ns = (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000 + t1.tv_nsec - t0.tv_nsec;
+		}
+	}
+	cost->ok = true;
+}
+
+/**
+  * @brief  Find the cost of a case.
+  * @note	Runs in a child process, so that every case starts from the
+  *         mixer's initial state and a crash is reported, not fatal.
+  * @param  c: The case.
+  * @param  cost: Set to the cost.
+  * @retval None
+  */
+static void measure(const Case *c, Cost *cost)
+{
+	int fd[2];
+	pid_t pid;
+
+	memset(cost, 0, sizeof(*cost));
+	fflush(NULL);
+	if (pipe(fd) != 0 || (pid = fork()) < 0)
+	{
+		perror("fork");
+		exit(1);
+	}
+
+	if (pid == 0)
+	{
+		close(fd[0]);
+		run_case(c, cost);
+		if (write(fd[1], cost, sizeof(*cost)) != sizeof(*cost))
+			_exit(1);
+		_exit(0);
+	}
+
+	close(fd[1]);
+	if (read(fd[0], cost, sizeof(*cost)) != sizeof(*cost))
+		cost->ok = false;
+	close(fd[0]);
+	waitpid(pid, NULL, 0);
+}
+
+/*
+ * Report
+ */
+
+static void report(const Case *c, const Cost *cost)
+{
+	const ModelData *m = &c->model;
+	unsigned mixes, mul = 0, rep = 0, curves = 0, tables = 0, delays = 0, speeds = 0;
+	unsigned trainer = 0, safety = 0, i;
+
+	for (mixes = 0; mixes < MAX_MIXERS; ++mixes)
+	{
+		const MixData *md = &m->mixData[mixes];
+
+		if (md->destCh == 0)
+			break;
+		mul += md->mltpx == MLTPX_MUL;
+		rep += md->mltpx == MLTPX_REP;
+		curves += md->curve > 0 && md->curve < 7;
+		tables += md->curve >= 7;
+		delays += md->delayUp || md->delayDown;
+		speeds += md->speedUp || md->speedDown;
+	}
+	for (i = 0; i < 4; ++i)
+		trainer += m->traineron && c->general.trainer.mix[i].mode;
+	for (i = 0; i < NUM_CHNOUT; ++i)
+		safety += m->safetySw[i].opt.ss.swtch != 0;
+
+	printf("inputs   %08x, %u passes\n", c->inputs, passes);
+	printf("mixes    %u: %u mul, %u replace, %u curves, %u curve tables, %u delays, %u speeds\n",
+			mixes, mul, rep, curves, tables, delays, speeds);
+	printf("model    swash %u ring %u, trainer %u, safety %u, thr trim %u expo %u\n",
+			m->swashType, m->swashRingValue, trainer, safety, m->thrTrim, m->thrExpo);
+	if (cost->ok)
+		printf("worst    %llu blocks in pass %u, %llu ns on this host\n",
+				(unsigned long long)cost->blocks, cost->pass, (unsigned long long)cost->ns);
+	else
+		printf("worst    crashed\n");
+}
+
+static bool load(const char *path, Case *c)
+{
+	FILE *f = fopen(path, "rb");
+	WcetHdr hdr;
+	bool ok;
+
+	if (!f)
+	{
+		perror(path);
+		return false;
+	}
+
+	ok = fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == WCET_MAGIC
+			&& hdr.version == WCET_VERSION && hdr.general_size == sizeof(c->general)
+			&& hdr.model_size == sizeof(c->model)
+			&& fread(&c->general, sizeof(c->general), 1, f) == 1
+			&& fread(&c->model, sizeof(c->model), 1, f) == 1;
+	fclose(f);
+
+	if (!ok)
+	{
+		fprintf(stderr, "%s: not a case for this build\n", path);
+		return false;
+	}
+	c->inputs = hdr.inputs;
+	passes = hdr.passes;
+	return true;
+}
+
+static bool save(const char *path, const Case *c)
+{
+	FILE *f = fopen(path, "wb");
+	WcetHdr hdr = { WCET_MAGIC, WCET_VERSION, sizeof(c->general), sizeof(c->model), passes, c->inputs };
+	bool ok;
+
+	if (!f)
+	{
+		perror(path);
+		return false;
+	}
+
+	ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1
+			&& fwrite(&c->general, sizeof(c->general), 1, f) == 1
+			&& fwrite(&c->model, sizeof(c->model), 1, f) == 1;
+	if (fclose(f) != 0 || !ok)
+	{
+		perror(path);
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const char *in = NULL, *out = NULL;
+	unsigned long randoms = 2000, mutations = 20000, limit = 0, n;
+	static Case best, c;
+	Cost best_cost, cost;
+	int opt;
+
+	rng = time(NULL);
+	while ((opt = getopt(argc, argv, "n:i:p:s:m:o:l:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			randoms = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			mutations = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			passes = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			rng = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			in = optarg;
+			break;
+		case 'o':
+			out = optarg;
+			break;
+		case 'l':
+			limit = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n random] [-i mutations] [-p passes] [-s seed]\n"
+					"            [-m case] [-o case] [-l limit]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (rng == 0)
+		rng = 1;
+	if (passes == 0)
+		passes = 1;
+
+	if (in)
+	{
+		// Run a saved case as it is.
+		if (!load(in, &best))
+			return 1;
+		measure(&best, &best_cost);
+	}
+	else
+	{
+		fprintf(stderr, "seed %u\n", rng);
+		memset(&best_cost, 0, sizeof(best_cost));
+
+		for (n = 0; n < randoms + mutations; ++n)
+		{
+			if (n < randoms || !best_cost.ok)
+				case_random(&c);
+			else
+			{
+				c = best;
+				case_mutate(&c);
+			}
+
+			measure(&c, &cost);
+			if (!cost.ok)
+			{
+				// A crash is worth more than any cost.
+				fprintf(stderr, "case %lu crashed\n", n);
+				best = c;
+				best_cost = cost;
+				break;
+			}
+			else if (cost.blocks >= best_cost.blocks)
+			{
+				if (cost.blocks > best_cost.blocks)
+					fprintf(stderr, "case %lu: %llu blocks\n", n, (unsigned long long)cost.blocks);
+				best = c;
+				best_cost = cost;
+			}
+		}
+	}
+
+	report(&best, &best_cost);
+	if (out && !save(out, &best))
+		return 1;
+
+	if (!best_cost.ok)
+		return 1;
+	if (limit && best_cost.blocks > limit)
+	{
+		printf("over the limit of %lu blocks\n", limit);
+		return 1;
+	}
+	return 0;
+}